@@ -26,7 +26,7 @@ along with RAVE.  If not, see <http://www.gnu.org/licenses/>.
 # @author Daniel Michelson and Peter Rodriquez, Environment and Climate Change Canada
 # @date 2017-06-14
 
-import sys, os, math, tarfile, mimetypes, gzip, datetime
+import sys, os, math, mimetypes, gzip, datetime
 import _rb52odim
 import _rave, _raveio, _polarvolume, _polarscan
 import rave_tempfile
@@ -37,6 +37,8 @@ RB52ODIMCONFIG = os.path.abspath(os.path.join(os.path.dirname(_rb52odim.__file__
 os.environ["RB52ODIMCONFIG"] = RB52ODIMCONFIG
 
 ACQUISITION_UPDATE_TIME = 6  # minutes
+STDIN = "-"  # input file name that reads from stdin
+SHM = "shm:"  # output file name prefix that publishes to POSIX shared memory, e.g. shm:/rb5vol
 
 
 ## Rudimentary input file validation
@@ -48,7 +50,8 @@ def validate(filename):
         raise IOError, "%s is zero-length. Bailing ..." % filename
 
 
-## Gunzips a (Rainbow5) file
+## Gunzips a (Rainbow5) file. Not needed to read one, the C reader inflates
+#  gzipped input itself.
 # @param string input file name, assumed to have trailing .gz
 # @returns string output file name, created by rave_tempfile
 def gunzip(fstr):
@@ -60,6 +63,54 @@ def gunzip(fstr):
     return fstr
 
 
+## Sets the number of threads decoding the moments and sweeps of each input
+#  file. Output is identical regardless.
+# @param int number of threads, 1 (default) decodes sequentially, 0 uses one per CPU
+def setDecodeThreads(nthreads):
+    _rb52odim.setDecodeThreads(int(nthreads))
+
+
+## Caches decoded RB5 files in a directory, for archives that are read many times.
+#  Full reads (no quantities or slices) of a file whose path, inode, size, mtime and ctime
+#  are unchanged are then mapped back from there instead of decoded again.
+# @param string cache directory, created if need be, or None to stop caching (default)
+# @param int cache size in bytes, the least recently used entries are evicted beyond it, 0 for 4 GiB
+def setCache(cache_dir, max_bytes=0):
+    _rb52odim.setCache(cache_dir, long(max_bytes))
+
+
+## Decodes RB5 files into the cache set with \ref setCache, where not cached already
+# @param list of input file names, may be gzipped
+# @returns list of the input file names that could not be read
+def warmCache(ifiles):
+    if _rb52odim.getCache()[0] is None:
+        raise IOError, "No cache directory set. Bailing ..."
+    failed = []
+    for ifile in ifiles:
+        try:
+            if singleRB5(ifile, return_rio=True) is None: failed.append(ifile)
+        except IOError:
+            failed.append(ifile)
+    return failed
+
+
+## Lists the entries of a cache directory
+# @param string cache directory
+# @returns list of dictionaries, least recently used first, with the input file's "path",
+#  "size", "mtime" and "crc32" (of its contents when stored), the entry's "bytes" and last use "used" (seconds since the
+#  epoch), and "stale" if the input file is gone, or has changed since
+def listCache(cache_dir):
+    return _rb52odim.listRB5cache(cache_dir)
+
+
+## Evicts the least recently used entries of a cache directory
+# @param string cache directory
+# @param int size in bytes to shrink the cache to, 0 (default) to empty it
+# @returns int number of entries evicted
+def evictCache(cache_dir, max_bytes=0):
+    return _rb52odim.evictRB5cache(cache_dir, long(max_bytes))
+
+
 ## Rounds date and time to the nearest acquisition interval (minute past hour),
 # assuming it is regular and starting at minute 0.
 # @param string date in YYYYMMDD format
@@ -77,26 +128,138 @@ def roundDT(DATE, TIME, INTERVAL=ACQUISITION_UPDATE_TIME):
 
 
 ## Reads RB5 files and merges their contents into an output ODIM_H5 file
-# @param string file name of input file
+# @param string file name of input file, may be gzipped, or STDIN to read it from stdin
 # @param string file name of output file
-def singleRB5(inp_fullfile, out_fullfile=None, return_rio=False):
-    TMPFILE = False
-    validate(inp_fullfile)
-    orig_ifile = copy(inp_fullfile)
-    if mimetypes.guess_type(inp_fullfile)[1] == 'gzip':
-        inp_fullfile = gunzip(inp_fullfile)
-        TMPFILE = True
-    if not _rb52odim.isRainbow5(inp_fullfile):
-        raise IOError, "%s is not a proper RB5 raw file" % orig_ifile
-    rio = _rb52odim.readRB5(inp_fullfile)
-    if TMPFILE: os.remove(inp_fullfile)
+# @param list of ODIM quantities to read, default all. The others are never decoded.
+# @param list of 0-based slice (sweep) indices to read, default all
+# @param tuple (min, max) elevation angles in degrees of the slices to read, if no slice indices
+def singleRB5(inp_fullfile, out_fullfile=None, return_rio=False, quantities=None,
+              slices=None, angles=None):
+    if inp_fullfile == STDIN:
+        rio = readRB5stream(sys.stdin, STDIN, quantities, slices, angles)
+    else:
+        validate(inp_fullfile)
+        if not _rb52odim.isRainbow5(inp_fullfile):
+            raise IOError, "%s is not a proper RB5 raw file" % inp_fullfile
+        if quantities is None and slices is None and angles is None:
+            rio = _rb52odim.readRB5(inp_fullfile)
+        else: rio = _rb52odim.readRB5(inp_fullfile, quantities, slices, angles)
 
     if out_fullfile:
-        rio.save(out_fullfile)
+        saveRIO(rio, out_fullfile)
     if return_rio:
         return rio
 
 
+## Writes ODIM_H5, or publishes the decoded data in POSIX shared memory if the output
+#  file name is SHM followed by the shared memory name, for \ref readRB5shm in downstream processes
+# @param RaveIOCore object
+# @param string output file name, or e.g. "shm:/rb5vol"
+def saveRIO(rio, out_fullfile):
+    if out_fullfile.startswith(SHM):
+        _rb52odim.saveRB5shm(rio, out_fullfile[len(SHM):])
+    else: rio.save(out_fullfile)
+
+
+## Maps a scan or volume published by \ref saveRIO in shared memory, without copying it
+# @param string shared memory name, e.g. "/rb5vol", with or without the SHM prefix
+# @returns dictionary with the what/where metadata, "attributes" and a list of "scans",
+#  each with its geometry, "attributes" and "moments" by ODIM quantity. Moment "data"
+#  and array attributes are read-only numpy arrays over the shared memory.
+def readRB5shm(shm_name):
+    if shm_name.startswith(SHM): shm_name = shm_name[len(SHM):]
+    return _rb52odim.readRB5shm(shm_name)
+
+
+## Reads an RB5 file, possibly gzipped, from a pipe, socket or stdin as it arrives,
+#  e.g. from "ssh host cat file.vol |". The stream need not be seekable, and is read to its end.
+# @param file object or file descriptor
+# @param string naming the input in messages and metadata
+# @param list of ODIM quantities to read, default all
+# @param list of 0-based slice (sweep) indices to read, default all
+# @param tuple (min, max) elevation angles in degrees of the slices to read, if no slice indices
+# @returns RaveIOCore object
+def readRB5stream(stream, name=STDIN, quantities=None, slices=None, angles=None):
+    fd = stream if isinstance(stream, int) else stream.fileno()
+    return _rb52odim.readRB5stream(fd, name, quantities, slices, angles)
+
+
+## Reads only the metadata of an RB5 file, for cataloguing. No data are decoded.
+# @param string input file name, may be gzipped
+# @param Boolean if True, slice end times come from the ray timestamps (reads the
+#  whole file), otherwise they are estimated from the antenna speed
+# @returns dictionary with sensor, task, quantities and a list of slice dictionaries
+def readRB5header(inp_fullfile, timestamps=False):
+    validate(inp_fullfile)
+    header = _rb52odim.readRB5header(inp_fullfile, int(timestamps))
+    header['filename'] = inp_fullfile
+    return header
+
+
+## Lazily read RB5 file. Every moment is created with its metadata, but only
+#  decoded when asked for with load() or getParameter(), or when saved.
+class LazyRB5(object):
+    ## Constructor
+    # @param string input file name, may be gzipped
+    # @param buffer optional contents of the file, read in place instead of it (str,
+    #  bytearray, memoryview or mmap), referenced as long as this object is alive
+    def __init__(self, inp_fullfile, buffer=None):
+        if buffer is None:
+            validate(inp_fullfile)
+            if not _rb52odim.isRainbow5(inp_fullfile):
+                raise IOError, "%s is not a proper RB5 raw file" % inp_fullfile
+            self._handle = _rb52odim.readRB5lazy(inp_fullfile)
+        else:
+            self._handle = _rb52odim.readRB5lazy(inp_fullfile, buffer)
+        ## RaveIO object, with each moment in its scan once loaded
+        self.rio = _rb52odim.getLazyRaveIO(self._handle)
+
+    ## Decodes moments not decoded yet
+    # @param string ODIM quantity, or None for all
+    # @param int scan index, or -1 for all scans
+    # @returns int number of moments decoded by this call
+    def load(self, quantity=None, scan_index=-1):
+        return _rb52odim.loadLazy(self._handle, quantity, scan_index)
+
+    ## Decodes and returns one moment
+    # @param int scan index, 0 for a single scan
+    # @param string ODIM quantity
+    # @returns PolarScanParamCore object
+    def getParameter(self, scan_index, quantity):
+        self.load(quantity, scan_index)
+        obj = self.rio.object
+        if self.rio.objectType is _rave.Rave_ObjectType_PVOL:
+            obj = obj.getScan(scan_index)
+        return obj.getParameter(quantity)
+
+    ## Decodes whatever is left, then writes ODIM_H5
+    # @param string file name of output file
+    def save(self, out_fullfile):
+        self.load()
+        saveRIO(self.rio, out_fullfile)
+
+
+## Reads an RB5 file, deferring the decoding of its moments
+# @param string file name of input file
+# @param buffer optional contents of the file, see LazyRB5
+# @returns LazyRB5 object
+def readRB5lazy(inp_fullfile, buffer=None):
+    return LazyRB5(inp_fullfile, buffer)
+
+
+## Reads RB5 files in order, the next ones being read ahead while one is decoded
+# @param list of input file names, may be gzipped
+# @param int number of files read ahead, 0 (default) for 8
+# @returns generator of (file name, RaveIOCore object, or None if the file could not be read)
+def readRB5batch(ifiles, window=0):
+    ifiles = list(ifiles)
+    handle = _rb52odim.openRB5batch(ifiles, window)
+    while True:
+        item = _rb52odim.nextRB5batch(handle)
+        if item is None: return
+        yield ifiles[item[0]], item[1]
+
+
 ### Functions that do not assume tarballing. Somewhat redundant functionality
 ### for merging parameters/quantities from individual files/objects.
 
@@ -109,10 +272,9 @@ def singleRB5(inp_fullfile, out_fullfile=None, return_rio=False):
 def readParameterFiles(ifiles):
     ifiles = sorted(ifiles, key=lambda s: s.lower())  # case-insensitive sort
     objects = []
-    for ifile in ifiles:
-        try: rio = singleRB5(ifile, return_rio=True)
-        except: print "readParameterFiles: failed to read %s" % ifile
-        objects.append(rio.object)
+    for ifile, rio in readRB5batch(ifiles):
+        if rio is None: print "readParameterFiles: failed to read %s" % ifile
+        else: objects.append(rio.object)
     return objects
 
 
@@ -268,54 +430,24 @@ def combineRB5(ifiles, out_fullfile=None, return_rio=False):
     container=_raveio.new()
     container.object=big_obj
     if out_fullfile:
-        container.save(out_fullfile)
+        saveRIO(container, out_fullfile)
     if return_rio:
         return container
 
 
-## Reads a single RB5 tarball and merges its contents into an output ODIM_H5 file
+## Reads a single RB5 tarball and merges its contents into an output ODIM_H5 file.
+# The tarball (optionally gzipped) is read in place by the C reader: members are filtered
+# as per \ref parse_tarball_member_name and merged as \ref compile_big_scan and
+# \ref compile_big_pvol would, with their moments decoded on a pool of threads.
 # @param string input tarball file name
 # @param string output file name
 # @param string output base directory, only used when creating new output file name  
 # @param Boolean if True, return the RaveIOCore object containing the decoded and merged RB5 data
+# @param int number of decode threads, 0 (default) for one per CPU
 # @returns RaveIOCore if return_rio=True, otherwise nothing
-def combineRB5FromTarball(ifile, ofile, out_basedir=None, return_rio=False):
+def combineRB5FromTarball(ifile, ofile, out_basedir=None, return_rio=False, nthreads=0):
     validate(ifile)
-    big_obj=None
-
-    tar=tarfile.open(ifile)
-    member_arr=tar.getmembers()
-    nMEMBERs=len(member_arr)
-    for iMEMBER in range(nMEMBERs):
-        this_member=member_arr[iMEMBER]
-        inp_fullfile=this_member.name
-        mb=parse_tarball_member_name(inp_fullfile)
-
-#XAH DPATC_replay: Special filter out for ZPHI_ITER_DEFAULT.dpatc & ZDR
-        if (
-            (mb['rb5_ftype'] == "rawdata") and
-            not ((mb['rb5_ppdf'] == "ZPHI_ITER_DEFAULT.dpatc") and
-                 (mb['nam_sparam'] == "ZDR"))
-            ):
-
-#        if mb['rb5_ftype'] == "rawdata":
-            obj_mb=tar.extractfile(this_member) #EXTRACTED MEMBER OBJECT
-#            import pdb; pdb.set_trace()
-
-            rb5_buffer=obj_mb.read() #NOTE: once read(), buffer is detached from obj_mb
-            isrb5=_rb52odim.isRainbow5buf(rb5_buffer)
-            if not isrb5:
-                raise IOError, "%s is not a proper RB5 buffer" % rb5_buffer
-            else:
-                buffer_len=obj_mb.size
-#                print '### inp_fullfile = %s (%ld)' % (inp_fullfile,  buffer_len)
-                rio=_rb52odim.readRB5buf(inp_fullfile,rb5_buffer,long(buffer_len)) ## by BUFFER
-                this_obj=rio.object
-
-                if rio.objectType == _rave.Rave_ObjectType_PVOL:
-                    big_obj=compile_big_pvol(big_obj,this_obj,mb,iMEMBER)
-                else:
-                    big_obj=compile_big_scan(big_obj,this_obj,mb)
+    big_obj=_rb52odim.readRB5tarball(ifile, nthreads).object
 
     #auto output filename (as needed)
     if not ofile and not return_rio:
@@ -341,7 +473,7 @@ def combineRB5FromTarball(ifile, ofile, out_basedir=None, return_rio=False):
     container=_raveio.new()
     container.object=big_obj
     if out_fullfile:
-        container.save(out_fullfile)
+        saveRIO(container, out_fullfile)
     if return_rio:
         return container
 
@@ -422,7 +554,7 @@ def mergeOdimScans2Pvol(rio_arr, out_fullfile=None, return_rio=False, interval=N
     container=_raveio.new()
     container.object=pvol
     if out_fullfile:
-        container.save(out_fullfile)
+        saveRIO(container, out_fullfile)
     if return_rio:
         return container
 
@@ -57,9 +57,23 @@ PYRAVE_DEBUG_MODULE("_rb52odim");
  */
 static PyObject *ErrorObject;
 
+/**
+ * Verifies the first line of a borrowed RB5 buffer, which need not be NUL terminated
+ */
+static int _isRainbow5view(Py_buffer* view) {
+  char line_buf[MAX_STRING+1] = "";
+  char* line = line_buf;
+  size_t line_len = ((size_t)view->len < MAX_STRING) ? (size_t)view->len : MAX_STRING;
+
+  memcpy(line_buf, view->buf, line_len);
+  line_buf[line_len] = '\0';
+  return isRainbow5buf(&line);
+}
+
 /**
  * Verifies if buffer is of proper RB5 raw file contents that can be handled
- * @param[in] Buffer with the RB5 file contents
+ * @param[in] Buffer with the RB5 file contents: str, or any object with the buffer
+ *            interface (bytearray, memoryview, mmap), or a file-like object
  * @returns Python boolean True or False
  */
 static PyObject* _isRainbow5buf_func(PyObject* self, PyObject* args) {
@@ -81,6 +95,16 @@ static PyObject* _isRainbow5buf_func(PyObject* self, PyObject* args) {
     if (!isRainbow5buf(&rb5_buffer)) return PyBool_FromLong(1);  /* True */
     else return PyBool_FromLong(0);  /* False */
 
+  } else if (PyObject_CheckBuffer(obj) || PyObject_CheckReadBuffer(obj)) {
+    Py_buffer view;
+    if (!PyArg_ParseTuple(args, "s*", &view)) {
+        PyErr_Clear();
+        return PyBool_FromLong(0);  /* False */
+    }
+    int status = _isRainbow5view(&view);
+    PyBuffer_Release(&view);
+    return PyBool_FromLong(status == 0);
+
   } else if (PyObject_TypeCheck(obj, &PyBaseObject_Type)) {
     fprintf(stdout,"A Python Object was passed\n");
     result=PyObject_GetAttrString(obj, "name");
@@ -126,29 +150,165 @@ static PyObject* _isRainbow5_func(PyObject* self, PyObject* args) {
 }
 
 /**
- * Reads an RB5 buffer
- * @param[in] Buffer with the RB5 file contents
+ * Frees the strings of _strings_from_sequence()
+ * @param[in] String array, or NULL
+ * @param[in] Number of strings
+ */
+static void _free_strings(const char** strings, size_t n_strings) {
+  size_t i;
+
+  if (strings == NULL) return;
+  for (i = 0; i < n_strings; i++) {
+    char* string = (char*)strings[i];
+    RAVE_FREE(string);
+  }
+  RAVE_FREE(strings);
+}
+
+/**
+ * Copies a sequence of strings, its items may be temporaries (generators, custom __getitem__)
+ * @param[in] Python sequence of strings
+ * @param[in] TypeError message if it is not one
+ * @param[out] String array of copies, free with _free_strings()
+ * @param[out] Number of strings
+ * @returns 0 on success, -1 with a Python exception set
+ */
+static int _strings_from_sequence(PyObject* seq, const char* errmsg, const char*** strings, size_t* n_strings) {
+  Py_ssize_t i, n;
+
+  *strings = NULL;
+  *n_strings = 0;
+  if (!PySequence_Check(seq) || PyString_Check(seq)) {
+    Raise(PyExc_TypeError, errmsg);
+    return -1;
+  }
+  n = PySequence_Size(seq);
+  *strings = RAVE_MALLOC((n+1)*sizeof(const char*));
+  if (*strings == NULL) {
+    PyErr_NoMemory();
+    return -1;
+  }
+  for (i = 0; i < n; i++) {
+    PyObject* item = PySequence_GetItem(seq, i);
+    int is_string = (item != NULL && PyString_Check(item));
+    char* string = is_string ? RAVE_STRDUP(PyString_AsString(item)) : NULL;
+    Py_XDECREF(item);
+    if (string == NULL) {
+      _free_strings(*strings, (size_t)i);
+      *strings = NULL;
+      if (is_string) PyErr_NoMemory();
+      else Raise(PyExc_TypeError, errmsg);
+      return -1;
+    }
+    (*strings)[i] = string;
+  }
+  *n_strings = (size_t)n;
+  return 0;
+}
+
+/**
+ * Converts an optional sequence of ODIM quantity strings for getRaveIOQuantities()
+ * @param[in] Python sequence of strings, or NULL/None for all quantities
+ * @param[out] String array (NULL for all) of copies, free with _free_strings()
+ * @param[out] Number of strings
+ * @returns 0 on success, -1 with a Python exception set
+ */
+static int _quantities_from_sequence(PyObject* seq, const char*** quantities, size_t* n_quantities) {
+  *quantities = NULL;
+  *n_quantities = 0;
+  if (seq == NULL || seq == Py_None) {
+    return 0;
+  }
+  return _strings_from_sequence(seq, "quantities must be a list of strings", quantities, n_quantities);
+}
+
+/**
+ * Converts the optional slice subset arguments for getRaveIOSubset()
+ * @param[in] Python sequence of 0-based slice indices, or NULL/None
+ * @param[in] Python (min, max) elevation angle tuple in degrees, or NULL/None
+ * @param[in] Storage for the selection
+ * @param[out] The selection, or NULL for all slices
+ * @returns 0 on success, -1 with a Python exception set
+ */
+static int _slice_select_from_args(PyObject* slices, PyObject* angles, strRB5_SLICE_SELECT* select, strRB5_SLICE_SELECT** return_select) {
+  Py_ssize_t i, n;
+
+  *return_select = NULL;
+  memset(select, 0, sizeof(strRB5_SLICE_SELECT));
+  if (slices != NULL && slices != Py_None) {
+    if (!PySequence_Check(slices) || (n = PySequence_Size(slices)) <= 0 || n > MAX_SLICES) {
+      Raise(PyExc_ValueError, "slices must be a non-empty list of slice indices");
+      return -1;
+    }
+    for (i = 0; i < n; i++) {
+      PyObject* item = PySequence_GetItem(slices, i);
+      long islice = (item != NULL) ? PyInt_AsLong(item) : -1;
+      Py_XDECREF(item);
+      if (islice < 0) {
+        if (!PyErr_Occurred()) Raise(PyExc_ValueError, "slice indices must be >= 0");
+        return -1;
+      }
+      select->slice_arr[i] = (size_t)islice;
+    }
+    select->n_slices = (size_t)n;
+    *return_select = select;
+  } else if (angles != NULL && angles != Py_None) {
+    if (!PyArg_ParseTuple(angles, "ff", &select->angle_min_deg, &select->angle_max_deg)) {
+      return -1;
+    }
+    *return_select = select;
+  }
+  return 0;
+}
+
+/**
+ * Reads an RB5 buffer in place, without copying it
+ * @param[in] String naming the buffer, e.g. its file name
+ * @param[in] Buffer with the RB5 file contents, possibly gzipped: str, or any object with
+ *            the buffer interface (bytearray, memoryview, mmap)
+ * @param[in] Optional number of bytes to read, default (or -1) the whole buffer
+ * @param[in] Optional list of ODIM quantities to read, default all
+ * @param[in] Optional list of 0-based slice indices to read, default all
+ * @param[in] Optional (min, max) elevation angles of the slices to read, if no indices
  * @returns PyRave_IO object containing a PolarVolume_t or PolarScan_t
  */
 static PyObject* _readRB5buf_func(PyObject* self, PyObject* args) {
   const char* filename;
-  char* rb5_buffer;
-  Py_ssize_t ignore_count = 0;
-  Py_ssize_t buffer_len = 0;
+  Py_buffer view;
+  Py_ssize_t buffer_len = -1;
   PyRaveIO* result = NULL;
   RaveIO_t* raveio = NULL;
+  PyObject* pyquantities = NULL;
+  PyObject* pyslices = NULL;
+  PyObject* pyangles = NULL;
+  const char** quantities = NULL;
+  size_t n_quantities = 0;
+  strRB5_SLICE_SELECT select;
+  strRB5_SLICE_SELECT* slice_select = NULL;
 
-  if (!PyArg_ParseTuple(args, "ss#l", &filename, &rb5_buffer, &ignore_count, &buffer_len)) {
-    return Py_None;
+  if (!PyArg_ParseTuple(args, "ss*|lOOO", &filename, &view, &buffer_len, &pyquantities, &pyslices, &pyangles)) {
+    return NULL;
+  }
+  if ((buffer_len < 0) || (buffer_len > view.len)) buffer_len = view.len;
+  if (_slice_select_from_args(pyslices, pyangles, &select, &slice_select) != 0) {
+    PyBuffer_Release(&view);
+    return NULL;
+  }
+  if (_quantities_from_sequence(pyquantities, &quantities, &n_quantities) != 0) {
+    PyBuffer_Release(&view);
+    return NULL;
   }
- 
-  //Copy Python's buffer. Needed for close_rb5_info()'s free(rb5_info->buffer)
-  /* my_rb5_buffer is freed in xml_utils.c:close_file_buffer, so we can't 
-     allocate memory for it using RAVE_MALLOC */
-  char* my_rb5_buffer=malloc(sizeof(char)*(buffer_len));
-  memcpy(my_rb5_buffer,rb5_buffer,(size_t)buffer_len);
 
-  raveio = getRaveIObuf((char *)filename,&my_rb5_buffer,(size_t)buffer_len);
+  //Python's buffer is borrowed, the view keeps its object alive and unresized until released
+  char* rb5_buffer = (char*)view.buf;
+  raveio = getRaveIObufSubset((char *)filename,&rb5_buffer,(size_t)buffer_len,FILE_BUFFER_BORROWED,quantities,n_quantities,slice_select);
+  PyBuffer_Release(&view);
+  if (quantities != NULL || slice_select != NULL) {
+    _free_strings(quantities, n_quantities);
+    if (raveio == NULL) {
+      raiseException_returnNULL(PyExc_IOError, "None of the requested quantities or slices could be read");
+    }
+  }
   result = PyRaveIO_New(raveio);
   RAVE_OBJECT_RELEASE(raveio);
   if (result->raveio) return (PyObject*)result;
@@ -158,24 +318,740 @@ static PyObject* _readRB5buf_func(PyObject* self, PyObject* args) {
 /**
  * Reads an RB5 file
  * @param[in] String with the RB5 file name
+ * @param[in] Optional list of ODIM quantities to read, default all
+ * @param[in] Optional list of 0-based slice indices to read, default all
+ * @param[in] Optional (min, max) elevation angles of the slices to read, if no indices
  * @returns PyRave_IO object containing a PolarVolume_t or PolarScan_t
  */
 static PyObject* _readRB5_func(PyObject* self, PyObject* args) {
   const char* filename;
   PyRaveIO* result = NULL;
   RaveIO_t* raveio = NULL;
+  PyObject* pyquantities = NULL;
+  PyObject* pyslices = NULL;
+  PyObject* pyangles = NULL;
+  const char** quantities = NULL;
+  size_t n_quantities = 0;
+  strRB5_SLICE_SELECT select;
+  strRB5_SLICE_SELECT* slice_select = NULL;
 
-  if (!PyArg_ParseTuple(args, "s", &filename)) {
+  if (!PyArg_ParseTuple(args, "s|OOO", &filename, &pyquantities, &pyslices, &pyangles)) {
     return Py_None;
   }
+  if (_slice_select_from_args(pyslices, pyangles, &select, &slice_select) != 0) {
+    return NULL;
+  }
+  if (_quantities_from_sequence(pyquantities, &quantities, &n_quantities) != 0) {
+    return NULL;
+  }
 
-  raveio = getRaveIO(filename);
+  raveio = getRaveIOSubset(filename, quantities, n_quantities, slice_select);
+  if (quantities != NULL || slice_select != NULL) {
+    _free_strings(quantities, n_quantities);
+    if (raveio == NULL) {
+      raiseException_returnNULL(PyExc_IOError, "None of the requested quantities or slices could be read");
+    }
+  }
   result = PyRaveIO_New(raveio);
   RAVE_OBJECT_RELEASE(raveio);
   if (result->raveio) return (PyObject*)result;
   else return Py_None;
 }
 
+/**
+ * Reads the RB5 rawdata members of a tarball, possibly gzipped, merged into one object
+ * @param[in] String with the tarball file name
+ * @param[in] Optional number of decode threads, default 0 for one per online CPU
+ * @returns PyRave_IO object containing a PolarVolume_t or PolarScan_t
+ */
+static PyObject* _readRB5tarball_func(PyObject* self, PyObject* args) {
+  const char* filename;
+  int n_threads = 0;
+  PyRaveIO* result = NULL;
+  RaveIO_t* raveio = NULL;
+
+  if (!PyArg_ParseTuple(args, "s|i", &filename, &n_threads)) {
+    return NULL;
+  }
+  if (n_threads < 0) {
+    raiseException_returnNULL(PyExc_ValueError, "Number of decode threads must be >= 0");
+  }
+
+  raveio = getRaveIOTarball(filename, n_threads);
+  if (raveio == NULL) {
+    raiseException_returnNULL(PyExc_IOError, "Could not read the RB5 members of the tarball");
+  }
+  result = PyRaveIO_New(raveio);
+  RAVE_OBJECT_RELEASE(raveio);
+  return (PyObject*)result;
+}
+
+/**
+ * Reads an RB5 payload, possibly gzipped, from a file descriptor to its end, e.g. a pipe or
+ * stdin, as it arrives. The descriptor need not be seekable, and is left open.
+ * @param[in] File descriptor, e.g. sys.stdin.fileno()
+ * @param[in] Optional string naming the payload, default "-"
+ * @param[in] Optional list of ODIM quantities to read, default all
+ * @param[in] Optional list of 0-based slice indices to read, default all
+ * @param[in] Optional (min, max) elevation angles of the slices to read, if no indices
+ * @returns PyRave_IO object containing a PolarVolume_t or PolarScan_t
+ */
+static PyObject* _readRB5stream_func(PyObject* self, PyObject* args) {
+  int fd;
+  const char* filename = "-";
+  PyRaveIO* result = NULL;
+  RaveIO_t* raveio = NULL;
+  PyObject* pyquantities = NULL;
+  PyObject* pyslices = NULL;
+  PyObject* pyangles = NULL;
+  const char** quantities = NULL;
+  size_t n_quantities = 0;
+  strRB5_SLICE_SELECT select;
+  strRB5_SLICE_SELECT* slice_select = NULL;
+  strRB5_INFO rb5_info;
+  int status;
+
+  if (!PyArg_ParseTuple(args, "i|sOOO", &fd, &filename, &pyquantities, &pyslices, &pyangles)) {
+    return NULL;
+  }
+  if (_slice_select_from_args(pyslices, pyangles, &select, &slice_select) != 0) {
+    return NULL;
+  }
+  if (_quantities_from_sequence(pyquantities, &quantities, &n_quantities) != 0) {
+    return NULL;
+  }
+
+  //other Python threads run while this one waits on the stream, the objects are built with the GIL held
+  Py_BEGIN_ALLOW_THREADS
+  status = readRB5Stream(&rb5_info, fd, filename, quantities, n_quantities, slice_select);
+  Py_END_ALLOW_THREADS
+  if (status == EXIT_SUCCESS) {
+    raveio = getRaveIOStreamed(&rb5_info, quantities, n_quantities, slice_select);
+  }
+  _free_strings(quantities, n_quantities);
+  if (raveio == NULL) {
+    raiseException_returnNULL(PyExc_IOError, "Could not read an RB5 payload from the stream");
+  }
+  result = PyRaveIO_New(raveio);
+  RAVE_OBJECT_RELEASE(raveio);
+  return (PyObject*)result;
+}
+
+/**
+ * Reads only the metadata of an RB5 file, no blob is decoded
+ * @param[in] String with the RB5 file name
+ * @param[in] Optional boolean, True reads slice end times from the ray timestamps
+ *            (whole file), otherwise they are estimated from the antenna speed
+ *            and reading stops at the end of the XML header
+ * @returns Python dictionary describing the file, with a list of slice dictionaries
+ */
+static PyObject* _readRB5header_func(PyObject* self, PyObject* args) {
+  const char* filename;
+  int timestamps = 0;
+  strRB5_HEADER header;
+  PyObject* result = NULL;
+  PyObject* quantities = NULL;
+  PyObject* slices = NULL;
+  size_t i;
+
+  if (!PyArg_ParseTuple(args, "s|i", &filename, &timestamps)) {
+    return NULL;
+  }
+  if (read_rb5_header((char *)filename, timestamps ? RB5_HEADER_TIMESTAMPS : RB5_HEADER_ONLY, &header) != EXIT_SUCCESS) {
+    raiseException_returnNULL(PyExc_IOError, "Failed to read RB5 header");
+  }
+
+  quantities = PyList_New(0);
+  slices = PyList_New(0);
+  if (quantities == NULL || slices == NULL) goto fail;
+  for (i = 0; i < header.n_rawdatas; i++) {
+    PyObject* q = PyString_FromString(header.quantity_arr[i]);
+    if (q == NULL || PyList_Append(quantities, q) != 0) {
+      Py_XDECREF(q);
+      goto fail;
+    }
+    Py_DECREF(q);
+  }
+  for (i = 0; i < header.n_slices; i++) {
+    PyObject* slice = Py_BuildValue("{s:s,s:s,s:d,s:l,s:l,s:d,s:d,s:d,s:d}",
+                                    "startdatetime", header.slice_iso8601_bgn[i],
+                                    "enddatetime", header.slice_iso8601_end[i],
+                                    "elangle", (double)header.angle_deg_arr[i],
+                                    "nrays", (long)header.nrays[i],
+                                    "nbins", (long)header.nbins[i],
+                                    "rstart", (double)header.slice_bin_range_bgn_km[i],
+                                    "rscale", (double)header.slice_bin_range_res_km[i]*1000.,
+                                    "anglestep", (double)header.slice_ray_angle_res_deg[i],
+                                    "antspeed", (double)header.slice_antspeed_deg_sec[i]);
+    if (slice == NULL || PyList_Append(slices, slice) != 0) {
+      Py_XDECREF(slice);
+      goto fail;
+    }
+    Py_DECREF(slice);
+  }
+  result = Py_BuildValue("{s:s,s:s,s:s,s:s,s:d,s:d,s:d,s:d,s:d,s:s,s:s,s:O,s:O}",
+                         "filename", header.inp_fullfile,
+                         "version", header.rainbow_version,
+                         "sensor_id", header.sensor_id,
+                         "sensor_name", header.sensor_name,
+                         "longitude", (double)header.sensor_lon_deg,
+                         "latitude", (double)header.sensor_lat_deg,
+                         "height", (double)header.sensor_alt_m,
+                         "wavelength", (double)header.sensor_wavelength_cm,
+                         "beamwidth", (double)header.sensor_beamwidth_deg,
+                         "scan_type", header.scan_type,
+                         "task", header.scan_name,
+                         "quantities", quantities,
+                         "slices", slices);
+fail:
+  Py_XDECREF(quantities);
+  Py_XDECREF(slices);
+  return result;
+}
+
+/**
+ * Name of the capsules holding a _lazy_handle*
+ */
+#define LAZY_CAPSULE_NAME "_rb52odim.lazy"
+
+/**
+ * A lazy payload, and the Python buffer it was read from (view.obj NULL if read from
+ * a file), held until the payload is closed so that its moments can be decoded later
+ */
+typedef struct {
+  strRB5_LAZY* lazy;
+  Py_buffer view;
+} _lazy_handle;
+
+static void _lazy_capsule_destructor(PyObject* capsule) {
+  _lazy_handle* handle = (_lazy_handle*)PyCapsule_GetPointer(capsule, LAZY_CAPSULE_NAME);
+  if (handle == NULL) return;
+  closeRaveIOLazy(handle->lazy);
+  if (handle->view.obj != NULL) PyBuffer_Release(&(handle->view));
+  RAVE_FREE(handle);
+}
+
+static strRB5_LAZY* _lazy_from_capsule(PyObject* capsule) {
+  _lazy_handle* handle = (_lazy_handle*)PyCapsule_GetPointer(capsule, LAZY_CAPSULE_NAME);
+  return (handle != NULL) ? handle->lazy : NULL;
+}
+
+/**
+ * Reads an RB5 file, leaving its moments undecoded until loadLazy()
+ * @param[in] String with the RB5 file name
+ * @param[in] Optional buffer with the RB5 file contents, possibly gzipped, read in place
+ *            instead of the file (str, bytearray, memoryview, mmap). It is referenced,
+ *            and a bytearray cannot be resized, until the handle is closed; an mmap
+ *            must not be closed before that.
+ * @returns Opaque handle, closed when garbage collected
+ */
+static PyObject* _readRB5lazy_func(PyObject* self, PyObject* args) {
+  const char* filename;
+  _lazy_handle* handle = NULL;
+  PyObject* capsule = NULL;
+
+  handle = RAVE_MALLOC(sizeof(_lazy_handle));
+  if (handle == NULL) {
+    return PyErr_NoMemory();
+  }
+  handle->lazy = NULL;
+  handle->view.obj = NULL;
+  if (!PyArg_ParseTuple(args, "s|s*", &filename, &(handle->view))) {
+    RAVE_FREE(handle);
+    return NULL;
+  }
+
+  if (handle->view.obj != NULL) {
+    char* rb5_buffer = (char*)handle->view.buf;
+    handle->lazy = getRaveIObufLazy(filename, &rb5_buffer, (size_t)handle->view.len, FILE_BUFFER_BORROWED);
+  } else {
+    handle->lazy = getRaveIOLazy(filename);
+  }
+  if (handle->lazy == NULL) {
+    if (handle->view.obj != NULL) PyBuffer_Release(&(handle->view));
+    RAVE_FREE(handle);
+    raiseException_returnNULL(PyExc_IOError, "Failed to read RB5 file");
+  }
+  capsule = PyCapsule_New(handle, LAZY_CAPSULE_NAME, _lazy_capsule_destructor);
+  if (capsule == NULL) {
+    closeRaveIOLazy(handle->lazy);
+    if (handle->view.obj != NULL) PyBuffer_Release(&(handle->view));
+    RAVE_FREE(handle);
+  }
+  return capsule;
+}
+
+/**
+ * Returns the payload of a readRB5lazy() handle, each moment in its scan once loaded
+ * @param[in] Handle from readRB5lazy()
+ * @returns PyRave_IO object containing a PolarVolume_t or PolarScan_t
+ */
+static PyObject* _getLazyRaveIO_func(PyObject* self, PyObject* args) {
+  PyObject* capsule = NULL;
+  strRB5_LAZY* lazy = NULL;
+
+  if (!PyArg_ParseTuple(args, "O", &capsule)) {
+    return NULL;
+  }
+  if ((lazy = _lazy_from_capsule(capsule)) == NULL) {
+    return NULL;
+  }
+  return (PyObject*)PyRaveIO_New(lazy->raveio);
+}
+
+/**
+ * Decodes the moments of a readRB5lazy() handle not decoded yet
+ * @param[in] Handle from readRB5lazy()
+ * @param[in] ODIM quantity string, or None for all
+ * @param[in] Scan index, or -1 (default) for all
+ * @returns Python integer, number of moments decoded by this call
+ */
+static PyObject* _loadLazy_func(PyObject* self, PyObject* args) {
+  PyObject* capsule = NULL;
+  strRB5_LAZY* lazy = NULL;
+  const char* quantity = NULL;
+  int this_slice = -1;
+  int n_loaded = 0;
+
+  if (!PyArg_ParseTuple(args, "O|zi", &capsule, &quantity, &this_slice)) {
+    return NULL;
+  }
+  if ((lazy = _lazy_from_capsule(capsule)) == NULL) {
+    return NULL;
+  }
+  n_loaded = loadLazyParams(lazy, quantity, this_slice);
+  if (n_loaded < 0) {
+    raiseException_returnNULL(PyExc_IOError, "Failed to decode RB5 moment");
+  }
+  return PyInt_FromLong(n_loaded);
+}
+
+/**
+ * Name of the capsules holding a strRB5_BATCH*
+ */
+#define BATCH_CAPSULE_NAME "_rb52odim.batch"
+
+static void _batch_capsule_destructor(PyObject* capsule) {
+  strRB5_BATCH* batch = (strRB5_BATCH*)PyCapsule_GetPointer(capsule, BATCH_CAPSULE_NAME);
+  closeRB5Batch(batch);
+}
+
+/**
+ * Starts reading ahead a list of RB5 files, to be read in order with nextRB5batch()
+ * @param[in] List of RB5 file name strings, possibly gzipped
+ * @param[in] Optional number of files read ahead, default 0 for 8
+ * @returns Opaque handle, closed when garbage collected
+ */
+static PyObject* _openRB5batch_func(PyObject* self, PyObject* args) {
+  PyObject* pyfilenames = NULL;
+  int window = 0;
+  const char** filenames = NULL;
+  size_t n_filenames = 0;
+  strRB5_BATCH* batch = NULL;
+  PyObject* capsule = NULL;
+
+  if (!PyArg_ParseTuple(args, "O|i", &pyfilenames, &window)) {
+    return NULL;
+  }
+  if (window < 0) {
+    raiseException_returnNULL(PyExc_ValueError, "Number of files read ahead must be >= 0");
+  }
+  /* Copies held until openRB5Batch() has made its own, kept for the life of the batch */
+  if (_strings_from_sequence(pyfilenames, "filenames must be a list of strings", &filenames, &n_filenames) != 0) {
+    return NULL;
+  }
+
+  batch = openRB5Batch(filenames, n_filenames, (size_t)window);
+  _free_strings(filenames, n_filenames);
+  if (batch == NULL) {
+    return PyErr_NoMemory();
+  }
+  capsule = PyCapsule_New(batch, BATCH_CAPSULE_NAME, _batch_capsule_destructor);
+  if (capsule == NULL) {
+    closeRB5Batch(batch);
+  }
+  return capsule;
+}
+
+/**
+ * Reads the next file of an openRB5batch() handle
+ * @param[in] Handle from openRB5batch()
+ * @returns (index in the list, PyRave_IO object or None if the file could not be read),
+ *          or None once all files have been read
+ */
+static PyObject* _nextRB5batch_func(PyObject* self, PyObject* args) {
+  PyObject* capsule = NULL;
+  strRB5_BATCH* batch = NULL;
+  size_t idx = 0;
+  RaveIO_t* raveio = NULL;
+  PyObject* pyrio = NULL;
+
+  if (!PyArg_ParseTuple(args, "O", &capsule)) {
+    return NULL;
+  }
+  if ((batch = (strRB5_BATCH*)PyCapsule_GetPointer(capsule, BATCH_CAPSULE_NAME)) == NULL) {
+    return NULL;
+  }
+  if (nextRaveIOBatch(batch, &idx, &raveio) == 0) {
+    Py_RETURN_NONE;
+  }
+  if (raveio == NULL) {
+    return Py_BuildValue("(nO)", (Py_ssize_t)idx, Py_None);
+  }
+  pyrio = (PyObject*)PyRaveIO_New(raveio);
+  RAVE_OBJECT_RELEASE(raveio);
+  if (pyrio == NULL) {
+    return NULL;
+  }
+  return Py_BuildValue("(nN)", (Py_ssize_t)idx, pyrio);
+}
+
+/**
+ * Sets the number of threads decoding the moments of each RB5 payload
+ * @param[in] Integer, 1 (default) decodes sequentially, 0 uses one thread per CPU
+ * @returns None
+ */
+static PyObject* _setDecodeThreads_func(PyObject* self, PyObject* args) {
+  int n_threads = 1;
+
+  if (!PyArg_ParseTuple(args, "i", &n_threads)) {
+    return NULL;
+  }
+  if (setDecodeThreads(n_threads) != EXIT_SUCCESS) {
+    raiseException_returnNULL(PyExc_ValueError, "Invalid number of decode threads");
+  }
+  Py_RETURN_NONE;
+}
+
+/**
+ * Returns the number of threads decoding the moments of each RB5 payload
+ * @returns Python integer
+ */
+static PyObject* _getDecodeThreads_func(PyObject* self, PyObject* args) {
+  if (!PyArg_ParseTuple(args, "")) {
+    return NULL;
+  }
+  return PyInt_FromLong(getDecodeThreads());
+}
+
+/**
+ * Publishes the scan or volume of a RaveIO object in POSIX shared memory, as RaveIO_save()
+ * would write it to a file
+ * @param[in] PyRave_IO object containing a PolarVolume_t or PolarScan_t
+ * @param[in] String with the shared memory name, e.g. "/rb5vol"
+ * @returns None, IOError if it could not be published
+ */
+static PyObject* _saveRB5shm_func(PyObject* self, PyObject* args) {
+  PyObject* pyraveio = NULL;
+  const char* shm_name;
+
+  if (!PyArg_ParseTuple(args, "Os", &pyraveio, &shm_name)) {
+    return NULL;
+  }
+  if (!PyRaveIO_Check(pyraveio)) {
+    raiseException_returnNULL(PyExc_TypeError, "Expected a RaveIO object");
+  }
+  if (!saveRaveIOShm(((PyRaveIO*)pyraveio)->raveio, shm_name)) {
+    raiseException_returnNULL(PyExc_IOError, "Could not publish to shared memory");
+  }
+  Py_RETURN_NONE;
+}
+
+/**
+ * Name of the capsules holding a strRB5_SHM*, the base of the arrays mapped by readRB5shm()
+ */
+#define SHM_CAPSULE_NAME "_rb52odim.shm"
+
+static void _shm_capsule_destructor(PyObject* capsule) {
+  strRB5_SHM* shm = (strRB5_SHM*)PyCapsule_GetPointer(capsule, SHM_CAPSULE_NAME);
+  if (shm == NULL) return;
+  close_shm_segment(shm);
+  RAVE_FREE(shm);
+}
+
+/**
+ * Read-only numpy array over bytes of the segment, keeping it mapped while it lives
+ */
+static PyObject* _shm_array(PyObject* capsule, const void* data, int nd, npy_intp* dims, int typechar) {
+  PyArray_Descr* descr = PyArray_DescrFromType(typechar);
+  if (descr == NULL || data == NULL) {
+    Py_XDECREF(descr);
+    raiseException_returnNULL(PyExc_IOError, "Shared memory array out of bounds or of unknown type");
+  }
+  PyObject* array = PyArray_NewFromDescr(&PyArray_Type, descr, nd, dims, NULL, (void*)data,
+                                         NPY_ARRAY_C_CONTIGUOUS | NPY_ARRAY_ALIGNED, NULL);
+  if (array == NULL) return NULL;
+  Py_INCREF(capsule);
+  if (PyArray_SetBaseObject((PyArrayObject*)array, capsule) != 0) {
+    Py_DECREF(array);
+    return NULL;
+  }
+  return array;
+}
+
+/**
+ * Dictionary of the attributes of one object, arrays mapped in place
+ */
+static PyObject* _shm_attributes(strRB5_SHM* shm, PyObject* capsule, uint32_t first_attrib, uint32_t n_attribs) {
+  PyObject* attributes = PyDict_New();
+  uint32_t i;
+
+  for (i = first_attrib; (attributes != NULL) && (i < first_attrib+n_attribs) && (i < shm->header->n_attribs); i++) {
+    const strRB5_SHM_ATTRIB* attrib = &(shm->attrib_arr[i]);
+    npy_intp dims[1] = {(npy_intp)attrib->n_values};
+    PyObject* value = NULL;
+    switch (attrib->format) {
+    case RB5_SHM_ATTRIB_STRING:
+      value = (get_shm_data(shm, attrib->value_offset, attrib->n_values) == NULL || attrib->n_values == 0) ? NULL :
+              PyString_FromStringAndSize(shm->segment+attrib->value_offset, (Py_ssize_t)strnlen(shm->segment+attrib->value_offset, attrib->n_values));
+      break;
+    case RB5_SHM_ATTRIB_LONG:
+      value = PyLong_FromLongLong((long long)attrib->lvalue);
+      break;
+    case RB5_SHM_ATTRIB_DOUBLE:
+      value = PyFloat_FromDouble(attrib->dvalue);
+      break;
+    case RB5_SHM_ATTRIB_LONG_ARRAY:
+      value = _shm_array(capsule, get_shm_data(shm, attrib->value_offset, (uint64_t)attrib->n_values*sizeof(int64_t)), 1, dims, NPY_INT64);
+      break;
+    case RB5_SHM_ATTRIB_DOUBLE_ARRAY:
+      value = _shm_array(capsule, get_shm_data(shm, attrib->value_offset, (uint64_t)attrib->n_values*sizeof(double)), 1, dims, NPY_DOUBLE);
+      break;
+    default:
+      continue;
+    }
+    if (value == NULL || PyDict_SetItemString(attributes, attrib->name, value) != 0) {
+      Py_XDECREF(value);
+      Py_DECREF(attributes);
+      return NULL;
+    }
+    Py_DECREF(value);
+  }
+  return attributes;
+}
+
+/**
+ * Maps a scan or volume published by saveRB5shm(), without copying its moments
+ * @param[in] String with the shared memory name
+ * @returns Python dictionary with the top level what/where metadata, "attributes" and
+ *          "scans", a list of scan dictionaries each with its geometry, "attributes" and
+ *          "moments", a dictionary of moment dictionaries by ODIM quantity. Moment data and
+ *          array attributes are read-only numpy arrays over the segment, which stays mapped
+ *          as long as any of them lives.
+ */
+static PyObject* _readRB5shm_func(PyObject* self, PyObject* args) {
+  const char* shm_name;
+  strRB5_SHM* shm = NULL;
+  PyObject* capsule = NULL;
+  PyObject* attributes = NULL;
+  PyObject* scans = NULL;
+  PyObject* result = NULL;
+  uint32_t i, j;
+
+  if (!PyArg_ParseTuple(args, "s", &shm_name)) {
+    return NULL;
+  }
+  shm = RAVE_MALLOC(sizeof(strRB5_SHM));
+  if (shm == NULL) {
+    return PyErr_NoMemory();
+  }
+  if (open_shm_segment(shm_name, shm) != EXIT_SUCCESS) {
+    RAVE_FREE(shm);
+    raiseException_returnNULL(PyExc_IOError, "Could not map shared memory");
+  }
+  capsule = PyCapsule_New(shm, SHM_CAPSULE_NAME, _shm_capsule_destructor);
+  if (capsule == NULL) {
+    close_shm_segment(shm);
+    RAVE_FREE(shm);
+    return NULL;
+  }
+
+  const strRB5_SHM_HEADER* header = shm->header;
+  attributes = _shm_attributes(shm, capsule, 0, header->n_attribs_top);
+  scans = PyList_New(0);
+  if (attributes == NULL || scans == NULL) goto fail;
+  for (i = 0; i < header->n_scans; i++) {
+    const strRB5_SHM_SCAN* scan = &(shm->scan_arr[i]);
+    PyObject* moments = PyDict_New();
+    PyObject* scan_attributes = _shm_attributes(shm, capsule, scan->first_attrib, scan->n_attribs);
+    PyObject* pyscan = NULL;
+    for (j = scan->first_moment; (moments != NULL) && (scan_attributes != NULL) && (j < scan->first_moment+scan->n_moments) && (j < header->n_moments); j++) {
+      const strRB5_SHM_MOMENT* moment = &(shm->moment_arr[j]);
+      npy_intp dims[2] = {(npy_intp)moment->nrays, (npy_intp)moment->nbins};
+      PyObject* data = _shm_array(capsule, get_shm_data(shm, moment->data_offset, moment->data_bytes), 2, dims, moment->typecode[0]);
+      PyObject* moment_attributes = _shm_attributes(shm, capsule, moment->first_attrib, moment->n_attribs);
+      PyObject* pymoment = (data == NULL || moment_attributes == NULL) ? NULL :
+          Py_BuildValue("{s:d,s:d,s:d,s:d,s:O,s:O}",
+                        "gain", moment->gain,
+                        "offset", moment->offset,
+                        "nodata", moment->nodata,
+                        "undetect", moment->undetect,
+                        "attributes", moment_attributes,
+                        "data", data);
+      Py_XDECREF(data);
+      Py_XDECREF(moment_attributes);
+      if (pymoment == NULL || PyDict_SetItemString(moments, moment->quantity, pymoment) != 0) {
+        Py_XDECREF(pymoment);
+        Py_CLEAR(moments);
+        break;
+      }
+      Py_DECREF(pymoment);
+    }
+    if (moments != NULL && scan_attributes != NULL) {
+      pyscan = Py_BuildValue("{s:s,s:s,s:s,s:s,s:d,s:d,s:d,s:L,s:l,s:l,s:O,s:O}",
+                             "startdate", scan->startdate,
+                             "starttime", scan->starttime,
+                             "enddate", scan->enddate,
+                             "endtime", scan->endtime,
+                             "elangle", scan->elangle,
+                             "rstart", scan->rstart,
+                             "rscale", scan->rscale,
+                             "a1gate", (long long)scan->a1gate,
+                             "nrays", (long)scan->nrays,
+                             "nbins", (long)scan->nbins,
+                             "attributes", scan_attributes,
+                             "moments", moments);
+    }
+    Py_XDECREF(moments);
+    Py_XDECREF(scan_attributes);
+    if (pyscan == NULL || PyList_Append(scans, pyscan) != 0) {
+      Py_XDECREF(pyscan);
+      goto fail;
+    }
+    Py_DECREF(pyscan);
+  }
+  result = Py_BuildValue("{s:s,s:s,s:s,s:s,s:d,s:d,s:d,s:d,s:O,s:O}",
+                         "object_type", (header->object_type == RB5_SHM_PVOL) ? "PVOL" : "SCAN",
+                         "date", header->date,
+                         "time", header->time,
+                         "source", header->source,
+                         "longitude", header->longitude,
+                         "latitude", header->latitude,
+                         "height", header->height,
+                         "beamwidth", header->beamwidth,
+                         "attributes", attributes,
+                         "scans", scans);
+fail:
+  Py_XDECREF(attributes);
+  Py_XDECREF(scans);
+  Py_DECREF(capsule); /* the arrays hold it from here on, unmapped after the last one */
+  return result;
+}
+
+/**
+ * Removes a shared memory name, the segment goes once no process has it mapped
+ * @param[in] String with the shared memory name
+ * @returns None, IOError if there is no such name
+ */
+static PyObject* _unlinkRB5shm_func(PyObject* self, PyObject* args) {
+  const char* shm_name;
+
+  if (!PyArg_ParseTuple(args, "s", &shm_name)) {
+    return NULL;
+  }
+  if (unlink_shm_segment(shm_name) != EXIT_SUCCESS) {
+    raiseException_returnNULL(PyExc_IOError, "Could not unlink shared memory");
+  }
+  Py_RETURN_NONE;
+}
+
+/**
+ * Caches decoded RB5 files in a directory, full reads (no quantities or slices) of an
+ * unchanged file then map them back from there instead of decoding them again
+ * @param[in] String with the cache directory, created if need be, or None to turn the cache off
+ * @param[in] Optional cache size in bytes, the least recently used entries are evicted beyond it, default 0 for 4 GiB
+ * @returns None, IOError if the directory could not be created
+ */
+static PyObject* _setCache_func(PyObject* self, PyObject* args) {
+  const char* cache_dir = NULL;
+  PY_LONG_LONG max_bytes = 0;
+
+  if (!PyArg_ParseTuple(args, "z|L", &cache_dir, &max_bytes)) {
+    return NULL;
+  }
+  if (max_bytes < 0) {
+    raiseException_returnNULL(PyExc_ValueError, "Cache size must be >= 0");
+  }
+  if (setRB5Cache(cache_dir, (uint64_t)max_bytes) != EXIT_SUCCESS) {
+    raiseException_returnNULL(PyExc_IOError, "Could not use cache directory");
+  }
+  Py_RETURN_NONE;
+}
+
+/**
+ * Returns the cache directory and size
+ * @returns Python tuple (directory or None while the cache is off, size in bytes)
+ */
+static PyObject* _getCache_func(PyObject* self, PyObject* args) {
+  uint64_t max_bytes = 0;
+
+  if (!PyArg_ParseTuple(args, "")) {
+    return NULL;
+  }
+  const char* cache_dir = getRB5Cache(&max_bytes);
+  return Py_BuildValue("(zK)", cache_dir, (unsigned PY_LONG_LONG)max_bytes);
+}
+
+/**
+ * Lists the entries of a cache directory, least recently used first
+ * @param[in] String with the cache directory
+ * @returns Python list of dictionaries: the input file's "path", "size", "mtime" and "crc32"
+ *          (of its contents when stored), the entry's "bytes", its last use "used", and "stale"
+ *          if the input is gone, or its inode, size, mtime or ctime changed since
+ */
+static PyObject* _listRB5cache_func(PyObject* self, PyObject* args) {
+  const char* cache_dir;
+  strRB5_CACHE_ITEM* items = NULL;
+  size_t n_items = 0, i;
+
+  if (!PyArg_ParseTuple(args, "s", &cache_dir)) {
+    return NULL;
+  }
+  if (list_cache(cache_dir, &items, &n_items) != EXIT_SUCCESS) {
+    raiseException_returnNULL(PyExc_IOError, "Could not list cache directory");
+  }
+  PyObject* result = PyList_New(0);
+  for (i = 0; (result != NULL) && (i < n_items); i++) {
+    const strRB5_CACHE_ITEM* item = &(items[i]);
+    PyObject* entry = Py_BuildValue("{s:s,s:K,s:d,s:k,s:K,s:L,s:O}",
+                                    "path", item->key.path,
+                                    "size", (unsigned PY_LONG_LONG)item->key.file_bytes,
+                                    "mtime", (double)item->key.mtime_sec+1.0e-9*item->key.mtime_nsec,
+                                    "crc32", (unsigned long)item->key.crc32,
+                                    "bytes", (unsigned PY_LONG_LONG)item->entry_bytes,
+                                    "used", (PY_LONG_LONG)item->used_sec,
+                                    "stale", item->stale ? Py_True : Py_False);
+    if (entry == NULL || PyList_Append(result, entry) != 0) {
+      Py_CLEAR(result);
+    }
+    Py_XDECREF(entry);
+  }
+  if (items != NULL) free(items);
+  return result;
+}
+
+/**
+ * Evicts the least recently used entries of a cache directory
+ * @param[in] String with the cache directory
+ * @param[in] Size in bytes to shrink the cache to, 0 to empty it
+ * @returns Python integer, the number of entries evicted
+ */
+static PyObject* _evictRB5cache_func(PyObject* self, PyObject* args) {
+  const char* cache_dir;
+  PY_LONG_LONG max_bytes = 0;
+  size_t n_evicted = 0;
+
+  if (!PyArg_ParseTuple(args, "sL", &cache_dir, &max_bytes)) {
+    return NULL;
+  }
+  if (max_bytes < 0) {
+    raiseException_returnNULL(PyExc_ValueError, "Cache size must be >= 0");
+  }
+  if (evict_cache(cache_dir, (uint64_t)max_bytes, &n_evicted, NULL) != EXIT_SUCCESS) {
+    raiseException_returnNULL(PyExc_IOError, "Could not evict from cache directory");
+  }
+  return PyInt_FromSize_t(n_evicted);
+}
 
 static struct PyMethodDef _rb52odim_functions[] =
 {
@@ -183,6 +1059,23 @@ static struct PyMethodDef _rb52odim_functions[] =
   { "isRainbow5",    (PyCFunction) _isRainbow5_func,    METH_VARARGS },
   { "readRB5buf",    (PyCFunction) _readRB5buf_func,    METH_VARARGS },
   { "readRB5",       (PyCFunction) _readRB5_func,       METH_VARARGS },
+  { "readRB5tarball", (PyCFunction) _readRB5tarball_func, METH_VARARGS },
+  { "readRB5stream", (PyCFunction) _readRB5stream_func, METH_VARARGS },
+  { "readRB5header", (PyCFunction) _readRB5header_func, METH_VARARGS },
+  { "readRB5lazy",   (PyCFunction) _readRB5lazy_func,   METH_VARARGS },
+  { "getLazyRaveIO", (PyCFunction) _getLazyRaveIO_func, METH_VARARGS },
+  { "loadLazy",      (PyCFunction) _loadLazy_func,      METH_VARARGS },
+  { "openRB5batch",  (PyCFunction) _openRB5batch_func,  METH_VARARGS },
+  { "nextRB5batch",  (PyCFunction) _nextRB5batch_func,  METH_VARARGS },
+  { "saveRB5shm",    (PyCFunction) _saveRB5shm_func,    METH_VARARGS },
+  { "readRB5shm",    (PyCFunction) _readRB5shm_func,    METH_VARARGS },
+  { "unlinkRB5shm",  (PyCFunction) _unlinkRB5shm_func,  METH_VARARGS },
+  { "setCache",      (PyCFunction) _setCache_func,      METH_VARARGS },
+  { "getCache",      (PyCFunction) _getCache_func,      METH_VARARGS },
+  { "listRB5cache",  (PyCFunction) _listRB5cache_func,  METH_VARARGS },
+  { "evictRB5cache", (PyCFunction) _evictRB5cache_func, METH_VARARGS },
+  { "setDecodeThreads", (PyCFunction) _setDecodeThreads_func, METH_VARARGS },
+  { "getDecodeThreads", (PyCFunction) _getDecodeThreads_func, METH_VARARGS },
   { NULL, NULL }
 };
 
@@ -201,6 +1094,7 @@ PyMODINIT_FUNC init_rb52odim(void)
   }
   import_pyraveio();
   import_array(); /*To make sure I get access to numpy*/
+  Py_AtExit(inflate_pool_drain);
   PYRAVE_DEBUG_INITIALIZE;
 }
 
@@ -16,474 +16,1799 @@
  */
 
 #include "rave_alloc.h"
+#include <errno.h> //for read_rb5_stream()
 
 #include "time_utils.h"
 #include "xml_utils.h"
+#include "byteswap_utils.h"
+#include "inflate_utils.h"
 #include "rb5_utils.h"
 
 //#############################################################################
 
-size_t uncompress_this_blob(unsigned char *buf, unsigned char** return_uncompressed_blob, size_t compressed_size_blob) {
+size_t uncompress_this_blob(const unsigned char *buf, unsigned char** return_uncompressed_blob, size_t compressed_size_blob) {
+    // output comes from the inflate pool, release with inflate_pool_free()
 
+    *return_uncompressed_blob=NULL;
+    if(compressed_size_blob < 4) {
+      fprintf(stderr,"zlib error: blob too short (%ld bytes)\n", compressed_size_blob);
+      return(0);
+    }
+
+    size_t expectedSize=(buf[0] << 24) |
+                        (buf[1] << 16) |
+                        (buf[2] <<  8) |
+                        (buf[3]      );
+
+    unsigned char *uncompressed_blob=(unsigned char *)inflate_pool_alloc(expectedSize);
+    if (uncompressed_blob == NULL) return(0);
+
+    size_t uncompressed_size_blob=inflate_blob(buf+4,compressed_size_blob-4,uncompressed_blob,expectedSize);
+    
+    *return_uncompressed_blob=uncompressed_blob;
+    return(uncompressed_size_blob);
+}
+
+//#############################################################################
+
+int load_rb5_blobspace(strRB5_INFO *rb5_info) {
+    // second phase of a header-first read: brings in the rest of the file, no-op once it is there
+    // or if the file is mapped
+
+    if(!rb5_info->blobspace_pending) return(EXIT_SUCCESS);
+    size_t buffer_len=read_file_rest_2_buffer(rb5_info->inp_fullfile,&(rb5_info->buffer),rb5_info->buffer_len);
+    if(buffer_len == 0) {
+        fprintf(stderr,"Error: cannot read the BLOBs of file = %s\n",rb5_info->inp_fullfile);
+        return(EXIT_FAILURE);
+    }
+    rb5_info->buffer_len=buffer_len;
+    rb5_info->blobspace_pending=0;
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+static int parse_rb5_blob_attrib(const char *BLOB_line, const char *name, size_t *return_val) {
+    // the unsigned decimal value of <BLOB name="...">, EXIT_FAILURE if missing, signed or out of range
+
+    char *attrib=strstr(BLOB_line,name);
+    if(attrib == NULL) return(EXIT_FAILURE);
+    attrib+=strlen(name);
+    if((*attrib < '0') || (*attrib > '9')) return(EXIT_FAILURE); //strtoul() takes "-1"
+    char *attrib_end=NULL;
+    errno=0;
+    unsigned long val=strtoul(attrib,&attrib_end,10);
+    if((errno != 0) || (*attrib_end != '"') || (val > (unsigned long)SIZE_MAX/2)) return(EXIT_FAILURE);
+    *return_val=(size_t)val;
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+static int compare_rb5_blobs(const void *a, const void *b){
+    // by blobid, then by position, so that the first of duplicate blobids is found
+
+    const strRB5_BLOB_INFO *blob_a=(const strRB5_BLOB_INFO *)a;
+    const strRB5_BLOB_INFO *blob_b=(const strRB5_BLOB_INFO *)b;
+    if(blob_a->blobid != blob_b->blobid) return((blob_a->blobid > blob_b->blobid) ? 1 : -1);
+    return((blob_a->byte_offset > blob_b->byte_offset) - (blob_a->byte_offset < blob_b->byte_offset));
+}
+
+//#############################################################################
+
+void sort_rb5_blobs(strRB5_INFO *rb5_info) {
+    // once all blobs are indexed, for find_rb5_blob(); they are in file order until then
+
+    size_t i;
+    for (i = 1; i < rb5_info->n_blob_index; i++){
+        if(compare_rb5_blobs(&(rb5_info->blob_index[i-1]),&(rb5_info->blob_index[i])) > 0) break;
+    }
+    if(i < rb5_info->n_blob_index) qsort(rb5_info->blob_index,rb5_info->n_blob_index,sizeof(strRB5_BLOB_INFO),compare_rb5_blobs);
+}
+
+//#############################################################################
+
+static int index_rb5_blobs_part(strRB5_INFO *rb5_info, size_t *byte_offset_scan, size_t *n_alloc, int at_end) {
+    // indexes the blobs from *byte_offset_scan on, <BLOB blobid="N" size="S" compression="qt">\n + S bytes + \n</BLOB>\n
+    // unless at_end, more bytes are on their way: stops before the first incomplete blob,
+    // *byte_offset_scan being where to resume from once they are in
+
+    char bgn_BLOB[]="<BLOB ";
+    char BLOB_line[MAX_STRING]="\0";
+    char *blobspace=(rb5_info->buffer) + (*byte_offset_scan);
+    char *blobspace_end=(rb5_info->buffer) + (rb5_info->buffer_len);
+    char *BLOB_bgn=NULL;
+    char *BLOB_end=NULL;
+    size_t this_blobid;
+    size_t compressed_size_blob;
+    size_t byte_offset;
+
+    while((BLOB_bgn=find_in_buffer(blobspace,blobspace_end-blobspace,bgn_BLOB)) != NULL) {
+
+      BLOB_end=memchr(BLOB_bgn,'>',blobspace_end-BLOB_bgn);
+      if(!at_end && (BLOB_end == NULL) && (blobspace_end-BLOB_bgn < MAX_STRING)) break; //header not all in yet
+      if((BLOB_end == NULL) || (BLOB_end-BLOB_bgn+1 >= MAX_STRING)) {
+          fprintf(stderr,"Error while parsing BLOB header\n");
+          return(EXIT_FAILURE);
+      }
+      strncpy(BLOB_line,BLOB_bgn,BLOB_end-BLOB_bgn+1);
+      BLOB_line[BLOB_end-BLOB_bgn+1]='\0';
+      if(L_DEBUG_OUTPUT_1) fprintf(stdout,"%s\n", BLOB_line);
+
+      if(parse_rb5_blob_attrib(BLOB_line," blobid=\"",&this_blobid) != 0) {
+          fprintf(stderr,"Error while parsing BLOB header, no valid blobid : %s\n",BLOB_line);
+          return(EXIT_FAILURE);
+      }
+      if(parse_rb5_blob_attrib(BLOB_line," size=\"",&compressed_size_blob) != 0) {
+          fprintf(stderr,"Error while parsing BLOB header, no valid size : %s\n",BLOB_line);
+          return(EXIT_FAILURE);
+      }
+
+      //payload follows the header's trailing '\n'
+      char *payload=BLOB_end+1;
+      if(!at_end && (payload == blobspace_end)) break; //'\n' not in yet
+      if((payload < blobspace_end) && (*payload == '\n')) payload++;
+      if(compressed_size_blob > (size_t)(blobspace_end-payload)) {
+          if(!at_end) break; //payload not all in yet
+          fprintf(stderr,"Error: blobid = %ld truncated (size = %ld, %ld bytes left)\n",
+              this_blobid,compressed_size_blob,(size_t)(blobspace_end-payload));
+          return(EXIT_FAILURE);
+      }
+      blobspace=payload;
+      byte_offset=blobspace-(rb5_info->buffer);
+
+      //one entry per blob found, in file order, see sort_rb5_blobs()
+      if(rb5_info->n_blob_index == *n_alloc) {
+          size_t n_new=(*n_alloc == 0) ? 256 : 2*(*n_alloc);
+          strRB5_BLOB_INFO *new_index=(strRB5_BLOB_INFO *)RAVE_REALLOC(rb5_info->blob_index,n_new*sizeof(strRB5_BLOB_INFO));
+          if(new_index == NULL) {
+              fprintf(stderr,"Error: cannot allocate blob index\n");
+              return(EXIT_FAILURE);
+          }
+          rb5_info->blob_index=new_index;
+          *n_alloc=n_new;
+      }
+      strRB5_BLOB_INFO *blob_info=&(rb5_info->blob_index[rb5_info->n_blob_index++]);
+      blob_info->blobid=this_blobid;
+      blob_info->byte_offset=byte_offset;
+      blob_info->size_blob=compressed_size_blob;
+      blob_info->inflated=NULL;
+      blob_info->inflated_len=0;
+      if(L_DEBUG_OUTPUT_1) fprintf(stdout,"  blobid = %ld @ %ld (%ld bytes)\n",this_blobid,byte_offset,compressed_size_blob);
+
+      blobspace+=compressed_size_blob; //skip payload, trailing </BLOB> found by next search
+    } //while((BLOB_bgn=find_in_buffer(...)) != NULL) {
+
+    if(BLOB_bgn != NULL) {
+        *byte_offset_scan=BLOB_bgn-(rb5_info->buffer);
+    } else {
+        //a "<BLOB " cut short may straddle the end
+        size_t n_keep=strlen(bgn_BLOB)-1;
+        size_t n_left=blobspace_end-blobspace;
+        *byte_offset_scan=(blobspace-(rb5_info->buffer))+((n_left > n_keep) ? n_left-n_keep : 0);
+    }
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+int index_rb5_blobs(strRB5_INFO *rb5_info) {
+    // single pass over the blob space, see index_rb5_blobs_part()
+
+    size_t byte_offset_scan;
+    size_t n_alloc=0;
+
+    rb5_info->blob_index=NULL;
+    rb5_info->n_blob_index=0;
+    if(load_rb5_blobspace(&(*rb5_info)) != 0) return(EXIT_FAILURE); //header-first reads get their blobs here
+    if(rb5_info->byte_offset_blobspace >= rb5_info->buffer_len) return(EXIT_SUCCESS); //no blobs
+
+    byte_offset_scan=rb5_info->byte_offset_blobspace;
+    if(index_rb5_blobs_part(&(*rb5_info),&byte_offset_scan,&n_alloc,1) != 0) return(EXIT_FAILURE);
+    sort_rb5_blobs(&(*rb5_info));
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+static strRB5_BLOB_INFO *search_rb5_blobs(strRB5_BLOB_INFO *blob_arr, size_t n_blobs, size_t req_blobid) {
+    // binary search of blobs sorted by compare_rb5_blobs(), the first in the file of duplicate blobids
+
+    size_t lo=0;
+    size_t hi=n_blobs;
+    if(blob_arr == NULL) return(NULL);
+    while(lo < hi) {
+        size_t mid=lo+(hi-lo)/2;
+        if(blob_arr[mid].blobid < req_blobid) lo=mid+1;
+        else hi=mid;
+    }
+    if((lo == n_blobs) || (blob_arr[lo].blobid != req_blobid)) return(NULL);
+    return(&(blob_arr[lo]));
+}
+
+//#############################################################################
+
+strRB5_BLOB_INFO *find_rb5_blob(strRB5_INFO *rb5_info, size_t req_blobid) {
+
+    return(search_rb5_blobs(rb5_info->blob_index,rb5_info->n_blob_index,req_blobid));
+}
+
+//#############################################################################
+
+size_t get_blobid_buffer(strRB5_INFO *rb5_info, int req_blobid, unsigned char** return_uncompressed_blob) {
+
+    size_t EXIT_NULL_VAL=0;
+
+    const unsigned char *compressed_blob = NULL;
+    unsigned char *uncompressed_blob = NULL;
+    size_t compressed_size_blob;
+    size_t uncompressed_size_blob;
+
+    strRB5_BLOB_INFO *blob_info=find_rb5_blob(rb5_info,req_blobid);
+    if(blob_info == NULL) {
+        fprintf(stdout,"ERROR: req_blobid = %d NOT FOUND!!!\n",req_blobid);
+        return(EXIT_NULL_VAL);
+    }
+
+    //inflate in place, straight from the file buffer
+    compressed_size_blob=blob_info->size_blob;
+    compressed_blob=(const unsigned char *)(rb5_info->buffer)+(blob_info->byte_offset);
+    if(L_DEBUG_OUTPUT_1) fprintf(stdout,"  compressed_size_blob = %ld\n",compressed_size_blob);
+    uncompressed_size_blob=uncompress_this_blob(compressed_blob, &uncompressed_blob, compressed_size_blob);
+    if(L_DEBUG_OUTPUT_1) fprintf(stdout,"uncompressed_size_blob = %ld\n",uncompressed_size_blob);
+
+    *return_uncompressed_blob=uncompressed_blob;
+    return(uncompressed_size_blob);
+}
+
+//#############################################################################
+
+void convert_raw_to_data(strRB5_PARAM_INFO *rb5_param, void **input_raw_arr, float **return_data_arr){
+
+    //local vars
+    RB5_CONVERSION conversion=rb5_param->conversion;
+    size_t n_elems_data    =rb5_param->n_elems_data;
+    size_t raw_binary_depth=rb5_param->raw_binary_depth;
+    size_t raw_binary_width=rb5_param->raw_binary_width;
+    float data_range_min   =rb5_param->data_range_min;
+    float data_range_max   =rb5_param->data_range_max;
+    float data_range_width =rb5_param->data_range_width;
+    float data_step        =rb5_param->data_step;
+    float NODATA_val=-99;
+
+    size_t i;
+    unsigned int *raw_arr=inflate_pool_alloc(n_elems_data*sizeof(unsigned int));
+    void *deref_input_raw_arr=*input_raw_arr;
+           if (raw_binary_depth ==  8){
+        uint8_t  *buffer_8 =((uint8_t  *)deref_input_raw_arr);
+        for (i = 0; i < n_elems_data; i++) raw_arr[i]=(unsigned int)buffer_8 [i];
+    } else if (raw_binary_depth == 16){
+        uint16_t *buffer_16=((uint16_t *)deref_input_raw_arr);
+        for (i = 0; i < n_elems_data; i++) raw_arr[i]=(unsigned int)buffer_16[i];
+    } else if (raw_binary_depth == 32){
+        uint32_t *buffer_32=((uint32_t *)deref_input_raw_arr);
+        for (i = 0; i < n_elems_data; i++) raw_arr[i]=(unsigned int)buffer_32[i];
+    }
+//fprintf(stdout,"### (%2ld) param=%s\n",raw_binary_depth,rb5_param->sparam);
+//for (i = 0; i < n_elems_data; i++) fprintf(stdout,"%d ",raw_arr[i]);
+//fprintf(stdout,"\n");
+
+    float *data_arr=NULL;
+    data_arr=RAVE_MALLOC(n_elems_data*sizeof(float));
+    if (conversion == RB5_CONV_COPY) {
+        for (i = 0; i < n_elems_data; i++) {
+          data_arr[i]=raw_arr[i];
+          if(L_DEBUG_OUTPUT_2) fprintf(stdout,"%f ",data_arr[i]);
+        }
+        if(L_DEBUG_OUTPUT_2) fprintf(stdout,"\n");
+        NODATA_val = 0;
+    } else if (conversion == RB5_CONV_ANGULAR) {
+        data_range_min=0.0;
+        data_range_max=360.0;
+        data_range_width=data_range_max-data_range_min;
+        data_step=data_range_width/raw_binary_width;
+        if(L_DEBUG_OUTPUT_1) fprintf(stdout,"  data_step = %f\n",data_step);
+        for (i = 0; i < (n_elems_data); i++) {
+          data_arr[i]=(raw_arr[i] * data_step) + data_range_min;
+          if(L_DEBUG_OUTPUT_2) fprintf(stdout,"%d ",raw_arr[i]);
+          if(L_DEBUG_OUTPUT_2) fprintf(stdout,"%f ",data_arr[i]);
+        }
+        if(L_DEBUG_OUTPUT_2) fprintf(stdout,"\n");
+        NODATA_val = (0 * data_step) - data_step + data_range_min;
+    } else {
+        //removed special param packing check, 2017-Mar-23
+        // we found KDP have variable data range!
+        // using rb5_param->data_range_min|max defaults (set in var declaration above)
+        //if (conversion == RB5_CONV_KDP) {
+        //    data_range_min=-20.0;
+        //    data_range_max=+20.0;
+        //} else if (conversion == RB5_CONV_PHIDP) {
+        //    data_range_min=  0.0;
+        //    data_range_max=360.0;
+        //}
+        data_range_width=data_range_max-data_range_min;
+        data_step=data_range_width/raw_binary_width;
+        if(L_DEBUG_OUTPUT_1) fprintf(stdout,"  data_step = %f\n",data_step);
+        for (i = 0; i < n_elems_data; i++) {
+          data_arr[i]=(raw_arr[i] * data_step) - data_step + data_range_min;
+          if(L_DEBUG_OUTPUT_2) fprintf(stdout,"%f ",data_arr[i]);
+        }
+        if(L_DEBUG_OUTPUT_2) fprintf(stdout,"\n");
+        NODATA_val = (0 * data_step) - data_step + data_range_min;
+    }
+    if(L_DEBUG_OUTPUT_1) fprintf(stdout,"  NODATA_val = %f\n",NODATA_val);
+
+    //update
+    rb5_param->data_range_min  =data_range_min;
+    rb5_param->data_range_max  =data_range_max;
+    rb5_param->data_range_width=data_range_width;
+    rb5_param->data_step       =data_step;
+    rb5_param->NODATA_val      =NODATA_val;
+
+    inflate_pool_free(raw_arr);
+    *return_data_arr=data_arr;
+}
+
+//#############################################################################
+
+static void swap_copy_be(void *dest_arr, const unsigned char *src, size_t n_elems, size_t data_bytesize){
+    // big-endian src to host order dest, vectorized where the CPU allows (see byteswap_utils.c)
+
+    if (data_bytesize == 1) {
+        memcpy(dest_arr,src,n_elems);
+    } else if (data_bytesize == 2) {
+        byteswap_copy_16(dest_arr,src,n_elems);
+    } else if (data_bytesize == 4) {
+        byteswap_copy_32(dest_arr,src,n_elems);
+    }
+}
+
+//#############################################################################
+
+static void scatter_swap_be(unsigned char *dest, size_t *i_dest, const unsigned char *src, size_t n_elems, size_t n_elems_data, size_t data_bytesize){
+    // byte-swap n_elems from src into dest at *i_dest, wrapping at n_elems_data
+
+    size_t n_run;
+    while (n_elems > 0) {
+      n_run=n_elems_data-(*i_dest);
+      if (n_run > n_elems) n_run=n_elems;
+      swap_copy_be(dest+(*i_dest)*data_bytesize,src,n_run,data_bytesize);
+      src+=n_run*data_bytesize;
+      n_elems-=n_run;
+      *i_dest+=n_run;
+      if (*i_dest == n_elems_data) *i_dest=0;
+    }
+}
+
+//#############################################################################
+
+size_t decode_param_blobid(strRB5_INFO *rb5_info, strRB5_PARAM_INFO* rb5_param, void *dest_arr){
+    // fused inflate -> byte-swap -> 0degN rotation, written straight into dest_arr
+    // (sized n_elems_data*data_bytesize), through a fixed scratch window
+    // (zlib backend), or one pooled whole-blob buffer (one-shot backends)
+
+    size_t EXIT_NULL_VAL=0;
+
+    //local vars
+    size_t blobid          =rb5_param->blobid;
+    size_t n_elems_data    =rb5_param->n_elems_data;
+    size_t data_bytesize   =rb5_param->data_bytesize;
+    unsigned char *dest    =(unsigned char *)dest_arr;
+
+    if ((data_bytesize != 1) && (data_bytesize != 2) && (data_bytesize != 4)) {
+      fprintf(stdout,"ERROR: blobid = %ld, unsupported raw_binary_depth = %ld\n",blobid,rb5_param->raw_binary_depth);
+      return(EXIT_NULL_VAL);
+    }
+
+    strRB5_BLOB_INFO *blob_info=find_rb5_blob(rb5_info,blobid);
+    if ((blob_info == NULL) || (blob_info->size_blob < 4)) {
+      fprintf(stdout,"ERROR: blobid = %ld NOT FOUND!!!\n",blobid);
+      return(EXIT_NULL_VAL);
+    }
+    const unsigned char *buf=(const unsigned char *)(rb5_info->buffer)+(blob_info->byte_offset);
     size_t expectedSize=(buf[0] << 24) |
                         (buf[1] << 16) |
                         (buf[2] <<  8) |
                         (buf[3]      );
+    if (expectedSize != n_elems_data*data_bytesize) {
+      fprintf(stdout,"  INCONSISTENT rb5_param->n_elems_data = %ld\n",n_elems_data);
+      fprintf(stdout,"  INCONSISTENT n_elems_data = %ld\n",expectedSize/data_bytesize);
+      return(EXIT_NULL_VAL);
+    }
+
+    //rays post 0-deg N go first, i.e. input element i lands at (i-p) modulo n
+    size_t p=0;
+    if (rb5_param->iray_0degN != -1) p=(rb5_param->iray_0degN)*(rb5_param->nbins); //handles 2-D data
+    if (p >= n_elems_data) p=0;
+    size_t i_dest=(p == 0) ? 0 : n_elems_data-p;
+
+    size_t carry=0;
+    size_t n_done=0;
+    int Z_result=Z_OK;
+
+    if (blob_info->inflated != NULL) {
+      //inflated already, as it came in, see read_rb5_stream()
+      if (blob_info->inflated_len == expectedSize) {
+        scatter_swap_be(dest,&i_dest,blob_info->inflated,n_elems_data,n_elems_data,data_bytesize);
+        n_done=n_elems_data;
+        Z_result=Z_STREAM_END;
+      }
+      //read once, the compressed blob is still there should it be needed again
+      RAVE_FREE(blob_info->inflated);
+      blob_info->inflated_len=0;
+    } else if (inflate_get_backend() != INFLATE_BACKEND_ZLIB) {
+      //one-shot backend (no streaming API), inflate whole then scatter
+      unsigned char *scratch=(unsigned char *)inflate_pool_alloc(expectedSize);
+      if (scratch == NULL) return(EXIT_NULL_VAL);
+      size_t n_bytes=inflate_blob(buf+4,blob_info->size_blob-4,scratch,expectedSize);
+      if (n_bytes == expectedSize) {
+        scatter_swap_be(dest,&i_dest,scratch,n_elems_data,n_elems_data,data_bytesize);
+        n_done=n_elems_data;
+        Z_result=Z_STREAM_END;
+      }
+      inflate_pool_free(scratch);
+    } else {
+      unsigned char window[INFLATE_WINDOW_BYTES];
+
+      //this thread's reusable z_stream
+      z_stream *strm=inflate_ctx_begin(buf+4,blob_info->size_blob-4);
+      if (strm == NULL) return(EXIT_NULL_VAL);
+
+      while (Z_result != Z_STREAM_END) {
+        strm->next_out=window+carry;
+        strm->avail_out=INFLATE_WINDOW_BYTES-carry;
+        Z_result=inflate(strm,Z_NO_FLUSH);
+        if ((Z_result != Z_OK) && (Z_result != Z_STREAM_END)) {
+          fprintf(stderr,"zlib error: %d\n", Z_result);
+          break;
+        }
+
+        size_t n_bytes=INFLATE_WINDOW_BYTES-strm->avail_out;
+        size_t n_elems=n_bytes/data_bytesize;
+        if (n_done+n_elems > n_elems_data) {
+          fprintf(stderr,"zlib error: blobid = %ld inflates past %ld elements\n",blobid,n_elems_data);
+          Z_result=Z_DATA_ERROR;
+          break;
+        }
+
+        scatter_swap_be(dest,&i_dest,window,n_elems,n_elems_data,data_bytesize);
+        n_done+=n_elems;
+
+        //keep any partial element for the next window
+        carry=n_bytes-n_elems*data_bytesize;
+        if (carry > 0) memmove(window,window+n_elems*data_bytesize,carry);
+      } //while (Z_result != Z_STREAM_END) {
+    } //if (inflate_get_backend() != INFLATE_BACKEND_ZLIB) {
+
+    if ((Z_result != Z_STREAM_END) || (n_done != n_elems_data) || (carry != 0)) {
+      fprintf(stdout,"  INCONSISTENT rb5_param->n_elems_data = %ld\n",n_elems_data);
+      fprintf(stdout,"  INCONSISTENT n_elems_data = %ld\n",n_done);
+      return(EXIT_NULL_VAL);
+    }
+
+    //update
+    rb5_param->size_blob=n_done*data_bytesize;
+
+    if(L_DEBUG_OUTPUT_1) fprintf(stdout,"  n_elems_data = %ld\n",n_done);
+    if(L_DEBUG_OUTPUT_1) dump_strRB5_PARAM_INFO(*rb5_param);
+
+    return(n_done);
+}
+
+//#############################################################################
+
+typedef struct{
+    strRB5_INFO *rb5_info;
+    strRB5_DECODE_TASK *tasks;
+    size_t n_tasks;
+    size_t next_task;
+    pthread_mutex_t mutex;
+} strRB5_DECODE_QUEUE;
+
+static void *decode_param_blobids_worker(void *arg){
+    // pull tasks until the queue is empty
+
+    strRB5_DECODE_QUEUE *queue=(strRB5_DECODE_QUEUE *)arg;
+    size_t this_task;
+
+    while (1) {
+      pthread_mutex_lock(&(queue->mutex));
+      this_task=queue->next_task++;
+      pthread_mutex_unlock(&(queue->mutex));
+      if (this_task >= queue->n_tasks) break;
+
+      strRB5_DECODE_TASK *task=&(queue->tasks[this_task]);
+      strRB5_INFO *rb5_info=(task->rb5_info != NULL) ? task->rb5_info : queue->rb5_info;
+      task->n_elems_data=decode_param_blobid(rb5_info, &(task->rb5_param), task->dest_arr);
+    }
+    return(NULL);
+}
+
+//#############################################################################
+
+size_t decode_param_blobids(strRB5_INFO *rb5_info, strRB5_DECODE_TASK *tasks, size_t n_tasks, int n_threads){
+    // decode_param_blobid() of every task, on up to n_threads (incl. the caller)
+    // each task owns its dest_arr, so results don't depend on scheduling
+    // tasks may come from several payloads, each naming its own rb5_info
+    // returns the number of tasks decoded OK
+
+    size_t n_ok=0;
+    size_t i;
+    int n_spawned=0;
+
+    if (n_threads < 1) n_threads=1;
+    if ((size_t)n_threads > n_tasks) n_threads=(int)n_tasks;
+
+    //settle lazily chosen kernels before any worker can race on them
+    byteswap_get_kernel();
+    inflate_get_backend();
+
+    strRB5_DECODE_QUEUE queue;
+    queue.rb5_info=rb5_info;
+    queue.tasks=tasks;
+    queue.n_tasks=n_tasks;
+    queue.next_task=0;
+    pthread_mutex_init(&(queue.mutex),NULL);
+
+    pthread_t *threads=NULL;
+    if (n_threads > 1) threads=(pthread_t *)RAVE_MALLOC((n_threads-1)*sizeof(pthread_t));
+    if (threads != NULL) {
+      for (n_spawned = 0; n_spawned < n_threads-1; n_spawned++) {
+        if (pthread_create(&threads[n_spawned],NULL,decode_param_blobids_worker,&queue) != 0) {
+          fprintf(stderr,"Warning: only %d decode threads started\n",n_spawned+1);
+          break;
+        }
+      }
+    }
+    decode_param_blobids_worker(&queue); //the caller works too
+    for (i = 0; i < (size_t)n_spawned; i++) pthread_join(threads[i],NULL);
+    if (threads != NULL) RAVE_FREE(threads);
+    pthread_mutex_destroy(&(queue.mutex));
+
+    for (i = 0; i < n_tasks; i++) if (tasks[i].n_elems_data != 0) n_ok++;
+    return(n_ok);
+}
+
+//#############################################################################
+
+size_t return_param_blobid_raw(strRB5_INFO *rb5_info, strRB5_PARAM_INFO* rb5_param, void **return_raw_arr){
+
+    size_t EXIT_NULL_VAL=0;
+
+    //one destination, filled by the fused decode
+    //from the inflate pool, release with inflate_pool_free()
+    void *raw_arr=inflate_pool_alloc(rb5_param->n_elems_data*rb5_param->data_bytesize);
+    if (raw_arr == NULL) {
+      fprintf(stdout,"ERROR: blobid = %ld cannot allocate %ld elements\n",rb5_param->blobid,rb5_param->n_elems_data);
+      return(EXIT_NULL_VAL);
+    }
+
+    size_t n_elems_data=decode_param_blobid(&(*rb5_info), &(*rb5_param), raw_arr);
+    if (n_elems_data == 0) {
+      inflate_pool_free(raw_arr);
+      return(EXIT_NULL_VAL);
+    }
+
+    *return_raw_arr=raw_arr;
+    return(n_elems_data);
+}
+
+//#############################################################################
+
+//known moments, ODIM quantities as per OPERA ODIM_H5 v2.2
+//URP types from /apps/urp/build/include/drpdecode.h, -1 for none
+typedef struct{
+    const char *sparam;
+    RB5_MOMENT_KIND kind;
+    RB5_CONVERSION conversion;
+    const char *quantity;
+    int urp_type;
+    const char *urp_name;
+    const char *urp_unit;
+    const char *urp_desc;
+} strRB5_MOMENT_DEF;
+
+static const strRB5_MOMENT_DEF rb5_moment_catalog[]={
+    {"dBuZ"         ,RB5_KIND_DBUZ         ,RB5_CONV_REG    ,"TH"           ,  1,"DBT"   ,"dBZ"   ,"Uncorrected Reflectivity"},
+    {"dBuZv"        ,RB5_KIND_DBUZV        ,RB5_CONV_REG    ,"TV"           , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"dBZ"          ,RB5_KIND_DBZ          ,RB5_CONV_REG    ,"DBZH"         ,  2,"DBZ"   ,"dBZ"   ,"Reflectivity"},
+    {"dBZv"         ,RB5_KIND_DBZV         ,RB5_CONV_REG    ,"DBZV"         , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"V"            ,RB5_KIND_V            ,RB5_CONV_REG    ,"VRADH"        ,  3,"VEL"   ,"m/s"   ,"Velocity"},
+    {"Vv"           ,RB5_KIND_VV           ,RB5_CONV_REG    ,"VRADV"        , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"W"            ,RB5_KIND_W            ,RB5_CONV_REG    ,"WRADH"        ,  4,"WID"   ,"m/s"   ,"Width"},
+    {"Wv"           ,RB5_KIND_WV           ,RB5_CONV_REG    ,"WRADV"        , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"SNR"          ,RB5_KIND_SNR          ,RB5_CONV_REG    ,"SNRH"         ,100,"SNR"   ,""      ,"Signal to Noise"},
+    {"SNRv"         ,RB5_KIND_SNRV         ,RB5_CONV_REG    ,"SNRV"         , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"SQI"          ,RB5_KIND_SQI          ,RB5_CONV_REG    ,"SQIH"         , 18,"SQI"   ,""      ,"Signal Quality Index"},
+    {"SQIv"         ,RB5_KIND_SQIV         ,RB5_CONV_REG    ,"SQIV"         , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"ZDR"          ,RB5_KIND_ZDR          ,RB5_CONV_REG    ,"ZDR"          ,  5,"ZDR"   ,"dB"    ,"Differential Reflectivity"},
+    {"RhoHV"        ,RB5_KIND_RHOHV        ,RB5_CONV_REG    ,"RHOHV"        , 19,"RHOHV" ,""      ,"Correlation Coefficient"},
+    {"uPhiDP"       ,RB5_KIND_UPHIDP       ,RB5_CONV_PHIDP  ,"UPHIDP"       ,216,"UPHIDP","deg"   ,"Uncorrected Differential Phase"}, //New URP decree 2017-Sep-12; was urp.type=16
+    {"PhiDP"        ,RB5_KIND_PHIDP        ,RB5_CONV_PHIDP  ,"PHIDP"        , 16,"PHIDP" ,"deg"   ,"Differential Phase"},
+    {"uKDP"         ,RB5_KIND_UKDP         ,RB5_CONV_KDP    ,"UKDP"         , 14,"UKDP"  ,"deg/km","Uncorrected Specific Differential Phase"},
+    {"KDP"          ,RB5_KIND_KDP          ,RB5_CONV_KDP    ,"KDP"          , 14,"KDP"   ,"deg/km","Specific Differential Phase"},
+    {"dataflag"     ,RB5_KIND_DATAFLAG     ,RB5_CONV_COPY   ,"DATAFLAG"     , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"startangle"   ,RB5_KIND_STARTANGLE   ,RB5_CONV_ANGULAR,"STARTANGLE"   , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"stopangle"    ,RB5_KIND_STOPANGLE    ,RB5_CONV_ANGULAR,"STOPANGLE"    , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"startfixangle",RB5_KIND_STARTFIXANGLE,RB5_CONV_ANGULAR,"STARTFIXANGLE", -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"stopfixangle" ,RB5_KIND_STOPFIXANGLE ,RB5_CONV_ANGULAR,"STOPFIXANGLE" , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"numpulses"    ,RB5_KIND_NUMPULSES    ,RB5_CONV_COPY   ,"NUMPULSES"    , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"timestamp"    ,RB5_KIND_TIMESTAMP    ,RB5_CONV_COPY   ,"TIMESTAMP"    , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"txpower"      ,RB5_KIND_TXPOWER      ,RB5_CONV_COPY   ,"TXPOWER"      , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"noisepowerh"  ,RB5_KIND_NOISEPOWERH  ,RB5_CONV_COPY   ,"NOISEPOWERH"  , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {"noisepowerv"  ,RB5_KIND_NOISEPOWERV  ,RB5_CONV_COPY   ,"NOISEPOWERV"  , -1,"n/a"   ,"n/a"   ,"n/a"},
+    {NULL           ,RB5_KIND_UNKNOWN      ,RB5_CONV_REG    ,NULL           , -1,"n/a"   ,"n/a"   ,"n/a"}
+};
+
+//#############################################################################
+
+static const strRB5_MOMENT_DEF *find_rb5_moment_def(RB5_MOMENT_KIND kind){
+    // catalog entry of kind, the terminating one for RB5_KIND_UNKNOWN
+
+    size_t i;
+    for (i = 0; rb5_moment_catalog[i].sparam != NULL; i++){
+        if(rb5_moment_catalog[i].kind == kind) break;
+    }
+    return(&(rb5_moment_catalog[i]));
+}
+
+//#############################################################################
+
+RB5_MOMENT_KIND get_rb5_moment_kind(const char *sparam){
+
+    size_t i;
+    for (i = 0; rb5_moment_catalog[i].sparam != NULL; i++){
+        if(strcmp(sparam,rb5_moment_catalog[i].sparam) == 0) break;
+    }
+    return(rb5_moment_catalog[i].kind);
+}
+
+//#############################################################################
+
+RB5_CONVERSION get_rb5_conversion(RB5_MOMENT_KIND kind){
+
+    return(find_rb5_moment_def(kind)->conversion);
+}
+
+//#############################################################################
+
+const char *get_rb5_conversion_name(RB5_CONVERSION conversion){
+
+    switch(conversion){
+        case RB5_CONV_COPY:    return("copy");
+        case RB5_CONV_ANGULAR: return("angular");
+        case RB5_CONV_PHIDP:   return("phidp_data");
+        case RB5_CONV_KDP:     return("kdp_data");
+        default:               return("reg_data");
+    }
+}
+
+//#############################################################################
+
+char *map_rb5_to_h5_param(const char *sparam){
+    // known moments from the catalog, others upper-cased
+
+  static char return_string[MAX_STRING]="\0";
+
+    const strRB5_MOMENT_DEF *def=find_rb5_moment_def(get_rb5_moment_kind(sparam));
+    if(def->quantity != NULL) {
+        snprintf(return_string,MAX_STRING,"%s",def->quantity);
+    } else {
+        snprintf(return_string,MAX_STRING,"%s",sparam);
+        int i;
+        for(i=0;i<strlen(return_string);i++){
+            return_string[i]=toupper(return_string[i]);
+        }
+    }
+    return(return_string);
+
+}
+
+//#############################################################################
+
+size_t select_rb5_rawdatas(strRB5_INFO *rb5_info, const char **quantities, size_t n_quantities){
+    // keeps only the <rawdata> moments whose ODIM quantity, as per map_rb5_to_h5_param(), is requested
+    // quantities == NULL keeps all, returns the number of moments kept
+
+    size_t n_selected=0;
+    size_t this_rawdata, i;
+    const strRB5_XML_SLICE *xml_slice=get_rb5_xml_slice(&(*rb5_info),0);
+
+    for (this_rawdata = 0; this_rawdata < rb5_info->n_rawdatas; this_rawdata++){
+        int selected=(quantities == NULL);
+        const char *quantity=xml_slice->rawdata_arr[this_rawdata].quantity;
+        for (i = 0; (!selected) && (i < n_quantities); i++){
+            if (strcmp(quantity,quantities[i]) == 0) selected=1;
+        }
+        rb5_info->rawdata_selected[this_rawdata]=selected;
+        if (selected) n_selected++;
+    }
+    return(n_selected);
+}
+
+//#############################################################################
+
+strURPDATA what_is_this_param_to_urp(const char *sparam){
+    strURPDATA urp;
+    // see /apps/urp/build/include/drpdecode.h
+
+    const strRB5_MOMENT_DEF *def=find_rb5_moment_def(get_rb5_moment_kind(sparam));
+    urp.type=def->urp_type;
+    snprintf(urp.name,MAX_STRING,"%s",def->urp_name);
+    snprintf(urp.unit,MAX_STRING,"%s",def->urp_unit);
+    snprintf(urp.desc,MAX_STRING,"%s",def->urp_desc);
+    return(urp);
+}
+
+//#############################################################################
+
+void close_rb5_info(strRB5_INFO *rb5_info){
+
+  if(rb5_info->xpathCtx != NULL) xmlXPathFreeContext(rb5_info->xpathCtx); //cleanup
+  if(rb5_info->doc      != NULL) xmlFreeDoc(rb5_info->doc); // free the document
+  if(rb5_info->buffer   != NULL) close_file_buffer(rb5_info->buffer,rb5_info->buffer_len,rb5_info->buffer_owner); // free or unmap entire file buffer
+  if(rb5_info->blob_index != NULL) {
+    size_t i;
+    for (i = 0; i < rb5_info->n_blob_index; i++){
+      if(rb5_info->blob_index[i].inflated != NULL) RAVE_FREE(rb5_info->blob_index[i].inflated);
+    }
+    RAVE_FREE(rb5_info->blob_index);
+    rb5_info->blob_index=NULL;
+  }
+  if(rb5_info->xml_model != NULL) {
+    free_rb5_xml_model(rb5_info->xml_model);
+    rb5_info->xml_model=NULL;
+  }
+
+  int this_slice;  
+  for (this_slice = 0; this_slice < rb5_info->n_slices; this_slice++){
+    if(rb5_info->slice_moving_angle_start_arr[this_slice] != NULL) RAVE_FREE(rb5_info->slice_moving_angle_start_arr[this_slice]);
+    if(rb5_info->slice_moving_angle_stop_arr[this_slice] != NULL) RAVE_FREE(rb5_info->slice_moving_angle_stop_arr[this_slice]);
+    if(rb5_info->slice_fixed_angle_start_arr[this_slice] != NULL) RAVE_FREE(rb5_info->slice_fixed_angle_start_arr[this_slice]);
+    if(rb5_info->slice_fixed_angle_stop_arr[this_slice] != NULL) RAVE_FREE(rb5_info->slice_fixed_angle_stop_arr[this_slice]);
+
+    if(rb5_info->slice_moving_angle_arr[this_slice] != NULL) RAVE_FREE(rb5_info->slice_moving_angle_arr[this_slice]);
+    if(rb5_info->slice_fixed_angle_arr[this_slice] != NULL) RAVE_FREE(rb5_info->slice_fixed_angle_arr[this_slice]);
+  }
+
+}
+
+//#############################################################################
+
+// streaming (SAX2) read of the XML header into strRB5_XML_MODEL, no DOM is built
+// one push parser per thread is reset from file to file, keeping its name dictionary
+
+#define RB5_XML_MAX_DEPTH          32
+#define RB5_XML_OTHER               0
+#define RB5_XML_VOLUME              1
+#define RB5_XML_SENSORINFO          2
+#define RB5_XML_HISTORY             3
+#define RB5_XML_RAWDATAFILES        4
+#define RB5_XML_PREPROCESSEDFILES   5
+#define RB5_XML_SCAN                6
+#define RB5_XML_PARGROUP            7
+#define RB5_XML_SLICE               8
+#define RB5_XML_SLICEDATA           9
+#define RB5_XML_FIELD              10
+
+typedef struct{
+    xmlParserCtxtPtr ctxt;          //reset, not freed, between files
+    char *text;                     //text of the field being read, reused
+    size_t text_len;
+    size_t text_alloc;
+    strRB5_XML_MODEL *model;        //per parse from here on
+    int depth;
+    int kind_arr[RB5_XML_MAX_DEPTH];
+    int sensorinfo_found;
+    int scan_found;
+    strRB5_XML_GROUP *text_group;   //of the field awaiting its text, NULL if none
+    size_t text_field;
+    int text_found;
+    int status;
+} strRB5_XML_PARSER;
+
+static pthread_once_t rb5_xml_parser_once=PTHREAD_ONCE_INIT;
+static pthread_key_t rb5_xml_parser_key;
+
+//#############################################################################
+
+static void free_rb5_xml_parser(void *ptr){
+    // thread-exit destructor, the models built keep their dictionaries referenced
+
+    strRB5_XML_PARSER *parser=(strRB5_XML_PARSER *)ptr;
+    if(parser == NULL) return;
+    if(parser->ctxt != NULL) xmlFreeParserCtxt(parser->ctxt);
+    if(parser->text != NULL) free(parser->text);
+    free(parser);
+}
+
+static void create_rb5_xml_parser_key(void){
+    pthread_key_create(&rb5_xml_parser_key,free_rb5_xml_parser);
+}
+
+//#############################################################################
+
+static const char *intern_rb5_xml_string(strRB5_XML_PARSER *parser, const xmlChar *str, int len){
+    // copy owned by the model's dictionary, len < 0 if NUL-terminated
+
+    const xmlChar *interned=xmlDictLookup(parser->model->dict,str,len);
+    if(interned == NULL) {
+        parser->status=EXIT_FAILURE;
+        return("");
+    }
+    return((const char *)interned);
+}
+
+//#############################################################################
+
+static const char *get_sax_attrib_value(strRB5_XML_PARSER *parser, int nb_attributes, const xmlChar **attributes, const char *attrib){
+    // NULL if there is no such attribute
+    // attributes come as (localname,prefix,URI,value,end) tuples
+
+    int i;
+    for (i = 0; i < nb_attributes; i++){
+        const xmlChar **attr=&(attributes[5*i]);
+        if(strcmp((const char *)attr[0],attrib) == 0) return(intern_rb5_xml_string(&(*parser),attr[3],(int)(attr[4]-attr[3])));
+    }
+    return(NULL);
+}
+
+static const char *get_sax_attrib_or_empty(strRB5_XML_PARSER *parser, int nb_attributes, const xmlChar **attributes, const char *attrib){
+    const char *value=get_sax_attrib_value(&(*parser),nb_attributes,attributes,attrib);
+    return((value == NULL) ? "" : value);
+}
+
+//#############################################################################
+
+static void add_rb5_xml_field(strRB5_XML_PARSER *parser, strRB5_XML_GROUP *group, const xmlChar *localname, int nb_attributes, const xmlChar **attributes){
+    // appends <localname> and its attributes, its text follows in set_rb5_xml_field_text()
+
+    strRB5_XML_MODEL *model=parser->model;
+    int i;
+
+    if(group->n_fields == group->n_alloc){
+        size_t n_alloc=(group->n_alloc == 0) ? 16 : 2*group->n_alloc;
+        strRB5_XML_FIELD *field_arr=(strRB5_XML_FIELD *)RAVE_REALLOC(group->field_arr,n_alloc*sizeof(strRB5_XML_FIELD));
+        if(field_arr == NULL) {
+            parser->status=EXIT_FAILURE;
+            return;
+        }
+        group->field_arr=field_arr;
+        group->n_alloc=n_alloc;
+    }
+    if(model->n_attribs+nb_attributes > model->attrib_alloc){
+        size_t attrib_alloc=(model->attrib_alloc == 0) ? 256 : 2*model->attrib_alloc;
+        while(attrib_alloc < model->n_attribs+nb_attributes) attrib_alloc*=2;
+        const char **attrib_arr=(const char **)RAVE_REALLOC(model->attrib_arr,2*attrib_alloc*sizeof(char *));
+        if(attrib_arr == NULL) {
+            parser->status=EXIT_FAILURE;
+            return;
+        }
+        model->attrib_arr=attrib_arr;
+        model->attrib_alloc=attrib_alloc;
+    }
+
+    strRB5_XML_FIELD *field=&(group->field_arr[group->n_fields]);
+    field->name=intern_rb5_xml_string(&(*parser),localname,-1);
+    field->value="";
+    field->n_attribs=nb_attributes;
+    field->attrib_arr=NULL; //set once the pool stops moving
+    field->attrib_bgn=model->n_attribs;
+    for (i = 0; i < nb_attributes; i++){
+        const xmlChar **attr=&(attributes[5*i]);
+        model->attrib_arr[2*model->n_attribs  ]=intern_rb5_xml_string(&(*parser),attr[0],-1);
+        model->attrib_arr[2*model->n_attribs+1]=intern_rb5_xml_string(&(*parser),attr[3],(int)(attr[4]-attr[3]));
+        model->n_attribs++;
+    }
+
+    parser->text_group=group;
+    parser->text_field=group->n_fields++;
+    parser->text_len=0;
+    parser->text_found=0;
+}
+
+//#############################################################################
+
+static void set_rb5_xml_field_text(strRB5_XML_PARSER *parser){
+    // as in the DOM, a field's value is its first child node only
+
+    if(parser->text_group == NULL) return;
+    if(parser->text_found) {
+        parser->text_group->field_arr[parser->text_field].value=intern_rb5_xml_string(&(*parser),(const xmlChar *)parser->text,(int)parser->text_len);
+    }
+    parser->text_group=NULL;
+}
+
+static void add_rb5_xml_field_text(strRB5_XML_PARSER *parser, const xmlChar *ch, int len){
+
+    if(parser->text_len+len > parser->text_alloc){
+        size_t text_alloc=(parser->text_alloc == 0) ? 1024 : 2*parser->text_alloc;
+        while(text_alloc < parser->text_len+len) text_alloc*=2;
+        char *text=(char *)realloc(parser->text,text_alloc);
+        if(text == NULL) {
+            parser->status=EXIT_FAILURE;
+            return;
+        }
+        parser->text=text;
+        parser->text_alloc=text_alloc;
+    }
+    memcpy(parser->text+parser->text_len,ch,len);
+    parser->text_len+=len;
+    parser->text_found=1;
+}
+
+//#############################################################################
+
+static void set_rb5_xml_param(strRB5_XML_PARSER *parser, strRB5_XML_PARAM *param, int nb_attributes, const xmlChar **attributes, int is_rawdata){
+
+    param->sparam          =get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,is_rawdata ? "type" : "refid");
+    param->kind            =get_rb5_moment_kind(param->sparam);
+    param->conversion      =get_rb5_conversion(param->kind);
+    param->quantity        =intern_rb5_xml_string(&(*parser),(const xmlChar *)map_rb5_to_h5_param(param->sparam),-1);
+    param->blobid          =atoi(get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"blobid"));
+    param->raw_binary_depth=atoi(get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"depth"));
+    param->nrays           =atoi(get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"rays"));
+    if(is_rawdata){
+        param->nbins         =atoi(get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"bins"));
+        param->data_range_min=atof(get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"min"));
+        param->data_range_max=atof(get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"max"));
+    }
+}
+
+//#############################################################################
+
+static void set_rb5_xml_iso8601(strRB5_XML_PARSER *parser, char *iso8601, int nb_attributes, const xmlChar **attributes){
+    // "YYYY-MM-DD hh:mm:ss[.sss]" from <slicedata @datetimehighaccuracy>, else @date & @time
+
+    const char *datetime=get_sax_attrib_value(&(*parser),nb_attributes,attributes,"datetimehighaccuracy");
+    const char *date=get_sax_attrib_value(&(*parser),nb_attributes,attributes,"date");
+    const char *time=get_sax_attrib_value(&(*parser),nb_attributes,attributes,"time");
+    if(datetime != NULL){
+        snprintf(iso8601,MAX_STRING,"%s",datetime);
+        if(strlen(iso8601) > 10) iso8601[10]=' '; //blank T-delimiter
+    } else if((date != NULL) || (time != NULL)){
+        snprintf(iso8601,MAX_STRING,"%s %s",(date == NULL) ? "" : date,(time == NULL) ? "" : time);
+    }
+}
+
+//#############################################################################
+
+static int get_rb5_xml_kind(strRB5_XML_PARSER *parser, const char *name, int nb_attributes, const xmlChar **attributes){
+    // what the element just opened is, adding it to the model on the way
+
+    strRB5_XML_MODEL *model=parser->model;
+    int parent=(parser->depth > RB5_XML_MAX_DEPTH) ? RB5_XML_OTHER : parser->kind_arr[parser->depth-1];
+    strRB5_XML_SLICE *slice=(model->n_slices == 0) ? NULL : &(model->slice_arr[model->n_slices-1]);
+
+    switch(parent){
+    case RB5_XML_VOLUME:
+        if(strcmp(name,"sensorinfo") == 0){
+            if(!parser->sensorinfo_found){
+                model->sensor_id  =get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"id");
+                model->sensor_name=get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"name");
+            }
+            parser->sensorinfo_found=1;
+            return(RB5_XML_SENSORINFO);
+        } else if(strcmp(name,"history") == 0){
+            if(!model->history_exists){
+                model->history_exists=1;
+                model->history_pdfname =get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"pdfname");
+                model->history_ppdfname=get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"ppdfname");
+                model->history_sdfname =get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"sdfname");
+            }
+            return(RB5_XML_HISTORY);
+        } else if(strcmp(name,"scan") == 0){
+            if(!parser->scan_found) model->scan_name=get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"name");
+            parser->scan_found=1;
+            return(RB5_XML_SCAN);
+        }
+        return(RB5_XML_OTHER);
+
+    case RB5_XML_SENSORINFO:
+        add_rb5_xml_field(&(*parser),&(model->sensorinfo),(const xmlChar *)name,nb_attributes,attributes);
+        return(RB5_XML_FIELD);
+
+    case RB5_XML_HISTORY:
+        if(strcmp(name,"rawdatafiles") == 0) return(RB5_XML_RAWDATAFILES);
+        if(strcmp(name,"preprocessedfiles") == 0) return(RB5_XML_PREPROCESSEDFILES);
+        return(RB5_XML_OTHER);
+
+    case RB5_XML_RAWDATAFILES:
+    case RB5_XML_PREPROCESSEDFILES:
+        if(strcmp(name,"file") != 0) return(RB5_XML_OTHER);
+        add_rb5_xml_field(&(*parser),(parent == RB5_XML_RAWDATAFILES) ? &(model->history_rawdatafiles) : &(model->history_preprocessedfiles),
+            (const xmlChar *)name,nb_attributes,attributes);
+        return(RB5_XML_FIELD);
+
+    case RB5_XML_SCAN:
+        if((strcmp(name,"pargroup") == 0) && (model->n_pargroups < MAX_PARGROUPS)){
+            strRB5_XML_GROUP *pargroup=&(model->pargroup_arr[model->n_pargroups++]);
+            pargroup->refid=get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"refid");
+            return(RB5_XML_PARGROUP);
+        } else if((strcmp(name,"slice") == 0) && (model->n_slices < MAX_SLICES)){
+            slice=&(model->slice_arr[model->n_slices++]);
+            slice->fields.refid=get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"refid");
+            return(RB5_XML_SLICE);
+        }
+        return(RB5_XML_OTHER);
+
+    case RB5_XML_PARGROUP:
+        add_rb5_xml_field(&(*parser),&(model->pargroup_arr[model->n_pargroups-1]),(const xmlChar *)name,nb_attributes,attributes);
+        return(RB5_XML_FIELD);
+
+    case RB5_XML_SLICE:
+        add_rb5_xml_field(&(*parser),&(slice->fields),(const xmlChar *)name,nb_attributes,attributes);
+        if(strcmp(name,"slicedata") != 0) return(RB5_XML_FIELD);
+        if(slice->iso8601[0] == '\0') set_rb5_xml_iso8601(&(*parser),slice->iso8601,nb_attributes,attributes);
+        return(RB5_XML_SLICEDATA);
+
+    case RB5_XML_SLICEDATA:
+        if(strcmp(name,"rawdata") == 0){
+            if(slice->n_rawdatas < MAX_PARAMS) set_rb5_xml_param(&(*parser),&(slice->rawdata_arr[slice->n_rawdatas++]),nb_attributes,attributes,1);
+        } else if(strcmp(name,"rayinfo") == 0){
+            if(slice->n_rayinfos < MAX_PARAMS) set_rb5_xml_param(&(*parser),&(slice->rayinfo_arr[slice->n_rayinfos++]),nb_attributes,attributes,0);
+        } else if(strcmp(name,"rawdatapacked") == 0){
+            slice->n_rawdatapackeds++;
+        }
+        return(RB5_XML_OTHER);
+    }
+    return(RB5_XML_OTHER);
+}
+
+//#############################################################################
+// SAX2 callbacks, ctx is the parser context
+
+static void rb5_xml_start_element(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI,
+        int nb_namespaces, const xmlChar **namespaces, int nb_attributes, int nb_defaulted, const xmlChar **attributes){
+
+    strRB5_XML_PARSER *parser=(strRB5_XML_PARSER *)((xmlParserCtxtPtr)ctx)->_private;
+    strRB5_XML_MODEL *model=parser->model;
+    const char *name=(const char *)localname;
+    int kind=RB5_XML_OTHER;
+
+    set_rb5_xml_field_text(&(*parser));
+    if(parser->depth == 0){
+        model->root_name=intern_rb5_xml_string(&(*parser),localname,-1);
+        if(strcmp(name,"volume") == 0){
+            model->version =get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"version");
+            model->type    =get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"type");
+            model->datetime=get_sax_attrib_or_empty(&(*parser),nb_attributes,attributes,"datetime");
+            kind=RB5_XML_VOLUME;
+        }
+    } else {
+        kind=get_rb5_xml_kind(&(*parser),name,nb_attributes,attributes);
+    }
+    if(parser->depth < RB5_XML_MAX_DEPTH) parser->kind_arr[parser->depth]=kind;
+    parser->depth++;
+}
+
+static void rb5_xml_end_element(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI){
+
+    strRB5_XML_PARSER *parser=(strRB5_XML_PARSER *)((xmlParserCtxtPtr)ctx)->_private;
+    set_rb5_xml_field_text(&(*parser));
+    parser->depth--;
+}
+
+static void rb5_xml_characters(void *ctx, const xmlChar *ch, int len){
+
+    strRB5_XML_PARSER *parser=(strRB5_XML_PARSER *)((xmlParserCtxtPtr)ctx)->_private;
+    if(parser->text_group != NULL) add_rb5_xml_field_text(&(*parser),ch,len);
+}
+
+static void rb5_xml_cdata_block(void *ctx, const xmlChar *value, int len){
+    // a node of its own, as is a comment
+
+    strRB5_XML_PARSER *parser=(strRB5_XML_PARSER *)((xmlParserCtxtPtr)ctx)->_private;
+    if(parser->text_group == NULL) return;
+    if(!parser->text_found) add_rb5_xml_field_text(&(*parser),value,len);
+    set_rb5_xml_field_text(&(*parser));
+}
+
+static void rb5_xml_comment(void *ctx, const xmlChar *value){
+    rb5_xml_cdata_block(ctx,value,strlen((const char *)value));
+}
+
+//#############################################################################
+
+static strRB5_XML_PARSER *get_rb5_xml_parser(void){
+
+    pthread_once(&rb5_xml_parser_once,create_rb5_xml_parser_key);
+    strRB5_XML_PARSER *parser=(strRB5_XML_PARSER *)pthread_getspecific(rb5_xml_parser_key);
+    if(parser != NULL) return(parser);
+
+    parser=(strRB5_XML_PARSER *)calloc(1,sizeof(strRB5_XML_PARSER));
+    if(parser == NULL) return(NULL);
+
+    xmlSAXHandler sax;
+    memset(&sax,0,sizeof(xmlSAXHandler));
+    sax.initialized=XML_SAX2_MAGIC;
+    sax.startElementNs=rb5_xml_start_element;
+    sax.endElementNs=rb5_xml_end_element;
+    sax.characters=rb5_xml_characters;
+    sax.ignorableWhitespace=rb5_xml_characters;
+    sax.cdataBlock=rb5_xml_cdata_block;
+    sax.comment=rb5_xml_comment;
+    sax.warning=xmlParserWarning; //report as xmlReadMemory() does
+    sax.error=xmlParserError;
+    parser->ctxt=xmlCreatePushParserCtxt(&sax,NULL,NULL,0,"noname.xml");
+    if(parser->ctxt == NULL) {
+        free(parser);
+        return(NULL);
+    }
+    pthread_setspecific(rb5_xml_parser_key,parser);
+    return(parser);
+}
+
+//#############################################################################
+
+void close_rb5_xml_parser(void){
+    // releases this thread's parser now rather than at thread exit
+
+    pthread_once(&rb5_xml_parser_once,create_rb5_xml_parser_key);
+    strRB5_XML_PARSER *parser=(strRB5_XML_PARSER *)pthread_getspecific(rb5_xml_parser_key);
+    if(parser == NULL) return;
+    pthread_setspecific(rb5_xml_parser_key,NULL);
+    free_rb5_xml_parser(parser);
+}
+
+//#############################################################################
+
+static void link_rb5_xml_attribs(strRB5_XML_MODEL *model, strRB5_XML_GROUP *group){
+
+    size_t i;
+    for (i = 0; i < group->n_fields; i++){
+        group->field_arr[i].attrib_arr=&(model->attrib_arr[2*group->field_arr[i].attrib_bgn]);
+    }
+}
+
+//#############################################################################
+
+static int set_rb5_xml_faultstats(strRB5_XML_SLICE *slice){
+    // the *warningstat and *faultstat fields
+
+    size_t i;
+    for (i = 0; i < slice->fields.n_fields; i++){
+        const char *name=slice->fields.field_arr[i].name;
+        if((strstr(name,"warningstat") != NULL) || (strstr(name,"faultstat") != NULL)) slice->n_faultstats++;
+    }
+    if(slice->n_faultstats == 0) return(EXIT_SUCCESS);
+
+    slice->faultstat_arr=(strRB5_XML_FIELD *)RAVE_MALLOC(slice->n_faultstats*sizeof(strRB5_XML_FIELD));
+    if(slice->faultstat_arr == NULL) return(EXIT_FAILURE);
+    slice->n_faultstats=0;
+    for (i = 0; i < slice->fields.n_fields; i++){
+        const char *name=slice->fields.field_arr[i].name;
+        if((strstr(name,"warningstat") != NULL) || (strstr(name,"faultstat") != NULL)) {
+            slice->faultstat_arr[slice->n_faultstats++]=slice->fields.field_arr[i];
+        }
+    }
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+static strRB5_XML_MODEL *begin_rb5_xml_model(void){
+    // an empty model, filled by feed_rb5_xml_model() and completed by end_rb5_xml_model(),
+    // on this thread's parser, one model at a time
+
+    strRB5_XML_PARSER *parser=get_rb5_xml_parser();
+    if(parser == NULL) {
+        fprintf(stderr,"Error: cannot create the XML header parser\n");
+        return(NULL);
+    }
+
+    //large, keep it off the stack
+    strRB5_XML_MODEL *model=(strRB5_XML_MODEL *)RAVE_MALLOC(sizeof(strRB5_XML_MODEL));
+    if(model == NULL) return(NULL);
+    memset(model,0,sizeof(strRB5_XML_MODEL));
+
+    model->root_name="";
+    model->version="";
+    model->type="";
+    model->datetime="";
+    model->sensor_id="";
+    model->sensor_name="";
+    model->history_pdfname="";
+    model->history_ppdfname="";
+    model->history_sdfname="";
+    model->scan_name="";
+
+    //names are looked up in the parser's dictionary first, the rest lands in this one
+    xmlCtxtResetPush(parser->ctxt,NULL,0,"noname.xml",NULL);
+    model->dict=xmlDictCreateSub(parser->ctxt->dict);
+    if(model->dict == NULL) {
+        RAVE_FREE(model);
+        return(NULL);
+    }
+
+    parser->ctxt->_private=parser;
+    parser->model=model;
+    parser->depth=0;
+    parser->sensorinfo_found=0;
+    parser->scan_found=0;
+    parser->text_group=NULL;
+    parser->status=EXIT_SUCCESS;
+    return(model);
+}
+
+//#############################################################################
+
+static int feed_rb5_xml_model(const char *chunk, size_t chunk_len){
+    // the next bytes of the XML header, as they come in
+    // EXIT_FAILURE as soon as they are not well-formed
+
+    strRB5_XML_PARSER *parser=get_rb5_xml_parser();
+    if(chunk_len > 0) xmlParseChunk(parser->ctxt,chunk,(int)chunk_len,0);
+    return((parser->ctxt->wellFormed) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+//#############################################################################
+
+static strRB5_XML_MODEL *end_rb5_xml_model(strRB5_XML_MODEL *model){
+    // the model of begin_rb5_xml_model() once the whole header was fed, NULL (and freed) on error
+
+    size_t i;
+    strRB5_XML_PARSER *parser=get_rb5_xml_parser();
+
+    xmlParseChunk(parser->ctxt,NULL,0,1);
+    int well_formed=parser->ctxt->wellFormed;
+    parser->model=NULL;
+    parser->text_group=NULL;
+    if(!well_formed || (model->root_name[0] == '\0')) {
+        free_rb5_xml_model(model);
+        return(NULL);
+    }
 
-    unsigned char *uncompressed_blob=(unsigned char *)RAVE_MALLOC(expectedSize);
+    link_rb5_xml_attribs(model,&(model->sensorinfo));
+    link_rb5_xml_attribs(model,&(model->history_rawdatafiles));
+    link_rb5_xml_attribs(model,&(model->history_preprocessedfiles));
+    for (i = 0; i < model->n_pargroups; i++) link_rb5_xml_attribs(model,&(model->pargroup_arr[i]));
+    for (i = 0; i < model->n_slices; i++){
+        link_rb5_xml_attribs(model,&(model->slice_arr[i].fields));
+        parser->status|=set_rb5_xml_faultstats(&(model->slice_arr[i]));
+    }
 
-    int Z_result=uncompress(uncompressed_blob,&expectedSize,buf+4,compressed_size_blob-4);
-    if (Z_result != Z_OK) {
-      fprintf(stderr,"zlib error: %d\n", Z_result);
+    if(parser->status != EXIT_SUCCESS){
+        fprintf(stderr,"Error: cannot allocate the XML header model\n");
+        free_rb5_xml_model(model);
+        return(NULL);
     }
-    
-    *return_uncompressed_blob=uncompressed_blob;
-    return(expectedSize);
+    return(model);
 }
 
 //#############################################################################
 
-char *get_xpath_iso8601_attrib(const xmlXPathContextPtr xpathCtx, char *xpath_bgn){
-    // expects trailing "/" 
+strRB5_XML_MODEL *build_rb5_xml_model(const char *buffer, size_t buffer_len){
+    // single forward pass over the XML header in buffer: <volume> attributes, sensorinfo,
+    // history, pargroup defaults, per-slice overrides, rawdata/rayinfo descriptors and
+    // fault status fields
+    // release with free_rb5_xml_model()
 
-    char xpath[MAX_STRING]="\0";
-    static char iso8601[MAX_STRING]="\0";
-    
-    if(get_xpath_size(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@datetimehighaccuracy")) == 1){
-      strcpy(iso8601,return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@datetimehighaccuracy")));
-      strncpy(iso8601+10," ",1); //blank T-delimiter
-    } else {
-      if(get_xpath_size(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@date")) ||
-         get_xpath_size(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@time")) == 1) {
-        sprintf(iso8601,"%s %s",
-          return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@date")),
-          return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@time")));
-      }
-    }
-    //fprintf(stdout,"xpath = %s, iso8601=%s\n",xpath,iso8601);
-    return(iso8601);
+    if((buffer == NULL) || (buffer_len == 0)) return(NULL);
 
+    strRB5_XML_MODEL *model=begin_rb5_xml_model();
+    if(model == NULL) return(NULL);
+    feed_rb5_xml_model(buffer,buffer_len); //errors show in end_rb5_xml_model()
+    return(end_rb5_xml_model(model));
 }
 
 //#############################################################################
 
-size_t get_blobid_buffer(strRB5_INFO *rb5_info, int req_blobid, unsigned char** return_uncompressed_blob) {
+size_t count_rb5_xml_quantities(const strRB5_XML_MODEL *model, const char **quantities, size_t n_quantities){
+    // <rawdata> moments of the 0th slice whose ODIM quantity is requested, all if quantities == NULL
+    // as select_rb5_rawdatas(), but from the header alone
 
-    size_t EXIT_NULL_VAL=0;
+    size_t n_selected=0;
+    size_t this_rawdata, i;
 
-    char *xpath;
-    int this_blobid;
-    unsigned char *compressed_blob = NULL;
-    unsigned char *uncompressed_blob = NULL;
-    size_t compressed_size_blob;
-    size_t uncompressed_size_blob;
+    if((model == NULL) || (model->n_slices == 0)) return(0);
+    for (this_rawdata = 0; this_rawdata < model->slice_arr[0].n_rawdatas; this_rawdata++){
+        int selected=(quantities == NULL);
+        const char *quantity=model->slice_arr[0].rawdata_arr[this_rawdata].quantity;
+        for (i = 0; (!selected) && (i < n_quantities); i++){
+            if (strcmp(quantity,quantities[i]) == 0) selected=1;
+        }
+        if (selected) n_selected++;
+    }
+    return(n_selected);
+}
 
-    char *blobspace=NULL;
-    size_t bs_size=(rb5_info->buffer_len) - (rb5_info->byte_offset_blobspace);
-//fprintf(stdout,"bs_size=%ld\n",bs_size);
-    blobspace=(rb5_info->buffer) + (rb5_info->byte_offset_blobspace);
-    size_t bs_abs_off=0;
-    size_t bs_rel_jmp=0;
+//#############################################################################
 
-    char bgn_BLOB[]="<BLOB ";
-    char *BLOB_line=NULL;
-    size_t bgn_BLOB_len=0;
-    char end_BLOB[]="</BLOB>";
-    size_t end_BLOB_len=strlen(end_BLOB)+2; //with trailing '\n'
+static void free_rb5_xml_fields(strRB5_XML_GROUP *group){
+    if(group->field_arr != NULL) RAVE_FREE(group->field_arr);
+    group->n_fields=0;
+    group->n_alloc=0;
+}
 
-    while (bs_abs_off <= bs_size) {
+//#############################################################################
 
-      BLOB_line=strstr(strtok(blobspace,"\n"),bgn_BLOB);
-      bgn_BLOB_len=strlen(BLOB_line)+1; //with trailing '\n'
-//fprintf(stdout,"(%ld) BLOB_line=%s\n",strlen(BLOB_line),BLOB_line);
-//fprintf(stdout,"(%ld) end_BLOB=%s\n",strlen(end_BLOB),end_BLOB);
+void free_rb5_xml_model(strRB5_XML_MODEL *model){
 
-      if(L_DEBUG_OUTPUT_1) fprintf(stdout,"%s\n", BLOB_line);
+    size_t i;
+    if(model == NULL) return;
+    if(model->dict != NULL) xmlDictFree(model->dict);
+    if(model->attrib_arr != NULL) RAVE_FREE(model->attrib_arr);
+    free_rb5_xml_fields(&(model->sensorinfo));
+    free_rb5_xml_fields(&(model->history_rawdatafiles));
+    free_rb5_xml_fields(&(model->history_preprocessedfiles));
+    for (i = 0; i < model->n_pargroups; i++) free_rb5_xml_fields(&(model->pargroup_arr[i]));
+    for (i = 0; i < model->n_slices; i++){
+        free_rb5_xml_fields(&(model->slice_arr[i].fields));
+        if(model->slice_arr[i].faultstat_arr != NULL) RAVE_FREE(model->slice_arr[i].faultstat_arr);
+    }
+    RAVE_FREE(model);
+}
 
-            // parse the BLOB header and get the DOM (</BLOB ...> only so force a quiet parse recovery)
-            xmlDoc *blob_doc = xmlReadMemory(BLOB_line,bgn_BLOB_len, "noname.xml", NULL, XML_PARSE_RECOVER+XML_PARSE_NOERROR);
-            if ( blob_doc == NULL ) {
-                fprintf(stderr,"Error while parsing BLOB header\n");
-                RAVE_FREE(blobspace);
-                xmlFreeDoc(blob_doc);
-                return(EXIT_NULL_VAL);
-            }
-            xmlXPathContextPtr blob_xpathCtx = xmlXPathNewContext(blob_doc);
-            if (blob_xpathCtx == NULL ){
-                fprintf(stderr,"Error in xmlXPathNewContext\n");
-                RAVE_FREE(blobspace);
-                xmlXPathFreeContext(blob_xpathCtx); //cleanup
-                xmlFreeDoc(blob_doc); // free the document
-                return(EXIT_NULL_VAL);
-            }
+//#############################################################################
+
+const char *find_rb5_xml_field(const strRB5_XML_GROUP *group, const char *name, const char *attrib){
+    // value of the first field <name>, or of its attribute if attrib != NULL
+    // NULL if not in this group
+
+    size_t i;
+    size_t j;
+    for (i = 0; i < group->n_fields; i++){
+        if(strcmp(group->field_arr[i].name,name) != 0) continue;
+        if(attrib == NULL) return(group->field_arr[i].value);
+        for (j = 0; j < group->field_arr[i].n_attribs; j++){
+            if(strcmp(group->field_arr[i].attrib_arr[2*j],attrib) == 0) return(group->field_arr[i].attrib_arr[2*j+1]);
+        }
+    }
+    return(NULL);
+}
+
+//#############################################################################
 
-            xpath="/BLOB/@size";
-            compressed_size_blob=atoi(return_xpath_value(blob_xpathCtx,xpath));
+const strRB5_XML_SLICE *get_rb5_xml_slice(strRB5_INFO *rb5_info, size_t this_slice){
+    // NULL if there is no such <slice>
 
-            xpath="/BLOB/@blobid";
-            //printf("XPATH: %s = %s\n", xpath, return_xpath_value(blob_xpathCtx,xpath));
-            this_blobid=atoi(return_xpath_value(blob_xpathCtx,xpath));
-            if (this_blobid == req_blobid) {
-                if(L_DEBUG_OUTPUT_1) fprintf(stdout,"  compressed_size_blob = %ld\n",compressed_size_blob);
-                compressed_blob=(unsigned char *)RAVE_MALLOC(compressed_size_blob);
-                memcpy(compressed_blob,blobspace+bgn_BLOB_len,compressed_size_blob);
-                    uncompressed_size_blob=uncompress_this_blob(compressed_blob, &uncompressed_blob, compressed_size_blob);
-                    if(L_DEBUG_OUTPUT_1) fprintf(stdout,"uncompressed_size_blob = %ld\n",uncompressed_size_blob);
-                    RAVE_FREE(compressed_blob);
-                    xmlXPathFreeContext(blob_xpathCtx); //cleanup
-                    xmlFreeDoc(blob_doc);
-                    *return_uncompressed_blob=uncompressed_blob;
-                    return(uncompressed_size_blob);
-            } 
-            bs_rel_jmp=bgn_BLOB_len+compressed_size_blob+end_BLOB_len;
-            blobspace+=bs_rel_jmp;
-            bs_abs_off+=bs_rel_jmp;
+    if((rb5_info->xml_model == NULL) || (this_slice >= rb5_info->xml_model->n_slices)) return(NULL);
+    return(&(rb5_info->xml_model->slice_arr[this_slice]));
+}
 
-//fprintf(stdout,"bs_abs_off=%ld\n",bs_abs_off);
-//fprintf(stdout,"bs_rel_jmp=%ld\n",bs_rel_jmp);
+//#############################################################################
 
-            xmlXPathFreeContext(blob_xpathCtx); //cleanup
-            xmlFreeDoc(blob_doc);
+const char *get_rb5_slice_attrib(strRB5_INFO *rb5_info, size_t this_slice, const char *name, const char *attrib) {
+    // <slice> override, else the default from the 0th slice, else ""
 
-    } //while (bs_abs_off <= bs_size) {
+    const char *value=NULL;
+    const strRB5_XML_SLICE *slice=get_rb5_xml_slice(&(*rb5_info),this_slice);
+    if(slice != NULL) value=find_rb5_xml_field(&(slice->fields),name,attrib);
+    if(value == NULL) {
+        slice=get_rb5_xml_slice(&(*rb5_info),0);
+        if(slice != NULL) value=find_rb5_xml_field(&(slice->fields),name,attrib);
+    }
+    if(value == NULL) value="";
+if(L_DEBUG_OUTPUT_2) fprintf(stdout,"this_slice = %2ld : %s = %s\n",this_slice,name,value);
+    return(value);
 
-    fprintf(stdout,"ERROR: req_blobid = %d NOT FOUND!!!\n",req_blobid);
-    return(EXIT_NULL_VAL);
 }
 
 //#############################################################################
 
-void convert_raw_to_data(strRB5_PARAM_INFO *rb5_param, void **input_raw_arr, float **return_data_arr){
+const char *get_rb5_sensorinfo_attrib(strRB5_INFO *rb5_info, const char *name) {
+    // <sensorinfo> field <name>, else ""
 
-    //local vars
-    char conversion[MAX_STRING]="\0";
-    char sparam[MAX_STRING]="\0";
-    strcpy(conversion,rb5_param->conversion);
-    strcpy(sparam,rb5_param->sparam);
-    size_t n_elems_data    =rb5_param->n_elems_data;
-    size_t raw_binary_depth=rb5_param->raw_binary_depth;
-    size_t raw_binary_width=rb5_param->raw_binary_width;
-    float data_range_min   =rb5_param->data_range_min;
-    float data_range_max   =rb5_param->data_range_max;
-    float data_range_width =rb5_param->data_range_width;
-    float data_step        =rb5_param->data_step;
-    float NODATA_val=-99;
+    const char *value=NULL;
+    if(rb5_info->xml_model != NULL) value=find_rb5_xml_field(&(rb5_info->xml_model->sensorinfo),name,NULL);
+    return((value == NULL) ? "" : value);
+
+}
+
+//#############################################################################
+
+const char *get_rb5_pargroup_attrib(strRB5_INFO *rb5_info, const char *refid, const char *name) {
+    // first <pargroup> field <name>, of any pargroup if refid == NULL, else ""
 
     size_t i;
-    unsigned int *raw_arr=RAVE_MALLOC(n_elems_data*sizeof(unsigned int));
-    void *deref_input_raw_arr=*input_raw_arr;
-           if (raw_binary_depth ==  8){
-        uint8_t  *buffer_8 =((uint8_t  *)deref_input_raw_arr);
-        for (i = 0; i < n_elems_data; i++) raw_arr[i]=(unsigned int)buffer_8 [i];
-    } else if (raw_binary_depth == 16){
-        uint16_t *buffer_16=((uint16_t *)deref_input_raw_arr);
-        for (i = 0; i < n_elems_data; i++) raw_arr[i]=(unsigned int)buffer_16[i];
-    } else if (raw_binary_depth == 32){
-        uint32_t *buffer_32=((uint32_t *)deref_input_raw_arr);
-        for (i = 0; i < n_elems_data; i++) raw_arr[i]=(unsigned int)buffer_32[i];
+    const char *value=NULL;
+    if(rb5_info->xml_model == NULL) return("");
+    for (i = 0; i < rb5_info->xml_model->n_pargroups; i++){
+        const strRB5_XML_GROUP *pargroup=&(rb5_info->xml_model->pargroup_arr[i]);
+        if((refid != NULL) && (strcmp(pargroup->refid,refid) != 0)) continue;
+        value=find_rb5_xml_field(pargroup,name,NULL);
+        if(value != NULL) return(value);
     }
-//fprintf(stdout,"### (%2ld) param=%s\n",raw_binary_depth,sparam);
-//for (i = 0; i < n_elems_data; i++) fprintf(stdout,"%d ",raw_arr[i]);
-//fprintf(stdout,"\n");
+    return("");
 
-    float *data_arr=NULL;
-    data_arr=RAVE_MALLOC(n_elems_data*sizeof(float));
-    if (strcmp(conversion, "copy") == 0) {
-        for (i = 0; i < n_elems_data; i++) {
-          data_arr[i]=raw_arr[i];
-          if(L_DEBUG_OUTPUT_2) fprintf(stdout,"%f ",data_arr[i]);
-        }
-        if(L_DEBUG_OUTPUT_2) fprintf(stdout,"\n");
-        NODATA_val = 0;
-    } else if (strcmp(conversion, "angular") == 0) {
-        data_range_min=0.0;
-        data_range_max=360.0;
-        data_range_width=data_range_max-data_range_min;
-        data_step=data_range_width/raw_binary_width;
-        if(L_DEBUG_OUTPUT_1) fprintf(stdout,"  data_step = %f\n",data_step);
-        for (i = 0; i < (n_elems_data); i++) {
-          data_arr[i]=(raw_arr[i] * data_step) + data_range_min;
-          if(L_DEBUG_OUTPUT_2) fprintf(stdout,"%d ",raw_arr[i]);
-          if(L_DEBUG_OUTPUT_2) fprintf(stdout,"%f ",data_arr[i]);
-        }
-        if(L_DEBUG_OUTPUT_2) fprintf(stdout,"\n");
-        NODATA_val = (0 * data_step) - data_step + data_range_min;
-    } else if (strstr(conversion, "data") != NULL) {
-        //removed special param packing check, 2017-Mar-23
-        // we found KDP have variable data range!
-        // using rb5_param->data_range_min|max defaults (set in var declaration above)
-        //if (strcmp(conversion, "kdp_data") == 0) {
-        //    data_range_min=-20.0;
-        //    data_range_max=+20.0;
-        //} else if (strcmp(conversion, "phidp_data") == 0) {
-        //    data_range_min=  0.0;
-        //    data_range_max=360.0;
-        //}
-        data_range_width=data_range_max-data_range_min;
-        data_step=data_range_width/raw_binary_width;
-        if(L_DEBUG_OUTPUT_1) fprintf(stdout,"  data_step = %f\n",data_step);
-        for (i = 0; i < n_elems_data; i++) {
-          data_arr[i]=(raw_arr[i] * data_step) - data_step + data_range_min;
-          if(L_DEBUG_OUTPUT_2) fprintf(stdout,"%f ",data_arr[i]);
-        }
-        if(L_DEBUG_OUTPUT_2) fprintf(stdout,"\n");
-        NODATA_val = (0 * data_step) - data_step + data_range_min;
-    }
-    if(L_DEBUG_OUTPUT_1) fprintf(stdout,"  NODATA_val = %f\n",NODATA_val);
+}
 
-    //update
-    rb5_param->data_range_min  =data_range_min;
-    rb5_param->data_range_max  =data_range_max;
-    rb5_param->data_range_width=data_range_width;
-    rb5_param->data_step       =data_step;
-    rb5_param->NODATA_val      =NODATA_val;
+//#############################################################################
 
-    RAVE_FREE(raw_arr); 
-    *return_data_arr=data_arr;
+static int populate_rb5_info_mode(strRB5_INFO *rb5_info, int L_VERBOSE, const strRB5_SLICE_SELECT *slice_select, int header_mode);
+
+int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
+    return(populate_rb5_info_mode(&(*rb5_info),L_VERBOSE,NULL,0));
 }
 
 //#############################################################################
 
-size_t return_param_blobid_raw(strRB5_INFO *rb5_info, strRB5_PARAM_INFO* rb5_param, void **return_raw_arr){
+int populate_rb5_info_slices(strRB5_INFO *rb5_info, int L_VERBOSE, const strRB5_SLICE_SELECT *slice_select){
+    // as populate_rb5_info(), with the per-slice XPath, rayinfo and readback decoding
+    // done only for the slices selected (all if slice_select == NULL)
+    return(populate_rb5_info_mode(&(*rb5_info),L_VERBOSE,slice_select,0));
+}
 
-    size_t EXIT_NULL_VAL=0;
+//#############################################################################
 
-    //local vars
-    size_t blobid          =rb5_param->blobid;
-    size_t size_blob;
-    size_t n_elems_data;
-    size_t data_bytesize   =rb5_param->data_bytesize;    
-    size_t raw_binary_depth=rb5_param->raw_binary_depth;
-    size_t i;
- 
-    unsigned char *blob_buffer=NULL;
-    size_blob=get_blobid_buffer(&(*rb5_info), blobid, &blob_buffer);
-    if (blob_buffer == NULL) {
-      fprintf(stdout,"ERROR: blobid = %ld NOT FOUND!!!\n",blobid);
-      return(EXIT_NULL_VAL);
-    }
+int populate_rb5_header(strRB5_INFO *rb5_info, int L_VERBOSE, int header_mode){
+    // as populate_rb5_info(), without the ray angle readbacks and iray_0degN
+    // RB5_HEADER_ONLY touches no blob at all, the buffer may end at the XML header
+    return(populate_rb5_info_mode(&(*rb5_info),L_VERBOSE,NULL,header_mode));
+}
 
-    n_elems_data=size_blob/data_bytesize;
-    void *raw_arr=(void *)RAVE_MALLOC(size_blob);
-    if (raw_binary_depth == 8 ) {
-        /*8 bit data (copy blob_buffer)*/
-        uint8_t *buffer_8=(uint8_t *)RAVE_MALLOC(size_blob);
-        memcpy(buffer_8 ,blob_buffer,size_blob);
-        memcpy(raw_arr,buffer_8 ,size_blob);
-        RAVE_FREE(buffer_8);
-    } else if (raw_binary_depth == 16) {
-        /*16 bit data (put on Little Endian order)*/
-        uint16_t *buffer_16=(uint16_t *)RAVE_MALLOC(size_blob);
-        memcpy(buffer_16,blob_buffer,size_blob);
-        for (i = 0; i < n_elems_data; i++) {
-            buffer_16[i]=(buffer_16[i] << 8) | (buffer_16[i] >> 8 );
-        }
-        memcpy(raw_arr,buffer_16,size_blob);
-        RAVE_FREE(buffer_16);
-    } else if (raw_binary_depth == 32){
-        /*32 bit data (put on Little Endian order)*/
-        uint32_t *buffer_32=(uint32_t *)RAVE_MALLOC(size_blob);
-        memcpy(buffer_32,blob_buffer,size_blob);
-        for (i = 0; i < n_elems_data; i++) {
-            buffer_32[i]=((buffer_32[i]>>24) & 0x000000ff) | // move byte 3 to byte 0
-                         ((buffer_32[i]<<8 ) & 0x00ff0000) | // move byte 1 to byte 2
-                         ((buffer_32[i]>>8 ) & 0x0000ff00) | // move byte 2 to byte 1
-                         ((buffer_32[i]<<24) & 0xff000000);  // move byte 0 to byte 3
-        }
-        memcpy(raw_arr,buffer_32,size_blob);
-        RAVE_FREE(buffer_32);
-    }
-    RAVE_FREE(blob_buffer);
+//#############################################################################
 
-    if(L_DEBUG_OUTPUT_1) fprintf(stdout,"  n_elems_data = %ld\n",n_elems_data);
+int read_rb5_header(char *inp_fname, int header_mode, strRB5_HEADER *header){
+    // metadata-only read of an RB5 file into a lightweight descriptor
+    // the file is read up to the end of the XML header, RB5_HEADER_ONLY never reads on
 
-    //update
-    rb5_param->size_blob   =size_blob;
-    if(rb5_param->n_elems_data != n_elems_data){
-        fprintf(stdout,"  INCONSISTENT rb5_param->n_elems_data = %ld\n",rb5_param->n_elems_data);
-        fprintf(stdout,"  INCONSISTENT n_elems_data = %ld\n",n_elems_data);
+    size_t i;
+    strXML_FILE_INFO xml_info;
+    strcpy(xml_info.inp_fullfile,inp_fname);
+    if(read_xml_header(&xml_info) != 0) return(EXIT_FAILURE);
+
+    //large, keep it off the stack
+    strRB5_INFO *rb5_info=RAVE_MALLOC(sizeof(strRB5_INFO));
+    if(rb5_info == NULL) {
+        close_xml_buffer(&xml_info);
+        return(EXIT_FAILURE);
+    }
+    memset(rb5_info,0,sizeof(strRB5_INFO));
+    strcpy(rb5_info->inp_fullfile,xml_info.inp_fullfile);
+    rb5_info->buffer=xml_info.buffer;
+    rb5_info->buffer_len=xml_info.buffer_len;
+    rb5_info->buffer_owner=xml_info.buffer_owner;
+    rb5_info->byte_offset_blobspace=xml_info.byte_offset_end_of_xml;
+    rb5_info->blobspace_pending=xml_info.header_only; //a mapped or gunzipped file is there in full
+    rb5_info->doc=xml_info.doc;
+    rb5_info->xpathCtx=xml_info.xpathCtx;
+    rb5_info->blob_index=NULL;
+    rb5_info->n_blob_index=0;
+
+    int L_VERBOSE=0;
+    if(populate_rb5_header(&(*rb5_info),L_VERBOSE,header_mode) != 0) {
+        RAVE_FREE(rb5_info);
         return(EXIT_FAILURE);
     }
-    rb5_param->n_elems_data=n_elems_data;
 
-    //reorder
-    reorder_by_iray_0degN(&(*rb5_param),&raw_arr);
+    memset(header,0,sizeof(strRB5_HEADER));
+    strcpy(header->inp_fullfile,rb5_info->inp_fullfile);
+    strcpy(header->rainbow_version,rb5_info->rainbow_version);
+    strcpy(header->sensor_id,rb5_info->sensor_id);
+    strcpy(header->sensor_name,rb5_info->sensor_name);
+    header->sensor_lon_deg=rb5_info->sensor_lon_deg;
+    header->sensor_lat_deg=rb5_info->sensor_lat_deg;
+    header->sensor_alt_m=rb5_info->sensor_alt_m;
+    header->sensor_wavelength_cm=rb5_info->sensor_wavelength_cm;
+    header->sensor_beamwidth_deg=rb5_info->sensor_beamwidth_deg;
+    strcpy(header->scan_type,rb5_info->scan_type);
+    strcpy(header->scan_name,rb5_info->scan_name);
+    header->n_rawdatas=rb5_info->n_rawdatas;
+    for (i = 0; i < rb5_info->n_rawdatas; i++){
+        snprintf(header->quantity_arr[i],MAX_NSTRINGS,"%s",map_rb5_to_h5_param(rb5_info->rawdata_name_arr[i]));
+    }
+    header->n_slices=rb5_info->n_slices;
+    for (i = 0; i < rb5_info->n_slices; i++){
+        snprintf(header->slice_iso8601_bgn[i],MAX_NSTRINGS,"%s",rb5_info->slice_iso8601_bgn[i]);
+        snprintf(header->slice_iso8601_end[i],MAX_NSTRINGS,"%s",rb5_info->slice_iso8601_end[i]);
+        header->angle_deg_arr[i]=rb5_info->angle_deg_arr[i];
+        header->nrays[i]=rb5_info->nrays[i];
+        header->nbins[i]=rb5_info->nbins[i];
+        header->slice_bin_range_bgn_km[i]=rb5_info->slice_bin_range_bgn_km[i];
+        header->slice_bin_range_res_km[i]=rb5_info->slice_bin_range_res_km[i];
+        header->slice_ray_angle_res_deg[i]=rb5_info->slice_ray_angle_res_deg[i];
+        header->slice_antspeed_deg_sec[i]=rb5_info->slice_antspeed_deg_sec[i];
+    }
 
-    if(L_DEBUG_OUTPUT_1) dump_strRB5_PARAM_INFO(*rb5_param);
-    *return_raw_arr=raw_arr;
+    close_rb5_info(&(*rb5_info));
+    RAVE_FREE(rb5_info);
+    return(EXIT_SUCCESS);
+}
 
-    return(n_elems_data);    
+//#############################################################################
+
+static int is_rb5_slice_selected(const strRB5_SLICE_SELECT *slice_select, size_t this_slice, float angle_deg){
+
+    size_t i;
+    if (slice_select == NULL) return(1);
+    if (slice_select->n_slices == 0) {
+        return((angle_deg >= slice_select->angle_min_deg) && (angle_deg <= slice_select->angle_max_deg));
+    }
+    for (i = 0; i < slice_select->n_slices; i++){
+        if (slice_select->slice_arr[i] == this_slice) return(1);
+    }
+    return(0);
 }
 
 //#############################################################################
 
-char *map_rb5_to_h5_param(char *sparam){
+// streaming read of an RB5 payload from a pipe, a socket or stdin: no seek, no size known up front
+// the XML header is parsed as it comes in, then each blob is indexed, and inflated if a selected
+// moment reads it, as soon as its last byte is in, so that most of the decoding is done by the
+// time the transfer ends
+
+typedef struct{
+    int fd;
+    const char *inp_fname;
+    size_t n_alloc;           //of rb5_info->buffer, less its NUL terminator
+    int gzipped;              //inflated on the fly, member after member as gunzip_buffer() does
+    int gz_member_end;        //1 if the input could end here
+    z_stream strm;
+    unsigned char *gz_chunk;  //compressed bytes read, gzipped streams only
+    size_t gz_chunk_alloc;
+    strRB5_BLOB_INFO *ahead;  //blobid and inflated_len of the blobs of the selected moments, sorted
+    size_t n_ahead;
+    size_t next_blob;         //of the blob index, first not looked at yet
+} strRB5_STREAM;
 
-  static char return_string[MAX_STRING]="\0";
+//#############################################################################
 
-               if (strcmp(sparam, "dBuZ"  ) == 0 ){; strcpy(return_string,"TH");
-        } else if (strcmp(sparam, "dBuZv" ) == 0 ){; strcpy(return_string,"TV");
-        } else if (strcmp(sparam, "dBZ"   ) == 0 ){; strcpy(return_string,"DBZH");
-//        } else if (strcmp(sparam, "dBZv"  ) == 0 ){; strcpy(return_string,"DBZV");
-        } else if (strcmp(sparam, "V"     ) == 0 ){; strcpy(return_string,"VRADH");
-        } else if (strcmp(sparam, "Vv"    ) == 0 ){; strcpy(return_string,"VRADV");
-        } else if (strcmp(sparam, "W"     ) == 0 ){; strcpy(return_string,"WRADH");
-        } else if (strcmp(sparam, "Wv"    ) == 0 ){; strcpy(return_string,"WRADV");
-        } else if (strcmp(sparam, "SNR"   ) == 0 ){; strcpy(return_string,"SNRH");
-//        } else if (strcmp(sparam, "SNRv"  ) == 0 ){; strcpy(return_string,"SNRV");
-        } else if (strcmp(sparam, "SQI"   ) == 0 ){; strcpy(return_string,"SQIH");
-//        } else if (strcmp(sparam, "SQIv"  ) == 0 ){; strcpy(return_string,"SQIV");
-//        } else if (strcmp(sparam, "ZDR"   ) == 0 ){; strcpy(return_string,"ZDR");
-//        } else if (strcmp(sparam, "RhoHV" ) == 0 ){; strcpy(return_string,"RHOHV");
-//        } else if (strcmp(sparam, "uPhiDP") == 0 ){; strcpy(return_string,"uPHIDP");
-//        } else if (strcmp(sparam, "PhiDP" ) == 0 ){; strcpy(return_string,"PHIDP");
-//        } else if (strcmp(sparam, "KDP"   ) == 0 ){; strcpy(return_string,"KDP");
-        } else {
-            strcpy(return_string,sparam);
-            int i;
-            for(i=0;i<strlen(return_string);i++){
-                return_string[i]=toupper(return_string[i]);
+static ssize_t read_rb5_stream_chunk(strRB5_STREAM *stream, strRB5_INFO *rb5_info){
+    // appends the next bytes of the stream, inflated if gzipped, to rb5_info->buffer, kept NUL terminated
+    // returns the number of bytes appended, 0 at the end of the stream, -1 on error
+
+    ssize_t n_read=0;
+
+    if(stream->n_alloc-rb5_info->buffer_len < RB5_STREAM_CHUNK_BYTES) {
+        size_t n_new=2*stream->n_alloc;
+        char *grown=realloc(rb5_info->buffer,sizeof(char)*(n_new+1));
+        if(grown == NULL) {
+            fprintf(stderr,"Error: cannot allocate the buffer of stream = %s\n",stream->inp_fname);
+            return(-1);
+        }
+        rb5_info->buffer=grown;
+        stream->n_alloc=n_new;
+    }
+    char *dest=rb5_info->buffer+rb5_info->buffer_len;
+    size_t n_room=stream->n_alloc-rb5_info->buffer_len;
+
+    if(!stream->gzipped) {
+        do n_read=read(stream->fd,dest,n_room); while((n_read < 0) && (errno == EINTR));
+    } else {
+        while(n_read == 0) {
+            if(stream->strm.avail_in == 0) {
+                ssize_t n_in;
+                do n_in=read(stream->fd,stream->gz_chunk,stream->gz_chunk_alloc); while((n_in < 0) && (errno == EINTR));
+                if(n_in < 0) {
+                    n_read=-1;
+                    break;
+                }
+                if(n_in == 0) {
+                    if(stream->gz_member_end) break;
+                    fprintf(stderr,"Error: stream = %s ends within a gzip member\n",stream->inp_fname);
+                    return(-1);
+                }
+                stream->strm.next_in=stream->gz_chunk;
+                stream->strm.avail_in=(uInt)n_in;
+            }
+            stream->strm.next_out=(Bytef *)dest;
+            stream->strm.avail_out=(uInt)n_room;
+            int Z_result=inflate(&(stream->strm),Z_NO_FLUSH);
+            if(Z_result == Z_STREAM_END) {
+                inflateReset(&(stream->strm)); //another member may follow
+                stream->gz_member_end=1;
+            } else if((Z_result == Z_OK) || (Z_result == Z_BUF_ERROR)) {
+                stream->gz_member_end=0;
+            } else {
+                fprintf(stderr,"zlib error: %d\n", Z_result);
+                return(-1);
             }
+            n_read=(ssize_t)(n_room-stream->strm.avail_out);
         }
-    return(return_string);
+    }
+    if(n_read < 0) {
+        fprintf(stderr,"Error while reading stream = %s (%s)\n",stream->inp_fname,strerror(errno));
+        return(-1);
+    }
 
+    rb5_info->buffer_len+=(size_t)n_read;
+    rb5_info->buffer[rb5_info->buffer_len]='\0';
+    return(n_read);
 }
 
 //#############################################################################
 
-strURPDATA what_is_this_param_to_urp(char *sparam){
-    strURPDATA urp;
-    // see /apps/urp/build/include/drpdecode.h
-                   urp.type=-1;
-            strcpy(urp.name,"n/a");
-            strcpy(urp.unit,"n/a");
-            strcpy(urp.desc,"n/a");
-               if (strcmp(sparam, "dataflag") == 0){
-        } else if (strcmp(sparam, "startangle") == 0){
-        } else if (strcmp(sparam, "stopangle") == 0){
-        } else if (strcmp(sparam, "startfixangle") == 0){
-        } else if (strcmp(sparam, "stopafixngle") == 0){
-        } else if (strcmp(sparam, "numpulses") == 0 ){
-        } else if (strcmp(sparam, "timestamp") == 0 ){
-        } else if (strcmp(sparam, "txpower") == 0 ){
-        } else if (strcmp(sparam, "noisepowerh") == 0 ){
-        } else if (strcmp(sparam, "noisepowerv") == 0 ){
-        } else if (strcmp(sparam, "dBuZ") == 0 ){
-                   urp.type=1;
-            strcpy(urp.name,"DBT");
-            strcpy(urp.unit,"dBZ");
-            strcpy(urp.desc,"Uncorrected Reflectivity");
-        } else if (strcmp(sparam, "dBZ") == 0 ){
-                   urp.type=2;
-            strcpy(urp.name,"DBZ");
-            strcpy(urp.unit,"dBZ");
-            strcpy(urp.desc,"Reflectivity");
-        } else if (strcmp(sparam, "V") == 0 ){
-                   urp.type=3;
-            strcpy(urp.name,"VEL");
-            strcpy(urp.unit,"m/s");
-            strcpy(urp.desc,"Velocity");
-        } else if (strcmp(sparam, "W") == 0 ){
-                   urp.type=4;
-            strcpy(urp.name,"WID");
-            strcpy(urp.unit,"m/s");
-            strcpy(urp.desc,"Width");
-        } else if (strcmp(sparam, "SNR") == 0 ){
-                   urp.type=100;
-            strcpy(urp.name,"SNR");
-            strcpy(urp.unit,"");
-            strcpy(urp.desc,"Signal to Noise");
-        } else if (strcmp(sparam, "SQI") == 0 ){
-                   urp.type=18;
-            strcpy(urp.name,"SQI");
-            strcpy(urp.unit,"");
-            strcpy(urp.desc,"Signal Quality Index");
-        } else if (strcmp(sparam, "ZDR") == 0 ){
-                   urp.type=5;
-            strcpy(urp.name,"ZDR");
-            strcpy(urp.unit,"dB");
-            strcpy(urp.desc,"Differential Reflectivity");
-        } else if (strcmp(sparam, "RhoHV") == 0 ){
-                   urp.type=19;
-            strcpy(urp.name,"RHOHV");
-            strcpy(urp.unit,"");
-            strcpy(urp.desc,"Correlation Coefficient");
-        } else if (strcmp(sparam, "uPhiDP") == 0 ){
-                   urp.type=216; //New URP decree 2017-Sep-12; was urp.type=16
-            strcpy(urp.name,"UPHIDP");
-            strcpy(urp.unit,"deg");
-            strcpy(urp.desc,"Uncorrected Differential Phase");
-        } else if (strcmp(sparam, "PhiDP") == 0 ){
-                   urp.type=16;
-            strcpy(urp.name,"PHIDP");
-            strcpy(urp.unit,"deg");
-            strcpy(urp.desc,"Differential Phase");
-        } else if (strcmp(sparam, "uKDP") == 0 ){
-                   urp.type=14;
-            strcpy(urp.name,"UKDP");
-            strcpy(urp.unit,"deg/km");
-            strcpy(urp.desc,"Uncorrected Specific Differential Phase");
-        } else if (strcmp(sparam, "KDP") == 0 ){
-                   urp.type=14;
-            strcpy(urp.name,"KDP");
-            strcpy(urp.unit,"deg/km");
-            strcpy(urp.desc,"Specific Differential Phase");
+static int plan_rb5_blobs_ahead(strRB5_STREAM *stream, strRB5_INFO *rb5_info, const char **quantities, size_t n_quantities, const strRB5_SLICE_SELECT *slice_select){
+    // once the header is in: the <rawdata> blobs of the selected slices and quantities, to inflate
+    // as they come in, each sized nrays*nbins*depth as populate_rb5_info_slices() will expect
+
+    size_t this_slice, this_rawdata, i;
+    const strRB5_XML_MODEL *xml_model=rb5_info->xml_model;
+
+    stream->n_ahead=0;
+    for (this_slice = 0; this_slice < xml_model->n_slices; this_slice++){
+        stream->n_ahead+=xml_model->slice_arr[this_slice].n_rawdatas;
+    }
+    if(stream->n_ahead == 0) return(EXIT_SUCCESS);
+    stream->ahead=(strRB5_BLOB_INFO *)RAVE_CALLOC(stream->n_ahead,sizeof(strRB5_BLOB_INFO));
+    if(stream->ahead == NULL) return(EXIT_FAILURE);
+
+    stream->n_ahead=0;
+    for (this_slice = 0; this_slice < xml_model->n_slices; this_slice++){
+        float angle_deg=atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"posangle",NULL));
+        if(!is_rb5_slice_selected(slice_select,this_slice,angle_deg)) continue;
+        const strRB5_XML_SLICE *xml_slice=&(xml_model->slice_arr[this_slice]);
+        for (this_rawdata = 0; this_rawdata < xml_slice->n_rawdatas; this_rawdata++){
+            const strRB5_XML_PARAM *xml_param=&(xml_slice->rawdata_arr[this_rawdata]);
+            int selected=(quantities == NULL);
+            for (i = 0; (!selected) && (i < n_quantities); i++){
+                if (strcmp(xml_param->quantity,quantities[i]) == 0) selected=1;
+            }
+            size_t depth=xml_param->raw_binary_depth;
+            if(!selected || ((depth != 8) && (depth != 16) && (depth != 32))) continue;
+            stream->ahead[stream->n_ahead].blobid=xml_param->blobid;
+            stream->ahead[stream->n_ahead].inflated_len=xml_param->nrays*xml_param->nbins*(depth/8);
+            stream->n_ahead++;
         }
-    return(urp);
+    }
+    if(stream->n_ahead > 1) qsort(stream->ahead,stream->n_ahead,sizeof(strRB5_BLOB_INFO),compare_rb5_blobs);
+    return(EXIT_SUCCESS);
 }
 
 //#############################################################################
 
-void close_rb5_info(strRB5_INFO *rb5_info){
-
-  if(rb5_info->xpathCtx != NULL) xmlXPathFreeContext(rb5_info->xpathCtx); //cleanup
-  if(rb5_info->doc      != NULL) xmlFreeDoc(rb5_info->doc); // free the document
-  if(rb5_info->buffer   != NULL) close_file_buffer(rb5_info->buffer); // free entire file buffer
+static void inflate_rb5_blobs_ahead(strRB5_STREAM *stream, strRB5_INFO *rb5_info){
+    // the planned blobs indexed since the last call, inflated whole
+    // a blob not inflated here, or that fails, is left to decode_param_blobid()
+
+    for (; stream->next_blob < rb5_info->n_blob_index; stream->next_blob++){
+        strRB5_BLOB_INFO *blob_info=&(rb5_info->blob_index[stream->next_blob]);
+        strRB5_BLOB_INFO *planned=search_rb5_blobs(stream->ahead,stream->n_ahead,blob_info->blobid);
+        if((planned == NULL) || (planned->inflated_len == 0) || (blob_info->size_blob < 4)) continue;
+        size_t expectedSize=planned->inflated_len;
+
+        //the size prefix is checked against the header before it sizes anything
+        const unsigned char *buf=(const unsigned char *)(rb5_info->buffer)+(blob_info->byte_offset);
+        size_t prefixSize=((size_t)buf[0] << 24) |
+                          ((size_t)buf[1] << 16) |
+                          ((size_t)buf[2] <<  8) |
+                          ((size_t)buf[3]      );
+        if(prefixSize != expectedSize) continue;
+        unsigned char *inflated=(unsigned char *)RAVE_MALLOC(expectedSize);
+        if(inflated == NULL) continue;
+        if(inflate_blob(buf+4,blob_info->size_blob-4,inflated,expectedSize) != expectedSize) {
+            RAVE_FREE(inflated);
+            continue;
+        }
+        blob_info->inflated=inflated;
+        blob_info->inflated_len=expectedSize;
+    }
+}
 
-  int this_slice;  
-  for (this_slice = 0; this_slice < rb5_info->n_slices; this_slice++){
-    if(rb5_info->slice_moving_angle_start_arr[this_slice] != NULL) RAVE_FREE(rb5_info->slice_moving_angle_start_arr[this_slice]);
-    if(rb5_info->slice_moving_angle_stop_arr[this_slice] != NULL) RAVE_FREE(rb5_info->slice_moving_angle_stop_arr[this_slice]);
-    if(rb5_info->slice_fixed_angle_start_arr[this_slice] != NULL) RAVE_FREE(rb5_info->slice_fixed_angle_start_arr[this_slice]);
-    if(rb5_info->slice_fixed_angle_stop_arr[this_slice] != NULL) RAVE_FREE(rb5_info->slice_fixed_angle_stop_arr[this_slice]);
+//#############################################################################
 
-    if(rb5_info->slice_moving_angle_arr[this_slice] != NULL) RAVE_FREE(rb5_info->slice_moving_angle_arr[this_slice]);
-    if(rb5_info->slice_fixed_angle_arr[this_slice] != NULL) RAVE_FREE(rb5_info->slice_fixed_angle_arr[this_slice]);
-  }
+static int fail_rb5_stream(strRB5_STREAM *stream, strRB5_XML_MODEL *model, strRB5_INFO *rb5_info){
+    // releases all read_rb5_stream() had built so far, returns EXIT_FAILURE
 
+    if(model != NULL) {
+        model=end_rb5_xml_model(model); //stops the parser
+        if(model != NULL) free_rb5_xml_model(model);
+    }
+    if(stream->gzipped) inflateEnd(&(stream->strm));
+    if(stream->gz_chunk != NULL) free(stream->gz_chunk);
+    if(stream->ahead != NULL) RAVE_FREE(stream->ahead);
+    close_rb5_info(&(*rb5_info));
+    rb5_info->buffer=NULL;
+    return(EXIT_FAILURE);
 }
 
 //#############################################################################
 
-char *get_xpath_slice_attrib(const xmlXPathContextPtr xpathCtx, size_t this_slice, char *xpath_end) {
+int read_rb5_stream(int fd, const char *inp_fname, const char **quantities, size_t n_quantities, const strRB5_SLICE_SELECT *slice_select, strRB5_INFO *rb5_info){
+    // reads an RB5 payload, possibly gzipped, from fd to its end without seeking (pipe, socket, stdin),
+    // inp_fname naming it in messages and metadata; the XML header model and the blob index are
+    // built as the bytes come in, and each blob of the selected slices and quantities (all if NULL)
+    // is inflated as soon as it is complete
+    // no static buffer is used, only this thread's XML parser
+    // rb5_info is then ready for populate_rb5_info*(), close_rb5_info() releases it
+
+    char marker[]="<!-- END XML -->";
+    size_t marker_len=strlen(marker);
+    size_t n_fed=0;            //bytes of the header fed to the XML parser
+    size_t n_searched=0;       //of the buffer, for the marker
+    size_t end_of_xml=0;
+    size_t byte_offset_scan=0; //the blob index resumes from here
+    size_t n_alloc_index=0;
+    ssize_t n_read=1;
+    strRB5_XML_MODEL *model=NULL;
+
+    strRB5_STREAM stream;
+    memset(&stream,0,sizeof(strRB5_STREAM));
+    stream.fd=fd;
+    stream.inp_fname=inp_fname;
+
+    snprintf(rb5_info->inp_fullfile,MAX_STRING,"%s",inp_fname);
+    rb5_info->buffer_len=0;
+    rb5_info->buffer_owner=FILE_BUFFER_HEAP;
+    rb5_info->byte_offset_blobspace=0;
+    rb5_info->blobspace_pending=0;
+    rb5_info->doc=NULL;
+    rb5_info->xpathCtx=NULL;
+    rb5_info->xml_model=NULL;
+    rb5_info->blob_index=NULL;
+    rb5_info->n_blob_index=0;
+    rb5_info->n_slices=0; //close_rb5_info() is safe from here on
+    stream.n_alloc=RB5_STREAM_CHUNK_BYTES;
+    rb5_info->buffer=malloc(sizeof(char)*(stream.n_alloc+1));
+    if(rb5_info->buffer == NULL) {
+        fprintf(stderr,"Error: cannot allocate the buffer of stream = %s\n",inp_fname);
+        return(EXIT_FAILURE);
+    }
+    rb5_info->buffer[0]='\0';
+
+    //gzipped or not, by its first bytes
+    while((rb5_info->buffer_len < GZIP_MIN_BYTES) && (n_read > 0)) n_read=read_rb5_stream_chunk(&stream,&(*rb5_info));
+    if(n_read < 0) return(fail_rb5_stream(&stream,model,&(*rb5_info)));
+    if(is_gzip_buffer((const unsigned char *)rb5_info->buffer,rb5_info->buffer_len)) {
+        stream.gz_chunk_alloc=stream.n_alloc;
+        stream.gz_chunk=(unsigned char *)malloc(stream.gz_chunk_alloc);
+        if((stream.gz_chunk == NULL) || (inflateInit2(&(stream.strm),16+MAX_WBITS) != Z_OK)) {
+            fprintf(stderr,"Error: cannot gunzip stream = %s\n",inp_fname);
+            return(fail_rb5_stream(&stream,model,&(*rb5_info)));
+        }
+        stream.gzipped=1;
+        memcpy(stream.gz_chunk,rb5_info->buffer,rb5_info->buffer_len);
+        stream.strm.next_in=stream.gz_chunk;
+        stream.strm.avail_in=(uInt)rb5_info->buffer_len;
+        rb5_info->buffer_len=0;
+        n_read=1;
+    }
 
-  char xpath[MAX_STRING]="\0";
-  char xpath_bgn[MAX_STRING]="\0";
-  static char return_string[MAX_STRING]="\0";
-  int iSLICE=0;
-  int ifoundSLICE=0;
-  //compare this_SLICE vs iSLICE=0
-  iSLICE=this_slice;
-  sprintf(xpath_bgn,"(/volume/scan/slice)[%2d]",iSLICE+1);
-  if(                        get_xpath_size(xpathCtx,strcat(strcpy(xpath,xpath_bgn),xpath_end))){
-    strcpy(return_string,return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),xpath_end)));
-    ifoundSLICE=iSLICE;
-  } else {
-    iSLICE=0;
-    sprintf(xpath_bgn,"(/volume/scan/slice)[%2d]",iSLICE+1);
-    strcpy(return_string,return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),xpath_end)));
-    ifoundSLICE=iSLICE;
-  }
-if(L_DEBUG_OUTPUT_2) fprintf(stdout,"ifoundSLICE = %2d : %s = %s\n",ifoundSLICE,xpath_end,return_string);
-  return(return_string); 
-  
+    //XML header, parsed as it comes in
+    model=begin_rb5_xml_model();
+    if(model == NULL) return(fail_rb5_stream(&stream,model,&(*rb5_info)));
+    while(1) {
+        size_t search_bgn=(n_searched >= marker_len) ? n_searched-marker_len+1 : 0;
+        char *match=find_in_buffer(rb5_info->buffer+search_bgn,rb5_info->buffer_len-search_bgn,marker);
+        n_searched=rb5_info->buffer_len;
+        if(match != NULL) {
+            end_of_xml=match-(rb5_info->buffer)+marker_len+1; //count trailing \n, as find_buffer_end_of_xml()
+            if(end_of_xml > rb5_info->buffer_len) end_of_xml=rb5_info->buffer_len;
+        } else if(n_read == 0) {
+            end_of_xml=rb5_info->buffer_len; //no marker, header only
+        }
+        size_t n_feed=((end_of_xml > 0) ? end_of_xml : rb5_info->buffer_len)-n_fed;
+        if(feed_rb5_xml_model(rb5_info->buffer+n_fed,n_feed) != 0) {
+            fprintf(stderr,"Error: not an RB5 XML header in stream = %s\n",inp_fname);
+            return(fail_rb5_stream(&stream,model,&(*rb5_info)));
+        }
+        n_fed+=n_feed;
+        if((end_of_xml > 0) || (n_read == 0)) break;
+        if((n_read=read_rb5_stream_chunk(&stream,&(*rb5_info))) < 0) return(fail_rb5_stream(&stream,model,&(*rb5_info)));
+    }
+    rb5_info->xml_model=end_rb5_xml_model(model);
+    model=NULL;
+    if(rb5_info->xml_model == NULL) {
+        fprintf(stderr,"Error: cannot read the XML header of stream = %s\n",inp_fname);
+        return(fail_rb5_stream(&stream,model,&(*rb5_info)));
+    }
+    rb5_info->byte_offset_blobspace=end_of_xml;
+    if(L_DEBUG_OUTPUT_1) fprintf(stdout,"stream XML header = %ld bytes\n",end_of_xml);
+
+    if(plan_rb5_blobs_ahead(&stream,&(*rb5_info),quantities,n_quantities,slice_select) != 0) return(fail_rb5_stream(&stream,model,&(*rb5_info)));
+
+    //blobs, indexed and inflated as each is complete
+    byte_offset_scan=end_of_xml;
+    while(1) {
+        if(index_rb5_blobs_part(&(*rb5_info),&byte_offset_scan,&n_alloc_index,(n_read == 0)) != 0) return(fail_rb5_stream(&stream,model,&(*rb5_info)));
+        inflate_rb5_blobs_ahead(&stream,&(*rb5_info));
+        if(n_read == 0) break;
+        if((n_read=read_rb5_stream_chunk(&stream,&(*rb5_info))) < 0) return(fail_rb5_stream(&stream,model,&(*rb5_info)));
+    }
+
+    if(stream.gzipped) inflateEnd(&(stream.strm));
+    if(stream.gz_chunk != NULL) free(stream.gz_chunk);
+    if(stream.ahead != NULL) RAVE_FREE(stream.ahead);
+    sort_rb5_blobs(&(*rb5_info));
+    return(EXIT_SUCCESS);
 }
 
 //#############################################################################
 
-int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
+static int populate_rb5_info_mode(strRB5_INFO *rb5_info, int L_VERBOSE, const strRB5_SLICE_SELECT *slice_select, int header_mode){
 
-    const xmlXPathContextPtr xpathCtx=rb5_info->xpathCtx;
     char xpath[MAX_STRING]="\0";
     char xpath_bgn[MAX_STRING]="\0";
 
@@ -493,11 +1818,31 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
     strcpy(stmpa,rb5_info->inp_fullfile);
     strcpy(rb5_info->inp_file_dirname , dirname(stmpa));
 
+    rb5_info->header_mode=header_mode;
+
+    //one pass over the XML header, it is thereafter read from this model
+    //the caller may have built it already, e.g. to check quantities before any blob is read
+    if(rb5_info->xml_model == NULL) rb5_info->xml_model=build_rb5_xml_model(rb5_info->buffer,rb5_info->byte_offset_blobspace);
+    if(rb5_info->xml_model == NULL){
+        fprintf(stderr,"Error: cannot read the XML header of file = %s\n",rb5_info->inp_fullfile);
+        close_rb5_info(&(*rb5_info));
+        return(EXIT_FAILURE);
+    }
+    const strRB5_XML_MODEL *xml_model=rb5_info->xml_model;
+
+    //one pass over the blob space, blobs are thereafter looked up by blobid
+    //read_rb5_stream() built the index already, as the blobs came in
+    if((header_mode != RB5_HEADER_ONLY) && (rb5_info->blob_index == NULL) && (index_rb5_blobs(&(*rb5_info)) != 0)){
+        fprintf(stderr,"Error: cannot index BLOBs\n");
+        close_rb5_info(&(*rb5_info));
+        return(EXIT_FAILURE);
+    }
+
     //determine data type by file contents
-    sprintf(xpath_bgn,"(/volume/scan/slice)[1]/slicedata/rawdata");
-    int this_n_rawdatas=get_xpath_size(xpathCtx,xpath_bgn);
+    const strRB5_XML_SLICE *xml_slice=get_rb5_xml_slice(&(*rb5_info),0);
+    int this_n_rawdatas=(xml_slice == NULL) ? 0 : xml_slice->n_rawdatas;
     if(this_n_rawdatas == 0){
-        int rawdatapacked_exists=get_xpath_size(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"packed"));
+        int rawdatapacked_exists=(xml_slice == NULL) ? 0 : xml_slice->n_rawdatapackeds;
         if(rawdatapacked_exists == 0) {
             strcpy(rb5_info->inp_file_data_type,"UNKNOWN");
         } else {
@@ -507,7 +1852,7 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
         close_rb5_info(&(*rb5_info));
         return(EXIT_FAILURE);
     } else if (this_n_rawdatas == 1){
-        strcpy(rb5_info->inp_file_data_type,return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/@type")));
+        strcpy(rb5_info->inp_file_data_type,xml_slice->rawdata_arr[0].sparam);
     } else {
         strcpy(rb5_info->inp_file_data_type,"ALL");
     }
@@ -520,22 +1865,22 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
 
     strRB5_PARAM_INFO rb5_param;
 
-    strcpy(rb5_info->rainbow_version,return_xpath_value(xpathCtx,"/volume/@version"));
+    strcpy(rb5_info->rainbow_version,xml_model->version);
     if(strcmp(rb5_info->rainbow_version,MINIMUM_RAINBOW_VERSION) < 0){
         fprintf(stderr,"Error: Incompatible Rainbow version, this is v%s, (v%s minumum)\n",rb5_info->rainbow_version,MINIMUM_RAINBOW_VERSION);
         close_rb5_info(&(*rb5_info));
         return(EXIT_FAILURE);
     }
     
-    strcpy(rb5_info->xml_block_name,return_xpath_name(xpathCtx,"/*[1]")); //top level name query
+    strcpy(rb5_info->xml_block_name,xml_model->root_name); //top level name
     if(strcmp(rb5_info->xml_block_name,"volume") != 0){
         fprintf(stderr,"Error: This is not a Rainbow raw file, expecting <volume>, this is a <%s>\n",rb5_info->xml_block_name);
         close_rb5_info(&(*rb5_info));
         return(EXIT_FAILURE);
     }
 
-    strcpy(rb5_info->xml_block_type   ,return_xpath_value(xpathCtx,"/volume/@type"));
-    strcpy(rb5_info->xml_block_iso8601,return_xpath_value(xpathCtx,"/volume/@datetime"));
+    strcpy(rb5_info->xml_block_type   ,xml_model->type);
+    strcpy(rb5_info->xml_block_iso8601,xml_model->datetime);
     strncpy(rb5_info->xml_block_iso8601+10," ",1); //blank T-delimiter
     if(L_VERBOSE){
         fprintf(stdout,"%s = %s\n", "rb5_info->rainbow_version"  , rb5_info->rainbow_version);
@@ -544,14 +1889,13 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
         fprintf(stdout,"%s = %s\n", "rb5_info->xml_block_iso8601", rb5_info->xml_block_iso8601);
     }
 
-    strcpy(xpath_bgn,"/volume/sensorinfo");
-    strcpy(rb5_info->sensor_id           ,     return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/@id")));
-    strcpy(rb5_info->sensor_name         ,     return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/@name")));
-           rb5_info->sensor_lon_deg      =atof(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/lon")));
-           rb5_info->sensor_lat_deg      =atof(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/lat")));
-           rb5_info->sensor_alt_m        =atof(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/alt")));
-           rb5_info->sensor_wavelength_cm=atof(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/wavelen")))*100.;
-           rb5_info->sensor_beamwidth_deg=atof(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/beamwidth")));
+    strcpy(rb5_info->sensor_id           ,     xml_model->sensor_id);
+    strcpy(rb5_info->sensor_name         ,     xml_model->sensor_name);
+           rb5_info->sensor_lon_deg      =atof(get_rb5_sensorinfo_attrib(&(*rb5_info),"lon"));
+           rb5_info->sensor_lat_deg      =atof(get_rb5_sensorinfo_attrib(&(*rb5_info),"lat"));
+           rb5_info->sensor_alt_m        =atof(get_rb5_sensorinfo_attrib(&(*rb5_info),"alt"));
+           rb5_info->sensor_wavelength_cm=atof(get_rb5_sensorinfo_attrib(&(*rb5_info),"wavelen"))*100.;
+           rb5_info->sensor_beamwidth_deg=atof(get_rb5_sensorinfo_attrib(&(*rb5_info),"beamwidth"));
     if(L_VERBOSE){
         fprintf(stdout,"%s = %s\n"  , "rb5_info->sensor_id"           , rb5_info->sensor_id);
         fprintf(stdout,"%s = %s\n"  , "rb5_info->sensor_name"         , rb5_info->sensor_name);
@@ -563,39 +1907,38 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
     }
 
     rb5_info->history_exists=0;
-    strcpy(xpath_bgn,"/volume/history"); //check for this named block
-    if(strcmp(return_xpath_name(xpathCtx,xpath_bgn),"history") == 0){
+    if(xml_model->history_exists){ //check for this named block
         rb5_info->history_exists=1;
-        strcpy(rb5_info->history_pdfname   ,return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/@pdfname")));
-        strcpy(rb5_info->history_ppdfname  ,return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/@ppdfname")));
-        strcpy(rb5_info->history_sdfname   ,return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/@sdfname")));
+        strcpy(rb5_info->history_pdfname   ,xml_model->history_pdfname);
+        strcpy(rb5_info->history_ppdfname  ,xml_model->history_ppdfname);
+        strcpy(rb5_info->history_sdfname   ,xml_model->history_sdfname);
         if(L_VERBOSE){
             fprintf(stdout,"%s = %s\n", "rb5_info->history_pdfname" , rb5_info->history_pdfname);
             fprintf(stdout,"%s = %s\n", "rb5_info->history_ppdfname", rb5_info->history_ppdfname);
             fprintf(stdout,"%s = %s\n", "rb5_info->history_sdfname" , rb5_info->history_sdfname);
         }        
         strcpy(xpath_bgn,"/volume/history/rawdatafiles/file");
-        rb5_info->history_n_rawdatafiles=get_xpath_size(xpathCtx,xpath_bgn);
+        rb5_info->history_n_rawdatafiles=xml_model->history_rawdatafiles.n_fields;
         if(L_VERBOSE){
             fprintf(stdout,"%s = %ld\n", "rb5_info->history_n_rawdatafiles" , rb5_info->history_n_rawdatafiles);
         }
         size_t this_rawdatafile;
         for (this_rawdatafile = 0; this_rawdatafile < rb5_info->history_n_rawdatafiles; this_rawdatafile++){
             sprintf(xpath,"(%s)[%2ld]",xpath_bgn,this_rawdatafile+1);
-            strcpy(rb5_info->history_rawdatafiles_arr[this_rawdatafile],return_xpath_value(xpathCtx,xpath));
+            strcpy(rb5_info->history_rawdatafiles_arr[this_rawdatafile],xml_model->history_rawdatafiles.field_arr[this_rawdatafile].value);
             if(L_VERBOSE){
                 fprintf(stdout,"%s = %s\n", xpath, rb5_info->history_rawdatafiles_arr[this_rawdatafile]);
             }
         }
         strcpy(xpath_bgn,"/volume/history/preprocessedfiles/file");
-        rb5_info->history_n_preprocessedfiles=get_xpath_size(xpathCtx,xpath_bgn);
+        rb5_info->history_n_preprocessedfiles=xml_model->history_preprocessedfiles.n_fields;
         if(L_VERBOSE){
             fprintf(stdout,"%s = %ld\n", "rb5_info->history_n_preprocessedfiles" , rb5_info->history_n_preprocessedfiles);
         }
         size_t this_preprocessedfile;
         for (this_preprocessedfile = 0; this_preprocessedfile < rb5_info->history_n_preprocessedfiles; this_preprocessedfile++){
             sprintf(xpath,"(%s)[%2ld]",xpath_bgn,this_preprocessedfile+1);
-            strcpy(rb5_info->history_preprocessedfiles_arr[this_preprocessedfile],return_xpath_value(xpathCtx,xpath));
+            strcpy(rb5_info->history_preprocessedfiles_arr[this_preprocessedfile],xml_model->history_preprocessedfiles.field_arr[this_preprocessedfile].value);
             if(L_VERBOSE){
                 fprintf(stdout,"%s = %s\n", xpath, rb5_info->history_preprocessedfiles_arr[this_preprocessedfile]);
             }
@@ -603,7 +1946,7 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
     }
 
     strcpy(rb5_info->scan_type,rb5_info->xml_block_type); //copy from xml_block
-    strcpy(stmpa,return_xpath_value(xpathCtx,"/volume/scan/@name"));
+    strcpy(stmpa,xml_model->scan_name);
     strncpy(rb5_info->scan_name,stmpa,strlen(stmpa)-strlen(rb5_info->scan_type)-1);
     rb5_info->scan_name[strlen(stmpa)-strlen(rb5_info->scan_type)-1]='\0'; // place the null terminator
     if(L_VERBOSE){
@@ -620,12 +1963,11 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
     rb5_info->iray_0degN[this_slice]=-1;
 
     //RAYINFO
-    sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)",this_slice+1,"rayinfo");
-    rb5_info->n_rayinfos=get_xpath_size(xpathCtx,xpath_bgn);
+    rb5_info->n_rayinfos=xml_slice->n_rayinfos;
     for (this_rayinfo = 0; this_rayinfo < rb5_info->n_rayinfos; this_rayinfo++){
-      sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)[%2ld]/",this_slice+1,"rayinfo",this_rayinfo+1);
-      rb5_param=get_rb5_param_info(rb5_info,xpath_bgn,L_RB5_PARAM_VERBOSE);
+      rb5_param=get_rb5_param_info(rb5_info,this_slice,"rayinfo",this_rayinfo,L_RB5_PARAM_VERBOSE);
       strcpy(rb5_info->rayinfo_name_arr[this_rayinfo],rb5_param.sparam);
+      rb5_info->rayinfo_kind_arr[this_rayinfo]=rb5_param.kind;
     } //for (this_rayinfo = 0; this_rayinfo < rb5_info->n_rayinfos; this_rayinfo++){
 
     if(L_DEBUG_OUTPUT_1){
@@ -642,12 +1984,11 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
     }
 
     //RAWDATA
-    sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)",this_slice+1,"rawdata");
-    rb5_info->n_rawdatas=get_xpath_size(xpathCtx,xpath_bgn);
+    rb5_info->n_rawdatas=xml_slice->n_rawdatas;
     for (this_rawdata = 0; this_rawdata < rb5_info->n_rawdatas; this_rawdata++){
-      sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)[%2ld]/",this_slice+1,"rawdata",this_rawdata+1);
-      rb5_param=get_rb5_param_info(rb5_info,xpath_bgn,L_RB5_PARAM_VERBOSE);
+      rb5_param=get_rb5_param_info(rb5_info,this_slice,"rawdata",this_rawdata,L_RB5_PARAM_VERBOSE);
       strcpy(rb5_info->rawdata_name_arr[this_rawdata],rb5_param.sparam);
+      rb5_info->rawdata_selected[this_rawdata]=1;
     } //for (this_rawdata = 0; this_rawdata < rb5_info->n_rawdatas; this_rawdata++){
 
     if(L_DEBUG_OUTPUT_1) {
@@ -663,18 +2004,46 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
       fprintf(stdout,"]\n");
     } //if(L_DEBUG_OUTPUT_1) {
 
-    strcpy(xpath,"/volume/scan/pargroup/numele");
-    rb5_info->n_slices=atoi(return_xpath_value(xpathCtx,xpath));
+    rb5_info->n_slices=atoi(get_rb5_pargroup_attrib(&(*rb5_info),NULL,"numele"));
     if(L_VERBOSE){
         fprintf(stdout,"%s = %ld\n", "rb5_info->n_slices", rb5_info->n_slices);
     }
 
+    //slice subset, by index or by <posangle>
+    rb5_info->n_slices_selected=0;
+    for (this_slice = 0; this_slice < rb5_info->n_slices; this_slice++){
+        //init, close_rb5_info() frees the readbacks of selected slices only
+        rb5_info->slice_moving_angle_start_arr[this_slice]=NULL;
+        rb5_info->slice_moving_angle_stop_arr[this_slice]=NULL;
+        rb5_info->slice_fixed_angle_start_arr[this_slice]=NULL;
+        rb5_info->slice_fixed_angle_stop_arr[this_slice]=NULL;
+        rb5_info->slice_moving_angle_arr[this_slice]=NULL;
+        rb5_info->slice_fixed_angle_arr[this_slice]=NULL;
+        rb5_info->iray_0degN[this_slice]=-1;
+
+        rb5_info->angle_deg_arr[this_slice]=atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"posangle",NULL));
+        rb5_info->slice_selected[this_slice]=is_rb5_slice_selected(slice_select,this_slice,rb5_info->angle_deg_arr[this_slice]);
+        if(rb5_info->slice_selected[this_slice]) rb5_info->n_slices_selected++;
+    }
+    if(rb5_info->n_slices_selected == 0){
+        fprintf(stderr,"Error: none of the requested slices in file = %s\n",rb5_info->inp_fullfile);
+        close_rb5_info(&(*rb5_info));
+        return(EXIT_FAILURE);
+    }
+
     char req_rawdata_name[MAX_STRING]="\0";
     int idx_req=-1;
     for (this_slice = 0; this_slice < rb5_info->n_slices; this_slice++){
 
-        //init
-        rb5_info->iray_0degN[this_slice]=-1;
+        if(!rb5_info->slice_selected[this_slice]) {
+            //the object's nominal time is that of the first (or last) slice, selected or not
+            if((this_slice == 0) || (this_slice == rb5_info->n_slices-1)) {
+                xml_slice=get_rb5_xml_slice(&(*rb5_info),this_slice);
+                strcpy(rb5_info->slice_iso8601_bgn[this_slice],(xml_slice == NULL) ? "" : xml_slice->iso8601);
+                get_slice_end_iso8601(&(*rb5_info),this_slice);
+            }
+            continue;
+        }
 
         //update dims
             strcpy(req_rawdata_name,"dBZ"); //mandatory
@@ -687,33 +2056,32 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
         if(idx_req == -1) {
             fprintf(stdout,"IMPOSSIBLE: %s not found\n", req_rawdata_name);
         } else {
-            sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)[%2d]/",this_slice+1,"rawdata",idx_req+1);
-            rb5_param=get_rb5_param_info(rb5_info,xpath_bgn,L_RB5_PARAM_VERBOSE);
+            rb5_param=get_rb5_param_info(rb5_info,this_slice,"rawdata",idx_req,L_RB5_PARAM_VERBOSE);
             rb5_info->nrays[this_slice]=rb5_param.nrays;
             rb5_info->nbins[this_slice]=rb5_param.nbins;
             rb5_info->n_elems_data[this_slice]=rb5_param.n_elems_data;
         }
 
         sprintf(xpath_bgn,"(/volume/scan/slice)[%2d]",this_slice+1);
-        // Note: using get_xpath_slice_attrib() to cycle thru 0th slice upward
-        strcpy(rb5_info->slice_iso8601_bgn      [this_slice],get_xpath_iso8601_attrib(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/slicedata/")));
+        xml_slice=get_rb5_xml_slice(&(*rb5_info),this_slice);
+        // Note: using get_rb5_slice_attrib() to fall back on the 0th slice
+        strcpy(rb5_info->slice_iso8601_bgn      [this_slice],(xml_slice == NULL) ? "" : xml_slice->iso8601);
         get_slice_end_iso8601(&(*rb5_info),      this_slice);
-               rb5_info->angle_deg_arr          [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/posangle"));
-               rb5_info->slice_nyquist_vel      [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/dynv/@max"));
-               rb5_info->slice_nyquist_wid      [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/dynw/@max"));
-               rb5_info->slice_bin_range_res_km [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/rangestep"));
-               rb5_info->slice_bin_range_bgn_km [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/start_range"));
-               rb5_info->slice_bin_range_end_km [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/stoprange"));
-               rb5_info->slice_ray_angle_res_deg[this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/anglestep"));
-               rb5_info->slice_ray_angle_bgn_deg[this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/startangle"));
-               rb5_info->slice_ray_angle_end_deg[this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/stopangle"));
+               rb5_info->slice_nyquist_vel      [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"dynv","max"));
+               rb5_info->slice_nyquist_wid      [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"dynw","max"));
+               rb5_info->slice_bin_range_res_km [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"rangestep",NULL));
+               rb5_info->slice_bin_range_bgn_km [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"start_range",NULL));
+               rb5_info->slice_bin_range_end_km [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"stoprange",NULL));
+               rb5_info->slice_ray_angle_res_deg[this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"anglestep",NULL));
+               rb5_info->slice_ray_angle_bgn_deg[this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"startangle",NULL));
+               rb5_info->slice_ray_angle_end_deg[this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"stopangle",NULL));
         //NOTE: since Rainbow v5.51 (re: CWRRP), pulse width determination via XML tag <pw_index> was replaced by <dynpw>
         static char tmp_a[MAX_STRING]="\0";
-        if(strcpy(tmp_a,get_xpath_slice_attrib(xpathCtx,this_slice,"/dynpw"))) {
+        if(strcpy(tmp_a,get_rb5_slice_attrib(&(*rb5_info),this_slice,"dynpw",NULL))) {
                rb5_info->slice_pw_index         [this_slice]=0; //radconst now a scalar
                rb5_info->slice_pw_microsec      [this_slice]=atof(tmp_a);
         } else {
-               size_t slice_pw_index=atoi(get_xpath_slice_attrib(xpathCtx,this_slice,"/pw_index"));
+               size_t slice_pw_index=atoi(get_rb5_slice_attrib(&(*rb5_info),this_slice,"pw_index",NULL));
                rb5_info->slice_pw_index         [this_slice]=slice_pw_index;
                if(slice_pw_index == 0){
                  rb5_info->slice_pw_microsec    [this_slice]=0.3;
@@ -726,25 +2094,25 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
                }
         }
 
-               rb5_info->slice_antspeed_deg_sec [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/antspeed"));
+               rb5_info->slice_antspeed_deg_sec [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"antspeed",NULL));
                rb5_info->slice_antspeed_rpm     [this_slice]= rb5_info->slice_antspeed_deg_sec [this_slice]/360.*60.;
-               rb5_info->slice_num_samples      [this_slice]= atoi(get_xpath_slice_attrib(xpathCtx,this_slice,"/timesamp"));
-        strcpy(rb5_info->slice_dual_prf_mode    [this_slice],      get_xpath_slice_attrib(xpathCtx,this_slice,"/dualprfmode"));
-        strcpy(rb5_info->slice_prf_stagger      [this_slice],      get_xpath_slice_attrib(xpathCtx,this_slice,"/stagger"));
-               rb5_info->slice_hi_prf           [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/highprf"));
-               rb5_info->slice_lo_prf           [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/lowprf"));
-               rb5_info->slice_csr_threshold    [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/csr"));
-               rb5_info->slice_sqi_threshold    [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/sqi"));
-               rb5_info->slice_zsqi_threshold   [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/zsqi"));
-               rb5_info->slice_log_threshold    [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/log"));
-               rb5_info->slice_noise_power_h    [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/noise_power_dbz"));
-               rb5_info->slice_noise_power_v    [this_slice]= atof(get_xpath_slice_attrib(xpathCtx,this_slice,"/noise_power_dbz_dpv"));
+               rb5_info->slice_num_samples      [this_slice]= atoi(get_rb5_slice_attrib(&(*rb5_info),this_slice,"timesamp",NULL));
+        strcpy(rb5_info->slice_dual_prf_mode    [this_slice],      get_rb5_slice_attrib(&(*rb5_info),this_slice,"dualprfmode",NULL));
+        strcpy(rb5_info->slice_prf_stagger      [this_slice],      get_rb5_slice_attrib(&(*rb5_info),this_slice,"stagger",NULL));
+               rb5_info->slice_hi_prf           [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"highprf",NULL));
+               rb5_info->slice_lo_prf           [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"lowprf",NULL));
+               rb5_info->slice_csr_threshold    [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"csr",NULL));
+               rb5_info->slice_sqi_threshold    [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"sqi",NULL));
+               rb5_info->slice_zsqi_threshold   [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"zsqi",NULL));
+               rb5_info->slice_log_threshold    [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"log",NULL));
+               rb5_info->slice_noise_power_h    [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"noise_power_dbz",NULL));
+               rb5_info->slice_noise_power_v    [this_slice]= atof(get_rb5_slice_attrib(&(*rb5_info),this_slice,"noise_power_dbz_dpv",NULL));
 
         //NOTE: since Rainbow v5.51 (re: CWRRP), radconst is a scalar
         static char rspdphradconst[MAX_STRING]="\0";
         static char rspdpvradconst[MAX_STRING]="\0";
-        strcpy(rspdphradconst,get_xpath_slice_attrib(xpathCtx,this_slice,"/rspdphradconst"));
-        strcpy(rspdpvradconst,get_xpath_slice_attrib(xpathCtx,this_slice,"/rspdpvradconst"));
+        strcpy(rspdphradconst,get_rb5_slice_attrib(&(*rb5_info),this_slice,"rspdphradconst",NULL));
+        strcpy(rspdpvradconst,get_rb5_slice_attrib(&(*rb5_info),this_slice,"rspdpvradconst",NULL));
         //get <pw_index>'th field
         // code ref: http://stackoverflow.com/questions/11198604/c-split-string-into-an-array-of-strings
         char *pw_array[MAX_PULSE_WIDTHS+1];
@@ -771,7 +2139,7 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
             stmpa[3]='\0'; //add NULL terminator
             fprintf(stdout," %s -> %s @ %05.2f deg, %5.3f km_res, %4.2f deg_res, %4ld samples, PRF(%3s)=%4.0f/%4.0f (%s to %s, %.3f sec)\n",
                 xpath_bgn,
-                     return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/slicedata/rawdata/@type")),
+                ((xml_slice == NULL) || (xml_slice->n_rawdatas == 0)) ? "" : xml_slice->rawdata_arr[0].sparam,
                 rb5_info->angle_deg_arr[this_slice],
                 rb5_info->slice_bin_range_res_km[this_slice],
                 rb5_info->slice_ray_angle_res_deg[this_slice],
@@ -785,11 +2153,13 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
             );
         }
 
-        //needed angle_deg_arr & slice_ray_angle_res_deg
-        //calculate moving and fixed average ray readbacks
-        get_slice_mid_angle_readbacks(&(*rb5_info),this_slice);
-        //get iray_0degN, updates rb5_info->slice_moving_angle_arr
-        get_slice_iray_0degN(&(*rb5_info),this_slice);
+        if(header_mode == 0){
+            //needed angle_deg_arr & slice_ray_angle_res_deg
+            //calculate moving and fixed average ray readbacks
+            get_slice_mid_angle_readbacks(&(*rb5_info),this_slice);
+            //get iray_0degN, updates rb5_info->slice_moving_angle_arr
+            get_slice_iray_0degN(&(*rb5_info),this_slice);
+        }
 
     } //for (this_slice = 0; this_slice < rb5_info->n_slices; this_slice++){
     if(L_VERBOSE){
@@ -802,37 +2172,45 @@ int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE){
 
 //#############################################################################
 
-strRB5_PARAM_INFO get_rb5_param_info(strRB5_INFO *rb5_info, char *xpath_bgn, int L_VERBOSE) {
+strRB5_PARAM_INFO get_rb5_param_info(strRB5_INFO *rb5_info, int this_slice, const char *block, size_t idx, int L_VERBOSE) {
+    // descriptor of the idx'th <rawdata> or <rayinfo> (as per block) of this_slice
 
-    const xmlXPathContextPtr xpathCtx=rb5_info->xpathCtx;
     strRB5_PARAM_INFO rb5_param;
-    strcpy(rb5_param.xpath_bgn,xpath_bgn);
-    char xpath[MAX_STRING]="\0";
-
-    //get this_slice and update rb5_param.iray_0degN
-    int this_slice;
-    //sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)[%2d]/",this_slice+1,"rawdata",idx_req+1);
-    sscanf(xpath_bgn,"%*[(]/volume/scan/slice)[%2d]%*[.]",&this_slice); //skip leading slashes and trailing chars
-    this_slice-=1; //decrement from string
+    //  ./get_xpath_val 2016090715102400dBZ.vol "((/volume/scan/slice)[1]/slicedata/rawdata)[1]/@type"
+    sprintf(rb5_param.xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)[%2ld]/",this_slice+1,block,idx+1);
     rb5_param.iray_0degN=rb5_info->iray_0degN[this_slice];
 
+    int is_rawdata=(strcmp(block,"rawdata") == 0);
+    const strRB5_XML_PARAM *xml_param=NULL;
+    const strRB5_XML_SLICE *xml_slice=get_rb5_xml_slice(&(*rb5_info),this_slice);
+    if(xml_slice != NULL) {
+      if(is_rawdata) {
+        if(idx < xml_slice->n_rawdatas) xml_param=&(xml_slice->rawdata_arr[idx]);
+      } else {
+        if(idx < xml_slice->n_rayinfos) xml_param=&(xml_slice->rayinfo_arr[idx]);
+      }
+    }
+
     //iso8601 is in the parent <slicedata>
-    strcpy(rb5_param.iso8601,get_xpath_iso8601_attrib(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"../")));
-
-    if(strstr(xpath_bgn,"rawdata") != NULL) {
-      //  ./get_xpath_val 2016090715102400dBZ.vol "((/volume/scan/slice)[1]/slicedata/rawdata)[1]/@type"
-      //  XPATH: ((/volume/scan/slice)[1]/slicedata/rawdata)[1]/@type = dBZ
-      strcpy(rb5_param.sparam,               return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@type"  )));
-             rb5_param.blobid          =atoi(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@blobid")));
-             rb5_param.raw_binary_depth=atoi(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@depth" )));
-             rb5_param.nrays           =atoi(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@rays"  )));
-             rb5_param.nbins           =atoi(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@bins"  )));
-             rb5_param.data_range_min  =atof(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@min"   )));
-             rb5_param.data_range_max  =atof(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@max"   )));
+    strcpy(rb5_param.iso8601,(xml_slice == NULL) ? "" : xml_slice->iso8601);
+
+    //resolved once by the header parse
+    rb5_param.kind      =(xml_param == NULL) ? RB5_KIND_UNKNOWN : xml_param->kind;
+    rb5_param.conversion=(xml_param == NULL) ? RB5_CONV_REG     : xml_param->conversion;
+    rb5_param.quantity  =(xml_param == NULL) ? ""               : xml_param->quantity;
+
+    if(is_rawdata) {
+      strcpy(rb5_param.sparam,      (xml_param == NULL) ? "" : xml_param->sparam);
+             rb5_param.blobid          =(xml_param == NULL) ? 0 : xml_param->blobid;
+             rb5_param.raw_binary_depth=(xml_param == NULL) ? 0 : xml_param->raw_binary_depth;
+             rb5_param.nrays           =(xml_param == NULL) ? 0 : xml_param->nrays;
+             rb5_param.nbins           =(xml_param == NULL) ? 0 : xml_param->nbins;
+             rb5_param.data_range_min  =(xml_param == NULL) ? 0 : xml_param->data_range_min;
+             rb5_param.data_range_max  =(xml_param == NULL) ? 0 : xml_param->data_range_max;
       rb5_param.data_bytesize=rb5_param.raw_binary_depth/8;
       if(L_VERBOSE){
         fprintf(stdout,"%s%s = %s [%ld,%ld] (%ld-byte) range={%.4f,%.4f} (%s)\n",
-          xpath_bgn,
+          rb5_param.xpath_bgn,
           "@type",
           rb5_param.sparam,
           rb5_param.nrays,
@@ -846,17 +2224,17 @@ strRB5_PARAM_INFO get_rb5_param_info(strRB5_INFO *rb5_info, char *xpath_bgn, int
     } else {
       //  ./get_xpath_val 2016090715102400dBZ.vol "((/volume/scan/slice)[1]/slicedata/rayinfo)[6]/@refid"
       //  XPATH: ((/volume/scan/slice)[1]/slicedata/rayinfo)[6]/@refid = numpulses
-      strcpy(rb5_param.sparam,               return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@refid"  )));
-             rb5_param.blobid          =atoi(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@blobid")));
-             rb5_param.raw_binary_depth=atoi(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@depth" )));
-             rb5_param.nrays           =atoi(return_xpath_value(xpathCtx,strcat(strcpy(xpath,xpath_bgn),"@rays"  )));
+      strcpy(rb5_param.sparam,      (xml_param == NULL) ? "" : xml_param->sparam);
+             rb5_param.blobid          =(xml_param == NULL) ? 0 : xml_param->blobid;
+             rb5_param.raw_binary_depth=(xml_param == NULL) ? 0 : xml_param->raw_binary_depth;
+             rb5_param.nrays           =(xml_param == NULL) ? 0 : xml_param->nrays;
              rb5_param.nbins=1;
              rb5_param.data_range_min=-999;
              rb5_param.data_range_max=-999;
       rb5_param.data_bytesize=rb5_param.raw_binary_depth/8;
       if(L_VERBOSE){
         fprintf(stdout,"%s%s = %s [%ld] (%ld-byte) (%s)\n",
-          xpath_bgn,
+          rb5_param.xpath_bgn,
           "@refid",
           rb5_param.sparam,
           rb5_param.nrays,
@@ -875,28 +2253,6 @@ strRB5_PARAM_INFO get_rb5_param_info(strRB5_INFO *rb5_info, char *xpath_bgn, int
     rb5_param.data_range_width=rb5_param.data_range_max-rb5_param.data_range_min;
     rb5_param.data_step=rb5_param.data_range_width/rb5_param.raw_binary_width;
 
-            if((strcmp(rb5_param.sparam, "dataflag") == 0) ||
-               (strcmp(rb5_param.sparam, "numpulses") == 0 ) ||
-               (strcmp(rb5_param.sparam, "timestamp") == 0 ) ||
-               (strcmp(rb5_param.sparam, "txpower") == 0 ) ||
-               (strcmp(rb5_param.sparam, "noisepowerh") == 0 ) ||
-               (strcmp(rb5_param.sparam, "noisepowerv") == 0 )) {
-        strcpy(rb5_param.conversion,"copy");
-    } else  if((strcmp(rb5_param.sparam, "startangle") == 0) ||
-               (strcmp(rb5_param.sparam, "stopangle") == 0 ) ||
-               (strcmp(rb5_param.sparam, "startfixangle") == 0 ) ||
-               (strcmp(rb5_param.sparam, "stopfixangle") == 0 )) {
-        strcpy(rb5_param.conversion,"angular");
-    } else  if( (strcmp(rb5_param.sparam, "uPhiDP") == 0) ||
-               (strcmp(rb5_param.sparam, "PhiDP") == 0 )) {
-        strcpy(rb5_param.conversion,"phidp_data");
-    } else  if( (strcmp(rb5_param.sparam, "uKDP") == 0) ||
-               (strcmp(rb5_param.sparam, "KDP") == 0 )) {
-        strcpy(rb5_param.conversion,"kdp_data");
-    } else {
-        strcpy(rb5_param.conversion,"reg_data");
-    }
-
     rb5_param.NODATA_val=-999; //TBD
 
     return(rb5_param);
@@ -917,6 +2273,18 @@ size_t find_in_string_arr(char arr[][MAX_NSTRINGS], size_t n, char *match){
 
 //#############################################################################
 
+int find_rb5_rayinfo(strRB5_INFO *rb5_info, RB5_MOMENT_KIND kind){
+    // index of the <rayinfo> of kind, as listed by populate_rb5_info(), -1 if none
+
+    int i;
+    for (i = 0; i < rb5_info->n_rayinfos; i++){
+      if(rb5_info->rayinfo_kind_arr[i] == kind) return(i);
+    }
+    return(-1);
+}
+
+//#############################################################################
+
 void dump_strRB5_PARAM_INFO(strRB5_PARAM_INFO rb5_param){
 
     fprintf(stdout,"### dump of _strRB5_PARAM_INFO\n");
@@ -936,7 +2304,7 @@ void dump_strRB5_PARAM_INFO(strRB5_PARAM_INFO rb5_param){
     fprintf(stdout,"--- nbins = %ld\n",rb5_param.nbins);
     fprintf(stdout,"--- iray_0degN = %ld\n",rb5_param.iray_0degN);
 
-    fprintf(stdout,"--- conversion = %s\n",rb5_param.conversion);
+    fprintf(stdout,"--- conversion = %s\n",get_rb5_conversion_name(rb5_param.conversion));
     fprintf(stdout,"--- data_range_min = %f\n",rb5_param.data_range_min);
     fprintf(stdout,"--- data_range_max = %f\n",rb5_param.data_range_max);
     fprintf(stdout,"--- data_range_width = %f\n",rb5_param.data_range_width);
@@ -1001,6 +2369,7 @@ void get_slice_iray_0degN(strRB5_INFO *rb5_info, int req_slice){
 //#############################################################################
 
 void reorder_by_iray_0degN(strRB5_PARAM_INFO *rb5_param, void **input_raw_arr){
+    // input_raw_arr as from the inflate pool, i.e. released with inflate_pool_free()
 
     size_t i;
     size_t this_n_elems_data=rb5_param->n_elems_data;
@@ -1015,24 +2384,24 @@ void reorder_by_iray_0degN(strRB5_PARAM_INFO *rb5_param, void **input_raw_arr){
       void *deref_input_raw_arr=*input_raw_arr;
              if (raw_binary_depth ==  8){
         uint8_t  *buffer_8 =((uint8_t  *)deref_input_raw_arr);
-        uint8_t  *output_raw_arr=(uint8_t  *)RAVE_MALLOC(n*sizeof(uint8_t ));
+        uint8_t  *output_raw_arr=(uint8_t  *)inflate_pool_alloc(n*sizeof(uint8_t ));
         for (i=p;i<n;i++) output_raw_arr[i-   p ]=buffer_8 [i]; //output rays post 0-deg N
         for (i=0;i<p;i++) output_raw_arr[i+(n-p)]=buffer_8 [i]; //output rays pre  0-deg N
-        RAVE_FREE(buffer_8);
+        inflate_pool_free(buffer_8);
         *input_raw_arr=&(*output_raw_arr); //update
       } else if (raw_binary_depth == 16){
         uint16_t *buffer_16=((uint16_t *)deref_input_raw_arr);
-        uint16_t *output_raw_arr=(uint16_t *)RAVE_MALLOC(n*sizeof(uint16_t));
+        uint16_t *output_raw_arr=(uint16_t *)inflate_pool_alloc(n*sizeof(uint16_t));
         for (i=p;i<n;i++) output_raw_arr[i-   p ]=buffer_16[i]; //output rays post 0-deg N
         for (i=0;i<p;i++) output_raw_arr[i+(n-p)]=buffer_16[i]; //output rays pre  0-deg N
-        RAVE_FREE(buffer_16);
+        inflate_pool_free(buffer_16);
         *input_raw_arr=&(*output_raw_arr); //update
       } else if (raw_binary_depth == 32){
         uint32_t *buffer_32=((uint32_t *)deref_input_raw_arr);
-        uint32_t *output_raw_arr=(uint32_t *)RAVE_MALLOC(n*sizeof(uint32_t));
+        uint32_t *output_raw_arr=(uint32_t *)inflate_pool_alloc(n*sizeof(uint32_t));
         for (i=p;i<n;i++) output_raw_arr[i-   p ]=buffer_32[i]; //output rays post 0-deg N
         for (i=0;i<p;i++) output_raw_arr[i+(n-p)]=buffer_32[i]; //output rays pre  0-deg N
-        RAVE_FREE(buffer_32);
+        inflate_pool_free(buffer_32);
         *input_raw_arr=&(*output_raw_arr); //update
       }
 
@@ -1047,8 +2416,6 @@ void get_slice_end_iso8601(strRB5_INFO *rb5_info, int req_slice) {
     strcpy(iso8601_bgn,rb5_info->slice_iso8601_bgn[req_slice]);
     static char iso8601_end[MAX_STRING]="\0";
 
-    char xpath_bgn[MAX_STRING]="\0";
-
     // how many seconds did the slice take to complete
     float n_elapsed_secs;
 
@@ -1056,12 +2423,11 @@ void get_slice_end_iso8601(strRB5_INFO *rb5_info, int req_slice) {
     //else estimate from antenna rotation
     char req_rayinfo_name[MAX_STRING]="\0";
     strcpy(req_rayinfo_name,"timestamp");
-    int idx_req=find_in_string_arr(rb5_info->rayinfo_name_arr,rb5_info->n_rayinfos,req_rayinfo_name);
-    if(idx_req != -1) {
+    int idx_req=find_rb5_rayinfo(&(*rb5_info),RB5_KIND_TIMESTAMP);
+    if((idx_req != -1) && (rb5_info->header_mode != RB5_HEADER_ONLY)) {
 
       int L_RB5_PARAM_VERBOSE=0;
-      sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)[%2d]/",req_slice+1,"rayinfo",idx_req+1);
-      strRB5_PARAM_INFO rb5_param=get_rb5_param_info(rb5_info,xpath_bgn,L_RB5_PARAM_VERBOSE);
+      strRB5_PARAM_INFO rb5_param=get_rb5_param_info(rb5_info,req_slice,"rayinfo",idx_req,L_RB5_PARAM_VERBOSE);
 
       float *data_arr=NULL;
       void *raw_arr=NULL;
@@ -1079,13 +2445,13 @@ void get_slice_end_iso8601(strRB5_INFO *rb5_info, int req_slice) {
       } //for (i = 0; i < this_nrays; i++) {
       n_elapsed_secs=data_arr[iray_max_val]/1000.;
 
-      if ( raw_arr != NULL ) RAVE_FREE( raw_arr);
+      if ( raw_arr != NULL ) { inflate_pool_free( raw_arr); raw_arr=NULL; }
       if (data_arr != NULL ) RAVE_FREE(data_arr);
 
     } else { //if(idx_req == -1) {
       if(L_DEBUG_OUTPUT_1) fprintf(stdout,"  n_elapsed_secs ESTIMATED from <antspeed>\n");
       //antenna speed from <pargroup>
-      float antspeed_deg_per_sec=atof(return_xpath_value(rb5_info->xpathCtx,"/volume/scan/pargroup/antspeed"));
+      float antspeed_deg_per_sec=atof(get_rb5_pargroup_attrib(&(*rb5_info),NULL,"antspeed"));
       n_elapsed_secs=360./antspeed_deg_per_sec;
     } //else
 
@@ -1106,7 +2472,6 @@ void get_slice_mid_angle_readbacks(strRB5_INFO *rb5_info, int req_slice) {
     char req_rayinfo_name[MAX_STRING]="\0";
     int idx_req=-1;
     int L_RB5_PARAM_VERBOSE=0;
-    char xpath_bgn[MAX_STRING]="\0";
     void *raw_arr=NULL;
     float *data_arr=NULL;
 
@@ -1127,12 +2492,11 @@ void get_slice_mid_angle_readbacks(strRB5_INFO *rb5_info, int req_slice) {
 
     //moving_start_deg_arr
     strcpy(req_rayinfo_name,"startangle"); //mandatory
-    idx_req=find_in_string_arr(rb5_info->rayinfo_name_arr,rb5_info->n_rayinfos,req_rayinfo_name);
+    idx_req=find_rb5_rayinfo(&(*rb5_info),RB5_KIND_STARTANGLE);
     if(idx_req == -1) {
         fprintf(stdout,"IMPOSSIBLE: %s not found\n", req_rayinfo_name);
     } else {
-        sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)[%2d]/",req_slice+1,"rayinfo",idx_req+1);
-        strRB5_PARAM_INFO rb5_param=get_rb5_param_info(rb5_info,xpath_bgn,L_RB5_PARAM_VERBOSE);
+        strRB5_PARAM_INFO rb5_param=get_rb5_param_info(rb5_info,req_slice,"rayinfo",idx_req,L_RB5_PARAM_VERBOSE);
         return_param_blobid_raw(&(*rb5_info), &rb5_param, &raw_arr);
         convert_raw_to_data(&rb5_param,&raw_arr,&data_arr);
         for (i = 0; i < this_nrays; i++) {
@@ -1145,21 +2509,20 @@ void get_slice_mid_angle_readbacks(strRB5_INFO *rb5_info, int req_slice) {
             (rb5_info->slice_moving_angle_start_arr[req_slice])[i]=data_arr[i];
             (rb5_info->slice_moving_angle_start_arr[req_slice])[i]=roundf((rb5_info->slice_moving_angle_start_arr[req_slice])[i]*precision_factor)/precision_factor;
         } //for (i = 0; i < rb5_param.nrays; i++) {
-        if ( raw_arr != NULL ) RAVE_FREE( raw_arr);
+        if ( raw_arr != NULL ) { inflate_pool_free( raw_arr); raw_arr=NULL; }
         if (data_arr != NULL ) RAVE_FREE(data_arr);
     }
 
     //moving_stop_deg_arr
     strcpy(req_rayinfo_name,"stopangle");
-    idx_req=find_in_string_arr(rb5_info->rayinfo_name_arr,rb5_info->n_rayinfos,req_rayinfo_name);
+    idx_req=find_rb5_rayinfo(&(*rb5_info),RB5_KIND_STOPANGLE);
     if(idx_req == -1) {
         for (i = 0; i < this_nrays; i++) {
             (rb5_info->slice_moving_angle_stop_arr[req_slice])[i]=(rb5_info->slice_moving_angle_start_arr[req_slice])[i]+rb5_info->slice_ray_angle_res_deg[req_slice];
             (rb5_info->slice_moving_angle_stop_arr[req_slice])[i]=roundf((rb5_info->slice_moving_angle_stop_arr[req_slice])[i]*precision_factor)/precision_factor;
         }
     } else {
-        sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)[%2d]/",req_slice+1,"rayinfo",idx_req+1);
-        strRB5_PARAM_INFO rb5_param=get_rb5_param_info(rb5_info,xpath_bgn,L_RB5_PARAM_VERBOSE);
+        strRB5_PARAM_INFO rb5_param=get_rb5_param_info(rb5_info,req_slice,"rayinfo",idx_req,L_RB5_PARAM_VERBOSE);
         return_param_blobid_raw(&(*rb5_info), &rb5_param, &raw_arr);
         convert_raw_to_data(&rb5_param,&raw_arr,&data_arr);
         for (i = 0; i < this_nrays; i++) {
@@ -1172,22 +2535,21 @@ void get_slice_mid_angle_readbacks(strRB5_INFO *rb5_info, int req_slice) {
             (rb5_info->slice_moving_angle_stop_arr[req_slice])[i]=data_arr[i];
             (rb5_info->slice_moving_angle_stop_arr[req_slice])[i]=roundf((rb5_info->slice_moving_angle_stop_arr[req_slice])[i]*precision_factor)/precision_factor;
         } //for (i = 0; i < rb5_param.nrays; i++) {
-        if ( raw_arr != NULL ) RAVE_FREE( raw_arr);
+        if ( raw_arr != NULL ) { inflate_pool_free( raw_arr); raw_arr=NULL; }
         if (data_arr != NULL ) RAVE_FREE(data_arr);
     }
     
     //fixed_start_deg_arr
     default_val=rb5_info->angle_deg_arr[req_slice];
     strcpy(req_rayinfo_name,"startfixangle");
-    idx_req=find_in_string_arr(rb5_info->rayinfo_name_arr,rb5_info->n_rayinfos,req_rayinfo_name);
+    idx_req=find_rb5_rayinfo(&(*rb5_info),RB5_KIND_STARTFIXANGLE);
     if(idx_req == -1) {
         for (i = 0; i < this_nrays; i++) {
             (rb5_info->slice_fixed_angle_start_arr[req_slice])[i]=default_val;
             (rb5_info->slice_fixed_angle_start_arr[req_slice])[i]=roundf((rb5_info->slice_fixed_angle_start_arr[req_slice])[i]*precision_factor)/precision_factor;
         }
     } else {
-        sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)[%2d]/",req_slice+1,"rayinfo",idx_req+1);
-        strRB5_PARAM_INFO rb5_param=get_rb5_param_info(rb5_info,xpath_bgn,L_RB5_PARAM_VERBOSE);
+        strRB5_PARAM_INFO rb5_param=get_rb5_param_info(rb5_info,req_slice,"rayinfo",idx_req,L_RB5_PARAM_VERBOSE);
         return_param_blobid_raw(&(*rb5_info), &rb5_param, &raw_arr);
         convert_raw_to_data(&rb5_param,&raw_arr,&data_arr);
         for (i = 0; i < this_nrays; i++) {
@@ -1200,22 +2562,21 @@ void get_slice_mid_angle_readbacks(strRB5_INFO *rb5_info, int req_slice) {
             (rb5_info->slice_fixed_angle_start_arr[req_slice])[i]=data_arr[i];
             (rb5_info->slice_fixed_angle_start_arr[req_slice])[i]=roundf((rb5_info->slice_fixed_angle_start_arr[req_slice])[i]*precision_factor)/precision_factor;
         } //for (i = 0; i < rb5_param.nrays; i++) {
-        if ( raw_arr != NULL ) RAVE_FREE( raw_arr);
+        if ( raw_arr != NULL ) { inflate_pool_free( raw_arr); raw_arr=NULL; }
         if (data_arr != NULL ) RAVE_FREE(data_arr);
     }
     
     //fixed_stop_deg_arr
     default_val=rb5_info->angle_deg_arr[req_slice];
     strcpy(req_rayinfo_name,"stopfixangle");
-    idx_req=find_in_string_arr(rb5_info->rayinfo_name_arr,rb5_info->n_rayinfos,req_rayinfo_name);
+    idx_req=find_rb5_rayinfo(&(*rb5_info),RB5_KIND_STOPFIXANGLE);
     if(idx_req == -1) {
         for (i = 0; i < this_nrays; i++) {
             (rb5_info->slice_fixed_angle_stop_arr[req_slice])[i]=default_val;
             (rb5_info->slice_fixed_angle_stop_arr[req_slice])[i]=roundf((rb5_info->slice_fixed_angle_stop_arr[req_slice])[i]*precision_factor)/precision_factor;
         }
     } else {
-        sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)[%2d]/",req_slice+1,"rayinfo",idx_req+1);
-        strRB5_PARAM_INFO rb5_param=get_rb5_param_info(rb5_info,xpath_bgn,L_RB5_PARAM_VERBOSE);
+        strRB5_PARAM_INFO rb5_param=get_rb5_param_info(rb5_info,req_slice,"rayinfo",idx_req,L_RB5_PARAM_VERBOSE);
         return_param_blobid_raw(&(*rb5_info), &rb5_param, &raw_arr);
         convert_raw_to_data(&rb5_param,&raw_arr,&data_arr);
         for (i = 0; i < this_nrays; i++) {
@@ -1228,7 +2589,7 @@ void get_slice_mid_angle_readbacks(strRB5_INFO *rb5_info, int req_slice) {
             (rb5_info->slice_fixed_angle_stop_arr[req_slice])[i]=data_arr[i];
             (rb5_info->slice_fixed_angle_stop_arr[req_slice])[i]=roundf((rb5_info->slice_fixed_angle_stop_arr[req_slice])[i]*precision_factor)/precision_factor;
         } //for (i = 0; i < rb5_param.nrays; i++) {
-        if ( raw_arr != NULL ) RAVE_FREE( raw_arr);
+        if ( raw_arr != NULL ) { inflate_pool_free( raw_arr); raw_arr=NULL; }
         if (data_arr != NULL ) RAVE_FREE(data_arr);
     }
    
@@ -1270,3 +2631,40 @@ void get_slice_mid_angle_readbacks(strRB5_INFO *rb5_info, int req_slice) {
     }    
 
 }
+
+//#############################################################################
+
+void parse_rb5_member_name(const char *fullfile, strRB5_MEMBER_NAME *mb){
+    // as parse_tarball_member_name() in Lib/rb52odim.py, the directory elements taken from the
+    // basefile up: date, sdf (or ppdf, unless it ends with the scan type), site, ftype
+    // "" for those a shorter path does not have
+
+    memset(mb,0,sizeof(strRB5_MEMBER_NAME));
+    const char *slash=strrchr(fullfile,'/');
+    const char *basefile=(slash != NULL) ? slash+1 : fullfile;
+    snprintf(mb->basefile,MAX_STRING,"%s",basefile);
+    snprintf(mb->nam_yyyymmddhhmmss,MAX_STRING,"%.14s",basefile);
+    if(strlen(basefile) > 14) snprintf(mb->nam_file_ver,MAX_STRING,"%.2s",basefile+14);
+    const char *dot=strchr(basefile,'.');
+    if(dot != NULL) {
+        if(dot-basefile > 16) snprintf(mb->nam_sparam,MAX_STRING,"%.*s",(int)(dot-basefile-16),basefile+16);
+        snprintf(mb->nam_scan_type,MAX_STRING,"%s",dot+1);
+    }
+
+    char *elem_arr[4]={mb->rb5_date,mb->rb5_sdf,mb->rb5_site,mb->rb5_ftype};
+    const char *elem_end=slash;
+    size_t i;
+    for (i = 0; (i < 4) && (elem_end != NULL) && (elem_end > fullfile); i++) {
+        const char *elem_bgn=elem_end;
+        while((elem_bgn > fullfile) && (*(elem_bgn-1) != '/')) elem_bgn--;
+        snprintf(elem_arr[i],MAX_STRING,"%.*s",(int)(elem_end-elem_bgn),elem_bgn);
+        elem_end=(elem_bgn > fullfile) ? elem_bgn-1 : NULL;
+    }
+
+    size_t sdf_len=strlen(mb->rb5_sdf);
+    size_t scan_type_len=strlen(mb->nam_scan_type);
+    if((sdf_len < scan_type_len) || (strcmp(mb->rb5_sdf+sdf_len-scan_type_len,mb->nam_scan_type) != 0)) {
+        strcpy(mb->rb5_ppdf,mb->rb5_sdf);
+        mb->rb5_sdf[0]='\0'; //unknown until decode
+    }
+}
@@ -0,0 +1,184 @@
+/*
+ * byteswap_utils.c
+ *
+ * Big-endian -> host copy kernels for 16- and 32-bit RB5 moments.
+ * SSSE3/AVX2 shuffles are chosen at runtime by CPU detection, with a
+ * portable scalar fallback (used as-is on non-x86 builds).
+ *
+ * compile: gcc -O2 -Wall -c byteswap_utils.c
+ * bench:   make -C src bench && ./src/byteswap_bench
+ *
+ */
+
+#include "byteswap_utils.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BYTESWAP_X86 1
+#include <immintrin.h>
+#else
+#define BYTESWAP_X86 0
+#endif
+
+static int byteswap_kernel=BYTESWAP_KERNEL_AUTO;
+
+//#############################################################################
+
+static void byteswap_copy_16_scalar(void *dest, const void *src, size_t n_elems){
+    const uint8_t *s=(const uint8_t *)src;
+    uint16_t *d=(uint16_t *)dest;
+    size_t i;
+    for (i = 0; i < n_elems; i++) d[i]=(uint16_t)((s[2*i] << 8) | s[2*i+1]);
+}
+
+static void byteswap_copy_32_scalar(void *dest, const void *src, size_t n_elems){
+    const uint8_t *s=(const uint8_t *)src;
+    uint32_t *d=(uint32_t *)dest;
+    size_t i;
+    for (i = 0; i < n_elems; i++) {
+        d[i]=((uint32_t)s[4*i  ] << 24) |
+             ((uint32_t)s[4*i+1] << 16) |
+             ((uint32_t)s[4*i+2] <<  8) |
+             ((uint32_t)s[4*i+3]      );
+    }
+}
+
+#if BYTESWAP_X86
+//#############################################################################
+
+__attribute__((target("ssse3")))
+static void byteswap_copy_16_ssse3(void *dest, const void *src, size_t n_elems){
+    const __m128i mask=_mm_set_epi8(14,15,12,13,10,11,8,9,6,7,4,5,2,3,0,1);
+    const uint8_t *s=(const uint8_t *)src;
+    uint8_t *d=(uint8_t *)dest;
+    size_t n_vec=n_elems/8;
+    size_t i;
+    for (i = 0; i < n_vec; i++) {
+        __m128i v=_mm_loadu_si128((const __m128i *)(s+16*i));
+        _mm_storeu_si128((__m128i *)(d+16*i),_mm_shuffle_epi8(v,mask));
+    }
+    byteswap_copy_16_scalar(d+16*n_vec,s+16*n_vec,n_elems-8*n_vec);
+}
+
+__attribute__((target("ssse3")))
+static void byteswap_copy_32_ssse3(void *dest, const void *src, size_t n_elems){
+    const __m128i mask=_mm_set_epi8(12,13,14,15,8,9,10,11,4,5,6,7,0,1,2,3);
+    const uint8_t *s=(const uint8_t *)src;
+    uint8_t *d=(uint8_t *)dest;
+    size_t n_vec=n_elems/4;
+    size_t i;
+    for (i = 0; i < n_vec; i++) {
+        __m128i v=_mm_loadu_si128((const __m128i *)(s+16*i));
+        _mm_storeu_si128((__m128i *)(d+16*i),_mm_shuffle_epi8(v,mask));
+    }
+    byteswap_copy_32_scalar(d+16*n_vec,s+16*n_vec,n_elems-4*n_vec);
+}
+
+//#############################################################################
+
+__attribute__((target("avx2")))
+static void byteswap_copy_16_avx2(void *dest, const void *src, size_t n_elems){
+    //vpshufb shuffles within each 128-bit lane, so the mask is repeated
+    const __m256i mask=_mm256_set_epi8(14,15,12,13,10,11,8,9,6,7,4,5,2,3,0,1,
+                                       14,15,12,13,10,11,8,9,6,7,4,5,2,3,0,1);
+    const uint8_t *s=(const uint8_t *)src;
+    uint8_t *d=(uint8_t *)dest;
+    size_t n_vec=n_elems/16;
+    size_t i;
+    for (i = 0; i < n_vec; i++) {
+        __m256i v=_mm256_loadu_si256((const __m256i *)(s+32*i));
+        _mm256_storeu_si256((__m256i *)(d+32*i),_mm256_shuffle_epi8(v,mask));
+    }
+    byteswap_copy_16_scalar(d+32*n_vec,s+32*n_vec,n_elems-16*n_vec);
+}
+
+__attribute__((target("avx2")))
+static void byteswap_copy_32_avx2(void *dest, const void *src, size_t n_elems){
+    const __m256i mask=_mm256_set_epi8(12,13,14,15,8,9,10,11,4,5,6,7,0,1,2,3,
+                                       12,13,14,15,8,9,10,11,4,5,6,7,0,1,2,3);
+    const uint8_t *s=(const uint8_t *)src;
+    uint8_t *d=(uint8_t *)dest;
+    size_t n_vec=n_elems/8;
+    size_t i;
+    for (i = 0; i < n_vec; i++) {
+        __m256i v=_mm256_loadu_si256((const __m256i *)(s+32*i));
+        _mm256_storeu_si256((__m256i *)(d+32*i),_mm256_shuffle_epi8(v,mask));
+    }
+    byteswap_copy_32_scalar(d+32*n_vec,s+32*n_vec,n_elems-8*n_vec);
+}
+#endif
+
+//#############################################################################
+
+int byteswap_kernel_supported(int kernel){
+
+    if (kernel == BYTESWAP_KERNEL_SCALAR) return(1);
+#if BYTESWAP_X86
+    __builtin_cpu_init();
+    if (kernel == BYTESWAP_KERNEL_SSSE3) return(__builtin_cpu_supports("ssse3") ? 1 : 0);
+    if (kernel == BYTESWAP_KERNEL_AVX2 ) return(__builtin_cpu_supports("avx2" ) ? 1 : 0);
+#endif
+    return(0);
+}
+
+//#############################################################################
+
+int byteswap_use_kernel(int kernel){
+    // BYTESWAP_KERNEL_AUTO picks the best supported kernel
+
+    if (kernel == BYTESWAP_KERNEL_AUTO) {
+               if (byteswap_kernel_supported(BYTESWAP_KERNEL_AVX2 )) { kernel=BYTESWAP_KERNEL_AVX2;
+        } else if (byteswap_kernel_supported(BYTESWAP_KERNEL_SSSE3)) { kernel=BYTESWAP_KERNEL_SSSE3;
+        } else                                                        { kernel=BYTESWAP_KERNEL_SCALAR;
+        }
+    }
+    if (!byteswap_kernel_supported(kernel)) {
+        fprintf(stderr,"Error: byteswap kernel %s not supported by this CPU\n",byteswap_kernel_name(kernel));
+        return(EXIT_FAILURE);
+    }
+    byteswap_kernel=kernel;
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+int byteswap_get_kernel(void){
+
+    if (byteswap_kernel == BYTESWAP_KERNEL_AUTO) byteswap_use_kernel(BYTESWAP_KERNEL_AUTO);
+    return(byteswap_kernel);
+}
+
+//#############################################################################
+
+const char *byteswap_kernel_name(int kernel){
+
+           if (kernel == BYTESWAP_KERNEL_AUTO  ) { return("auto");
+    } else if (kernel == BYTESWAP_KERNEL_SCALAR) { return("scalar");
+    } else if (kernel == BYTESWAP_KERNEL_SSSE3 ) { return("ssse3");
+    } else if (kernel == BYTESWAP_KERNEL_AVX2  ) { return("avx2");
+    }
+    return("unknown");
+}
+
+//#############################################################################
+
+void byteswap_copy_16(void *dest, const void *src, size_t n_elems){
+
+#if BYTESWAP_X86
+    int kernel=byteswap_get_kernel();
+    if (kernel == BYTESWAP_KERNEL_AVX2 ) { byteswap_copy_16_avx2 (dest,src,n_elems); return; }
+    if (kernel == BYTESWAP_KERNEL_SSSE3) { byteswap_copy_16_ssse3(dest,src,n_elems); return; }
+#endif
+    byteswap_copy_16_scalar(dest,src,n_elems);
+}
+
+//#############################################################################
+
+void byteswap_copy_32(void *dest, const void *src, size_t n_elems){
+
+#if BYTESWAP_X86
+    int kernel=byteswap_get_kernel();
+    if (kernel == BYTESWAP_KERNEL_AVX2 ) { byteswap_copy_32_avx2 (dest,src,n_elems); return; }
+    if (kernel == BYTESWAP_KERNEL_SSSE3) { byteswap_copy_32_ssse3(dest,src,n_elems); return; }
+#endif
+    byteswap_copy_32_scalar(dest,src,n_elems);
+}
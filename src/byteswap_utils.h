@@ -0,0 +1,21 @@
+#include <stdint.h> //for uint16_t, uint32_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//kernels for big-endian -> host conversion of 16- and 32-bit moments
+#define BYTESWAP_KERNEL_AUTO   0 //best supported by this CPU, chosen at runtime
+#define BYTESWAP_KERNEL_SCALAR 1
+#define BYTESWAP_KERNEL_SSSE3  2
+#define BYTESWAP_KERNEL_AVX2   3
+
+//#############################################################################
+// function declarations
+//#############################################################################
+void byteswap_copy_16(void *dest, const void *src, size_t n_elems);
+void byteswap_copy_32(void *dest, const void *src, size_t n_elems);
+
+int byteswap_kernel_supported(int kernel);
+int byteswap_use_kernel(int kernel);
+int byteswap_get_kernel(void);
+const char *byteswap_kernel_name(int kernel);
@@ -0,0 +1,428 @@
+/*
+ * cache_utils.c
+ *
+ * On-disk cache of decoded RB5 files, for archives that are reprocessed many times: an
+ * entry holds the decoded scan or volume as a shm_utils.h segment, behind the key of the
+ * input file, and is mapped read-only by later reads instead of parsing the XML header,
+ * indexing and inflating the blobs again.
+ *
+ * - entries are written to a temporary file and renamed into place, so a reader sees a
+ *   whole entry or none, and readers that have an entry mapped keep it when it is replaced
+ *   or evicted
+ * - a changed input (path, inode, size, mtime or ctime) no longer matches its entry's key,
+ *   which is then replaced on the next store; lookups only stat() the input
+ * - the least recently used entries are evicted first, an entry's mtime being its last use
+ *
+ * compile: gcc -Wall -c cache_utils.c -lz
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h> //for PATH_MAX
+#include <inttypes.h> //for PRIx64
+#include <dirent.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "shm_utils.h"
+#include "cache_utils.h"
+
+#define L_DEBUG_OUTPUT_cache 0
+
+#define CRC32_CHUNK 65536 //get_cache_key_crc32() read size
+
+//#############################################################################
+
+int make_cache_dir(const char *cache_dir){
+    // creates the cache directory, if not there yet
+
+    struct stat dir_stat;
+
+    if((mkdir(cache_dir,0755) != 0) && (errno != EEXIST)) {
+        fprintf(stderr,"Error: cannot create cache directory = %s (%s)\n", cache_dir, strerror(errno));
+        return(EXIT_FAILURE);
+    }
+    if((stat(cache_dir,&dir_stat) != 0) || (!S_ISDIR(dir_stat.st_mode))) {
+        fprintf(stderr,"Error: cache directory = %s is not a directory\n", cache_dir);
+        return(EXIT_FAILURE);
+    }
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+static void set_cache_key_stat(strRB5_CACHE_KEY *key, const struct stat *inp_stat){
+
+    key->file_bytes=(uint64_t)inp_stat->st_size;
+    key->mtime_sec=(int64_t)inp_stat->st_mtim.tv_sec;
+    key->mtime_nsec=(int64_t)inp_stat->st_mtim.tv_nsec;
+    key->ctime_sec=(int64_t)inp_stat->st_ctim.tv_sec;
+    key->ctime_nsec=(int64_t)inp_stat->st_ctim.tv_nsec;
+    key->dev=(uint64_t)inp_stat->st_dev;
+    key->ino=(uint64_t)inp_stat->st_ino;
+}
+
+//#############################################################################
+
+int get_cache_key(const char *inp_fname, strRB5_CACHE_KEY *key){
+    // identifies an input file by its real path, inode, size, mtime and ctime, from stat() alone
+    // crc32 is left 0, see get_cache_key_crc32()
+
+    struct stat inp_stat;
+    char real_path[PATH_MAX];
+
+    memset(key,0,sizeof(strRB5_CACHE_KEY));
+    if((realpath(inp_fname,real_path) == NULL) || (strlen(real_path) >= RB5_CACHE_MAX_PATH)) {
+        fprintf(stderr,"Error: cannot resolve file = %s\n", inp_fname);
+        return(EXIT_FAILURE);
+    }
+    if((stat(real_path,&inp_stat) != 0) || (!S_ISREG(inp_stat.st_mode))) {
+        fprintf(stderr,"Error: file = %s is not a regular file\n", real_path);
+        return(EXIT_FAILURE);
+    }
+
+    memcpy(key->magic,RB5_CACHE_MAGIC,sizeof(key->magic));
+    key->version=RB5_CACHE_VERSION;
+    set_cache_key_stat(key,&inp_stat);
+    strcpy(key->path,real_path);
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+int get_cache_key_crc32(strRB5_CACHE_KEY *key){
+    // the crc32 of the input's contents, once it is to be stored, read rather than mapped
+    // so that an input truncated meanwhile comes up short instead of raising SIGBUS
+    // EXIT_FAILURE if it no longer matches the key
+
+    struct stat inp_stat;
+    unsigned char buffer[CRC32_CHUNK];
+    uint64_t n_total=0;
+    ssize_t n_read;
+
+    int fd=open(key->path,O_RDONLY);
+    if(fd == -1) {
+        fprintf(stderr,"Error: cannot open file = %s (%s)\n", key->path, strerror(errno));
+        return(EXIT_FAILURE);
+    }
+    uLong crc=crc32(0L,Z_NULL,0);
+    while(1) {
+        do n_read=read(fd,buffer,sizeof(buffer)); while((n_read < 0) && (errno == EINTR));
+        if(n_read <= 0) break;
+        crc=crc32(crc,buffer,(uInt)n_read);
+        n_total+=(uint64_t)n_read;
+    }
+    strRB5_CACHE_KEY now_key=*key;
+    int changed=((n_read < 0) || (fstat(fd,&inp_stat) != 0));
+    if(!changed) {
+        set_cache_key_stat(&now_key,&inp_stat);
+        changed=((n_total != key->file_bytes) || (memcmp(&now_key,key,sizeof(strRB5_CACHE_KEY)) != 0));
+    }
+    close(fd);
+    if(changed) {
+        fprintf(stderr,"Error: file = %s changed while being read for the cache\n", key->path);
+        return(EXIT_FAILURE);
+    }
+    key->crc32=(uint32_t)crc;
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+static int is_same_cache_key(const strRB5_CACHE_KEY *key_a, const strRB5_CACHE_KEY *key_b){
+    // crc32 aside, which lookups do not compute
+
+    return((memcmp(key_a->magic,key_b->magic,sizeof(key_a->magic)) == 0) &&
+           (key_a->version == key_b->version) &&
+           (key_a->file_bytes == key_b->file_bytes) &&
+           (key_a->mtime_sec == key_b->mtime_sec) &&
+           (key_a->mtime_nsec == key_b->mtime_nsec) &&
+           (key_a->ctime_sec == key_b->ctime_sec) &&
+           (key_a->ctime_nsec == key_b->ctime_nsec) &&
+           (key_a->dev == key_b->dev) &&
+           (key_a->ino == key_b->ino) &&
+           (strncmp(key_a->path,key_b->path,RB5_CACHE_MAX_PATH) == 0));
+}
+
+//#############################################################################
+
+char *get_cache_entry_name(const char *cache_dir, const strRB5_CACHE_KEY *key){
+    // <cache dir>/<FNV-1a hash of the input's real path>RB5_CACHE_SUFFIX, malloc()ed
+
+    uint64_t hash=14695981039346656037ULL;
+    const unsigned char *c;
+    for (c = (const unsigned char *)key->path; *c != '\0'; c++) {
+        hash^=*c;
+        hash*=1099511628211ULL;
+    }
+    char *entry_name=(char *)malloc(strlen(cache_dir)+1+16+strlen(RB5_CACHE_SUFFIX)+1);
+    if(entry_name == NULL) return(NULL);
+    sprintf(entry_name,"%s/%016" PRIx64 "%s",cache_dir,hash,RB5_CACHE_SUFFIX);
+    return(entry_name);
+}
+
+//#############################################################################
+
+int open_cache_entry(const char *cache_dir, const strRB5_CACHE_KEY *key, strRB5_SHM *shm){
+    // maps the entry of an input read-only, release with close_shm_segment()
+    // returns EXIT_FAILURE, quietly, if it is not cached or has changed since
+
+    strRB5_CACHE_KEY entry_key;
+
+    memset(shm,0,sizeof(strRB5_SHM));
+    char *entry_name=get_cache_entry_name(cache_dir,key);
+    if(entry_name == NULL) return(EXIT_FAILURE);
+    int fd=open(entry_name,O_RDONLY);
+    if(fd == -1) {
+        free(entry_name);
+        return(EXIT_FAILURE);
+    }
+    //a stale entry, or that of another input with the same hash
+    if((pread(fd,&entry_key,sizeof(strRB5_CACHE_KEY),0) != (ssize_t)sizeof(strRB5_CACHE_KEY)) ||
+       (!is_same_cache_key(&entry_key,key))) {
+        if(L_DEBUG_OUTPUT_cache) fprintf(stdout,"cache entry %s does not match %s\n",entry_name,key->path);
+        close(fd);
+        free(entry_name);
+        return(EXIT_FAILURE);
+    }
+    int ret=map_shm_segment(fd,entry_name,RB5_CACHE_KEY_BYTES,shm);
+    if(ret == EXIT_SUCCESS) futimens(fd,NULL); //last use, for evict_cache()
+    if(L_DEBUG_OUTPUT_cache) fprintf(stdout,"cache entry %s for %s %s\n",entry_name,key->path,(ret == EXIT_SUCCESS) ? "mapped" : "unreadable");
+    close(fd);
+    free(entry_name);
+    return(ret);
+}
+
+//#############################################################################
+
+char *create_cache_entry(const char *cache_dir, const strRB5_CACHE_KEY *key, size_t segment_bytes, char **return_tmp_name){
+    // a new zeroed entry for an input, mapped read-write, its segment to be filled
+    // publish_cache_entry() once written, discard_cache_entry() on error
+    // returns the segment, NULL on error
+
+    *return_tmp_name=NULL;
+    char *entry_name=get_cache_entry_name(cache_dir,key);
+    if(entry_name == NULL) return(NULL);
+    char *tmp_name=(char *)malloc(strlen(entry_name)+strlen(RB5_CACHE_TMP)+6+1);
+    if(tmp_name == NULL) {
+        free(entry_name);
+        return(NULL);
+    }
+    sprintf(tmp_name,"%s%sXXXXXX",entry_name,RB5_CACHE_TMP);
+    free(entry_name);
+
+    int fd=mkstemp(tmp_name);
+    if(fd == -1) {
+        fprintf(stderr,"Error: cannot create cache entry = %s (%s)\n", tmp_name, strerror(errno));
+        free(tmp_name);
+        return(NULL);
+    }
+    fchmod(fd,0644); //mkstemp() makes it private
+    size_t entry_bytes=RB5_CACHE_KEY_BYTES+segment_bytes;
+    char *mapping=MAP_FAILED;
+    if(ftruncate(fd,(off_t)entry_bytes) == 0) {
+        mapping=(char *)mmap(NULL,entry_bytes,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    }
+    if(mapping == MAP_FAILED) {
+        fprintf(stderr,"Error: cannot size cache entry = %s to %ld bytes (%s)\n", tmp_name, entry_bytes, strerror(errno));
+        close(fd);
+        unlink(tmp_name);
+        free(tmp_name);
+        return(NULL);
+    }
+    close(fd);
+
+    strRB5_CACHE_KEY *entry_key=(strRB5_CACHE_KEY *)mapping;
+    memcpy(entry_key,key,sizeof(strRB5_CACHE_KEY));
+    entry_key->segment_bytes=(uint64_t)segment_bytes;
+    *return_tmp_name=tmp_name;
+    return(mapping+RB5_CACHE_KEY_BYTES);
+}
+
+//#############################################################################
+
+int publish_cache_entry(const char *cache_dir, const strRB5_CACHE_KEY *key, char *tmp_name, char *segment, size_t segment_bytes){
+    // seals a written entry, unmaps it and renames it into place, replacing any older one
+    // tmp_name is freed
+
+    int ret=EXIT_SUCCESS;
+    char *mapping=segment-RB5_CACHE_KEY_BYTES;
+    size_t entry_bytes=RB5_CACHE_KEY_BYTES+segment_bytes;
+
+    //on disk before it is named, lest a crash leaves an entry with holes that still matches its key
+    seal_shm_segment(segment,segment_bytes);
+    int synced=(msync(mapping,entry_bytes,MS_SYNC) == 0);
+    munmap(mapping,entry_bytes);
+    int fd=open(tmp_name,O_RDONLY);
+    if((fd == -1) || (fsync(fd) != 0)) synced=0;
+    if(fd != -1) close(fd);
+    if(!synced) {
+        fprintf(stderr,"Error: cannot sync cache entry = %s (%s)\n", tmp_name, strerror(errno));
+        unlink(tmp_name);
+        free(tmp_name);
+        return(EXIT_FAILURE);
+    }
+
+    char *entry_name=get_cache_entry_name(cache_dir,key);
+    if((entry_name == NULL) || (rename(tmp_name,entry_name) != 0)) {
+        fprintf(stderr,"Error: cannot store cache entry = %s (%s)\n", tmp_name, strerror(errno));
+        unlink(tmp_name);
+        ret=EXIT_FAILURE;
+    } else if(L_DEBUG_OUTPUT_cache) fprintf(stdout,"cache entry %s for %s stored, %ld bytes\n",entry_name,key->path,segment_bytes);
+    free(entry_name);
+    free(tmp_name);
+    return(ret);
+}
+
+//#############################################################################
+
+void discard_cache_entry(char *tmp_name, char *segment, size_t segment_bytes){
+    // tmp_name is freed
+
+    munmap(segment-RB5_CACHE_KEY_BYTES,RB5_CACHE_KEY_BYTES+segment_bytes);
+    unlink(tmp_name);
+    free(tmp_name);
+}
+
+//#############################################################################
+
+static int has_suffix(const char *name, const char *suffix){
+
+    size_t name_len=strlen(name);
+    size_t suffix_len=strlen(suffix);
+    return((name_len > suffix_len) && (strcmp(name+name_len-suffix_len,suffix) == 0));
+}
+
+static int compare_cache_items(const void *a, const void *b){
+    // least recently used first
+
+    int64_t used_a=((const strRB5_CACHE_ITEM *)a)->used_sec;
+    int64_t used_b=((const strRB5_CACHE_ITEM *)b)->used_sec;
+    return((used_a > used_b) - (used_a < used_b));
+}
+
+//#############################################################################
+
+int list_cache(const char *cache_dir, strRB5_CACHE_ITEM **return_items, size_t *return_n_items){
+    // the entries of a cache directory, least recently used first, free() the items
+    // unreadable entries are left out, entries being written too
+
+    size_t n_alloc=0;
+    struct dirent *dir_entry;
+    struct stat entry_stat, inp_stat;
+
+    *return_items=NULL;
+    *return_n_items=0;
+    DIR *dir=opendir(cache_dir);
+    if(dir == NULL) {
+        fprintf(stderr,"Error: cannot open cache directory = %s (%s)\n", cache_dir, strerror(errno));
+        return(EXIT_FAILURE);
+    }
+    while((dir_entry=readdir(dir)) != NULL) {
+        if(!has_suffix(dir_entry->d_name,RB5_CACHE_SUFFIX)) continue;
+        int fd=openat(dirfd(dir),dir_entry->d_name,O_RDONLY);
+        if(fd == -1) continue;
+
+        strRB5_CACHE_ITEM item;
+        memset(&item,0,sizeof(strRB5_CACHE_ITEM));
+        if((fstat(fd,&entry_stat) == 0) &&
+           (pread(fd,&item.key,sizeof(strRB5_CACHE_KEY),0) == (ssize_t)sizeof(strRB5_CACHE_KEY)) &&
+           (memcmp(item.key.magic,RB5_CACHE_MAGIC,sizeof(item.key.magic)) == 0) &&
+           (item.key.version == RB5_CACHE_VERSION)) {
+            item.key.path[RB5_CACHE_MAX_PATH-1]='\0';
+            item.entry_bytes=(uint64_t)entry_stat.st_size;
+            item.used_sec=(int64_t)entry_stat.st_mtime;
+            strRB5_CACHE_KEY inp_key=item.key;
+            item.stale=(stat(item.key.path,&inp_stat) != 0);
+            if(!item.stale) {
+                set_cache_key_stat(&inp_key,&inp_stat);
+                item.stale=!is_same_cache_key(&inp_key,&item.key);
+            }
+            if(*return_n_items == n_alloc) {
+                n_alloc=(n_alloc == 0) ? 16 : 2*n_alloc;
+                strRB5_CACHE_ITEM *items=(strRB5_CACHE_ITEM *)realloc(*return_items,n_alloc*sizeof(strRB5_CACHE_ITEM));
+                if(items == NULL) {
+                    close(fd);
+                    break;
+                }
+                *return_items=items;
+            }
+            (*return_items)[(*return_n_items)++]=item;
+        }
+        close(fd);
+    }
+    closedir(dir);
+    if(*return_n_items > 0) qsort(*return_items,*return_n_items,sizeof(strRB5_CACHE_ITEM),compare_cache_items);
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+typedef struct{
+    strRB5_CACHE_ITEM item;    //first, for compare_cache_items()
+    char name[NAME_MAX+1];
+} strCACHE_FILE;
+
+int evict_cache(const char *cache_dir, uint64_t max_bytes, size_t *return_n_evicted, uint64_t *return_total_bytes){
+    // removes the least recently used entries until the cache holds at most max_bytes,
+    // and entries abandoned while being written; readers that have them mapped keep them
+    // *return_total_bytes, if not NULL, is what the entries left hold
+
+    strCACHE_FILE *files=NULL;
+    size_t n_files=0, n_alloc=0, i;
+    uint64_t total_bytes=0;
+    struct dirent *dir_entry;
+    struct stat entry_stat;
+    time_t now=time(NULL);
+
+    if(return_n_evicted != NULL) *return_n_evicted=0;
+    if(return_total_bytes != NULL) *return_total_bytes=0;
+    DIR *dir=opendir(cache_dir);
+    if(dir == NULL) {
+        fprintf(stderr,"Error: cannot open cache directory = %s (%s)\n", cache_dir, strerror(errno));
+        return(EXIT_FAILURE);
+    }
+    while((dir_entry=readdir(dir)) != NULL) {
+        if(fstatat(dirfd(dir),dir_entry->d_name,&entry_stat,0) != 0) continue;
+        if(strstr(dir_entry->d_name,RB5_CACHE_SUFFIX RB5_CACHE_TMP) != NULL) {
+            if(now-entry_stat.st_mtime > RB5_CACHE_STALE_SEC) unlinkat(dirfd(dir),dir_entry->d_name,0);
+            continue;
+        }
+        //corrupt entries count, and go like the others
+        if(!has_suffix(dir_entry->d_name,RB5_CACHE_SUFFIX)) continue;
+        if(n_files == n_alloc) {
+            n_alloc=(n_alloc == 0) ? 16 : 2*n_alloc;
+            strCACHE_FILE *new_files=(strCACHE_FILE *)realloc(files,n_alloc*sizeof(strCACHE_FILE));
+            if(new_files == NULL) {
+                fprintf(stderr,"Error: cannot allocate memory for cache directory = %s\n", cache_dir);
+                free(files);
+                closedir(dir);
+                return(EXIT_FAILURE);
+            }
+            files=new_files;
+        }
+        memset(&files[n_files],0,sizeof(strCACHE_FILE));
+        snprintf(files[n_files].name,sizeof(files[n_files].name),"%s",dir_entry->d_name);
+        files[n_files].item.entry_bytes=(uint64_t)entry_stat.st_size;
+        files[n_files].item.used_sec=(int64_t)entry_stat.st_mtime;
+        total_bytes+=(uint64_t)entry_stat.st_size;
+        n_files++;
+    }
+
+    //least recently used first
+    if(n_files > 0) qsort(files,n_files,sizeof(strCACHE_FILE),compare_cache_items);
+    for (i = 0; (i < n_files) && (total_bytes > max_bytes); i++) {
+        if(unlinkat(dirfd(dir),files[i].name,0) != 0) continue;
+        total_bytes-=files[i].item.entry_bytes;
+        if(return_n_evicted != NULL) (*return_n_evicted)++;
+        if(L_DEBUG_OUTPUT_cache) fprintf(stdout,"cache entry %s/%s evicted\n",cache_dir,files[i].name);
+    }
+    closedir(dir);
+    free(files);
+    if(return_total_bytes != NULL) *return_total_bytes=total_bytes;
+    return(EXIT_SUCCESS);
+}
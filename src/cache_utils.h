@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+//include after shm_utils.h
+//
+//on-disk cache of decoded RB5 files, one entry file per input file in a cache directory,
+//mapped back by a later read instead of parsing and decoding the input again, see setRB5Cache()
+//
+//entry file layout:
+//  strRB5_CACHE_KEY                 padded to RB5_CACHE_KEY_BYTES
+//  segment                          the decoded scan or volume, as a shm_utils.h segment
+//
+//an entry is <cache dir>/<hash of the input's real path>RB5_CACHE_SUFFIX, found again while
+//the input's path, inode, size, mtime and ctime all match its key, so that a lookup reads
+//none of the input (ctime cannot be set back, as mtime can); its own mtime is its last use,
+//the least recently used entries go first when the cache outgrows its size, see evict_cache()
+
+#define RB5_CACHE_MAGIC     "RB5CACHE"
+#define RB5_CACHE_VERSION   2
+#define RB5_CACHE_SUFFIX    ".rb5c"
+#define RB5_CACHE_TMP       ".tmp"      //entries being written, <name>.tmpXXXXXX
+#define RB5_CACHE_STALE_SEC 3600        //age after which evict_cache() takes them for abandoned
+#define RB5_CACHE_MAX_PATH  4096
+#define RB5_CACHE_MAX_BYTES ((uint64_t)4 << 30) //default cache size
+
+typedef struct{
+    char magic[8];             //RB5_CACHE_MAGIC
+    uint32_t version;          //RB5_CACHE_VERSION
+    uint32_t crc32;            //of the input file's contents, as zlib's crc32(), for the record
+    uint64_t file_bytes;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    int64_t ctime_sec;
+    int64_t ctime_nsec;
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t segment_bytes;
+    char path[RB5_CACHE_MAX_PATH]; //the input's real path
+} strRB5_CACHE_KEY;
+
+#define RB5_CACHE_KEY_BYTES ((sizeof(strRB5_CACHE_KEY)+RB5_SHM_ALIGN-1) & ~((size_t)RB5_SHM_ALIGN-1))
+
+//an entry, as listed by list_cache()
+typedef struct{
+    strRB5_CACHE_KEY key;
+    uint64_t entry_bytes;
+    int64_t used_sec;          //last use, its mtime
+    int stale;                 //the input is gone, or no longer matches the key
+} strRB5_CACHE_ITEM;
+
+//#############################################################################
+// function declarations
+//#############################################################################
+int make_cache_dir(const char *cache_dir);
+int get_cache_key(const char *inp_fname, strRB5_CACHE_KEY *key);
+int get_cache_key_crc32(strRB5_CACHE_KEY *key);
+char *get_cache_entry_name(const char *cache_dir, const strRB5_CACHE_KEY *key);
+int open_cache_entry(const char *cache_dir, const strRB5_CACHE_KEY *key, strRB5_SHM *shm);
+char *create_cache_entry(const char *cache_dir, const strRB5_CACHE_KEY *key, size_t segment_bytes, char **return_tmp_name);
+int publish_cache_entry(const char *cache_dir, const strRB5_CACHE_KEY *key, char *tmp_name, char *segment, size_t segment_bytes);
+void discard_cache_entry(char *tmp_name, char *segment, size_t segment_bytes);
+int list_cache(const char *cache_dir, strRB5_CACHE_ITEM **return_items, size_t *return_n_items);
+int evict_cache(const char *cache_dir, uint64_t max_bytes, size_t *return_n_evicted, uint64_t *return_total_bytes);
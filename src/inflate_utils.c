@@ -0,0 +1,447 @@
+/*
+ * inflate_utils.c
+ *
+ * Reusable zlib inflate state and a size-classed output buffer pool, so
+ * the hundreds of blobs in a volume don't each pay for inflateInit() (and
+ * its 32 KiB window) plus a fresh output RAVE_MALLOC().
+ *
+ * - one z_stream per thread, inflateInit() once then inflateReset() per blob
+ * - inflate_pool_alloc() buffers must be returned with inflate_pool_free()
+ * - the pool keeps at most INFLATE_POOL_MAX_BYTES, inflate_pool_drain() empties it
+ *
+ * One-shot blob inflate goes through a small backend interface: stock zlib
+ * (default, also what zlib-ng's compat build provides as -lz), or libdeflate
+ * when built with -DHAVE_LIBDEFLATE (make WITH_LIBDEFLATE=yes).
+ *
+ * compile: gcc -Wall -c inflate_utils.c -lz -lpthread [-DHAVE_LIBDEFLATE -ldeflate]
+ * test:    make bench (decodes every test/ file with each built-in backend)
+ *
+ */
+
+#include <pthread.h>
+#include <limits.h> //for UINT_MAX
+
+#include "rave_alloc.h"
+
+#include "inflate_utils.h"
+
+#ifdef HAVE_LIBDEFLATE
+#include <libdeflate.h> //add -ldeflate to compile
+#endif
+
+#define INFLATE_POOL_N_CLASSES (INFLATE_POOL_MAX_SHIFT-INFLATE_POOL_MIN_SHIFT+1)
+#define INFLATE_POOL_UNPOOLED -1
+
+typedef struct{
+    z_stream strm;
+    int initialized;
+#ifdef HAVE_LIBDEFLATE
+    struct libdeflate_decompressor *decompressor;
+#endif
+} strINFLATE_CTX;
+
+static int inflate_backend=INFLATE_BACKEND_AUTO;
+
+static pthread_once_t inflate_ctx_once=PTHREAD_ONCE_INIT;
+static pthread_key_t inflate_ctx_key;
+
+static pthread_mutex_t inflate_pool_mutex=PTHREAD_MUTEX_INITIALIZER;
+static void *inflate_pool_cache[INFLATE_POOL_N_CLASSES][INFLATE_POOL_MAX_PER_CLASS];
+static size_t inflate_pool_n_cache[INFLATE_POOL_N_CLASSES];
+static strINFLATE_POOL_STATS inflate_pool_stats;
+
+//#############################################################################
+
+static void free_inflate_ctx(void *ptr){
+    // thread-exit destructor
+
+    strINFLATE_CTX *ctx=(strINFLATE_CTX *)ptr;
+    if (ctx == NULL) return;
+    if (ctx->initialized) inflateEnd(&(ctx->strm));
+#ifdef HAVE_LIBDEFLATE
+    if (ctx->decompressor != NULL) libdeflate_free_decompressor(ctx->decompressor);
+#endif
+    free(ctx);
+}
+
+static void create_inflate_ctx_key(void){
+    pthread_key_create(&inflate_ctx_key,free_inflate_ctx);
+}
+
+//#############################################################################
+
+static strINFLATE_CTX *get_inflate_ctx(void){
+
+    pthread_once(&inflate_ctx_once,create_inflate_ctx_key);
+    strINFLATE_CTX *ctx=(strINFLATE_CTX *)pthread_getspecific(inflate_ctx_key);
+    if (ctx == NULL) {
+      ctx=(strINFLATE_CTX *)calloc(1,sizeof(strINFLATE_CTX));
+      if (ctx == NULL) {
+        fprintf(stderr,"zlib error: cannot allocate inflate context\n");
+        return(NULL);
+      }
+      pthread_setspecific(inflate_ctx_key,ctx);
+    }
+    return(ctx);
+}
+
+//#############################################################################
+
+z_stream *inflate_ctx_begin(const unsigned char *next_in, size_t avail_in){
+    // this thread's z_stream, ready to inflate next_in; NULL on error
+    // no inflateEnd() needed by the caller
+
+    int Z_result;
+
+    strINFLATE_CTX *ctx=get_inflate_ctx();
+    if (ctx == NULL) return(NULL);
+
+    if (ctx->initialized) {
+      Z_result=inflateReset(&(ctx->strm));
+    } else {
+      Z_result=inflateInit(&(ctx->strm));
+    }
+    if (Z_result != Z_OK) {
+      fprintf(stderr,"zlib error: %d\n", Z_result);
+      if (ctx->initialized) inflateEnd(&(ctx->strm));
+      ctx->initialized=0;
+      return(NULL);
+    }
+
+    pthread_mutex_lock(&inflate_pool_mutex);
+    if (ctx->initialized) {
+      inflate_pool_stats.n_ctx_reset++;
+    } else {
+      inflate_pool_stats.n_ctx_init++;
+    }
+    pthread_mutex_unlock(&inflate_pool_mutex);
+    ctx->initialized=1;
+
+    ctx->strm.next_in=(Bytef *)next_in;
+    ctx->strm.avail_in=avail_in;
+    return(&(ctx->strm));
+}
+
+//#############################################################################
+
+void inflate_ctx_end(void){
+    // release this thread's z_stream now, rather than at thread exit
+
+    pthread_once(&inflate_ctx_once,create_inflate_ctx_key);
+    free_inflate_ctx(pthread_getspecific(inflate_ctx_key));
+    pthread_setspecific(inflate_ctx_key,NULL);
+}
+
+//#############################################################################
+
+int inflate_backend_supported(int backend){
+
+    if (backend == INFLATE_BACKEND_ZLIB) return(1);
+#ifdef HAVE_LIBDEFLATE
+    if (backend == INFLATE_BACKEND_LIBDEFLATE) return(1);
+#endif
+    return(0);
+}
+
+//#############################################################################
+
+int inflate_use_backend(int backend){
+    // INFLATE_BACKEND_AUTO picks the fastest one built in
+
+    if (backend == INFLATE_BACKEND_AUTO) {
+        if (inflate_backend_supported(INFLATE_BACKEND_LIBDEFLATE)) { backend=INFLATE_BACKEND_LIBDEFLATE;
+        } else                                                      { backend=INFLATE_BACKEND_ZLIB;
+        }
+    }
+    if (!inflate_backend_supported(backend)) {
+        fprintf(stderr,"Error: inflate backend %s not built in\n",inflate_backend_name(backend));
+        return(EXIT_FAILURE);
+    }
+    inflate_backend=backend;
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+int inflate_get_backend(void){
+
+    if (inflate_backend == INFLATE_BACKEND_AUTO) inflate_use_backend(INFLATE_BACKEND_AUTO);
+    return(inflate_backend);
+}
+
+//#############################################################################
+
+const char *inflate_backend_name(int backend){
+
+           if (backend == INFLATE_BACKEND_AUTO      ) { return("auto");
+    } else if (backend == INFLATE_BACKEND_ZLIB      ) { return("zlib");
+    } else if (backend == INFLATE_BACKEND_LIBDEFLATE) { return("libdeflate");
+    }
+    return("unknown");
+}
+
+//#############################################################################
+
+size_t inflate_blob(const unsigned char *src, size_t src_len, unsigned char *dest, size_t dest_len){
+    // one-shot inflate of a whole zlib stream into dest, with the selected backend
+    // returns the number of bytes written, 0 on error
+
+    size_t EXIT_NULL_VAL=0;
+
+#ifdef HAVE_LIBDEFLATE
+    if (inflate_get_backend() == INFLATE_BACKEND_LIBDEFLATE) {
+      strINFLATE_CTX *ctx=get_inflate_ctx();
+      if (ctx == NULL) return(EXIT_NULL_VAL);
+      if (ctx->decompressor == NULL) ctx->decompressor=libdeflate_alloc_decompressor();
+      if (ctx->decompressor == NULL) {
+        fprintf(stderr,"libdeflate error: cannot allocate decompressor\n");
+        return(EXIT_NULL_VAL);
+      }
+      size_t n_bytes=0;
+      enum libdeflate_result result=libdeflate_zlib_decompress(ctx->decompressor,src,src_len,dest,dest_len,&n_bytes);
+      if (result != LIBDEFLATE_SUCCESS) {
+        fprintf(stderr,"libdeflate error: %d\n", result);
+        return(EXIT_NULL_VAL);
+      }
+      return(n_bytes);
+    }
+#endif
+
+    z_stream *strm=inflate_ctx_begin(src,src_len);
+    if (strm == NULL) return(EXIT_NULL_VAL);
+    strm->next_out=dest;
+    strm->avail_out=dest_len;
+    int Z_result=inflate(strm,Z_FINISH);
+    if (Z_result != Z_STREAM_END) {
+      fprintf(stderr,"zlib error: %d\n", Z_result);
+      return(EXIT_NULL_VAL);
+    }
+    return(dest_len-strm->avail_out);
+}
+
+//#############################################################################
+
+int is_gzip_buffer(const unsigned char *buf, size_t buf_len){
+    // gzip magic and deflate method, RFC 1952
+
+    return((buf_len >= GZIP_MIN_BYTES) && (buf[0] == 0x1f) && (buf[1] == 0x8b) && (buf[2] == 8));
+}
+
+//#############################################################################
+
+size_t gunzip_buffer(const unsigned char *src, size_t src_len, char **return_buffer){
+    // inflates a whole gzip file, all of its members, into a plain malloc()ed buffer, NUL terminated
+    // sized up front by the ISIZE trailer of the last member, grown only if that falls short
+    // (multi-member or > 4 GiB), so that the output is inflated in place, once
+    // the trailer is only a hint: a corrupt one could ask for 4 GiB, so the first allocation is
+    // kept within [src_len, GZIP_MAX_RATIO*src_len]
+    // returns the number of bytes inflated, 0 on error
+
+    size_t EXIT_NULL_VAL=0;
+    *return_buffer=NULL;
+    if (!is_gzip_buffer(src,src_len)) return(EXIT_NULL_VAL);
+
+    const unsigned char *trailer=src+src_len-4;
+    size_t n_alloc=((size_t)trailer[0]      ) |
+                   ((size_t)trailer[1] <<  8) |
+                   ((size_t)trailer[2] << 16) |
+                   ((size_t)trailer[3] << 24);
+    if (n_alloc < src_len) n_alloc=src_len;
+    if (n_alloc/GZIP_MAX_RATIO > src_len) n_alloc=GZIP_MAX_RATIO*src_len;
+    char *buffer=malloc(n_alloc+1);
+    if (buffer == NULL) {
+        fprintf(stderr,"Error: cannot allocate %ld bytes to gunzip\n", n_alloc);
+        return(EXIT_NULL_VAL);
+    }
+
+    z_stream strm;
+    memset(&strm,0,sizeof(z_stream));
+    if (inflateInit2(&strm,15+16) != Z_OK) { //gzip wrapper only
+        fprintf(stderr,"zlib error: %s\n", (strm.msg == NULL) ? "inflateInit2" : strm.msg);
+        free(buffer);
+        return(EXIT_NULL_VAL);
+    }
+
+    const unsigned char *next_in=src;
+    size_t avail_in=src_len;
+    size_t buffer_len=0;
+    int Z_result=Z_OK;
+    while (1) {
+        if (buffer_len == n_alloc) {
+            char *grown=realloc(buffer,2*n_alloc+1);
+            if (grown == NULL) {
+                fprintf(stderr,"Error: cannot allocate %ld bytes to gunzip\n", 2*n_alloc);
+                Z_result=Z_MEM_ERROR;
+                break;
+            }
+            buffer=grown;
+            n_alloc*=2;
+        }
+        //avail_* are uInt
+        size_t chunk_in =(avail_in          > UINT_MAX) ? UINT_MAX : avail_in;
+        size_t chunk_out=(n_alloc-buffer_len > UINT_MAX) ? UINT_MAX : n_alloc-buffer_len;
+        strm.next_in=(unsigned char *)next_in;
+        strm.avail_in=chunk_in;
+        strm.next_out=(unsigned char *)buffer+buffer_len;
+        strm.avail_out=chunk_out;
+        Z_result=inflate(&strm,Z_NO_FLUSH);
+        next_in+=chunk_in-strm.avail_in;
+        avail_in-=chunk_in-strm.avail_in;
+        buffer_len+=chunk_out-strm.avail_out;
+        if (Z_result == Z_STREAM_END) {
+            //another member follows, trailing garbage is ignored as by gzip(1)
+            if (!is_gzip_buffer(next_in,avail_in)) break;
+            inflateReset(&strm);
+        } else if ((Z_result == Z_BUF_ERROR) && (strm.avail_out != 0)) {
+            break; //input ended before the stream did
+        } else if ((Z_result != Z_OK) && (Z_result != Z_BUF_ERROR)) {
+            break;
+        }
+    }
+    inflateEnd(&strm);
+
+    if (Z_result != Z_STREAM_END) {
+        fprintf(stderr,"zlib error: %d, gzip stream %s\n", Z_result, (Z_result == Z_BUF_ERROR) ? "truncated" : "corrupt");
+        free(buffer);
+        return(EXIT_NULL_VAL);
+    }
+    buffer[buffer_len]='\0';
+
+    *return_buffer=buffer;
+    return(buffer_len);
+}
+
+//#############################################################################
+
+static int get_inflate_pool_class(size_t n_bytes){
+
+    int size_class=0;
+    while ((((size_t)1) << (INFLATE_POOL_MIN_SHIFT+size_class)) < n_bytes) {
+      size_class++;
+      if (size_class == INFLATE_POOL_N_CLASSES) return(INFLATE_POOL_UNPOOLED);
+    }
+    return(size_class);
+}
+
+//#############################################################################
+
+void *inflate_pool_alloc(size_t n_bytes){
+    // buffer of at least n_bytes, reused where possible; NULL on error
+
+    int size_class=get_inflate_pool_class(n_bytes);
+    unsigned char *hdr=NULL;
+
+    pthread_mutex_lock(&inflate_pool_mutex);
+    inflate_pool_stats.n_alloc++;
+    if ((size_class != INFLATE_POOL_UNPOOLED) && (inflate_pool_n_cache[size_class] > 0)) {
+      hdr=inflate_pool_cache[size_class][--inflate_pool_n_cache[size_class]];
+      inflate_pool_stats.n_reuse_hits++;
+      inflate_pool_stats.n_cached--;
+      inflate_pool_stats.cached_bytes-=((size_t)1) << (INFLATE_POOL_MIN_SHIFT+size_class);
+    } else {
+      inflate_pool_stats.n_misses++;
+    }
+    pthread_mutex_unlock(&inflate_pool_mutex);
+
+    if (hdr == NULL) {
+      size_t n_alloc_bytes=n_bytes;
+      if (size_class != INFLATE_POOL_UNPOOLED) n_alloc_bytes=((size_t)1) << (INFLATE_POOL_MIN_SHIFT+size_class);
+      hdr=(unsigned char *)RAVE_MALLOC(INFLATE_POOL_HEADER_BYTES+n_alloc_bytes);
+      if (hdr == NULL) {
+        fprintf(stderr,"Error: cannot allocate %ld bytes\n",n_alloc_bytes);
+        return(NULL);
+      }
+      memcpy(hdr,&size_class,sizeof(int));
+    }
+    return(hdr+INFLATE_POOL_HEADER_BYTES);
+}
+
+//#############################################################################
+
+static void evict_inflate_pool(size_t max_bytes, int min_class){
+    // frees cached buffers of size class min_class and up, largest first, until at most max_bytes
+    // remain cached; called with inflate_pool_mutex held
+
+    int size_class;
+
+    for (size_class = INFLATE_POOL_N_CLASSES-1; size_class >= min_class; size_class--) {
+      while ((inflate_pool_stats.cached_bytes > max_bytes) && (inflate_pool_n_cache[size_class] > 0)) {
+        unsigned char *hdr=inflate_pool_cache[size_class][--inflate_pool_n_cache[size_class]];
+        RAVE_FREE(hdr);
+        inflate_pool_stats.n_evicted++;
+        inflate_pool_stats.n_cached--;
+        inflate_pool_stats.cached_bytes-=((size_t)1) << (INFLATE_POOL_MIN_SHIFT+size_class);
+      }
+    }
+}
+
+//#############################################################################
+
+void inflate_pool_free(void *buf){
+
+    if (buf == NULL) return;
+
+    unsigned char *hdr=(unsigned char *)buf-INFLATE_POOL_HEADER_BYTES;
+    int size_class;
+    memcpy(&size_class,hdr,sizeof(int));
+
+    pthread_mutex_lock(&inflate_pool_mutex);
+    if ((size_class != INFLATE_POOL_UNPOOLED) && (inflate_pool_n_cache[size_class] < INFLATE_POOL_MAX_PER_CLASS)) {
+      evict_inflate_pool(INFLATE_POOL_MAX_BYTES-(((size_t)1) << (INFLATE_POOL_MIN_SHIFT+size_class)), size_class);
+    }
+    if ((size_class != INFLATE_POOL_UNPOOLED) && (inflate_pool_n_cache[size_class] < INFLATE_POOL_MAX_PER_CLASS) &&
+        (inflate_pool_stats.cached_bytes+(((size_t)1) << (INFLATE_POOL_MIN_SHIFT+size_class)) <= INFLATE_POOL_MAX_BYTES)) {
+      inflate_pool_cache[size_class][inflate_pool_n_cache[size_class]++]=hdr;
+      inflate_pool_stats.n_released++;
+      inflate_pool_stats.n_cached++;
+      inflate_pool_stats.cached_bytes+=((size_t)1) << (INFLATE_POOL_MIN_SHIFT+size_class);
+      hdr=NULL;
+    } else {
+      inflate_pool_stats.n_dropped++;
+    }
+    pthread_mutex_unlock(&inflate_pool_mutex);
+
+    if (hdr != NULL) RAVE_FREE(hdr);
+}
+
+//#############################################################################
+
+void inflate_pool_drain(void){
+    // free every cached buffer, e.g. before a RAVE memory leak report
+
+    int size_class;
+
+    pthread_mutex_lock(&inflate_pool_mutex);
+    for (size_class = 0; size_class < INFLATE_POOL_N_CLASSES; size_class++) {
+      while (inflate_pool_n_cache[size_class] > 0) {
+        unsigned char *hdr=inflate_pool_cache[size_class][--inflate_pool_n_cache[size_class]];
+        RAVE_FREE(hdr);
+      }
+    }
+    inflate_pool_stats.n_cached=0;
+    inflate_pool_stats.cached_bytes=0;
+    pthread_mutex_unlock(&inflate_pool_mutex);
+}
+
+//#############################################################################
+
+void inflate_pool_get_stats(strINFLATE_POOL_STATS *stats){
+
+    pthread_mutex_lock(&inflate_pool_mutex);
+    *stats=inflate_pool_stats;
+    pthread_mutex_unlock(&inflate_pool_mutex);
+}
+
+//#############################################################################
+
+void inflate_pool_reset_stats(void){
+    // zero the counters, keeping n_cached & cached_bytes (the pool's contents)
+
+    pthread_mutex_lock(&inflate_pool_mutex);
+    size_t n_cached=inflate_pool_stats.n_cached;
+    size_t cached_bytes=inflate_pool_stats.cached_bytes;
+    memset(&inflate_pool_stats,0,sizeof(strINFLATE_POOL_STATS));
+    inflate_pool_stats.n_cached=n_cached;
+    inflate_pool_stats.cached_bytes=cached_bytes;
+    pthread_mutex_unlock(&inflate_pool_mutex);
+}
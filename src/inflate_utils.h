@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zlib.h> //add -lz to compile
+
+//one-shot blob inflate backends, see inflate_use_backend()
+#define INFLATE_BACKEND_AUTO       0 //fastest built in, libdeflate if HAVE_LIBDEFLATE
+#define INFLATE_BACKEND_ZLIB       1 //stock zlib (or zlib-ng in compat mode), always built
+#define INFLATE_BACKEND_LIBDEFLATE 2 //-DHAVE_LIBDEFLATE -ldeflate
+
+//output buffer pool, power-of-2 size classes from 4 KiB to 64 MiB
+#define INFLATE_POOL_MIN_SHIFT 12
+#define INFLATE_POOL_MAX_SHIFT 26
+#define INFLATE_POOL_MAX_PER_CLASS 8 //cached buffers kept per size class
+#define INFLATE_POOL_MAX_BYTES ((size_t)128 << 20) //cached bytes kept in all, the largest classes go first
+#define INFLATE_POOL_HEADER_BYTES 16 //size class prefix, keeps malloc() alignment
+
+#define GZIP_MIN_BYTES 18 //10-byte header + 8-byte trailer, see gunzip_buffer()
+#define GZIP_MAX_RATIO 32 //bound on gunzip_buffer()'s first allocation, times the compressed size
+
+typedef struct{
+    size_t n_alloc;      //inflate_pool_alloc() calls
+    size_t n_reuse_hits; //served from a cached buffer
+    size_t n_misses;     //needed a fresh RAVE_MALLOC()
+    size_t n_released;   //returned to the pool and cached
+    size_t n_dropped;    //returned but freed (class full, or too large to pool)
+    size_t n_evicted;    //cached but freed to keep within INFLATE_POOL_MAX_BYTES
+    size_t n_cached;     //buffers currently cached
+    size_t cached_bytes;
+    size_t n_ctx_init;   //z_stream inflateInit(), once per thread
+    size_t n_ctx_reset;  //z_stream reused via inflateReset()
+} strINFLATE_POOL_STATS;
+
+//#############################################################################
+// function declarations
+//#############################################################################
+z_stream *inflate_ctx_begin(const unsigned char *next_in, size_t avail_in);
+void inflate_ctx_end(void);
+int inflate_backend_supported(int backend);
+int inflate_use_backend(int backend);
+int inflate_get_backend(void);
+const char *inflate_backend_name(int backend);
+size_t inflate_blob(const unsigned char *src, size_t src_len, unsigned char *dest, size_t dest_len);
+int is_gzip_buffer(const unsigned char *buf, size_t buf_len);
+size_t gunzip_buffer(const unsigned char *src, size_t src_len, char **return_buffer);
+void *inflate_pool_alloc(size_t n_bytes);
+void inflate_pool_free(void *buf);
+void inflate_pool_drain(void);
+void inflate_pool_get_stats(strINFLATE_POOL_STATS *stats);
+void inflate_pool_reset_stats(void);
@@ -0,0 +1,313 @@
+/*
+ * prefetch_utils.c
+ *
+ * Read-ahead of an ordered list of files, so that batch conversions don't stall on
+ * a blocking open/read per file: while file N is decoded, files N+1..N+window are
+ * already being read.
+ *
+ * - io_uring (-DHAVE_LIBURING, make WITH_LIBURING=yes): each file entering the window
+ *   is read whole into a malloc()ed buffer by the kernel, in the background
+ * - otherwise, or where io_uring is not allowed (old kernels, seccomp): the kernel is
+ *   asked to read each file entering the window into the page cache with
+ *   posix_fadvise(WILLNEED), and the file is mapped when its turn comes
+ *
+ * Not thread safe, one strPREFETCH per thread.
+ *
+ * compile: gcc -Wall -I/usr/include/libxml2 -c prefetch_utils.c [-DHAVE_LIBURING -luring]
+ *
+ */
+
+#include <stdint.h> //for uintptr_t
+#include <errno.h>
+
+#include "xml_utils.h"
+#include "prefetch_utils.h"
+
+#ifdef HAVE_LIBURING
+#include <liburing.h> //add -luring to compile
+#endif
+
+#define L_DEBUG_OUTPUT_prefetch 0
+
+//window slot states
+#define PREFETCH_SLOT_IDLE     0
+#define PREFETCH_SLOT_READING  1 //io_uring read in flight
+#define PREFETCH_SLOT_DONE     2 //buffer read whole
+#define PREFETCH_SLOT_DEFERRED 3 //read (or mapped) by prefetch_next(): fadvise backend, pipes, ...
+#define PREFETCH_SLOT_FAILED   4
+
+typedef struct{
+    size_t idx;        //of the file in fnames[]
+    int state;         //PREFETCH_SLOT_*
+    int fd;
+    char *buffer;      //malloc()ed, NUL terminated
+    size_t buffer_len;
+    size_t n_read;
+} strPREFETCH_SLOT;
+
+//an ordered list of files, read ahead a window at a time
+struct strPREFETCH{
+    char **fnames;     //the caller's, must outlive this
+    size_t n_files;
+    size_t window;
+    size_t next_submit; //next file to enter the window
+    size_t next_get;    //next file handed out by prefetch_next()
+    int backend;        //PREFETCH_BACKEND_*
+    strPREFETCH_SLOT *slot_arr; //file idx in slot idx % window
+#ifdef HAVE_LIBURING
+    struct io_uring ring;
+#endif
+};
+
+//#############################################################################
+
+const char *prefetch_backend_name(int backend){
+
+    switch(backend){
+        case PREFETCH_BACKEND_FADVISE: return("fadvise");
+        case PREFETCH_BACKEND_URING:   return("io_uring");
+        default:                       return("unknown");
+    }
+}
+
+//#############################################################################
+
+#ifdef HAVE_LIBURING
+static int submit_slot_read(strPREFETCH *pf, strPREFETCH_SLOT *slot){
+    // the next part of the file, queued for the next io_uring_submit()
+
+    struct io_uring_sqe *sqe=io_uring_get_sqe(&(pf->ring));
+    if(sqe == NULL) {
+        io_uring_submit(&(pf->ring)); //full, make room
+        sqe=io_uring_get_sqe(&(pf->ring));
+        if(sqe == NULL) return(EXIT_FAILURE);
+    }
+    size_t n_bytes=slot->buffer_len-slot->n_read;
+    if(n_bytes > PREFETCH_MAX_READ_BYTES) n_bytes=PREFETCH_MAX_READ_BYTES;
+    io_uring_prep_read(sqe,slot->fd,slot->buffer+slot->n_read,(unsigned)n_bytes,(uint64_t)slot->n_read);
+    io_uring_sqe_set_data(sqe,(void *)(uintptr_t)slot->idx);
+    slot->state=PREFETCH_SLOT_READING;
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+static void end_slot_read(strPREFETCH_SLOT *slot, int state){
+
+    close(slot->fd);
+    slot->fd=-1;
+    slot->state=state;
+    if(state == PREFETCH_SLOT_DONE) {
+        slot->buffer_len=slot->n_read; //shorter if the file shrank meanwhile
+        slot->buffer[slot->buffer_len]='\0';
+    } else {
+        free(slot->buffer);
+        slot->buffer=NULL;
+    }
+}
+
+//#############################################################################
+
+static void reap_prefetch(strPREFETCH *pf, int wait){
+    // handles the reads completed so far, waiting for one if wait
+    // a short read queues the rest of its file
+
+    struct io_uring_cqe *cqe;
+    int n_queued=0;
+
+    while(1) {
+        int ret=(wait) ? io_uring_wait_cqe(&(pf->ring),&cqe) : io_uring_peek_cqe(&(pf->ring),&cqe);
+        if(ret == -EINTR) continue;
+        if(ret != 0) break;
+        wait=0;
+
+        size_t idx=(size_t)(uintptr_t)io_uring_cqe_get_data(cqe);
+        int res=cqe->res;
+        io_uring_cqe_seen(&(pf->ring),cqe);
+        strPREFETCH_SLOT *slot=&(pf->slot_arr[idx % pf->window]);
+        if((slot->idx != idx) || (slot->state != PREFETCH_SLOT_READING)) continue;
+
+        if((res == -EINTR) || (res == -EAGAIN)) {
+            if(submit_slot_read(pf,slot) == 0) n_queued++;
+            else end_slot_read(slot,PREFETCH_SLOT_FAILED);
+        } else if(res < 0) {
+            fprintf(stderr,"Error while reading file = %s (%s)\n", pf->fnames[idx], strerror(-res));
+            end_slot_read(slot,PREFETCH_SLOT_FAILED);
+        } else if(res == 0) {
+            end_slot_read(slot,PREFETCH_SLOT_DONE);
+        } else {
+            slot->n_read+=(size_t)res;
+            if(slot->n_read < slot->buffer_len) {
+                if(submit_slot_read(pf,slot) == 0) n_queued++;
+                else end_slot_read(slot,PREFETCH_SLOT_FAILED);
+            } else end_slot_read(slot,PREFETCH_SLOT_DONE);
+        }
+    }
+    if(n_queued > 0) io_uring_submit(&(pf->ring));
+}
+#endif
+
+//#############################################################################
+
+static void submit_prefetch(strPREFETCH *pf){
+    // brings the window up to next_get+window files
+
+    int n_queued=0;
+
+    while((pf->next_submit < pf->n_files) && (pf->next_submit < pf->next_get+pf->window)) {
+        size_t idx=pf->next_submit++;
+        strPREFETCH_SLOT *slot=&(pf->slot_arr[idx % pf->window]);
+        struct stat file_stat;
+
+        slot->idx=idx;
+        slot->state=PREFETCH_SLOT_DEFERRED;
+        slot->fd=-1;
+        slot->buffer=NULL;
+        slot->buffer_len=0;
+        slot->n_read=0;
+
+        //missing files and the like fail when their turn comes, with the usual message
+        int fd=open(pf->fnames[idx],O_RDONLY);
+        if(fd == -1) continue;
+        if(fstat(fd,&file_stat) != 0) {
+            close(fd);
+            continue;
+        }
+        if(S_ISDIR(file_stat.st_mode)) {
+            fprintf(stderr,"Error: %s is a directory\n", pf->fnames[idx]);
+            slot->state=PREFETCH_SLOT_FAILED;
+            close(fd);
+            continue;
+        }
+        if((!S_ISREG(file_stat.st_mode)) || (file_stat.st_size <= 0)) {
+            close(fd);
+            continue;
+        }
+
+#ifdef HAVE_LIBURING
+        if(pf->backend == PREFETCH_BACKEND_URING) {
+            slot->buffer=(char *)malloc((size_t)file_stat.st_size+1);
+            if(slot->buffer != NULL) {
+                slot->fd=fd;
+                slot->buffer_len=(size_t)file_stat.st_size;
+                if(submit_slot_read(pf,slot) == 0) {
+                    n_queued++;
+                    continue;
+                }
+                free(slot->buffer);
+                slot->buffer=NULL;
+                slot->fd=-1;
+                slot->buffer_len=0;
+                slot->state=PREFETCH_SLOT_DEFERRED;
+            }
+        }
+#endif
+        posix_fadvise(fd,0,0,POSIX_FADV_WILLNEED); //starts reading in the background
+        close(fd);
+    }
+#ifdef HAVE_LIBURING
+    if(n_queued > 0) io_uring_submit(&(pf->ring));
+#endif
+    if(L_DEBUG_OUTPUT_prefetch) fprintf(stdout,"prefetch window [%ld,%ld), queued %d\n",pf->next_get,pf->next_submit,n_queued);
+}
+
+//#############################################################################
+
+strPREFETCH *prefetch_open(char **fnames, size_t n_files, size_t window){
+    // starts reading the first window files (0 for PREFETCH_WINDOW_DEFAULT) of fnames[]
+    // io_uring if built with it and the kernel allows, posix_fadvise() otherwise
+
+    if(window == 0) window=PREFETCH_WINDOW_DEFAULT;
+    if(window > PREFETCH_MAX_WINDOW) window=PREFETCH_MAX_WINDOW;
+
+    strPREFETCH *pf=(strPREFETCH *)calloc(1,sizeof(strPREFETCH));
+    if(pf == NULL) return(NULL);
+    pf->slot_arr=(strPREFETCH_SLOT *)calloc(window,sizeof(strPREFETCH_SLOT));
+    if(pf->slot_arr == NULL) {
+        free(pf);
+        return(NULL);
+    }
+    pf->fnames=fnames;
+    pf->n_files=n_files;
+    pf->window=window;
+    pf->backend=PREFETCH_BACKEND_FADVISE;
+#ifdef HAVE_LIBURING
+    if(io_uring_queue_init((unsigned)(2*window),&(pf->ring),0) == 0) pf->backend=PREFETCH_BACKEND_URING;
+#endif
+    if(L_DEBUG_OUTPUT_prefetch) fprintf(stdout,"prefetch backend = %s\n",prefetch_backend_name(pf->backend));
+
+    submit_prefetch(pf);
+    return(pf);
+}
+
+//#############################################################################
+
+int prefetch_next(strPREFETCH *pf, size_t *return_idx, char **return_buffer, size_t *return_len, int *return_owner){
+    // hands out the next file in order, and lets the next one enter the window
+    // release the buffer with close_file_buffer(..,*return_owner)
+    // 0 once all files have been handed out, else 1, with *return_len 0 if it could not be read
+
+    char *buffer=NULL;
+    size_t buffer_len=0;
+    int buffer_owner=FILE_BUFFER_HEAP;
+
+    if(pf->next_get >= pf->n_files) return(0);
+    size_t idx=pf->next_get;
+    strPREFETCH_SLOT *slot=&(pf->slot_arr[idx % pf->window]);
+
+#ifdef HAVE_LIBURING
+    while(slot->state == PREFETCH_SLOT_READING) reap_prefetch(pf,1);
+#endif
+    if(slot->state == PREFETCH_SLOT_DONE) {
+        buffer=slot->buffer;
+        buffer_len=slot->buffer_len;
+    } else if(slot->state == PREFETCH_SLOT_DEFERRED) {
+        buffer_owner=FILE_BUFFER_MMAP;
+        buffer_len=map_file_2_buffer(pf->fnames[idx],&buffer);
+        if(buffer_len == 0) {
+            buffer_owner=FILE_BUFFER_HEAP;
+            buffer_len=read_file_2_buffer(pf->fnames[idx],&buffer);
+        }
+    }
+    if(buffer_len == 0) {
+        if(buffer != NULL) close_file_buffer(buffer,buffer_len,buffer_owner);
+        buffer=NULL;
+    }
+    slot->state=PREFETCH_SLOT_IDLE;
+    slot->buffer=NULL;
+
+    pf->next_get++;
+    submit_prefetch(pf);
+#ifdef HAVE_LIBURING
+    if(pf->backend == PREFETCH_BACKEND_URING) reap_prefetch(pf,0);
+#endif
+
+    *return_idx=idx;
+    *return_buffer=buffer;
+    *return_len=buffer_len;
+    *return_owner=buffer_owner;
+    return(1);
+}
+
+//#############################################################################
+
+void prefetch_close(strPREFETCH *pf){
+    // files still in the window are dropped, once the kernel is done with their buffers
+
+    size_t i;
+
+    if(pf == NULL) return;
+#ifdef HAVE_LIBURING
+    if(pf->backend == PREFETCH_BACKEND_URING) {
+        for (i = 0; i < pf->window; i++) {
+            while(pf->slot_arr[i].state == PREFETCH_SLOT_READING) reap_prefetch(pf,1);
+        }
+        io_uring_queue_exit(&(pf->ring));
+    }
+#endif
+    for (i = 0; i < pf->window; i++) {
+        if(pf->slot_arr[i].buffer != NULL) free(pf->slot_arr[i].buffer);
+    }
+    free(pf->slot_arr);
+    free(pf);
+}
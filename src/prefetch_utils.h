@@ -0,0 +1,23 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//read-ahead backends, see prefetch_open()
+#define PREFETCH_BACKEND_FADVISE 0 //posix_fadvise(WILLNEED) when a file enters the window, mapped when its turn comes
+#define PREFETCH_BACKEND_URING   1 //-DHAVE_LIBURING -luring, files in the window are read whole by io_uring
+
+#define PREFETCH_WINDOW_DEFAULT 8           //files in flight ahead of the one being decoded
+#define PREFETCH_MAX_WINDOW     64
+#define PREFETCH_MAX_READ_BYTES (1 << 30)   //one io_uring read, the rest of a file follows in turn
+
+//an ordered list of files, read ahead a window at a time
+//opaque, its layout depends on the backends built in (HAVE_LIBURING), see prefetch_utils.c
+typedef struct strPREFETCH strPREFETCH;
+
+//#############################################################################
+// function declarations
+//#############################################################################
+strPREFETCH *prefetch_open(char **fnames, size_t n_files, size_t window);
+int prefetch_next(strPREFETCH *pf, size_t *return_idx, char **return_buffer, size_t *return_len, int *return_owner);
+void prefetch_close(strPREFETCH *pf);
+const char *prefetch_backend_name(int backend);
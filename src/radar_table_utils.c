@@ -0,0 +1,255 @@
+/*
+ * radar_table_utils.c
+ *
+ * Process-wide cache of the radar station table, $RB52ODIMCONFIG/odim_radar_table.xml,
+ * so that batch runs don't re-read and re-parse it for every file converted.
+ *
+ * - loaded on the first lookup, reloaded only when the file's mtime or size changes
+ * - <radar> entries are hashed by @id, lookups honour @bgn_date and @end_date
+ * - lookups copy the entry out under a mutex, safe from any thread
+ *
+ * compile: gcc -Wall -I/usr/include/libxml2 -c radar_table_utils.c -lxml2 -lpthread
+ *
+ */
+
+#include <stddef.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "xml_utils.h"
+#include "radar_table_utils.h"
+
+typedef struct{
+    char fname[MAX_STRING];
+    int loaded;
+    time_t mtime;                //of the file when loaded
+    off_t size;
+    size_t n_entries;
+    strRADAR_TABLE_ENTRY *entry_arr;          //in document order
+    size_t *next_arr;                         //index+1 of the next entry in the same bucket, 0 ends
+    size_t bucket_arr[RADAR_TABLE_N_BUCKETS]; //index+1 of the first entry, 0 if empty
+    strRADAR_TABLE_STATS stats;
+} strRADAR_TABLE;
+
+static pthread_mutex_t radar_table_mutex=PTHREAD_MUTEX_INITIALIZER;
+static strRADAR_TABLE radar_table;
+
+//<radar> child elements, their text ("" if empty)
+static const struct{
+    const char *name;
+    size_t offset;
+} radar_table_field_arr[]={
+    {"label"       ,offsetof(strRADAR_TABLE_ENTRY,label)},
+    {"operator"    ,offsetof(strRADAR_TABLE_ENTRY,operator_name)},
+    {"band"        ,offsetof(strRADAR_TABLE_ENTRY,band)},
+    {"odim_node"   ,offsetof(strRADAR_TABLE_ENTRY,odim_node)},
+    {"locale"      ,offsetof(strRADAR_TABLE_ENTRY,locale)},
+    {"admin_state" ,offsetof(strRADAR_TABLE_ENTRY,admin_state)},
+    {"country"     ,offsetof(strRADAR_TABLE_ENTRY,country)},
+    {"wmo_id"      ,offsetof(strRADAR_TABLE_ENTRY,wmo_id)},
+    {"rf_call_sign",offsetof(strRADAR_TABLE_ENTRY,rf_call_sign)},
+    {"make"        ,offsetof(strRADAR_TABLE_ENTRY,make)},
+    {"model"       ,offsetof(strRADAR_TABLE_ENTRY,model)},
+    {"serial"      ,offsetof(strRADAR_TABLE_ENTRY,serial)},
+    {"txtype"      ,offsetof(strRADAR_TABLE_ENTRY,txtype)},
+    {"poltype"     ,offsetof(strRADAR_TABLE_ENTRY,poltype)},
+    {"comment"     ,offsetof(strRADAR_TABLE_ENTRY,comment)},
+    {NULL,0}
+};
+
+//#############################################################################
+
+static size_t hash_radar_id(const char *id){
+    // FNV-1a
+
+    size_t h=2166136261u;
+    for (; *id != '\0'; id++) {
+        h^=(unsigned char)*id;
+        h*=16777619u;
+    }
+    return(h & (RADAR_TABLE_N_BUCKETS-1));
+}
+
+//#############################################################################
+
+static void free_radar_table(void){
+
+    if(radar_table.entry_arr != NULL) free(radar_table.entry_arr);
+    if(radar_table.next_arr != NULL) free(radar_table.next_arr);
+    radar_table.entry_arr=NULL;
+    radar_table.next_arr=NULL;
+    radar_table.n_entries=0;
+    radar_table.loaded=0;
+    radar_table.stats.n_entries=0;
+    memset(radar_table.bucket_arr,0,sizeof(radar_table.bucket_arr));
+}
+
+//#############################################################################
+
+static void set_radar_table_entry(strRADAR_TABLE_ENTRY *entry, xmlNodePtr radar){
+
+    xmlNodePtr cur;
+    size_t i;
+    xmlChar *attrib;
+
+    memset(entry,0,sizeof(strRADAR_TABLE_ENTRY));
+    if((attrib=xmlGetProp(radar,(const xmlChar *)"id")) != NULL) {
+        snprintf(entry->id,RADAR_TABLE_MAX_STRING,"%s",(char *)attrib);
+        xmlFree(attrib);
+    }
+    if((attrib=xmlGetProp(radar,(const xmlChar *)"bgn_date")) != NULL) {
+        snprintf(entry->bgn_date,RADAR_TABLE_MAX_STRING,"%s",(char *)attrib);
+        xmlFree(attrib);
+    }
+    if((attrib=xmlGetProp(radar,(const xmlChar *)"end_date")) != NULL) {
+        snprintf(entry->end_date,RADAR_TABLE_MAX_STRING,"%s",(char *)attrib);
+        xmlFree(attrib);
+    }
+
+    //first element of each name wins
+    for (i = 0; radar_table_field_arr[i].name != NULL; i++){
+        char *value=(char *)entry+radar_table_field_arr[i].offset;
+        for (cur = radar->children; cur != NULL; cur = cur->next){
+            if(cur->type != XML_ELEMENT_NODE) continue;
+            if(strcmp((const char *)cur->name,radar_table_field_arr[i].name) != 0) continue;
+            if((cur->children != NULL) && (cur->children->content != NULL)) {
+                snprintf(value,RADAR_TABLE_MAX_STRING,"%s",(const char *)cur->children->content);
+            }
+            break;
+        }
+    }
+}
+
+//#############################################################################
+
+static int load_radar_table(const char *table_fname, const struct stat *file_stat){
+    // (re)builds the table from /table/radar, the table in memory is kept on error
+
+    size_t n_entries=0;
+    size_t i;
+    xmlNodePtr cur;
+
+    strXML_FILE_INFO xml_info;
+    snprintf(xml_info.inp_fullfile,MAX_STRING,"%s",table_fname);
+    if(open_xml_buffer(&xml_info) != 0) return(EXIT_FAILURE);
+
+    xmlNodePtr root=xmlDocGetRootElement(xml_info.doc);
+    if((root == NULL) || (strcmp((const char *)root->name,"table") != 0)) {
+        fprintf(stderr,"Error: expecting <table> in file = %s\n",table_fname);
+        close_xml_buffer(&xml_info);
+        return(EXIT_FAILURE);
+    }
+    for (cur = root->children; cur != NULL; cur = cur->next){
+        if((cur->type == XML_ELEMENT_NODE) && (strcmp((const char *)cur->name,"radar") == 0)) n_entries++;
+    }
+
+    strRADAR_TABLE_ENTRY *entry_arr=(strRADAR_TABLE_ENTRY *)calloc(n_entries+1,sizeof(strRADAR_TABLE_ENTRY));
+    size_t *next_arr=(size_t *)calloc(n_entries+1,sizeof(size_t));
+    if((entry_arr == NULL) || (next_arr == NULL)) {
+        fprintf(stderr,"Error: cannot allocate the radar table\n");
+        if(entry_arr != NULL) free(entry_arr);
+        if(next_arr != NULL) free(next_arr);
+        close_xml_buffer(&xml_info);
+        return(EXIT_FAILURE);
+    }
+    n_entries=0;
+    for (cur = root->children; cur != NULL; cur = cur->next){
+        if((cur->type == XML_ELEMENT_NODE) && (strcmp((const char *)cur->name,"radar") == 0)) {
+            set_radar_table_entry(&(entry_arr[n_entries++]),cur);
+        }
+    }
+    close_xml_buffer(&xml_info);
+
+    free_radar_table();
+    snprintf(radar_table.fname,MAX_STRING,"%s",table_fname);
+    radar_table.mtime=file_stat->st_mtime;
+    radar_table.size=file_stat->st_size;
+    radar_table.n_entries=n_entries;
+    radar_table.entry_arr=entry_arr;
+    radar_table.next_arr=next_arr;
+    //insert backwards so that each chain is in document order
+    for (i = n_entries; i > 0; i--){
+        size_t h=hash_radar_id(entry_arr[i-1].id);
+        next_arr[i-1]=radar_table.bucket_arr[h];
+        radar_table.bucket_arr[h]=i;
+    }
+    radar_table.loaded=1;
+    radar_table.stats.n_entries=n_entries;
+    radar_table.stats.n_loads++;
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+static int is_radar_in_service(const strRADAR_TABLE_ENTRY *entry, const char *iso8601){
+    // YYYY-MM-DD compares as text, anything else ("present", "n/a", "") is open-ended
+
+    if((iso8601 == NULL) || (strlen(iso8601) < 10)) return(1);
+    if(isdigit((unsigned char)entry->bgn_date[0]) && (strncmp(entry->bgn_date,iso8601,10) > 0)) return(0);
+    if(isdigit((unsigned char)entry->end_date[0]) && (strncmp(iso8601,entry->end_date,10) > 0)) return(0);
+    return(1);
+}
+
+//#############################################################################
+
+int lookup_radar_table(const char *table_fname, const char *sensor_id, const char *iso8601, strRADAR_TABLE_ENTRY *entry){
+    // the <radar> of sensor_id in service on the date of iso8601 ("YYYY-MM-DD...", NULL for any date),
+    // else the first <radar> of sensor_id, else entry->id is ""
+    // EXIT_FAILURE only if the table cannot be read
+
+    struct stat file_stat;
+    const strRADAR_TABLE_ENTRY *match=NULL;
+    const strRADAR_TABLE_ENTRY *first=NULL;
+    size_t i;
+
+    memset(entry,0,sizeof(strRADAR_TABLE_ENTRY));
+    if(stat(table_fname,&file_stat) != 0) {
+        fprintf(stderr,"Error while opening file = %s\n", table_fname);
+        return(EXIT_FAILURE);
+    }
+
+    pthread_mutex_lock(&radar_table_mutex);
+    if(!radar_table.loaded || (strcmp(radar_table.fname,table_fname) != 0) ||
+       (radar_table.mtime != file_stat.st_mtime) || (radar_table.size != file_stat.st_size)) {
+        if(load_radar_table(table_fname,&file_stat) != 0) {
+            pthread_mutex_unlock(&radar_table_mutex);
+            return(EXIT_FAILURE);
+        }
+    }
+
+    for (i = radar_table.bucket_arr[hash_radar_id(sensor_id)]; i != 0; i = radar_table.next_arr[i-1]){
+        const strRADAR_TABLE_ENTRY *cur=&(radar_table.entry_arr[i-1]);
+        if(strcmp(cur->id,sensor_id) != 0) continue;
+        if(first == NULL) first=cur;
+        if(is_radar_in_service(cur,iso8601)) {
+            match=cur;
+            break;
+        }
+    }
+    if(match == NULL) match=first;
+    if(match != NULL) *entry=*match;
+    radar_table.stats.n_lookups++;
+    pthread_mutex_unlock(&radar_table_mutex);
+
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+void clear_radar_table(void){
+    // drops the cached table, the next lookup reads the file again
+
+    pthread_mutex_lock(&radar_table_mutex);
+    free_radar_table();
+    pthread_mutex_unlock(&radar_table_mutex);
+}
+
+//#############################################################################
+
+void get_radar_table_stats(strRADAR_TABLE_STATS *stats){
+
+    pthread_mutex_lock(&radar_table_mutex);
+    *stats=radar_table.stats;
+    pthread_mutex_unlock(&radar_table_mutex);
+}
@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RADAR_TABLE_FNAME       "odim_radar_table.xml" //in $RB52ODIMCONFIG
+#define RADAR_TABLE_MAX_STRING  256
+#define RADAR_TABLE_N_BUCKETS   64 //sensor id hash, power of 2
+
+//one <radar> of the table, "" for elements it does not have
+typedef struct{
+    char id[RADAR_TABLE_MAX_STRING];       //Rainbow sensor id, @id
+    char bgn_date[RADAR_TABLE_MAX_STRING]; //YYYY-MM-DD, valid from
+    char end_date[RADAR_TABLE_MAX_STRING]; //YYYY-MM-DD or "present", valid until
+    char label[RADAR_TABLE_MAX_STRING];
+    char operator_name[RADAR_TABLE_MAX_STRING]; //<operator>
+    char band[RADAR_TABLE_MAX_STRING];
+    char odim_node[RADAR_TABLE_MAX_STRING];
+    char locale[RADAR_TABLE_MAX_STRING];
+    char admin_state[RADAR_TABLE_MAX_STRING];
+    char country[RADAR_TABLE_MAX_STRING];
+    char wmo_id[RADAR_TABLE_MAX_STRING];
+    char rf_call_sign[RADAR_TABLE_MAX_STRING];
+    char make[RADAR_TABLE_MAX_STRING];
+    char model[RADAR_TABLE_MAX_STRING];
+    char serial[RADAR_TABLE_MAX_STRING];
+    char txtype[RADAR_TABLE_MAX_STRING];
+    char poltype[RADAR_TABLE_MAX_STRING];
+    char comment[RADAR_TABLE_MAX_STRING];
+} strRADAR_TABLE_ENTRY;
+
+typedef struct{
+    size_t n_entries;  //in the table loaded now
+    size_t n_loads;    //file parsed, first time or after its mtime changed
+    size_t n_lookups;
+} strRADAR_TABLE_STATS;
+
+//#############################################################################
+// function declarations
+//#############################################################################
+int lookup_radar_table(const char *table_fname, const char *sensor_id, const char *iso8601, strRADAR_TABLE_ENTRY *entry);
+void clear_radar_table(void);
+void get_radar_table_stats(strRADAR_TABLE_STATS *stats);
@@ -42,15 +42,73 @@ int objectTypeFromRB5(strRB5_INFO rb5_info) {
    }
 } // End function: objectTypeFromRB5
 
+/*
+ * Number of threads decoding the moments of one payload, see setDecodeThreads().
+ */
+static int n_decode_threads = 1;
+
+static int onlineCPUs(void) {
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n_cpus > 0) ? (int)n_cpus : 1;
+}
+
+/*
+ * Function name: setDecodeThreads
+ * Intent: opt in to decoding all (slice, moment) blobs of a payload concurrently.
+ * 1 (default) decodes sequentially, 0 uses one thread per online CPU.
+ */
+int setDecodeThreads(int n_threads) {
+    if (n_threads < 0) {
+        fprintf(stderr,"Error: invalid number of decode threads = %d\n",n_threads);
+        return(EXIT_FAILURE);
+    }
+    if (n_threads == 0) n_threads = onlineCPUs();
+    n_decode_threads = n_threads;
+    return(EXIT_SUCCESS);
+}
+
+int getDecodeThreads(void) {
+    return n_decode_threads;
+}
+
 /*
  * Input object is an empty Toolbox sweep/moment of data and a native RB5 object (if that's how RB5 data are provided).
  */
 int populateParam(PolarScanParam_t* param, strRB5_INFO *rb5_info, strRB5_PARAM_INFO *rb5_param) {
+	int ret = setupParam(param, rb5_param);
+
+	/* Access the data buffer from RB5. Ensure they are ordered properly, ie. with the first ray pointing north.
+	 * The blob is inflated, byte-swapped and rotated in one pass, directly into the param's own data array. */
+	if (ret) {
+	    if (decode_param_blobid(&(*rb5_info), &(*rb5_param), PolarScanParam_getData(param)) == 0) ret = 0;
+	}
+
+	/* We'll add appropriate exception handling later */
+	return ret;
+}
+
+/*
+ * Toolbox data type of a moment's raw_binary_depth, RaveDataType_UNDEFINED if unsupported.
+ */
+static RaveDataType paramDataType(strRB5_PARAM_INFO *rb5_param) {
+           if(rb5_param->raw_binary_depth ==  8) {
+	    return RaveDataType_UCHAR;
+    } else if(rb5_param->raw_binary_depth == 16) {
+	    return RaveDataType_USHORT;
+    } else if(rb5_param->raw_binary_depth == 32) {
+	    return RaveDataType_UINT;
+    }
+	return RaveDataType_UNDEFINED;
+}
+
+/*
+ * Sets the what attributes of an empty Toolbox sweep/moment and allocates its (not yet decoded) data.
+ */
+int setupParam(PolarScanParam_t* param, strRB5_PARAM_INFO *rb5_param) {
 	int ret = 0;
-	//	RaveDataType type;
 
 	/* Map RB5 moments to ODIM, e g. corrected horizontal reflectivity */
-	PolarScanParam_setQuantity(param, map_rb5_to_h5_param(rb5_param->sparam));
+	PolarScanParam_setQuantity(param, rb5_param->quantity);
 
 	/* Linear scaling factor, with an example for 8-bit reflectivity */
 	PolarScanParam_setGain(param, rb5_param->data_step);
@@ -65,48 +123,111 @@ int populateParam(PolarScanParam_t* param, strRB5_INFO *rb5_info, strRB5_PARAM_I
 	/* Value for 'undetected', ie. areas radiated but with no echo, with a convention used for reflectivity */
 	PolarScanParam_setUndetect(param, 0);
 
-	/* Access the data buffer from RB5. Ensure they are ordered properly, ie. with the first ray pointing north. */
-	//rb5_util vars
-    //Note: my decode returns a void*, user must resolve by data_depth, i.e.  data_type
-	void *raw_arr=NULL;
-    return_param_blobid_raw(&(*rb5_info), &(*rb5_param), &raw_arr);
-//  float *data_arr=NULL;
-//  convert_raw_to_data(&(*rb5_param),&raw_arr,&data_arr);
-
 	/* Figure out what data depth this moment of data is in, ie. 8, 16, 32, or 64-bit (u)int or float.
-	 * Map to Toolbox equivalent. This example is for 16-bit unsigned int */
-           if(rb5_param->raw_binary_depth ==  8) {
-	     //type = RaveDataType_UCHAR;
-//        uint8_t  *out_raw_arr=((uint8_t  *)raw_arr);
-//	    ret = PolarScanParam_setData(param, rb5_param->nbins, rb5_param->nrays, out_raw_arr, type);
-	    ret = PolarScanParam_setData(param, rb5_param->nbins, rb5_param->nrays, ((uint8_t  *)raw_arr), RaveDataType_UCHAR);
-    } else if(rb5_param->raw_binary_depth == 16) {
-	     //type = RaveDataType_USHORT;
-//        uint16_t *out_raw_arr=((uint16_t *)raw_arr);
-//	    ret = PolarScanParam_setData(param, rb5_param->nbins, rb5_param->nrays, out_raw_arr, type);
-	    ret = PolarScanParam_setData(param, rb5_param->nbins, rb5_param->nrays, ((uint16_t *)raw_arr), RaveDataType_USHORT);
-    } else if(rb5_param->raw_binary_depth == 32) {
-	     //type = RaveDataType_UINT;
-//        uint32_t *out_raw_arr=((uint32_t *)raw_arr);
-//	    ret = PolarScanParam_setData(param, rb5_param->nbins, rb5_param->nrays, out_raw_arr, type);
-	    ret = PolarScanParam_setData(param, rb5_param->nbins, rb5_param->nrays, ((uint32_t *)raw_arr), RaveDataType_UINT);
+	 * Map to Toolbox equivalent. */
+	RaveDataType type = paramDataType(rb5_param);
+	if (type == RaveDataType_UNDEFINED) {
+        fprintf(stderr,"Error: unsupported raw_binary_depth = %ld for %s\n",rb5_param->raw_binary_depth,rb5_param->sparam);
+        return 0;
     }
 
-	/* Set the data in the Toolbox object */
-//	ret = PolarScanParam_setData(param, rb5_param->nbins, rb5_param->nrays, data_arr, RaveDataType_FLOAT);
-//	ret = PolarScanParam_setData(param, rb5_param->nbins, rb5_param->nrays, out_raw_arr, type); //hmm, doesn't type cast
-
-	if ( raw_arr != NULL ) RAVE_FREE( raw_arr);
-//  if (data_arr != NULL ) RAVE_FREE(data_arr);
+	ret = PolarScanParam_createData(param, rb5_param->nbins, rb5_param->nrays, type);
 
-	/* We'll add appropriate exception handling later */
 	return ret;
 }
 
+/*
+ * Creates every (slice, moment) Toolbox parameter of the payload with its metadata and
+ * (not yet decoded) data, slice-major in <rawdata> order. Each parameter's blob is described
+ * by the matching task, with dest_arr NULL where setupParam() failed (unsupported depth).
+ */
+PolarScanParam_t** createParams(strRB5_INFO *rb5_info, int nscans, strRB5_DECODE_TASK** return_tasks) {
+	int np = rb5_info->n_rawdatas;
+	size_t n_tasks = (size_t)nscans*np;
+	int this_slice, i;
+	size_t k;
+	int L_RB5_PARAM_VERBOSE=0;
+
+	PolarScanParam_t** params = RAVE_MALLOC(n_tasks*sizeof(PolarScanParam_t*));
+	strRB5_DECODE_TASK* tasks = RAVE_MALLOC(n_tasks*sizeof(strRB5_DECODE_TASK));
+	if ((params == NULL) || (tasks == NULL)) {
+		if (params != NULL) RAVE_FREE(params);
+		if (tasks != NULL) RAVE_FREE(tasks);
+		return NULL;
+	}
+
+	/* Metadata (XPath) and Toolbox objects stay on this thread, only blob decoding is shared */
+	k = 0;
+	for (this_slice=0;this_slice<nscans;this_slice++) {
+		for (i=0;i<np;i++) {
+			tasks[k].dest_arr=NULL;
+			tasks[k].n_elems_data=0;
+			tasks[k].rb5_info=NULL;
+			params[k] = NULL;
+			if ((!rb5_info->slice_selected[this_slice]) || (!rb5_info->rawdata_selected[i])) {
+				k++;
+				continue;
+			}
+			tasks[k].rb5_param=get_rb5_param_info(rb5_info,this_slice,"rawdata",i,L_RB5_PARAM_VERBOSE);
+			params[k] = RAVE_OBJECT_NEW(&PolarScanParam_TYPE);
+			if (setupParam(params[k], &(tasks[k].rb5_param))) tasks[k].dest_arr=PolarScanParam_getData(params[k]);
+			k++;
+		}
+	}
+
+	*return_tasks = tasks;
+	return params;
+}
+
+/*
+ * Creates every (slice, moment) Toolbox parameter of the payload, and decodes their
+ * blobs concurrently on n_threads. Returns nscans*n_rawdatas parameters, slice-major
+ * in <rawdata> order, for populateScanDecoded(); release with releaseParams().
+ * Returns NULL if any blob fails to decode, rather than leave its moment all zero.
+ */
+PolarScanParam_t** decodeParams(strRB5_INFO *rb5_info, int nscans, int n_threads) {
+	size_t n_tasks = (size_t)nscans*rb5_info->n_rawdatas;
+	size_t k;
+	strRB5_DECODE_TASK* tasks = NULL;
+
+	PolarScanParam_t** params = createParams(rb5_info, nscans, &tasks);
+	if (params == NULL) return NULL;
+
+	/* Tasks without data (unsupported depth) are skipped, as populateParam() does */
+	size_t n_ready = 0;
+	for (k=0;k<n_tasks;k++) {
+		if (tasks[k].dest_arr != NULL) tasks[n_ready++] = tasks[k];
+	}
+	size_t n_ok = decode_param_blobids(rb5_info, tasks, n_ready, n_threads);
+
+	RAVE_FREE(tasks);
+	if (n_ok != n_ready) {
+		fprintf(stderr,"Error: %ld of %ld blobs failed to decode in file = %s\n", n_ready-n_ok, n_ready, rb5_info->inp_fullfile);
+		releaseParams(params, n_tasks);
+		return NULL;
+	}
+	return params;
+}
+
+void releaseParams(PolarScanParam_t** params, size_t n_params) {
+	size_t k;
+	if (params == NULL) return;
+	for (k=0;k<n_params;k++) RAVE_OBJECT_RELEASE(params[k]);
+	RAVE_FREE(params);
+}
+
 /*
  * Input object is an empty Toolbox polar scan object and a native RB5 object.
  */
 int populateScan(PolarScan_t* scan, strRB5_INFO *rb5_info, int this_slice) {
+	return populateScanDecoded(scan, rb5_info, this_slice, NULL);
+}
+
+/*
+ * As populateScan(), with this slice's moments already decoded by decodeParams(),
+ * or NULL to decode them here.
+ */
+int populateScanDecoded(PolarScan_t* scan, strRB5_INFO *rb5_info, int this_slice, PolarScanParam_t** params) {
 	int ret = 0;
 	int i;
 	int np;  /* Number of moments/parameters in this scan of data */
@@ -115,7 +236,6 @@ int populateScan(PolarScan_t* scan, strRB5_INFO *rb5_info, int this_slice) {
     //rb5_util vars
 	strRB5_PARAM_INFO rb5_param;
 //	static char xpath[MAX_STRING]="\0";
-	static char xpath_bgn[MAX_STRING]="\0";
 	static char iso8601[MAX_STRING]="\0";
 	static char tmp_a[MAX_STRING]="\0";
 	int L_RB5_PARAM_VERBOSE=0;
@@ -173,21 +293,15 @@ int populateScan(PolarScan_t* scan, strRB5_INFO *rb5_info, int this_slice) {
     }
 
     /* Corrupt scans need to be caught */
-    //Derive master fault flag from these attributes
-    sprintf(xpath_bgn, \
-        "(/volume/scan/slice)[%2d]/*[ \
-            contains(local-name(),'warningstat') or \
-            contains(local-name(),'faultstat') \
-        ]",this_slice+1);
-    char xpath[MAX_STRING]="\0";
+    //Derive master fault flag from the <slice> *warningstat and *faultstat attributes
+    const strRB5_XML_SLICE *xml_slice=get_rb5_xml_slice(rb5_info,this_slice);
     char attrib_name [MAX_STRING]="\0";
     char attrib_value[MAX_STRING]="\0";
     char fault_msg[MAX_STRING]="\0";
-    int nSTAT_ATTRIBs=get_xpath_size(rb5_info->xpathCtx,xpath_bgn);
+    int nSTAT_ATTRIBs=(xml_slice == NULL) ? 0 : xml_slice->n_faultstats;
     for (i = 0; i < nSTAT_ATTRIBs; i++) {
-        sprintf(xpath,"(%s)[%2d]",xpath_bgn,i+1);
-        strcpy(attrib_name ,return_xpath_name (rb5_info->xpathCtx,xpath));
-        strcpy(attrib_value,return_xpath_value(rb5_info->xpathCtx,xpath));
+        strcpy(attrib_name ,xml_slice->faultstat_arr[i].name);
+        strcpy(attrib_value,xml_slice->faultstat_arr[i].value);
 //        fprintf(stdout,"%2d: %s = %s\n",i,attrib_name,attrib_value);
         if(strcmp(attrib_value,"OK") != 0){
             sprintf(tmp_a,"<%s>%s</%s>\n",attrib_name,attrib_value,attrib_name);
@@ -209,8 +323,8 @@ int populateScan(PolarScan_t* scan, strRB5_INFO *rb5_info, int this_slice) {
 	ret = addStringAttribute(object, "how/clutterMap",  "Off"); // (not used)
 
 // NOTE: these attributes may not exist in the original RB5 raw file, thus check
-    if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/spbdphtxcalpowkw"))          ) ret = addDoubleAttribute(object, "how/zcalH"  , atof(tmp_a));
-    if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/spbdpvtxcalpowkw"))          ) ret = addDoubleAttribute(object, "how/zcalV"  , atof(tmp_a));
+    if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"spbdphtxcalpowkw",NULL))          ) ret = addDoubleAttribute(object, "how/zcalH"  , atof(tmp_a));
+    if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"spbdpvtxcalpowkw",NULL))          ) ret = addDoubleAttribute(object, "how/zcalV"  , atof(tmp_a));
 
 //	ret = addDoubleAttribute(object, "how/nsampleH",    ); // n/a
 //	ret = addDoubleAttribute(object, "how/nsampleV",    ); // n/a
@@ -222,12 +336,9 @@ int populateScan(PolarScan_t* scan, strRB5_INFO *rb5_info, int this_slice) {
 ///*
     // from <txpower> determine max & avg
     L_RB5_PARAM_VERBOSE=0;
-    char req_rayinfo_name[MAX_STRING]="\0";
-    strcpy(req_rayinfo_name,"txpower");
-    int idx_req=find_in_string_arr(rb5_info->rayinfo_name_arr,rb5_info->n_rayinfos,req_rayinfo_name);
+    int idx_req=find_rb5_rayinfo(&(*rb5_info),RB5_KIND_TXPOWER);
     if(idx_req != -1) {
-    	sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)[%2d]/",this_slice+1,"rayinfo",idx_req+1);
-		rb5_param=get_rb5_param_info(rb5_info,xpath_bgn,L_RB5_PARAM_VERBOSE);
+		rb5_param=get_rb5_param_info(rb5_info,this_slice,"rayinfo",idx_req,L_RB5_PARAM_VERBOSE);
         void *raw_arr=NULL;
         float *data_arr=NULL;
         return_param_blobid_raw(&(*rb5_info), &rb5_param, &raw_arr);
@@ -251,7 +362,7 @@ int populateScan(PolarScan_t* scan, strRB5_INFO *rb5_info, int this_slice) {
 	    ret = addDoubleAttribute(object, "how/peakpwr",     data_arr[iray_peak_pwr]/1000.); //[kW]
         ret = addDoubleAttribute(object, "how/avgpwr",      avg_pwr); //[W]
 
-        if ( raw_arr != NULL ) RAVE_FREE( raw_arr);
+        if ( raw_arr != NULL ) { inflate_pool_free( raw_arr); raw_arr=NULL; }
         if (data_arr != NULL ) RAVE_FREE(data_arr);
     }
 //*/
@@ -290,14 +401,23 @@ int populateScan(PolarScan_t* scan, strRB5_INFO *rb5_info, int this_slice) {
 	/* Loop through the moments, populating a Toolbox object for each */
 	L_RB5_PARAM_VERBOSE=0;
 	for (i=0;i<np;i++) {
-		PolarScanParam_t* param = RAVE_OBJECT_NEW(&PolarScanParam_TYPE);
+		PolarScanParam_t* param = NULL;
+
+		/* Moments filtered out on read are never decoded */
+		if (!rb5_info->rawdata_selected[i]) continue;
 
-		sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)[%2d]/",this_slice+1,"rawdata",i+1);
-		rb5_param=get_rb5_param_info(rb5_info,xpath_bgn,L_RB5_PARAM_VERBOSE);
+		if (params != NULL) {
+			/* Not decoded yet, added by loadLazyParams() once it is */
+			if (params[i] == NULL) continue;
+			param = RAVE_OBJECT_COPY(params[i]);
+		} else {
+			param = RAVE_OBJECT_NEW(&PolarScanParam_TYPE);
+			rb5_param=get_rb5_param_info(rb5_info,this_slice,"rawdata",i,L_RB5_PARAM_VERBOSE);
 
-		ret = populateParam(param, &(*rb5_info), &rb5_param);
+			ret = populateParam(param, &(*rb5_info), &rb5_param);
+		}
 
-if(L_RB52ODIM_DEBUG) fprintf(stdout,"Adding rawdata = %s to scan...\n",rb5_param.sparam);
+if(L_RB52ODIM_DEBUG) fprintf(stdout,"Adding rawdata = %s to scan...\n",PolarScanParam_getQuantity(param));
 
 		ret = PolarScan_addParameter(scan, param);
 		RAVE_OBJECT_RELEASE(param);
@@ -313,9 +433,30 @@ if(L_RB52ODIM_DEBUG) fprintf(stdout,"Adding rawdata = %s to scan...\n",rb5_param
 
 /*
  * Input object is an empty Toolbox core object ((object type to be determined below)).
+ * Returns -1 if the concurrent decode fails.
  */
 int populateObject(RaveCoreObject* object, strRB5_INFO *rb5_info) {
 	int ret = 0;
+
+	/* Opt-in: decode all (slice, moment) blobs up front, concurrently, then assemble in order */
+	PolarScanParam_t** params = NULL;
+	if (n_decode_threads > 1) {
+		params = decodeParams(&(*rb5_info), rb5_info->n_slices, n_decode_threads);
+		if (params == NULL) return -1;
+	}
+
+	ret = populateObjectParams(object, &(*rb5_info), params);
+	releaseParams(params, (size_t)rb5_info->n_slices*rb5_info->n_rawdatas);
+
+	return ret;
+}
+
+/*
+ * As populateObject(), with every (slice, moment) parameter already created by
+ * createParams() or decodeParams(), or NULL to decode them scan by scan.
+ */
+int populateObjectParams(RaveCoreObject* object, strRB5_INFO *rb5_info, PolarScanParam_t** params) {
+	int ret = 0;
 	int nscans = 0;
 
 	/* Determine number of scans == n_slices */
@@ -348,7 +489,7 @@ int populateObject(RaveCoreObject* object, strRB5_INFO *rb5_info) {
        get_xpath_val ../config/odim_radar_table.xml  "(/table/radar)[*][@id='CAXWH' and band='X'][1]/label"
      */
 
-    //get radar_table from XML
+    //radar_table from XML, cached by radar_table_utils.c
     char inp_fname[MAX_STRING]="\0";
     if(getenv("RB52ODIMCONFIG")==NULL){
       fprintf(stderr,"Error cannot getenv(\"RB52ODIMCONFIG\")\n");
@@ -358,39 +499,20 @@ int populateObject(RaveCoreObject* object, strRB5_INFO *rb5_info) {
     } else {
       strcpy(inp_fname,getenv("RB52ODIMCONFIG"));
       strcat(inp_fname,"/");
-      strcat(inp_fname,"odim_radar_table.xml");
+      strcat(inp_fname,RADAR_TABLE_FNAME);
     }
 
-    strXML_FILE_INFO radar_table;
-    strcpy(radar_table.inp_fullfile,inp_fname);
-    if(open_xml_buffer(&radar_table) != 0) {
+    // Rainbow should be configured with a unique 3-char id
+    // the table is cached for the process, an unknown id leaves all fields ""
+    strRADAR_TABLE_ENTRY radar;
+    if(lookup_radar_table(inp_fname,rb5_info->sensor_id,iso8601,&radar) != 0) {
       fprintf(stderr,"Error cannot process file = %s\n", inp_fname);
       return(EXIT_FAILURE);
     }
-
-    char xpath_bgn[MAX_STRING]="\0";
-    char xpath[MAX_STRING]="\0";
-
-/*
-    sprintf(xpath, \
-        "(/table/radar)[*][ \
-            @id='%s' and \
-//            @end_date='present' \
-        ]/label",rb5_info->sensor_id);
-    char attrib_name [MAX_STRING]="\0";
-    char attrib_value[MAX_STRING]="\0";
-    strcpy(attrib_name ,return_xpath_name (radar_table.xpathCtx,xpath));
-    strcpy(attrib_value,return_xpath_value(radar_table.xpathCtx,xpath));
-    printf("%s: %s = %s\n",rb5_info->sensor_id,attrib_name,attrib_value);
-*/
-
-    // Rainbow should be configured with a unique 3-char id
-    sprintf(xpath_bgn,"(/table/radar)[*][@id='%s']",rb5_info->sensor_id);
-    sprintf(tmp_a,"NOD:%s,PLC:%s %s",
-        return_xpath_value(radar_table.xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/odim_node")),
-        return_xpath_value(radar_table.xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/locale")),
-        return_xpath_value(radar_table.xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/admin_state"))
-        );
+    //table fields are as long as tmp_a, what does not fit is cut, and said so
+    if (snprintf(tmp_a,sizeof(tmp_a),"NOD:%s,PLC:%s %s",radar.odim_node,radar.locale,radar.admin_state) >= (int)sizeof(tmp_a)) {
+      fprintf(stderr,"Warning: what/source of %s truncated to %s\n",rb5_info->sensor_id,tmp_a);
+    }
     if(L_RB52ODIM_DEBUG) printf("\n%s: odim_source = %s\n",rb5_info->sensor_id,tmp_a);
     if (RAVE_OBJECT_CHECK_TYPE(object, &PolarVolume_TYPE)) {
       PolarVolume_setDate     ((PolarVolume_t*)object,func_iso8601_2_yyyymmdd(iso8601));
@@ -413,18 +535,17 @@ int populateObject(RaveCoreObject* object, strRB5_INFO *rb5_info) {
     //#############################################################################//
 	/* Set optional 'how' attributes. There are lots! See Table 8 in the ODIM_H5 spec. */
 
-    sprintf(tmp_a,"%s%s",
-        return_xpath_value(radar_table.xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/make")),
-        return_xpath_value(radar_table.xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/model"))
-        );
+    if (snprintf(tmp_a,sizeof(tmp_a),"%s%s",radar.make,radar.model) >= (int)sizeof(tmp_a)) {
+      fprintf(stderr,"Warning: how/system of %s truncated to %s\n",rb5_info->sensor_id,tmp_a);
+    }
 	ret = addStringAttribute(object, "how/system", tmp_a); //According to Table 10
-    strcpy(tmp_a,return_xpath_value(radar_table.xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/txtype")));
+    strcpy(tmp_a,radar.txtype);
 	ret = addStringAttribute(object, "how/TXtype", tmp_a);
-    strcpy(tmp_a,return_xpath_value(radar_table.xpathCtx,strcat(strcpy(xpath,xpath_bgn),"/poltype")));
+    strcpy(tmp_a,radar.poltype);
 	ret = addStringAttribute(object, "how/poltype", tmp_a);
 
     char gdrx_dp_proc_mode[MAX_STRING]="\0";
-    strcpy(gdrx_dp_proc_mode,return_xpath_value(rb5_info->xpathCtx,"(/volume/scan/pargroup)[*][@refid='sdfbase']/gdrx_dp_proc_mode"));
+    strcpy(gdrx_dp_proc_mode,get_rb5_pargroup_attrib(rb5_info,"sdfbase","gdrx_dp_proc_mode"));
     if     (!strcmp(gdrx_dp_proc_mode,"GdrxDpModeHV_HV")) strcpy(tmp_a,"simultaneous-dual");
     else if(!strcmp(gdrx_dp_proc_mode,"GdrxDpModeHV_V" )) strcpy(tmp_a,"LDR-H");
     else if(!strcmp(gdrx_dp_proc_mode,"GdrxDpModeHV_H" )) strcpy(tmp_a,"single-H");
@@ -441,37 +562,38 @@ int populateObject(RaveCoreObject* object, strRB5_INFO *rb5_info) {
 	ret = addDoubleAttribute(object, "how/wavelength", rb5_info->sensor_wavelength_cm);
 //	ret = addDoubleAttribute(object, "how/RXbandwidth", ); // n/a
 
-    close_xml_buffer(&radar_table);
-    
 // as per Issue #23, found in <slice refid="0">
 // NOTE: these attributes may not exist in the original RB5 raw file, thus check
-//  if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/foobar"))          ) ret = addDoubleAttribute(object, "how/my_foobar"  , atof(tmp_a));
-    if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/gdrxtransmitfreq"))) ret = addDoubleAttribute(object, "how/RXfrequency", atof(tmp_a));
-    if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/spbtxloss"))       ) ret = addDoubleAttribute(object, "how/TXlossH"    , atof(tmp_a));
-    if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/spbdpvtxloss"))    ) ret = addDoubleAttribute(object, "how/TXlossV"    , atof(tmp_a));
-//  if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,))                   ) ret = addDoubleAttribute(object, "how/injectlossH", atof(tmp_a));
-//  if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,))                   ) ret = addDoubleAttribute(object, "how/injectlossV", atof(tmp_a));
-    if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/spbrxloss"))       ) ret = addDoubleAttribute(object, "how/RXlossH"    , atof(tmp_a));
-    if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/spbdpvrxloss"))    ) ret = addDoubleAttribute(object, "how/RXlossV"    , atof(tmp_a));
-    if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/spbradomloss"))    ) ret = addDoubleAttribute(object, "how/radomelossH", atof(tmp_a));
-    if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/spbradomloss"))    ) ret = addDoubleAttribute(object, "how/radomelossV", atof(tmp_a)); //copying Horz
-    if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/spbantgain"))      ) ret = addDoubleAttribute(object, "how/antgainH"   , atof(tmp_a));
-    if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/spbdpvantgain"))   ) ret = addDoubleAttribute(object, "how/antgainV"   , atof(tmp_a));
-    if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/spbhorbeam"))      ) ret = addDoubleAttribute(object, "how/beamwH"     , atof(tmp_a));
-    if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,"/spbverbeam"))      ) ret = addDoubleAttribute(object, "how/beamwV"     , atof(tmp_a));
-//  if(strcpy(tmp_a,get_xpath_slice_attrib(rb5_info->xpathCtx,0,))                   ) ret = addDoubleAttribute(object, "how/gasattn"    , atof(tmp_a));
+//  if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"foobar",NULL))          ) ret = addDoubleAttribute(object, "how/my_foobar"  , atof(tmp_a));
+    if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"gdrxtransmitfreq",NULL))) ret = addDoubleAttribute(object, "how/RXfrequency", atof(tmp_a));
+    if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"spbtxloss",NULL))       ) ret = addDoubleAttribute(object, "how/TXlossH"    , atof(tmp_a));
+    if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"spbdpvtxloss",NULL))    ) ret = addDoubleAttribute(object, "how/TXlossV"    , atof(tmp_a));
+//  if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,,NULL))                   ) ret = addDoubleAttribute(object, "how/injectlossH", atof(tmp_a));
+//  if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,,NULL))                   ) ret = addDoubleAttribute(object, "how/injectlossV", atof(tmp_a));
+    if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"spbrxloss",NULL))       ) ret = addDoubleAttribute(object, "how/RXlossH"    , atof(tmp_a));
+    if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"spbdpvrxloss",NULL))    ) ret = addDoubleAttribute(object, "how/RXlossV"    , atof(tmp_a));
+    if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"spbradomloss",NULL))    ) ret = addDoubleAttribute(object, "how/radomelossH", atof(tmp_a));
+    if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"spbradomloss",NULL))    ) ret = addDoubleAttribute(object, "how/radomelossV", atof(tmp_a)); //copying Horz
+    if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"spbantgain",NULL))      ) ret = addDoubleAttribute(object, "how/antgainH"   , atof(tmp_a));
+    if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"spbdpvantgain",NULL))   ) ret = addDoubleAttribute(object, "how/antgainV"   , atof(tmp_a));
+    if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"spbhorbeam",NULL))      ) ret = addDoubleAttribute(object, "how/beamwH"     , atof(tmp_a));
+    if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,"spbverbeam",NULL))      ) ret = addDoubleAttribute(object, "how/beamwV"     , atof(tmp_a));
+//  if(strcpy(tmp_a,get_rb5_slice_attrib(rb5_info,0,,NULL))                   ) ret = addDoubleAttribute(object, "how/gasattn"    , atof(tmp_a));
 
     // NOTE, rest set at SCAN level: rpm, prf's pw, Nyquist, noise_power_dbz, nsamples
 
 if(L_RB52ODIM_DEBUG) fprintf(stdout,"Done top-level 'how' attributes...\n");
 
+    int np = rb5_info->n_rawdatas;
+
 	/* Populate each */
     int ireqSWEEP=0;
     //fprintf(stdout,"Populating with %2d scans...\n",nscans);
     if (RAVE_OBJECT_CHECK_TYPE(object, &PolarVolume_TYPE)) {
 	  for (ireqSWEEP=0;ireqSWEEP<nscans;ireqSWEEP++) {
+		if (!rb5_info->slice_selected[ireqSWEEP]) continue;
 		PolarScan_t* scan = RAVE_OBJECT_NEW(&PolarScan_TYPE);
-		ret = populateScan((PolarScan_t*)scan, &(*rb5_info), ireqSWEEP);
+		ret = populateScanDecoded((PolarScan_t*)scan, &(*rb5_info), ireqSWEEP, (params != NULL) ? params+ireqSWEEP*np : NULL);
         if(ret != 1) {
           RAVE_OBJECT_RELEASE(scan);
           return -1;
@@ -483,7 +605,7 @@ if(L_RB52ODIM_DEBUG) fprintf(stdout,"Done top-level 'how' attributes...\n");
     } else {
       /* Only one scan to populate */
       //fprintf(stdout,"Adding scan = %2d (%4.1f deg) to SCAN...\n",ireqSWEEP,rb5_info->angle_deg_arr[ireqSWEEP]);
-      ret = populateScan((PolarScan_t*)object, &(*rb5_info), ireqSWEEP);
+      ret = populateScanDecoded((PolarScan_t*)object, &(*rb5_info), ireqSWEEP, params);
       if(ret != 1) {
         return -1;
       }
@@ -495,64 +617,133 @@ if(L_RB52ODIM_DEBUG) fprintf(stdout,"Done top-level 'how' attributes...\n");
 }
 
 /*
- * Reads an RB5 buffer and returns a RaveIO_t* with a complete payload.
+ * Takes over an RB5 buffer (released by close_rb5_info() as buffer_owner says, FILE_BUFFER_BORROWED
+ * ones are left to the caller), possibly gzipped, streams its XML header and reads the top level info
+ * of the selected slices (all if slice_select is NULL).
  */
-RaveIO_t* getRaveIObuf(const char* ifile, char **inp_buffer, size_t buffer_len) {
-    RaveIO_t* RETURN_raveio_NULL = NULL;
-
-//#############################################################################
-
+static int openRB5InfoBuf(strRB5_INFO *rb5_info, const char* ifile, char **inp_buffer, size_t buffer_len, int buffer_owner, const strRB5_SLICE_SELECT *slice_select) {
     char *inp_fname=(char *)ifile;
 
     //get RB5 top level info
-    strRB5_INFO rb5_info;
-    strcpy(rb5_info.inp_fullfile,inp_fname);
+    strcpy(rb5_info->inp_fullfile,inp_fname);
 //printf("GOT inp_fname = %s\n", inp_fname);
 //printf("buffer_len= %ld\n", buffer_len);
 //printf("READ buffer = %.250s\n",*inp_buffer);
-//return RETURN_raveio_NULL;
 
-    rb5_info.buffer=*inp_buffer;
-    rb5_info.buffer_len=buffer_len;
+    //a gzipped buffer is inflated whole, then stands in for the one taken over
+    if(is_gzip_buffer((const unsigned char *)*inp_buffer,buffer_len)) {
+      char *gunzipped=NULL;
+      size_t gunzipped_len=gunzip_buffer((const unsigned char *)*inp_buffer,buffer_len,&gunzipped);
+      close_file_buffer(*inp_buffer,buffer_len,buffer_owner);
+      *inp_buffer=gunzipped;
+      buffer_len=gunzipped_len;
+      buffer_owner=FILE_BUFFER_HEAP;
+      if(gunzipped_len == 0) {
+        fprintf(stderr,"Error cannot gunzip file = %s\n", inp_fname);
+        return(EXIT_FAILURE);
+      }
+    }
 
-    //find end of XML
-    rb5_info.byte_offset_blobspace=find_buffer_end_of_xml(*inp_buffer);
+    rb5_info->buffer=*inp_buffer;
+    rb5_info->buffer_len=buffer_len;
+    rb5_info->buffer_owner=buffer_owner;
+    rb5_info->blob_index=NULL;
+    rb5_info->n_blob_index=0;
+    rb5_info->xml_model=NULL;
 
-    // parse the XML and get the DOM
-    rb5_info.doc=xmlReadMemory(rb5_info.buffer, rb5_info.byte_offset_blobspace, "noname.xml", NULL, 0);
+    //find end of XML, populate_rb5_info() reads the header from there without a DOM
+    rb5_info->byte_offset_blobspace=find_buffer_end_of_xml(*inp_buffer,buffer_len);
+    rb5_info->blobspace_pending=0;
+    rb5_info->doc=NULL;
+    rb5_info->xpathCtx=NULL;
 
-    // create xpath evaluation context
-    rb5_info.xpathCtx = xmlXPathNewContext(rb5_info.doc);
-    if(rb5_info.xpathCtx == NULL) {
-        fprintf(stderr,"Error: unable to create new XPath context\n");
-        close_rb5_info(&rb5_info);
-        return RETURN_raveio_NULL;
+    int L_VERBOSE=0;
+    if(populate_rb5_info_slices(&(*rb5_info),L_VERBOSE,slice_select) != 0) {
+      fprintf(stderr,"Error cannot process file = %s\n", inp_fname);
+      return(EXIT_FAILURE);
     }
+    return(EXIT_SUCCESS);
+}
 
-    int L_VERBOSE=0;
-    if(populate_rb5_info(&rb5_info,L_VERBOSE) != 0) {
+/*
+ * Ingests an RB5 file in two phases and reads the top level info of the selected slices.
+ * Only the XML header is read first, the BLOBs follow if any of the requested quantities
+ * (all if NULL) is in the file. Regular files are memory-mapped, so that the phases only
+ * differ by which pages get touched.
+ */
+static int openRB5Info(strRB5_INFO *rb5_info, const char* ifile, const char** quantities, size_t n_quantities, const strRB5_SLICE_SELECT *slice_select) {
+    char *inp_fname=(char *)ifile;
+    strXML_FILE_INFO xml_info;
+    strcpy(xml_info.inp_fullfile,inp_fname);
+    if(read_xml_header(&xml_info) != 0) {
       fprintf(stderr,"Error cannot process file = %s\n", inp_fname);
-      return RETURN_raveio_NULL;
+      return(EXIT_FAILURE);
     }
 
-//#############################################################################
-    RaveIO_t* raveio = RAVE_OBJECT_NEW(&RaveIO_TYPE);
-    RaveCoreObject* object = NULL;
-    int rot = Rave_ObjectType_UNDEFINED;
+    //get RB5 top level info
+    //init with xml_info
+    strcpy(rb5_info->inp_fullfile,xml_info.inp_fullfile);
+    rb5_info->buffer=xml_info.buffer;
+    rb5_info->buffer_len=xml_info.buffer_len;
+    rb5_info->buffer_owner=xml_info.buffer_owner;
+    rb5_info->byte_offset_blobspace=xml_info.byte_offset_end_of_xml;
+    rb5_info->blobspace_pending=xml_info.header_only; //a mapped or gunzipped file is there in full
+    rb5_info->doc=xml_info.doc;
+    rb5_info->xpathCtx=xml_info.xpathCtx;
+    rb5_info->blob_index=NULL;
+    rb5_info->n_blob_index=0;
+    rb5_info->xml_model=NULL;
+
+    if (quantities != NULL) {
+      rb5_info->xml_model=build_rb5_xml_model(rb5_info->buffer,rb5_info->byte_offset_blobspace);
+      if ((rb5_info->xml_model != NULL) && (count_rb5_xml_quantities(rb5_info->xml_model,quantities,n_quantities) == 0)) {
+        fprintf(stderr,"Error: none of the requested quantities in file = %s\n", inp_fname);
+        close_rb5_info(&(*rb5_info));
+        return(EXIT_FAILURE);
+      }
+    }
 
-    /* If the RB5 file contains a scan or a pvol, create equivalent object */
-    rot = objectTypeFromRB5(rb5_info);
+    int L_VERBOSE=0;
+    if(populate_rb5_info_slices(&(*rb5_info),L_VERBOSE,slice_select) != 0) {
+      fprintf(stderr,"Error cannot process file = %s\n", inp_fname);
+      return(EXIT_FAILURE);
+    }
+    return(EXIT_SUCCESS);
+}
+
+/*
+ * If the RB5 file contains a scan or a pvol, creates the equivalent (empty) Toolbox object.
+ */
+static RaveCoreObject* newObjectFromRB5(strRB5_INFO *rb5_info) {
+    int rot = objectTypeFromRB5(*rb5_info);
     if (rot == Rave_ObjectType_PVOL) {
-      object = (RaveCoreObject*)RAVE_OBJECT_NEW(&PolarVolume_TYPE);
-    } else {
-      if(rot == Rave_ObjectType_SCAN) {
-        object = (RaveCoreObject*)RAVE_OBJECT_NEW(&PolarScan_TYPE);
-      } else return RETURN_raveio_NULL;
+      return (RaveCoreObject*)RAVE_OBJECT_NEW(&PolarVolume_TYPE);
+    } else if (rot == Rave_ObjectType_SCAN) {
+      return (RaveCoreObject*)RAVE_OBJECT_NEW(&PolarScan_TYPE);
+    }
+    return NULL;
+}
+
+/*
+ * Maps an open RB5 payload to a Toolbox object in a new RaveIO_t*, then closes the payload.
+ */
+static RaveIO_t* newRaveIOFromRB5(strRB5_INFO *rb5_info) {
+    RaveCoreObject* object = newObjectFromRB5(&(*rb5_info));
+    if (object == NULL) {
+        close_rb5_info(&(*rb5_info));
+        return NULL;
     }
+    RaveIO_t* raveio = RAVE_OBJECT_NEW(&RaveIO_TYPE);
 
     /* Map RB5 object(s) to Toolbox ones. */
-    populateObject(object, &rb5_info);
-    close_rb5_info(&rb5_info);
+    int ret = populateObject(object, &(*rb5_info));
+    close_rb5_info(&(*rb5_info));
+//    xmlCleanupParser(); // free globals in main() only for thread safety & valgrind
+    if (ret < 0) {
+        RAVE_OBJECT_RELEASE(object);
+        RAVE_OBJECT_RELEASE(raveio);
+        return NULL;
+    }
 
     /* Set the object into the I/O container */
     RaveIO_setObject(raveio, object);
@@ -561,66 +752,1151 @@ RaveIO_t* getRaveIObuf(const char* ifile, char **inp_buffer, size_t buffer_len)
     return raveio;
 }
 
+/*
+ * Keeps only the requested ODIM quantities (all if NULL) of an open RB5 payload, closing it if none is there.
+ */
+static int selectQuantities(strRB5_INFO *rb5_info, const char** quantities, size_t n_quantities) {
+    if (select_rb5_rawdatas(&(*rb5_info), quantities, n_quantities) == 0) {
+        fprintf(stderr,"Error: none of the requested quantities in file = %s\n", rb5_info->inp_fullfile);
+        close_rb5_info(&(*rb5_info));
+        return(EXIT_FAILURE);
+    }
+    return(EXIT_SUCCESS);
+}
+
+/*
+ * Reads an RB5 buffer, taking over the malloc()ed inp_buffer, and returns a RaveIO_t* with a complete payload.
+ */
+RaveIO_t* getRaveIObuf(const char* ifile, char **inp_buffer, size_t buffer_len) {
+    return getRaveIObufSubset(ifile, &(*inp_buffer), buffer_len, FILE_BUFFER_HEAP, NULL, 0, NULL);
+}
+
+/*
+ * As getRaveIObuf(), with only the moments of the given ODIM quantities (all if NULL),
+ * as named by map_rb5_to_h5_param(). Blobs of the other moments are never decoded.
+ */
+RaveIO_t* getRaveIObufQuantities(const char* ifile, char **inp_buffer, size_t buffer_len, const char** quantities, size_t n_quantities) {
+    return getRaveIObufSubset(ifile, &(*inp_buffer), buffer_len, FILE_BUFFER_HEAP, quantities, n_quantities, NULL);
+}
+
+/*
+ * As getRaveIObufQuantities(), with only the slices selected by index or elevation angle
+ * (all if NULL). Unselected slices are neither parsed nor decoded, and left out of the volume.
+ * inp_buffer is released as buffer_owner says, a FILE_BUFFER_BORROWED one is only read
+ * while decoding, and stays the caller's.
+ */
+RaveIO_t* getRaveIObufSubset(const char* ifile, char **inp_buffer, size_t buffer_len, int buffer_owner, const char** quantities, size_t n_quantities, const strRB5_SLICE_SELECT* slice_select) {
+    strRB5_INFO rb5_info;
+    if (openRB5InfoBuf(&rb5_info, ifile, &(*inp_buffer), buffer_len, buffer_owner, slice_select) != EXIT_SUCCESS) return NULL;
+    if (selectQuantities(&rb5_info, quantities, n_quantities) != EXIT_SUCCESS) return NULL;
+    return newRaveIOFromRB5(&rb5_info);
+}
+
 /*
  * Reads an RB5 file and returns a RaveIO_t* with a complete payload.
  */
 RaveIO_t* getRaveIO(const char* ifile) {
-    RaveIO_t* RETURN_raveio_NULL = NULL;
+    return getRaveIOSubset(ifile, NULL, 0, NULL);
+}
+
+/*
+ * As getRaveIO(), with only the moments of the given ODIM quantities (all if NULL).
+ */
+RaveIO_t* getRaveIOQuantities(const char* ifile, const char** quantities, size_t n_quantities) {
+    return getRaveIOSubset(ifile, quantities, n_quantities, NULL);
+}
 
-//#############################################################################
+static RaveIO_t* decodeRaveIO(const char* ifile, const char** quantities, size_t n_quantities, const strRB5_SLICE_SELECT* slice_select) {
+    strRB5_INFO rb5_info;
+    if (openRB5Info(&rb5_info, ifile, quantities, n_quantities, slice_select) != EXIT_SUCCESS) return NULL;
+    if (selectQuantities(&rb5_info, quantities, n_quantities) != EXIT_SUCCESS) return NULL;
+    return newRaveIOFromRB5(&rb5_info);
+}
 
-   //use open_xml_buffer() to ingest file
-    char *inp_fname=(char *)ifile;
-    strXML_FILE_INFO xml_info;
-    strcpy(xml_info.inp_fullfile,inp_fname);
-    if(open_xml_buffer(&xml_info) != 0) {
-      fprintf(stderr,"Error cannot process file = %s\n", inp_fname);
-      return RETURN_raveio_NULL;
+/*
+ * As getRaveIOQuantities(), with only the selected slices (all if NULL).
+ * Full reads go through the cache while it is on, see setRB5Cache().
+ */
+RaveIO_t* getRaveIOSubset(const char* ifile, const char** quantities, size_t n_quantities, const strRB5_SLICE_SELECT* slice_select) {
+    uint64_t cache_max_bytes;
+    const char* cache_dir = getRB5Cache(&cache_max_bytes);
+    if ((cache_dir != NULL) && (quantities == NULL) && (slice_select == NULL)) {
+        return getRaveIOCached(ifile, cache_dir, cache_max_bytes);
     }
+    return decodeRaveIO(ifile, quantities, n_quantities, slice_select);
+}
 
-    //get RB5 top level info
-    //init with xml_info
-    strRB5_INFO rb5_info;
-    strcpy(rb5_info.inp_fullfile,xml_info.inp_fullfile);
-    rb5_info.buffer=xml_info.buffer;
-    rb5_info.buffer_len=xml_info.buffer_len;
-    rb5_info.byte_offset_blobspace=xml_info.byte_offset_end_of_xml;
-    rb5_info.doc=xml_info.doc;
-    rb5_info.xpathCtx=xml_info.xpathCtx;
-
-//#############################################################################
+/*
+ * Reads the RB5 payload, possibly gzipped, from fd to its end into rb5_info, see getRaveIOStream().
+ * Only the BLOBs of the selected slices and quantities are inflated as they arrive. No RAVE object
+ * and no static buffer is touched, so that callers may run it while other threads go on.
+ */
+int readRB5Stream(strRB5_INFO *rb5_info, int fd, const char* ifile, const char** quantities, size_t n_quantities, const strRB5_SLICE_SELECT* slice_select) {
+    if (read_rb5_stream(fd, ifile, quantities, n_quantities, slice_select, &(*rb5_info)) != EXIT_SUCCESS) {
+      fprintf(stderr,"Error cannot process file = %s\n", ifile);
+      return(EXIT_FAILURE);
+    }
+    return(EXIT_SUCCESS);
+}
+
+/*
+ * Returns a RaveIO_t* from the payload of readRB5Stream(), with the same selection, rb5_info is closed.
+ */
+RaveIO_t* getRaveIOStreamed(strRB5_INFO *rb5_info, const char** quantities, size_t n_quantities, const strRB5_SLICE_SELECT* slice_select) {
     int L_VERBOSE=0;
-    if(populate_rb5_info(&rb5_info,L_VERBOSE) != 0) {
-      fprintf(stderr,"Error cannot process file = %s\n", inp_fname);
-      return RETURN_raveio_NULL;
+    if (populate_rb5_info_slices(&(*rb5_info), L_VERBOSE, slice_select) != 0) {
+      fprintf(stderr,"Error cannot process file = %s\n", rb5_info->inp_fullfile);
+      return NULL;
     }
+    if (selectQuantities(&(*rb5_info), quantities, n_quantities) != EXIT_SUCCESS) return NULL;
+    return newRaveIOFromRB5(&(*rb5_info));
+}
 
-//#############################################################################
-    RaveIO_t* raveio = RAVE_OBJECT_NEW(&RaveIO_TYPE);
-    RaveCoreObject* object = NULL;
-    int rot = Rave_ObjectType_UNDEFINED;
+/*
+ * As getRaveIOSubset(), reading the RB5 payload, possibly gzipped, from fd to its end: a pipe,
+ * a socket or stdin, that need not be seekable. ifile names it in messages and metadata. The
+ * XML header is parsed and the BLOBs are inflated as they arrive, see read_rb5_stream().
+ */
+RaveIO_t* getRaveIOStream(int fd, const char* ifile, const char** quantities, size_t n_quantities, const strRB5_SLICE_SELECT* slice_select) {
+    strRB5_INFO rb5_info;
+    if (readRB5Stream(&rb5_info, fd, ifile, quantities, n_quantities, slice_select) != EXIT_SUCCESS) return NULL;
+    return getRaveIOStreamed(&rb5_info, quantities, n_quantities, slice_select);
+}
 
-    /* If the RB5 file contains a scan or a pvol, create equivalent object */
-    rot = objectTypeFromRB5(rb5_info);
-    if (rot == Rave_ObjectType_PVOL) {
-      object = (RaveCoreObject*)RAVE_OBJECT_NEW(&PolarVolume_TYPE);
+//################################################################################
+// Lazy reading: every moment is created with its metadata (quantity, gain, offset,
+// nodata, dims), but its blob is only inflated by loadLazyParams(), or when saved
+// with saveRaveIOLazy(). Moments join their scan once decoded, so the object never
+// shows zeroed data. The payload (file buffer, header model, blob index) stays open
+// for that until closeRaveIOLazy().
+//################################################################################
+
+/*
+ * Scan this_slice of a volume, or the scan itself, as a new reference.
+ */
+static PolarScan_t* getObjectScan(RaveCoreObject* object, int this_slice) {
+    if (RAVE_OBJECT_CHECK_TYPE(object, &PolarVolume_TYPE)) {
+        return PolarVolume_getScan((PolarVolume_t*)object, this_slice);
+    }
+    return (PolarScan_t*)RAVE_OBJECT_COPY(object);
+}
+
+/*
+ * Data array of lazy param k to decode into, fetched afresh in case it was replaced since
+ * createParams(). NULL unless it still has the dims and type of the blob.
+ */
+static void* getLazyParamData(strRB5_LAZY* lazy, size_t k) {
+    PolarScanParam_t* param = lazy->params[k];
+    strRB5_PARAM_INFO* rb5_param = &(lazy->tasks[k].rb5_param);
+    if ((PolarScanParam_getNbins(param) != (long)rb5_param->nbins) ||
+        (PolarScanParam_getNrays(param) != (long)rb5_param->nrays) ||
+        (PolarScanParam_getDataType(param) != paramDataType(rb5_param))) {
+        fprintf(stderr,"Error: %s of slice %ld no longer fits its blob in file = %s\n", rb5_param->sparam, k/lazy->rb5_info.n_rawdatas, lazy->rb5_info.inp_fullfile);
+        return NULL;
+    }
+    return PolarScanParam_getData(param);
+}
+
+static strRB5_LAZY* newRaveIOLazy(strRB5_INFO *rb5_info) {
+    RaveCoreObject* object = newObjectFromRB5(&(*rb5_info));
+    if (object == NULL) {
+        close_rb5_info(&(*rb5_info));
+        return NULL;
+    }
+    strRB5_LAZY* lazy = RAVE_MALLOC(sizeof(strRB5_LAZY));
+    if (lazy == NULL) {
+        RAVE_OBJECT_RELEASE(object);
+        close_rb5_info(&(*rb5_info));
+        return NULL;
+    }
+    lazy->rb5_info = *rb5_info;
+    lazy->n_params = (size_t)lazy->rb5_info.n_slices*lazy->rb5_info.n_rawdatas;
+    lazy->tasks = NULL;
+    lazy->params = createParams(&(lazy->rb5_info), lazy->rb5_info.n_slices, &(lazy->tasks));
+    lazy->raveio = NULL;
+    /* Scans without moments, see loadLazyParams() */
+    PolarScanParam_t** none = RAVE_CALLOC(lazy->n_params+1, sizeof(PolarScanParam_t*));
+    if ((lazy->params == NULL) || (none == NULL) || (populateObjectParams(object, &(lazy->rb5_info), none) < 0)) {
+        if (none != NULL) RAVE_FREE(none);
+        RAVE_OBJECT_RELEASE(object);
+        closeRaveIOLazy(lazy);
+        return NULL;
+    }
+    RAVE_FREE(none);
+    lazy->raveio = RAVE_OBJECT_NEW(&RaveIO_TYPE);
+    RaveIO_setObject(lazy->raveio, object);
+    RAVE_OBJECT_RELEASE(object);
+
+    return lazy;
+}
+
+/*
+ * Reads an RB5 file and returns its payload with undecoded moments, see loadLazyParams().
+ * The file is read whole rather than mapped: the payload stays open until closeRaveIOLazy(),
+ * and a mapped file truncated meanwhile would raise SIGBUS when its moments are decoded.
+ */
+strRB5_LAZY* getRaveIOLazy(const char* ifile) {
+    char *inp_buffer = NULL;
+    size_t buffer_len = read_file_2_buffer((char *)ifile, &inp_buffer);
+    if (buffer_len == 0) {
+        fprintf(stderr,"Error cannot process file = %s\n", ifile);
+        return NULL;
+    }
+    return getRaveIObufLazy(ifile, &inp_buffer, buffer_len, FILE_BUFFER_HEAP);
+}
+
+/*
+ * As getRaveIOLazy() for an RB5 buffer, released as buffer_owner says by closeRaveIOLazy().
+ * A FILE_BUFFER_BORROWED one must outlive the payload.
+ */
+strRB5_LAZY* getRaveIObufLazy(const char* ifile, char **inp_buffer, size_t buffer_len, int buffer_owner) {
+    strRB5_INFO rb5_info;
+    if (openRB5InfoBuf(&rb5_info, ifile, &(*inp_buffer), buffer_len, buffer_owner, NULL) != EXIT_SUCCESS) return NULL;
+    return newRaveIOLazy(&rb5_info);
+}
+
+/*
+ * Decodes the moments not decoded yet, of one ODIM quantity (NULL for all) in one
+ * slice (-1 for all), on getDecodeThreads() threads, and adds them to their scans.
+ * Returns the number of moments decoded by this call, or -1 on error.
+ */
+int loadLazyParams(strRB5_LAZY* lazy, const char* quantity, int this_slice) {
+    size_t np = lazy->rb5_info.n_rawdatas;
+    size_t k, n_todo = 0;
+    int ret = 0;
+
+    size_t* todo = RAVE_MALLOC((lazy->n_params+1)*sizeof(size_t));
+    strRB5_DECODE_TASK* tasks = RAVE_MALLOC((lazy->n_params+1)*sizeof(strRB5_DECODE_TASK));
+    if ((todo == NULL) || (tasks == NULL)) {
+        if (todo != NULL) RAVE_FREE(todo);
+        if (tasks != NULL) RAVE_FREE(tasks);
+        return -1;
+    }
+    for (k=0;k<lazy->n_params;k++) {
+        if ((lazy->tasks[k].dest_arr == NULL) || (lazy->tasks[k].n_elems_data != 0)) continue;
+        if ((this_slice >= 0) && (k/np != (size_t)this_slice)) continue;
+        if ((quantity != NULL) && (strcmp(PolarScanParam_getQuantity(lazy->params[k]),quantity) != 0)) continue;
+        todo[n_todo] = k;
+        tasks[n_todo] = lazy->tasks[k];
+        tasks[n_todo].dest_arr = getLazyParamData(lazy, k);
+        if (tasks[n_todo].dest_arr == NULL) {
+            ret = -1;
+            continue;
+        }
+        n_todo++;
+    }
+
+    decode_param_blobids(&(lazy->rb5_info), tasks, n_todo, n_decode_threads);
+
+    RaveCoreObject* object = RaveIO_getObject(lazy->raveio);
+    for (k=0;k<n_todo;k++) {
+        lazy->tasks[todo[k]].n_elems_data = tasks[k].n_elems_data;
+        if (tasks[k].n_elems_data == 0) {
+            ret = -1;
+            continue;
+        }
+        PolarScan_t* scan = getObjectScan(object, (int)(todo[k]/np));
+        if (!PolarScan_addParameter(scan, lazy->params[todo[k]])) ret = -1;
+        else if (ret >= 0) ret++;
+        RAVE_OBJECT_RELEASE(scan);
+    }
+    RAVE_OBJECT_RELEASE(object);
+    RAVE_FREE(todo);
+    RAVE_FREE(tasks);
+    return ret;
+}
+
+/*
+ * Decodes whatever is left, and saves the payload as ODIM_H5. Returns 1 on success, as RaveIO_save().
+ */
+int saveRaveIOLazy(strRB5_LAZY* lazy, const char* ofile) {
+    if (loadLazyParams(lazy, NULL, -1) < 0) return 0;
+    return RaveIO_save(lazy->raveio, ofile);
+}
+
+/*
+ * Closes the payload. The Toolbox objects remain valid, without the moments never loaded.
+ */
+void closeRaveIOLazy(strRB5_LAZY* lazy) {
+    if (lazy == NULL) return;
+    RAVE_OBJECT_RELEASE(lazy->raveio);
+    releaseParams(lazy->params, lazy->n_params);
+    if (lazy->tasks != NULL) RAVE_FREE(lazy->tasks);
+    close_rb5_info(&(lazy->rb5_info));
+    RAVE_FREE(lazy);
+}
+
+//################################################################################
+// Tarballs: the RB5 rawdata files of a bundle (e.g. caxah_dopvol1a_20151209T1650Z.azi.tar.gz,
+// one file per moment), merged into one object. Members are read in place from the tar
+// buffer; headers are parsed one member at a time, then the blobs of all members are
+// decoded together on a pool of threads.
+//################################################################################
+
+/*
+ * Whether a tarball member is merged, as combineRB5FromTarball() filters them: rawdata only,
+ * less the ZDR of the ZPHI_ITER_DEFAULT.dpatc replay.
+ */
+static int isTarballRawdata(const strRB5_MEMBER_NAME *mb) {
+    if (strcmp(mb->rb5_ftype,"rawdata") != 0) return 0;
+    if ((strcmp(mb->rb5_ppdf,"ZPHI_ITER_DEFAULT.dpatc") == 0) && (strcmp(mb->nam_sparam,"ZDR") == 0)) return 0;
+    return 1;
+}
+
+/*
+ * isRainbow5buf() on the first line of a buffer that need not be NUL terminated (a tar member, a mapped file).
+ */
+static int isRainbow5head(const char* buffer, size_t buffer_len) {
+    char line_buf[MAX_STRING+1]="\0";
+    char *line=line_buf;
+    size_t line_len=(buffer_len < MAX_STRING) ? buffer_len : MAX_STRING;
+    memcpy(line_buf,buffer,line_len);
+    line_buf[line_len]='\0';
+    return isRainbow5buf(&line);
+}
+
+/*
+ * Opens one member of a tar buffer, borrowing its bytes, with undecoded moments.
+ */
+static strRB5_LAZY* openTarballMember(const char* ifile, char *tar_buffer, const strTAR_MEMBER *member) {
+    const char *inp_fname=member->name;
+
+    //named in rb5_info->inp_fullfile, and thereby in the metadata, whole or not at all
+    if (strlen(inp_fname) >= MAX_STRING) {
+        fprintf(stderr,"Error: member name longer than %d in tarball = %s : %.64s...\n", MAX_STRING-1, ifile, inp_fname);
+        return NULL;
+    }
+    if (isRainbow5head(tar_buffer+member->byte_offset, member->size) != 0) {
+        fprintf(stderr,"Error: %s is not a proper RB5 buffer in tarball = %s\n", inp_fname, ifile);
+        return NULL;
+    }
+
+    strRB5_INFO rb5_info;
+    char *inp_buffer = tar_buffer+member->byte_offset;
+    if (openRB5InfoBuf(&rb5_info, inp_fname, &inp_buffer, member->size, FILE_BUFFER_BORROWED, NULL) != EXIT_SUCCESS) return NULL;
+    return newRaveIOLazy(&rb5_info);
+}
+
+/*
+ * As loadLazyParams() for every member at once, so that no thread waits on a member with
+ * fewer moments. Returns the number of moments decoded, or -1 on error.
+ */
+static int loadTarballParams(strRB5_LAZY** lazies, size_t n_lazies, int n_threads) {
+    size_t m, k, n_params = 0, n_todo = 0;
+    int ret = 0;
+
+    for (m=0;m<n_lazies;m++) n_params += lazies[m]->n_params;
+    strRB5_DECODE_TASK* tasks = RAVE_MALLOC((n_params+1)*sizeof(strRB5_DECODE_TASK));
+    if (tasks == NULL) return -1;
+    for (m=0;m<n_lazies;m++) {
+        for (k=0;k<lazies[m]->n_params;k++) {
+            if ((lazies[m]->tasks[k].dest_arr == NULL) || (lazies[m]->tasks[k].n_elems_data != 0)) continue;
+            tasks[n_todo] = lazies[m]->tasks[k];
+            tasks[n_todo].dest_arr = getLazyParamData(lazies[m], k);
+            if (tasks[n_todo].dest_arr == NULL) {
+                RAVE_FREE(tasks);
+                return -1;
+            }
+            tasks[n_todo++].rb5_info = &(lazies[m]->rb5_info);
+        }
+    }
+
+    decode_param_blobids(NULL, tasks, n_todo, n_threads);
+
+    n_todo = 0;
+    for (m=0;m<n_lazies;m++) {
+        for (k=0;k<lazies[m]->n_params;k++) {
+            if ((lazies[m]->tasks[k].dest_arr == NULL) || (lazies[m]->tasks[k].n_elems_data != 0)) continue;
+            lazies[m]->tasks[k].n_elems_data = tasks[n_todo].n_elems_data;
+            if (tasks[n_todo++].n_elems_data == 0) ret = -1;
+            else if (ret >= 0) ret++;
+        }
+    }
+    RAVE_FREE(tasks);
+    return ret;
+}
+
+/*
+ * Moves the moments of every member into the scans of the first member's object, by scan
+ * index, as compile_big_scan() and compile_big_pvol() did. The quantity of a member under a
+ * post-processing product definition gets its extension, e.g. ZDR.dpatc. Returns the merged
+ * object in a new RaveIO_t*, NULL if the members don't fit together.
+ */
+static RaveIO_t* mergeTarballMembers(strRB5_LAZY** lazies, const strRB5_MEMBER_NAME* mbs, size_t n_lazies) {
+    RaveCoreObject* big_obj = RaveIO_getObject(lazies[0]->raveio);
+    int is_pvol = RAVE_OBJECT_CHECK_TYPE(big_obj, &PolarVolume_TYPE) ? 1 : 0;
+    int ret = 1;
+    size_t m, k;
+
+    for (m=0;(m<n_lazies) && ret;m++) {
+        strRB5_LAZY* lazy = lazies[m];
+        RaveCoreObject* obj = RaveIO_getObject(lazy->raveio);
+        size_t np = lazy->rb5_info.n_rawdatas;
+        if (((RAVE_OBJECT_CHECK_TYPE(obj, &PolarVolume_TYPE) ? 1 : 0) != is_pvol) ||
+            (lazy->rb5_info.n_slices != lazies[0]->rb5_info.n_slices)) {
+            fprintf(stderr,"Error: scans of tarball member = %s differ from those of %s\n", lazy->rb5_info.inp_fullfile, lazies[0]->rb5_info.inp_fullfile);
+            ret = 0;
+        }
+        for (k=0;(k<lazy->n_params) && ret;k++) {
+            /* Decoded params never joined the member's own scans, see loadTarballParams() */
+            PolarScanParam_t* param = lazy->params[k];
+            if ((param == NULL) || (lazy->tasks[k].n_elems_data == 0)) continue;
+            PolarScan_t* big_scan = getObjectScan(big_obj, (int)(k/np));
+
+            char quantity[MAX_STRING]="\0";
+            snprintf(quantity,MAX_STRING,"%s",PolarScanParam_getQuantity(param));
+            if (mbs[m].rb5_ppdf[0] != '\0') {
+                //rb5_ppdf[rb5_ppdf.find("."):]
+                const char* ext = strchr(mbs[m].rb5_ppdf,'.');
+                if (ext == NULL) ext = mbs[m].rb5_ppdf+strlen(mbs[m].rb5_ppdf)-1;
+                strncat(quantity,ext,MAX_STRING-strlen(quantity)-1);
+                PolarScanParam_setQuantity(param, quantity);
+            }
+            if (!PolarScan_addParameter(big_scan, param)) {
+                fprintf(stderr,"Error: cannot merge %s of tarball member = %s\n", quantity, lazy->rb5_info.inp_fullfile);
+                ret = 0;
+            }
+            RAVE_OBJECT_RELEASE(big_scan);
+        }
+        RAVE_OBJECT_RELEASE(obj);
+    }
+
+    RaveIO_t* raveio = NULL;
+    if (ret) {
+        if (is_pvol) PolarVolume_sortByElevations((PolarVolume_t*)big_obj, 1);
+        raveio = RAVE_OBJECT_NEW(&RaveIO_TYPE);
+        RaveIO_setObject(raveio, big_obj);
+    }
+    RAVE_OBJECT_RELEASE(big_obj);
+    return raveio;
+}
+
+/*
+ * Reads the RB5 rawdata members of a tarball, possibly gzipped, decoding their moments on
+ * n_threads (0 for one per online CPU), and returns a RaveIO_t* with them merged into one
+ * scan or volume.
+ */
+RaveIO_t* getRaveIOTarball(const char* ifile, int n_threads) {
+    char *tar_buffer=NULL;
+    int tar_owner=FILE_BUFFER_HEAP;
+    strTAR_MEMBER* members=NULL;
+    size_t k, n_lazies=0;
+    int ret=1;
+    RaveIO_t* raveio=NULL;
+
+    size_t tar_len=read_tar_2_buffer((char *)ifile, &tar_buffer, &tar_owner);
+    if (tar_len == 0) return NULL;
+    size_t n_members=index_tar_members(tar_buffer, tar_len, &members);
+    if (n_members == 0) {
+        fprintf(stderr,"Error cannot process tarball = %s\n", ifile);
+        close_file_buffer(tar_buffer, tar_len, tar_owner);
+        return NULL;
+    }
+    strRB5_LAZY** lazies = RAVE_MALLOC(n_members*sizeof(strRB5_LAZY*));
+    strRB5_MEMBER_NAME* mbs = RAVE_MALLOC(n_members*sizeof(strRB5_MEMBER_NAME));
+    if ((lazies == NULL) || (mbs == NULL)) ret = 0;
+
+    /* Headers one member at a time, populate_rb5_info() is not reentrant */
+    for (k=0;(k<n_members) && ret;k++) {
+        parse_rb5_member_name(members[k].name, &(mbs[n_lazies]));
+        if (!isTarballRawdata(&(mbs[n_lazies]))) continue;
+        lazies[n_lazies] = openTarballMember(ifile, tar_buffer, &(members[k]));
+        if (lazies[n_lazies] == NULL) {
+            ret = 0;
+            break;
+        }
+        n_lazies++;
+    }
+    if (ret && (n_lazies == 0)) fprintf(stderr,"Error: no RB5 rawdata in tarball = %s\n", ifile);
+
+    /* Blobs of all members together */
+    if (ret && (n_lazies > 0)) {
+        if (n_threads == 0) n_threads = onlineCPUs();
+        if (loadTarballParams(lazies, n_lazies, n_threads) >= 0) raveio = mergeTarballMembers(lazies, mbs, n_lazies);
+    }
+
+    for (k=0;k<n_lazies;k++) closeRaveIOLazy(lazies[k]);
+    if (lazies != NULL) RAVE_FREE(lazies);
+    if (mbs != NULL) RAVE_FREE(mbs);
+    free(members);
+    close_file_buffer(tar_buffer, tar_len, tar_owner);
+    return raveio;
+}
+
+//################################################################################
+// Batches: an ordered list of RB5 files, e.g. one per moment of a scan, read ahead a
+// window at a time (prefetch_utils) so that the next files are on their way in while
+// one is decoded.
+//################################################################################
+
+/*
+ * Starts reading ahead the first window files of ifiles (0 for PREFETCH_WINDOW_DEFAULT),
+ * get them in order with nextRaveIOBatch(). Returns NULL if out of memory.
+ */
+strRB5_BATCH* openRB5Batch(const char** ifiles, size_t n_files, size_t window) {
+    size_t k;
+    strRB5_BATCH* batch = RAVE_MALLOC(sizeof(strRB5_BATCH));
+    if (batch == NULL) return NULL;
+    batch->n_files = n_files;
+    batch->prefetch = NULL;
+    batch->fnames = RAVE_MALLOC((n_files+1)*sizeof(char*));
+    if (batch->fnames == NULL) {
+        RAVE_FREE(batch);
+        return NULL;
+    }
+    for (k=0;k<n_files;k++) {
+        if ((batch->fnames[k] = RAVE_STRDUP(ifiles[k])) == NULL) break;
+    }
+    if (k == n_files) batch->prefetch = prefetch_open(batch->fnames, n_files, window);
+    if (batch->prefetch == NULL) {
+        batch->n_files = k;
+        closeRB5Batch(batch);
+        return NULL;
+    }
+    return batch;
+}
+
+/*
+ * Reads the next file of a batch, then lets the file after the window in. Returns 0 once
+ * all files have been read, else 1 with the index of the file in ifiles and a RaveIO_t*
+ * with its complete payload, NULL if it is not a readable RB5 file.
+ */
+int nextRaveIOBatch(strRB5_BATCH* batch, size_t* return_idx, RaveIO_t** return_raveio) {
+    char *inp_buffer=NULL;
+    size_t buffer_len=0;
+    int buffer_owner=FILE_BUFFER_HEAP;
+
+    if (prefetch_next(batch->prefetch, &(*return_idx), &inp_buffer, &buffer_len, &buffer_owner) == 0) return 0;
+    *return_raveio = NULL;
+    const char* ifile = batch->fnames[*return_idx];
+    if (buffer_len == 0) return 1; //the usual messages were printed
+
+    //inflated here rather than by openRB5InfoBuf(), so that its first line can be checked
+    if (is_gzip_buffer((const unsigned char *)inp_buffer, buffer_len)) {
+        char *gunzipped=NULL;
+        size_t gunzipped_len=gunzip_buffer((const unsigned char *)inp_buffer, buffer_len, &gunzipped);
+        close_file_buffer(inp_buffer, buffer_len, buffer_owner);
+        if (gunzipped_len == 0) {
+            fprintf(stderr,"Error cannot gunzip file = %s\n", ifile);
+            return 1;
+        }
+        inp_buffer=gunzipped;
+        buffer_len=gunzipped_len;
+        buffer_owner=FILE_BUFFER_HEAP;
+    }
+    if (isRainbow5head(inp_buffer, buffer_len) != 0) {
+        fprintf(stderr,"Error: %s is not a proper RB5 raw file\n", ifile);
+        close_file_buffer(inp_buffer, buffer_len, buffer_owner);
+        return 1;
+    }
+    *return_raveio = getRaveIObufSubset(ifile, &inp_buffer, buffer_len, buffer_owner, NULL, 0, NULL);
+    return 1;
+}
+
+/*
+ * Drops the files of a batch not read yet, and releases it.
+ */
+void closeRB5Batch(strRB5_BATCH* batch) {
+    size_t k;
+    if (batch == NULL) return;
+    prefetch_close(batch->prefetch);
+    for (k=0;k<batch->n_files;k++) {
+        if (batch->fnames[k] != NULL) RAVE_FREE(batch->fnames[k]);
+    }
+    RAVE_FREE(batch->fnames);
+    RAVE_FREE(batch);
+    inflate_pool_drain(); //the end of a run, don't sit on its blob buffers
+}
+
+//################################################################################
+// Shared memory: a decoded scan or volume published next to RaveIO_save(), for downstream
+// processes (QC, gridding, profiling) to map instead of re-reading the ODIM_H5 file. Laid out
+// as shm_utils.h says: header, scan, moment and attribute tables, then the moment arrays.
+//################################################################################
+
+//where saveRaveIOShm() puts things, sized by a first walk over the object, filled by a second
+typedef struct{
+    char* segment;               //NULL while sizing
+    size_t n_scans;
+    size_t n_moments;
+    size_t n_attribs;
+    size_t value_bytes;          //of the attribute values so far
+    size_t data_bytes;           //of the moment arrays so far
+    size_t scan_offset;
+    size_t moment_offset;
+    size_t attrib_offset;
+    size_t value_offset;
+    size_t data_offset;
+} strRB5_SHM_LAYOUT;
+
+/*
+ * Attribute names of a Toolbox volume, scan or moment, NULL for other objects.
+ */
+static RaveList_t* getAttributeNames(RaveCoreObject* object) {
+    if (RAVE_OBJECT_CHECK_TYPE(object, &PolarVolume_TYPE)) {
+        return PolarVolume_getAttributeNames((PolarVolume_t*)object);
+    } else if (RAVE_OBJECT_CHECK_TYPE(object, &PolarScan_TYPE)) {
+        return PolarScan_getAttributeNames((PolarScan_t*)object);
+    } else if (RAVE_OBJECT_CHECK_TYPE(object, &PolarScanParam_TYPE)) {
+        return PolarScanParam_getAttributeNames((PolarScanParam_t*)object);
+    }
+    return NULL;
+}
+
+/*
+ * Attribute of a Toolbox volume, scan or moment as a new reference, NULL if not there.
+ */
+static RaveAttribute_t* getAttribute(RaveCoreObject* object, const char* name) {
+    if (RAVE_OBJECT_CHECK_TYPE(object, &PolarVolume_TYPE)) {
+        return PolarVolume_getAttribute((PolarVolume_t*)object, name);
+    } else if (RAVE_OBJECT_CHECK_TYPE(object, &PolarScan_TYPE)) {
+        return PolarScan_getAttribute((PolarScan_t*)object, name);
+    } else if (RAVE_OBJECT_CHECK_TYPE(object, &PolarScanParam_TYPE)) {
+        return PolarScanParam_getAttribute((PolarScanParam_t*)object, name);
+    }
+    return NULL;
+}
+
+/*
+ * Element typecode of a moment, as Python's struct and numpy, 0 if it has none.
+ */
+static int shmTypecode(RaveDataType type, char* typecode, uint32_t* elem_bytes) {
+    switch (type) {
+    case RaveDataType_CHAR:   strcpy(typecode, "b"); *elem_bytes = sizeof(char); break;
+    case RaveDataType_UCHAR:  strcpy(typecode, "B"); *elem_bytes = sizeof(unsigned char); break;
+    case RaveDataType_SHORT:  strcpy(typecode, "h"); *elem_bytes = sizeof(short); break;
+    case RaveDataType_USHORT: strcpy(typecode, "H"); *elem_bytes = sizeof(unsigned short); break;
+    case RaveDataType_INT:    strcpy(typecode, "i"); *elem_bytes = sizeof(int); break;
+    case RaveDataType_UINT:   strcpy(typecode, "I"); *elem_bytes = sizeof(unsigned int); break;
+    case RaveDataType_LONG:   strcpy(typecode, "l"); *elem_bytes = sizeof(long); break;
+    case RaveDataType_ULONG:  strcpy(typecode, "L"); *elem_bytes = sizeof(unsigned long); break;
+    case RaveDataType_FLOAT:  strcpy(typecode, "f"); *elem_bytes = sizeof(float); break;
+    case RaveDataType_DOUBLE: strcpy(typecode, "d"); *elem_bytes = sizeof(double); break;
+    default: return 0;
+    }
+    return 1;
+}
+
+/*
+ * Lays out (or, once the segment is there, writes) the attributes of an object,
+ * returning where they are in the attribute table.
+ */
+static void putShmAttributes(strRB5_SHM_LAYOUT* layout, RaveCoreObject* object, uint32_t* first_attrib, uint32_t* n_attribs) {
+    RaveList_t* names = getAttributeNames(object);
+    int i, k;
+
+    *first_attrib = (uint32_t)layout->n_attribs;
+    *n_attribs = 0;
+    if (names == NULL) return;
+    for (i=0;i<RaveList_size(names);i++) {
+        const char* name = (const char*)RaveList_get(names, i);
+        RaveAttribute_t* attr = getAttribute(object, name);
+        if (attr == NULL) continue;
+
+        strRB5_SHM_ATTRIB shm_attrib;
+        memset(&shm_attrib, 0, sizeof(strRB5_SHM_ATTRIB));
+        snprintf(shm_attrib.name, RB5_SHM_MAX_NAME, "%s", name);
+        shm_attrib.n_values = 1;
+        char* svalue = NULL;
+        long lvalue = 0;
+        double dvalue = 0.0;
+        long* larr = NULL;
+        double* darr = NULL;
+        int len = 0;
+        size_t value_bytes = 0;
+        switch (RaveAttribute_getFormat(attr)) {
+        case RaveAttribute_Format_String:
+            RaveAttribute_getString(attr, &svalue);
+            if (svalue == NULL) svalue = "";
+            shm_attrib.format = RB5_SHM_ATTRIB_STRING;
+            shm_attrib.n_values = (uint32_t)(strlen(svalue)+1);
+            value_bytes = shm_attrib.n_values;
+            break;
+        case RaveAttribute_Format_Long:
+            RaveAttribute_getLong(attr, &lvalue);
+            shm_attrib.format = RB5_SHM_ATTRIB_LONG;
+            shm_attrib.lvalue = (int64_t)lvalue;
+            shm_attrib.dvalue = (double)lvalue;
+            break;
+        case RaveAttribute_Format_Double:
+            RaveAttribute_getDouble(attr, &dvalue);
+            shm_attrib.format = RB5_SHM_ATTRIB_DOUBLE;
+            shm_attrib.lvalue = (int64_t)dvalue;
+            shm_attrib.dvalue = dvalue;
+            break;
+        case RaveAttribute_Format_LongArray:
+            RaveAttribute_getLongArray(attr, &larr, &len);
+            shm_attrib.format = RB5_SHM_ATTRIB_LONG_ARRAY;
+            shm_attrib.n_values = (uint32_t)len;
+            value_bytes = len*sizeof(int64_t);
+            break;
+        case RaveAttribute_Format_DoubleArray:
+            RaveAttribute_getDoubleArray(attr, &darr, &len);
+            shm_attrib.format = RB5_SHM_ATTRIB_DOUBLE_ARRAY;
+            shm_attrib.n_values = (uint32_t)len;
+            value_bytes = len*sizeof(double);
+            break;
+        default:
+            RAVE_OBJECT_RELEASE(attr);
+            continue;
+        }
+
+        if (value_bytes > 0) {
+            shm_attrib.value_offset = layout->value_offset+layout->value_bytes;
+            if (layout->segment != NULL) {
+                char* dest = layout->segment+shm_attrib.value_offset;
+                if (svalue != NULL) memcpy(dest, svalue, value_bytes);
+                if (darr != NULL) memcpy(dest, darr, value_bytes);
+                if (larr != NULL) for (k=0;k<len;k++) ((int64_t*)dest)[k] = (int64_t)larr[k];
+            }
+            layout->value_bytes += (value_bytes+7) & ~(size_t)7; //arrays stay 8-byte aligned
+        }
+        if (layout->segment != NULL) {
+            ((strRB5_SHM_ATTRIB*)(layout->segment+layout->attrib_offset))[layout->n_attribs] = shm_attrib;
+        }
+        layout->n_attribs++;
+        (*n_attribs)++;
+        RAVE_OBJECT_RELEASE(attr);
+    }
+    RaveList_freeAndDestroy(&names);
+}
+
+/*
+ * Lays out (or writes) a scan, its moments and their attributes.
+ */
+static void putShmScan(strRB5_SHM_LAYOUT* layout, PolarScan_t* scan) {
+    strRB5_SHM_SCAN shm_scan;
+    RaveList_t* names = PolarScan_getParameterNames(scan);
+    int i;
+
+    memset(&shm_scan, 0, sizeof(strRB5_SHM_SCAN));
+    snprintf(shm_scan.startdate, RB5_SHM_MAX_DATE, "%s", PolarScan_getStartDate(scan) ? PolarScan_getStartDate(scan) : "");
+    snprintf(shm_scan.starttime, RB5_SHM_MAX_DATE, "%s", PolarScan_getStartTime(scan) ? PolarScan_getStartTime(scan) : "");
+    snprintf(shm_scan.enddate, RB5_SHM_MAX_DATE, "%s", PolarScan_getEndDate(scan) ? PolarScan_getEndDate(scan) : "");
+    snprintf(shm_scan.endtime, RB5_SHM_MAX_DATE, "%s", PolarScan_getEndTime(scan) ? PolarScan_getEndTime(scan) : "");
+    shm_scan.elangle = PolarScan_getElangle(scan)/DEG_TO_RAD;
+    shm_scan.rstart = PolarScan_getRstart(scan);
+    shm_scan.rscale = PolarScan_getRscale(scan);
+    shm_scan.a1gate = (int64_t)PolarScan_getA1gate(scan);
+    shm_scan.nrays = (uint32_t)PolarScan_getNrays(scan);
+    shm_scan.nbins = (uint32_t)PolarScan_getNbins(scan);
+    putShmAttributes(layout, (RaveCoreObject*)scan, &shm_scan.first_attrib, &shm_scan.n_attribs);
+
+    shm_scan.first_moment = (uint32_t)layout->n_moments;
+    for (i=0;(names != NULL) && (i<RaveList_size(names));i++) {
+        PolarScanParam_t* param = PolarScan_getParameter(scan, (const char*)RaveList_get(names, i));
+        strRB5_SHM_MOMENT shm_moment;
+        memset(&shm_moment, 0, sizeof(strRB5_SHM_MOMENT));
+        if ((param == NULL) || (!shmTypecode(PolarScanParam_getDataType(param), shm_moment.typecode, &shm_moment.elem_bytes))) {
+            RAVE_OBJECT_RELEASE(param);
+            continue;
+        }
+        snprintf(shm_moment.quantity, RB5_SHM_MAX_NAME, "%s", PolarScanParam_getQuantity(param));
+        shm_moment.gain = PolarScanParam_getGain(param);
+        shm_moment.offset = PolarScanParam_getOffset(param);
+        shm_moment.nodata = PolarScanParam_getNodata(param);
+        shm_moment.undetect = PolarScanParam_getUndetect(param);
+        shm_moment.nrays = (uint32_t)PolarScanParam_getNrays(param);
+        shm_moment.nbins = (uint32_t)PolarScanParam_getNbins(param);
+        shm_moment.data_bytes = (uint64_t)shm_moment.nrays*shm_moment.nbins*shm_moment.elem_bytes;
+        shm_moment.data_offset = layout->data_offset+layout->data_bytes;
+        putShmAttributes(layout, (RaveCoreObject*)param, &shm_moment.first_attrib, &shm_moment.n_attribs);
+
+        if (layout->segment != NULL) {
+            void* data = PolarScanParam_getData(param);
+            if (data != NULL) memcpy(layout->segment+shm_moment.data_offset, data, shm_moment.data_bytes);
+            ((strRB5_SHM_MOMENT*)(layout->segment+layout->moment_offset))[layout->n_moments] = shm_moment;
+        }
+        layout->data_bytes += shm_align(shm_moment.data_bytes);
+        layout->n_moments++;
+        shm_scan.n_moments++;
+        RAVE_OBJECT_RELEASE(param);
+    }
+    if (names != NULL) RaveList_freeAndDestroy(&names);
+
+    if (layout->segment != NULL) {
+        ((strRB5_SHM_SCAN*)(layout->segment+layout->scan_offset))[layout->n_scans] = shm_scan;
+    }
+    layout->n_scans++;
+}
+
+/*
+ * Lays out (or writes) a volume or scan: header, then scan by scan.
+ */
+static void putShmObject(strRB5_SHM_LAYOUT* layout, RaveCoreObject* object) {
+    strRB5_SHM_HEADER header;
+    int is_pvol = RAVE_OBJECT_CHECK_TYPE(object, &PolarVolume_TYPE) ? 1 : 0;
+    int nscans = is_pvol ? PolarVolume_getNumberOfScans((PolarVolume_t*)object) : 1;
+    int i;
+
+    memset(&header, 0, sizeof(strRB5_SHM_HEADER));
+    if (is_pvol) {
+        PolarVolume_t* pvol = (PolarVolume_t*)object;
+        header.object_type = RB5_SHM_PVOL;
+        snprintf(header.date, RB5_SHM_MAX_DATE, "%s", PolarVolume_getDate(pvol) ? PolarVolume_getDate(pvol) : "");
+        snprintf(header.time, RB5_SHM_MAX_DATE, "%s", PolarVolume_getTime(pvol) ? PolarVolume_getTime(pvol) : "");
+        snprintf(header.source, RB5_SHM_MAX_SOURCE, "%s", PolarVolume_getSource(pvol) ? PolarVolume_getSource(pvol) : "");
+        header.longitude = PolarVolume_getLongitude(pvol)/DEG_TO_RAD;
+        header.latitude = PolarVolume_getLatitude(pvol)/DEG_TO_RAD;
+        header.height = PolarVolume_getHeight(pvol);
+        header.beamwidth = PolarVolume_getBeamwidth(pvol)/DEG_TO_RAD;
     } else {
-      if(rot == Rave_ObjectType_SCAN) {
-        object = (RaveCoreObject*)RAVE_OBJECT_NEW(&PolarScan_TYPE);
-      } else return RETURN_raveio_NULL;
+        PolarScan_t* scan = (PolarScan_t*)object;
+        header.object_type = RB5_SHM_SCAN;
+        snprintf(header.date, RB5_SHM_MAX_DATE, "%s", PolarScan_getDate(scan) ? PolarScan_getDate(scan) : "");
+        snprintf(header.time, RB5_SHM_MAX_DATE, "%s", PolarScan_getTime(scan) ? PolarScan_getTime(scan) : "");
+        snprintf(header.source, RB5_SHM_MAX_SOURCE, "%s", PolarScan_getSource(scan) ? PolarScan_getSource(scan) : "");
+        header.longitude = PolarScan_getLongitude(scan)/DEG_TO_RAD;
+        header.latitude = PolarScan_getLatitude(scan)/DEG_TO_RAD;
+        header.height = PolarScan_getHeight(scan);
+        header.beamwidth = PolarScan_getBeamwidth(scan)/DEG_TO_RAD;
     }
 
-    /* Map RB5 object(s) to Toolbox ones. */
-    populateObject(object, &rb5_info);
-    close_rb5_info(&rb5_info);
-//    xmlCleanupParser(); // free globals in main() only for thread safety & valgrind
+    //a scan's own attributes are its top level ones
+    uint32_t first_attrib;
+    if (is_pvol) putShmAttributes(layout, object, &first_attrib, &header.n_attribs_top);
 
-    /* Set the object into the I/O container */
-    RaveIO_setObject(raveio, object);
+    for (i=0;i<nscans;i++) {
+        PolarScan_t* scan = getObjectScan(object, i);
+        if (scan == NULL) continue;
+        putShmScan(layout, scan);
+        RAVE_OBJECT_RELEASE(scan);
+    }
+
+    if (layout->segment != NULL) {
+        header.n_scans = (uint32_t)layout->n_scans;
+        header.n_moments = (uint32_t)layout->n_moments;
+        header.n_attribs = (uint32_t)layout->n_attribs;
+        if (!is_pvol) header.n_attribs_top = (layout->n_scans > 0) ? ((strRB5_SHM_SCAN*)(layout->segment+layout->scan_offset))[0].n_attribs : 0;
+        header.scan_offset = layout->scan_offset;
+        header.moment_offset = layout->moment_offset;
+        header.attrib_offset = layout->attrib_offset;
+        memcpy(layout->segment, &header, sizeof(strRB5_SHM_HEADER)); //magic still 0, see publish_shm_segment()
+    }
+}
+
+/*
+ * The scan or volume of a RaveIO_t*, as a new reference, NULL for other objects.
+ */
+static RaveCoreObject* getShmObject(RaveIO_t* raveio, const char* shm_name) {
+    RaveCoreObject* object = RaveIO_getObject(raveio);
+    if ((object == NULL) || (!RAVE_OBJECT_CHECK_TYPE(object, &PolarVolume_TYPE) && !RAVE_OBJECT_CHECK_TYPE(object, &PolarScan_TYPE))) {
+        fprintf(stderr,"Error: only a scan or a volume goes to shared memory = %s\n", shm_name);
+        RAVE_OBJECT_RELEASE(object);
+        return NULL;
+    }
+    return object;
+}
+
+/*
+ * Sizes the segment of a volume or scan by a first walk over it, leaving the layout
+ * ready for the same walk to fill the tables in place. Returns the segment bytes.
+ */
+static size_t layoutShmObject(strRB5_SHM_LAYOUT* layout, RaveCoreObject* object) {
+    memset(layout, 0, sizeof(strRB5_SHM_LAYOUT));
+    putShmObject(layout, object);
+    layout->scan_offset = shm_align(sizeof(strRB5_SHM_HEADER));
+    layout->moment_offset = layout->scan_offset+shm_align(layout->n_scans*sizeof(strRB5_SHM_SCAN));
+    layout->attrib_offset = layout->moment_offset+shm_align(layout->n_moments*sizeof(strRB5_SHM_MOMENT));
+    layout->value_offset = layout->attrib_offset+shm_align(layout->n_attribs*sizeof(strRB5_SHM_ATTRIB));
+    layout->data_offset = layout->value_offset+shm_align(layout->value_bytes);
+    size_t segment_bytes = layout->data_offset+layout->data_bytes;
+    layout->n_scans = layout->n_moments = layout->n_attribs = 0;
+    layout->value_bytes = layout->data_bytes = 0;
+    return segment_bytes;
+}
+
+/*
+ * Publishes a RaveIO_t*'s scan or volume in POSIX shared memory under shm_name (e.g. "/rb5vol"),
+ * replacing any segment of that name; readers that still have the old one mapped keep it.
+ * Returns 1 on success, as RaveIO_save().
+ */
+int saveRaveIOShm(RaveIO_t* raveio, const char* shm_name) {
+    strRB5_SHM_LAYOUT layout;
+    int ret = 0;
+
+    RaveCoreObject* object = getShmObject(raveio, shm_name);
+    if (object == NULL) return 0;
+
+    size_t segment_bytes = layoutShmObject(&layout, object);
+    layout.segment = create_shm_segment(shm_name, segment_bytes);
+    if (layout.segment != NULL) {
+        putShmObject(&layout, object);
+        publish_shm_segment(layout.segment, segment_bytes);
+        ret = 1;
+    }
     RAVE_OBJECT_RELEASE(object);
+    return ret;
+}
+
+/*
+ * A NUL terminated copy of a fixed size string of a segment.
+ */
+static const char* getShmString(char* dest, const char* src, size_t max_len) {
+    snprintf(dest, max_len, "%.*s", (int)(max_len-1), src);
+    return dest;
+}
+
+/*
+ * Toolbox data type of a moment's typecode, RaveDataType_UNDEFINED if not one of shmTypecode()'s.
+ */
+static RaveDataType getShmDataType(const strRB5_SHM_MOMENT* shm_moment) {
+    static const RaveDataType types[] = {RaveDataType_CHAR, RaveDataType_UCHAR, RaveDataType_SHORT, RaveDataType_USHORT,
+                                         RaveDataType_INT, RaveDataType_UINT, RaveDataType_LONG, RaveDataType_ULONG,
+                                         RaveDataType_FLOAT, RaveDataType_DOUBLE};
+    char typecode[4];
+    uint32_t elem_bytes;
+    size_t i;
+
+    for (i=0;i<sizeof(types)/sizeof(types[0]);i++) {
+        if (shmTypecode(types[i], typecode, &elem_bytes) &&
+            (strncmp(typecode, shm_moment->typecode, sizeof(typecode)) == 0) && (elem_bytes == shm_moment->elem_bytes)) {
+            return types[i];
+        }
+    }
+    return RaveDataType_UNDEFINED;
+}
+
+/*
+ * Adds the attributes of an object, as laid out by putShmAttributes(), to a Toolbox volume, scan or moment.
+ */
+static void getShmAttributes(const strRB5_SHM* shm, RaveCoreObject* object, uint32_t first_attrib, uint32_t n_attribs) {
+    char name[RB5_SHM_MAX_NAME];
+    size_t i, k;
+
+    for (i=first_attrib;(i<(size_t)first_attrib+n_attribs) && (i<shm->header->n_attribs);i++) {
+        const strRB5_SHM_ATTRIB* shm_attrib = &(shm->attrib_arr[i]);
+        RaveAttribute_t* attr = NULL;
+        getShmString(name, shm_attrib->name, RB5_SHM_MAX_NAME);
+        if (shm_attrib->format == RB5_SHM_ATTRIB_STRING) {
+            const char* svalue = (const char*)get_shm_data(shm, shm_attrib->value_offset, shm_attrib->n_values);
+            if ((svalue != NULL) && (shm_attrib->n_values > 0) && (svalue[shm_attrib->n_values-1] == '\0')) {
+                attr = RaveAttributeHelp_createString(name, svalue);
+            }
+        } else if (shm_attrib->format == RB5_SHM_ATTRIB_LONG) {
+            attr = RaveAttributeHelp_createLong(name, (long)shm_attrib->lvalue);
+        } else if (shm_attrib->format == RB5_SHM_ATTRIB_DOUBLE) {
+            attr = RaveAttributeHelp_createDouble(name, shm_attrib->dvalue);
+        } else if (shm_attrib->format == RB5_SHM_ATTRIB_LONG_ARRAY) {
+            const int64_t* larr = (const int64_t*)get_shm_data(shm, shm_attrib->value_offset, (uint64_t)shm_attrib->n_values*sizeof(int64_t));
+            long* values = (larr != NULL) ? RAVE_MALLOC(shm_attrib->n_values*sizeof(long)+1) : NULL;
+            if (values != NULL) {
+                for (k=0;k<shm_attrib->n_values;k++) values[k] = (long)larr[k];
+                attr = RaveAttributeHelp_createLongArray(name, values, (int)shm_attrib->n_values);
+                RAVE_FREE(values);
+            }
+        } else if (shm_attrib->format == RB5_SHM_ATTRIB_DOUBLE_ARRAY) {
+            const double* darr = (const double*)get_shm_data(shm, shm_attrib->value_offset, (uint64_t)shm_attrib->n_values*sizeof(double));
+            if (darr != NULL) attr = RaveAttributeHelp_createDoubleArray(name, (double*)darr, (int)shm_attrib->n_values);
+        }
+        if (attr != NULL) addAttribute(object, attr);
+        RAVE_OBJECT_RELEASE(attr);
+    }
+}
+
+/*
+ * Populates a Toolbox scan from a scan of a segment, with its moments and their attributes.
+ * Returns 1 on success, 0 if the segment is inconsistent.
+ */
+static int populateScanShm(PolarScan_t* scan, const strRB5_SHM* shm, size_t this_scan) {
+    const strRB5_SHM_SCAN* shm_scan = &(shm->scan_arr[this_scan]);
+    char tmp_a[RB5_SHM_MAX_NAME];
+    size_t i;
+
+    PolarScan_setStartDate(scan, getShmString(tmp_a, shm_scan->startdate, RB5_SHM_MAX_DATE));
+    PolarScan_setStartTime(scan, getShmString(tmp_a, shm_scan->starttime, RB5_SHM_MAX_DATE));
+    PolarScan_setEndDate(scan, getShmString(tmp_a, shm_scan->enddate, RB5_SHM_MAX_DATE));
+    PolarScan_setEndTime(scan, getShmString(tmp_a, shm_scan->endtime, RB5_SHM_MAX_DATE));
+    PolarScan_setElangle(scan, shm_scan->elangle*DEG_TO_RAD);
+    PolarScan_setRstart(scan, shm_scan->rstart);
+    PolarScan_setRscale(scan, shm_scan->rscale);
+    PolarScan_setA1gate(scan, (long)shm_scan->a1gate);
+    getShmAttributes(shm, (RaveCoreObject*)scan, shm_scan->first_attrib, shm_scan->n_attribs);
+
+    for (i=shm_scan->first_moment;i<(size_t)shm_scan->first_moment+shm_scan->n_moments;i++) {
+        if (i >= shm->header->n_moments) return 0;
+        const strRB5_SHM_MOMENT* shm_moment = &(shm->moment_arr[i]);
+        RaveDataType type = getShmDataType(shm_moment);
+        const void* data = get_shm_data(shm, shm_moment->data_offset, shm_moment->data_bytes);
+        if ((type == RaveDataType_UNDEFINED) || (data == NULL) ||
+            (shm_moment->data_bytes != (uint64_t)shm_moment->nrays*shm_moment->nbins*shm_moment->elem_bytes)) {
+            return 0;
+        }
+        PolarScanParam_t* param = RAVE_OBJECT_NEW(&PolarScanParam_TYPE);
+        if ((param == NULL) || (!PolarScanParam_createData(param, shm_moment->nbins, shm_moment->nrays, type))) {
+            RAVE_OBJECT_RELEASE(param);
+            return 0;
+        }
+        PolarScanParam_setQuantity(param, getShmString(tmp_a, shm_moment->quantity, RB5_SHM_MAX_NAME));
+        PolarScanParam_setGain(param, shm_moment->gain);
+        PolarScanParam_setOffset(param, shm_moment->offset);
+        PolarScanParam_setNodata(param, shm_moment->nodata);
+        PolarScanParam_setUndetect(param, shm_moment->undetect);
+        memcpy(PolarScanParam_getData(param), data, shm_moment->data_bytes);
+        getShmAttributes(shm, (RaveCoreObject*)param, shm_moment->first_attrib, shm_moment->n_attribs);
+        PolarScan_addParameter(scan, param);
+        RAVE_OBJECT_RELEASE(param);
+    }
+    return 1;
+}
 
+/*
+ * Returns a RaveIO_t* with the scan or volume of a mapped segment, as saveRaveIOShm() or
+ * saveRaveIOCache() wrote it; the moments are copied out of the segment, which can then be closed.
+ */
+static RaveIO_t* newRaveIOFromShm(const strRB5_SHM* shm) {
+    const strRB5_SHM_HEADER* header = shm->header;
+    RaveCoreObject* object = NULL;
+    char tmp_a[RB5_SHM_MAX_SOURCE];
+    size_t i;
+    int ret = 1;
+
+    if (header->object_type == RB5_SHM_PVOL) {
+        PolarVolume_t* pvol = RAVE_OBJECT_NEW(&PolarVolume_TYPE);
+        if (pvol == NULL) return NULL;
+        PolarVolume_setDate(pvol, getShmString(tmp_a, header->date, RB5_SHM_MAX_DATE));
+        PolarVolume_setTime(pvol, getShmString(tmp_a, header->time, RB5_SHM_MAX_DATE));
+        PolarVolume_setSource(pvol, getShmString(tmp_a, header->source, RB5_SHM_MAX_SOURCE));
+        PolarVolume_setLongitude(pvol, header->longitude*DEG_TO_RAD);
+        PolarVolume_setLatitude(pvol, header->latitude*DEG_TO_RAD);
+        PolarVolume_setHeight(pvol, header->height);
+        PolarVolume_setBeamwidth(pvol, header->beamwidth*DEG_TO_RAD);
+        getShmAttributes(shm, (RaveCoreObject*)pvol, 0, header->n_attribs_top);
+        for (i=0;(i<header->n_scans) && (ret == 1);i++) {
+            PolarScan_t* scan = RAVE_OBJECT_NEW(&PolarScan_TYPE);
+            ret = (scan != NULL) ? populateScanShm(scan, shm, i) : 0;
+            if (ret == 1) PolarVolume_addScan(pvol, scan);
+            RAVE_OBJECT_RELEASE(scan);
+        }
+        object = (RaveCoreObject*)pvol;
+    } else if ((header->object_type == RB5_SHM_SCAN) && (header->n_scans == 1)) {
+        PolarScan_t* scan = RAVE_OBJECT_NEW(&PolarScan_TYPE);
+        if (scan == NULL) return NULL;
+        PolarScan_setDate(scan, getShmString(tmp_a, header->date, RB5_SHM_MAX_DATE));
+        PolarScan_setTime(scan, getShmString(tmp_a, header->time, RB5_SHM_MAX_DATE));
+        PolarScan_setSource(scan, getShmString(tmp_a, header->source, RB5_SHM_MAX_SOURCE));
+        PolarScan_setLongitude(scan, header->longitude*DEG_TO_RAD);
+        PolarScan_setLatitude(scan, header->latitude*DEG_TO_RAD);
+        PolarScan_setHeight(scan, header->height);
+        PolarScan_setBeamwidth(scan, header->beamwidth*DEG_TO_RAD);
+        ret = populateScanShm(scan, shm, 0);
+        object = (RaveCoreObject*)scan;
+    } else ret = 0;
+
+    if (ret != 1) {
+        RAVE_OBJECT_RELEASE(object);
+        return NULL;
+    }
+    RaveIO_t* raveio = RAVE_OBJECT_NEW(&RaveIO_TYPE);
+    if (raveio != NULL) RaveIO_setObject(raveio, object);
+    RAVE_OBJECT_RELEASE(object);
     return raveio;
+}
+
+//################################################################################
+// Cache: once enabled with setRB5Cache(), full reads of RB5 files store the decoded scan or
+// volume in a cache directory, as a segment laid out as for shared memory, and later reads of
+// the unchanged file map it back from there instead of decoding it again, see cache_utils.h.
+//################################################################################
+
+/*
+ * Cache directory, "" while the cache is off, and its size, see setRB5Cache().
+ */
+static char rb5_cache_dir[RB5_CACHE_MAX_PATH] = "";
+static uint64_t rb5_cache_max_bytes = RB5_CACHE_MAX_BYTES;
 
+/*
+ * Approximate size of rb5_cache_counted_dir: as evict_cache() last counted it, plus the entries
+ * stored since, so that the directory is only walked once the cache may have outgrown its size.
+ * Replaced entries count twice, and other processes' not at all, until the next count.
+ */
+static char rb5_cache_counted_dir[RB5_CACHE_MAX_PATH] = "";
+static uint64_t rb5_cache_counted_bytes = 0;
+
+/*
+ * Function name: setRB5Cache
+ * Intent: opt in to caching decoded RB5 files in cache_dir, created if need be, evicting the
+ * least recently used entries beyond max_bytes (0 for RB5_CACHE_MAX_BYTES). NULL or "" turns
+ * the cache off (default). Only full reads use it, see getRaveIOSubset().
+ */
+int setRB5Cache(const char* cache_dir, uint64_t max_bytes) {
+    if ((cache_dir == NULL) || (cache_dir[0] == '\0')) {
+        rb5_cache_dir[0] = '\0';
+        return EXIT_SUCCESS;
+    }
+    if (strlen(cache_dir) >= RB5_CACHE_MAX_PATH-64) { //room for the entry names
+        fprintf(stderr,"Error: cache directory name too long = %s\n", cache_dir);
+        return EXIT_FAILURE;
+    }
+    if (make_cache_dir(cache_dir) != EXIT_SUCCESS) return EXIT_FAILURE;
+    strcpy(rb5_cache_dir, cache_dir);
+    rb5_cache_max_bytes = (max_bytes > 0) ? max_bytes : RB5_CACHE_MAX_BYTES;
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Returns the cache directory, NULL while the cache is off, and its size.
+ */
+const char* getRB5Cache(uint64_t* max_bytes) {
+    if (max_bytes != NULL) *max_bytes = rb5_cache_max_bytes;
+    return (rb5_cache_dir[0] != '\0') ? rb5_cache_dir : NULL;
+}
+
+/*
+ * Stores a RaveIO_t*'s scan or volume in cache_dir as the entry of the input file of key,
+ * replacing an older one, then evicts the least recently used entries beyond max_bytes
+ * once the cache may hold more, see rb5_cache_counted_bytes.
+ * Returns 1 on success, as RaveIO_save().
+ */
+int saveRaveIOCache(RaveIO_t* raveio, const char* cache_dir, const strRB5_CACHE_KEY* key, uint64_t max_bytes) {
+    strRB5_SHM_LAYOUT layout;
+    char* tmp_name = NULL;
+    int ret = 0;
+
+    RaveCoreObject* object = getShmObject(raveio, key->path);
+    if (object == NULL) return 0;
+
+    size_t segment_bytes = layoutShmObject(&layout, object);
+    layout.segment = create_cache_entry(cache_dir, key, segment_bytes, &tmp_name);
+    if (layout.segment != NULL) {
+        putShmObject(&layout, object);
+        ret = (publish_cache_entry(cache_dir, key, tmp_name, layout.segment, segment_bytes) == EXIT_SUCCESS) ? 1 : 0;
+    }
+    RAVE_OBJECT_RELEASE(object);
+    if (ret == 1) rb5_cache_counted_bytes += RB5_CACHE_KEY_BYTES + segment_bytes;
+    if ((strcmp(rb5_cache_counted_dir, cache_dir) != 0) || (rb5_cache_counted_bytes > max_bytes)) {
+        if (evict_cache(cache_dir, max_bytes, NULL, &rb5_cache_counted_bytes) == EXIT_SUCCESS) {
+            snprintf(rb5_cache_counted_dir, RB5_CACHE_MAX_PATH, "%s", cache_dir);
+        } else {
+            rb5_cache_counted_dir[0] = '\0';
+        }
+    }
+    return ret;
+}
+
+/*
+ * As getRaveIO(), mapped back from the entry of the file in cache_dir while its path, inode,
+ * size, mtime and ctime match, otherwise decoded and stored there for the next read. Hits only
+ * stat() the file; its crc32 is read for the entry on a miss, and a file that changed while
+ * being decoded is not stored.
+ */
+RaveIO_t* getRaveIOCached(const char* ifile, const char* cache_dir, uint64_t max_bytes) {
+    strRB5_CACHE_KEY key;
+    strRB5_SHM shm;
+    RaveIO_t* raveio = NULL;
+
+    if (get_cache_key(ifile, &key) != EXIT_SUCCESS) return decodeRaveIO(ifile, NULL, 0, NULL);
+    if (open_cache_entry(cache_dir, &key, &shm) == EXIT_SUCCESS) {
+        raveio = newRaveIOFromShm(&shm);
+        close_shm_segment(&shm);
+        if (raveio != NULL) return raveio;
+        fprintf(stderr,"Error: cannot read cache entry of file = %s, decoding it again\n", ifile);
+    }
+    raveio = decodeRaveIO(ifile, NULL, 0, NULL);
+    if ((raveio != NULL) && (get_cache_key_crc32(&key) == EXIT_SUCCESS)) {
+        saveRaveIOCache(raveio, cache_dir, &key, max_bytes);
+    }
+    return raveio;
 }
 
 /*
@@ -681,32 +1957,32 @@ int isRainbow5buf(char **inp_buffer) {
 }
 
 /*
- * Verifies it is an RB5 raw file and of the compatible version.
+ * Verifies it is an RB5 raw file, possibly gzipped, and of the compatible version.
  */
 int isRainbow5(const char* inp_fname) {
 
 //	int RETURN_yes = 0;
 	int RETURN_no = -1;
 
-    FILE *fp = NULL;
-    fp = fopen(inp_fname, "r");
+    //gzopen() reads plain files as they are, and inflates .gz ones on the fly
+    gzFile fp = NULL;
+    fp = gzopen(inp_fname, "rb");
     if (NULL == fp) {
         fprintf(stderr,"Error while opening file = %s\n", inp_fname);
         return RETURN_no;
     }
 
-    char *line=NULL;
-    size_t len=0;
-    getline(&line,&len,fp);
-    fclose(fp);
+    //isRainbow5buf() takes no longer header line
+    char line_buf[MAX_STRING+1]="\0";
+    char *line=line_buf;
+    if (gzgets(fp,line_buf,sizeof(line_buf)) == NULL) line_buf[0]='\0';
+    gzclose(fp);
 
     //Note, trailing '\n' kept for subsequent proper header line extraction in isRainbow5buf()
 //    line[strlen(line)-1]='\0'; //trim trailing <LF>
 //    fprintf(stdout,"line : %s\n",line);
 
     int RETURN_val=isRainbow5buf(&line);
-    free(line);
-    //RAVE_FREE(line);
     return RETURN_val;
 }
 
@@ -725,7 +2001,6 @@ int setRayAttributes(PolarScan_t* scan, strRB5_INFO *rb5_info, int this_slice) {
 
     //rb5_util vars
     strRB5_PARAM_INFO rb5_param;
-    static char xpath_bgn[MAX_STRING]="\0";
     void *raw_arr=NULL;
     float *data_arr=NULL;
     int i;
@@ -795,8 +2070,8 @@ int setRayAttributes(PolarScan_t* scan, strRB5_INFO *rb5_info, int this_slice) {
     int L_RB5_PARAM_VERBOSE=0;
     int this_rayinfo;
     for(this_rayinfo=0;this_rayinfo<rb5_info->n_rayinfos;this_rayinfo++){
-      sprintf(xpath_bgn,"((/volume/scan/slice)[%2d]/slicedata/%s)[%2d]/",this_slice+1,"rayinfo",this_rayinfo+1);
-      rb5_param=get_rb5_param_info(rb5_info,xpath_bgn,L_RB5_PARAM_VERBOSE);
+      rb5_param=get_rb5_param_info(rb5_info,this_slice,"rayinfo",this_rayinfo,L_RB5_PARAM_VERBOSE);
+      if(rb5_param.conversion == RB5_CONV_ANGULAR) continue; //read back above
 
       return_param_blobid_raw(&(*rb5_info), &rb5_param, &raw_arr);
       convert_raw_to_data(&rb5_param,&raw_arr,&data_arr);
@@ -805,7 +2080,7 @@ if(L_RB52ODIM_DEBUG) fprintf(stdout,"Adding rayinfo = %s to scan...\n",rb5_param
 
       // Note: angle readback not done here anymore, see above
       // added capture and logic to decode-side
-      if(strcmp(rb5_param.sparam,"dataflag") == 0){
+      if(rb5_param.kind == RB5_KIND_DATAFLAG){
         for (i=0;i<this_nrays;i++) ldata_arr[i]=data_arr[i];
 if(L_RB52ODIM_DEBUG) fprintf(stdout,"Creating how/dataflag...\n");
         RaveAttribute_t* dataflag_attr = RaveAttributeHelp_createLongArray("how/dataflag", ldata_arr, this_nrays);
@@ -832,34 +2107,34 @@ if(L_RB52ODIM_DEBUG) fprintf(stdout,"Creating how/dataflag...\n");
             "0x2000 = not used\n"
             "0x4000 = not used\n"
             "0x8000 = not used");
-      }else if(strcmp(rb5_param.sparam,"numpulses") == 0){
+      }else if(rb5_param.kind == RB5_KIND_NUMPULSES){
         for (i=0;i<this_nrays;i++) ldata_arr[i]=data_arr[i];
         RaveAttribute_t* numpulses_attr = RaveAttributeHelp_createLongArray("how/numpulses", ldata_arr, this_nrays);
         ret = PolarScan_addAttribute(scan, numpulses_attr);
 	    RAVE_OBJECT_RELEASE(numpulses_attr);
-      }else if(strcmp(rb5_param.sparam,"timestamp") == 0){ //EPOCH SECONDS
+      }else if(rb5_param.kind == RB5_KIND_TIMESTAMP){ //EPOCH SECONDS
         for (i=0;i<this_nrays;i++) ddata_arr[i]=(double)data_arr[i]/1000. + systime_0;
         RaveAttribute_t* startazT_attr = RaveAttributeHelp_createDoubleArray("how/startazT", ddata_arr, this_nrays);
         ret = PolarScan_addAttribute(scan, startazT_attr);
 	    RAVE_OBJECT_RELEASE(startazT_attr);
-      }else if(strcmp(rb5_param.sparam,"txpower") == 0){ //KILOWATTS
+      }else if(rb5_param.kind == RB5_KIND_TXPOWER){ //KILOWATTS
         for (i=0;i<this_nrays;i++) ddata_arr[i]=(double)data_arr[i]/1000.;
         RaveAttribute_t* txpower_attr = RaveAttributeHelp_createDoubleArray("how/TXpower", ddata_arr, this_nrays);
         ret = PolarScan_addAttribute(scan, txpower_attr);
 	    RAVE_OBJECT_RELEASE(txpower_attr);
-      }else if(strcmp(rb5_param.sparam,"noisepowerh") == 0){ //UNITS?!?
+      }else if(rb5_param.kind == RB5_KIND_NOISEPOWERH){ //UNITS?!?
         for (i=0;i<this_nrays;i++) ldata_arr[i]=data_arr[i];
         RaveAttribute_t* noisepowerh_attr = RaveAttributeHelp_createLongArray("how/noisepowerh", ldata_arr, this_nrays);
         ret = PolarScan_addAttribute(scan, noisepowerh_attr);
 	    RAVE_OBJECT_RELEASE(noisepowerh_attr);
-      }else if(strcmp(rb5_param.sparam,"noisepowerv") == 0){ //UNITS?!?
+      }else if(rb5_param.kind == RB5_KIND_NOISEPOWERV){ //UNITS?!?
         for (i=0;i<this_nrays;i++) ldata_arr[i]=data_arr[i];
         RaveAttribute_t* noisepowerv_attr = RaveAttributeHelp_createLongArray("how/noisepowerv", ldata_arr, this_nrays);
         ret = PolarScan_addAttribute(scan, noisepowerv_attr);
 	    RAVE_OBJECT_RELEASE(noisepowerv_attr);
       }
 
-      if ( raw_arr != NULL ) RAVE_FREE( raw_arr);
+      if ( raw_arr != NULL ) { inflate_pool_free( raw_arr); raw_arr=NULL; }
       if (data_arr != NULL ) RAVE_FREE(data_arr);
 
     } //for(this_rayinfo=0;this_rayinfo<rb5_info->n_rayinfos;this_rayinfo++){
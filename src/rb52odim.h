@@ -31,27 +31,80 @@ along with RAVE.  If not, see <http://www.gnu.org/licenses/>.
 #include "rave_field.h"
 #include "rave_types.h"
 #include "rave_attribute.h"
+#include "rave_list.h"
 #include "polarscanparam.h"
 #include "polarscan.h"
 #include "polarvolume.h"
 
 #include "rave_alloc.h"
 #include "time_utils.h"
+#include "inflate_utils.h"
 #include "rb5_utils.h"
 #include "xml_utils.h"
+#include "radar_table_utils.h"
+#include "tar_utils.h"
+#include "prefetch_utils.h"
+#include "shm_utils.h"
+#include "cache_utils.h"
 
 #include <ctype.h> //for tolower() & isalnum()
 #include <sys/stat.h> //stat()
+#include <unistd.h> //sysconf()
 
 #define L_RB52ODIM_DEBUG 0
 
+//payload read by getRaveIOLazy(), moments decoded on demand
+typedef struct{
+    strRB5_INFO rb5_info;        //file buffer, header model and blob index, open until closeRaveIOLazy()
+    RaveIO_t* raveio;            //PolarVolume_t or PolarScan_t, all metadata set
+    size_t n_params;             //n_slices*n_rawdatas
+    PolarScanParam_t** params;   //slice-major in <rawdata> order
+    strRB5_DECODE_TASK* tasks;   //one per param, n_elems_data != 0 once decoded
+} strRB5_LAZY;
+
+//ordered list of RB5 files opened by openRB5Batch(), read ahead while the previous ones are decoded
+typedef struct{
+    char** fnames;               //copies of the caller's
+    size_t n_files;
+    strPREFETCH* prefetch;
+} strRB5_BATCH;
+
 //function declarations from "rb52odim.c"
 int objectTypeFromRB5(strRB5_INFO rb5_info);
+int setDecodeThreads(int n_threads);
+int getDecodeThreads(void);
 int populateParam(PolarScanParam_t* param, strRB5_INFO *rb5_info, strRB5_PARAM_INFO *rb5_param);
+int setupParam(PolarScanParam_t* param, strRB5_PARAM_INFO *rb5_param);
+PolarScanParam_t** createParams(strRB5_INFO *rb5_info, int nscans, strRB5_DECODE_TASK** return_tasks);
+PolarScanParam_t** decodeParams(strRB5_INFO *rb5_info, int nscans, int n_threads);
+void releaseParams(PolarScanParam_t** params, size_t n_params);
 int populateScan(PolarScan_t* scan, strRB5_INFO *rb5_info, int this_slice);
+int populateScanDecoded(PolarScan_t* scan, strRB5_INFO *rb5_info, int this_slice, PolarScanParam_t** params);
 int populateObject(RaveCoreObject* object, strRB5_INFO *rb5_info);
+int populateObjectParams(RaveCoreObject* object, strRB5_INFO *rb5_info, PolarScanParam_t** params);
 RaveIO_t* getRaveIObuf(const char* ifile, char **inp_buffer, size_t buffer_len);
 RaveIO_t* getRaveIO(const char* ifile);
+RaveIO_t* getRaveIObufQuantities(const char* ifile, char **inp_buffer, size_t buffer_len, const char** quantities, size_t n_quantities);
+RaveIO_t* getRaveIOQuantities(const char* ifile, const char** quantities, size_t n_quantities);
+RaveIO_t* getRaveIObufSubset(const char* ifile, char **inp_buffer, size_t buffer_len, int buffer_owner, const char** quantities, size_t n_quantities, const strRB5_SLICE_SELECT* slice_select);
+RaveIO_t* getRaveIOSubset(const char* ifile, const char** quantities, size_t n_quantities, const strRB5_SLICE_SELECT* slice_select);
+RaveIO_t* getRaveIOStream(int fd, const char* ifile, const char** quantities, size_t n_quantities, const strRB5_SLICE_SELECT* slice_select);
+int readRB5Stream(strRB5_INFO *rb5_info, int fd, const char* ifile, const char** quantities, size_t n_quantities, const strRB5_SLICE_SELECT* slice_select);
+RaveIO_t* getRaveIOStreamed(strRB5_INFO *rb5_info, const char** quantities, size_t n_quantities, const strRB5_SLICE_SELECT* slice_select);
+strRB5_LAZY* getRaveIOLazy(const char* ifile);
+strRB5_LAZY* getRaveIObufLazy(const char* ifile, char **inp_buffer, size_t buffer_len, int buffer_owner);
+int loadLazyParams(strRB5_LAZY* lazy, const char* quantity, int this_slice);
+int saveRaveIOLazy(strRB5_LAZY* lazy, const char* ofile);
+void closeRaveIOLazy(strRB5_LAZY* lazy);
+RaveIO_t* getRaveIOTarball(const char* ifile, int n_threads);
+strRB5_BATCH* openRB5Batch(const char** ifiles, size_t n_files, size_t window);
+int nextRaveIOBatch(strRB5_BATCH* batch, size_t* return_idx, RaveIO_t** return_raveio);
+void closeRB5Batch(strRB5_BATCH* batch);
+int saveRaveIOShm(RaveIO_t* raveio, const char* shm_name);
+int setRB5Cache(const char* cache_dir, uint64_t max_bytes);
+const char* getRB5Cache(uint64_t* max_bytes);
+int saveRaveIOCache(RaveIO_t* raveio, const char* cache_dir, const strRB5_CACHE_KEY* key, uint64_t max_bytes);
+RaveIO_t* getRaveIOCached(const char* ifile, const char* cache_dir, uint64_t max_bytes);
 int is_regular_file(const char *path);
 int isRainbow5buf(char **inp_buffer);
 int isRainbow5(const char* ifile);
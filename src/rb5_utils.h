@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <libgen.h> //for basename()
+#include <pthread.h> //add -lpthread to compile
 
 #include <zlib.h> //add -lz to compile
 
@@ -19,12 +20,138 @@
 #define MAX_NSTRINGS 32
 #define MAX_SLICES 32
 #define MAX_PARAMS MAX_NSTRINGS
+#define MAX_PARGROUPS MAX_NSTRINGS
 
 #define MAX_PULSE_WIDTHS 4
 
+//populate_rb5_header() modes, strRB5_INFO.header_mode 0 is a full read
+#define RB5_HEADER_ONLY       1 //no blob is touched, slice end times estimated from <antspeed>
+#define RB5_HEADER_TIMESTAMPS 2 //slice end times from the <timestamp> rayinfo, needs the blob space
+
+#define INFLATE_WINDOW_BYTES 32768 //scratch window for the fused blob decode, multiple of 4
+#define RB5_STREAM_CHUNK_BYTES 65536 //read_rb5_stream() read size, and initial buffer
+
 //#define MINIMUM_RAINBOW_VERSION "5.0"
 #define MINIMUM_RAINBOW_VERSION "5.43.10" //wrt CAX1 delivery (sensorinfo attribs have been updated)
 
+//what a <rawdata> @type or <rayinfo> @refid is, see rb5_moment_catalog[]
+typedef enum{
+    RB5_KIND_UNKNOWN=0,
+    RB5_KIND_DBUZ,
+    RB5_KIND_DBUZV,
+    RB5_KIND_DBZ,
+    RB5_KIND_DBZV,
+    RB5_KIND_V,
+    RB5_KIND_VV,
+    RB5_KIND_W,
+    RB5_KIND_WV,
+    RB5_KIND_SNR,
+    RB5_KIND_SNRV,
+    RB5_KIND_SQI,
+    RB5_KIND_SQIV,
+    RB5_KIND_ZDR,
+    RB5_KIND_RHOHV,
+    RB5_KIND_UPHIDP,
+    RB5_KIND_PHIDP,
+    RB5_KIND_UKDP,
+    RB5_KIND_KDP,
+    RB5_KIND_DATAFLAG,      //<rayinfo> from here on
+    RB5_KIND_STARTANGLE,
+    RB5_KIND_STOPANGLE,
+    RB5_KIND_STARTFIXANGLE,
+    RB5_KIND_STOPFIXANGLE,
+    RB5_KIND_NUMPULSES,
+    RB5_KIND_TIMESTAMP,
+    RB5_KIND_TXPOWER,
+    RB5_KIND_NOISEPOWERH,
+    RB5_KIND_NOISEPOWERV
+} RB5_MOMENT_KIND;
+
+//raw counts -> physical values, see convert_raw_to_data()
+typedef enum{
+    RB5_CONV_REG=0,   //linear over <rawdata> @min,@max
+    RB5_CONV_PHIDP,   //as RB5_CONV_REG
+    RB5_CONV_KDP,     //as RB5_CONV_REG
+    RB5_CONV_COPY,    //counts as is
+    RB5_CONV_ANGULAR  //linear over [0,360]
+} RB5_CONVERSION;
+
+typedef struct{
+    size_t blobid;
+    size_t byte_offset; //of the compressed payload, relative to the start of buffer
+    size_t size_blob;   //compressed size, as per <BLOB size="...">
+    unsigned char *inflated; //whole blob, inflated by read_rb5_stream() as soon as it was in, else NULL, freed once decoded
+    size_t inflated_len;
+} strRB5_BLOB_INFO;
+
+//model of the XML header, built in one SAX pass by build_rb5_xml_model()
+//strings are interned in its dictionary, valid until free_rb5_xml_model()
+typedef struct{
+    const char *name;        //element name
+    const char *value;       //its text, "" if empty
+    size_t n_attribs;
+    const char **attrib_arr; //name,value pairs, e.g. <dynv max="...">
+    size_t attrib_bgn;       //of attrib_arr in the model's pool
+} strRB5_XML_FIELD;
+
+typedef struct{
+    const char *refid;           //@refid, "" if none
+    size_t n_fields;
+    size_t n_alloc;
+    strRB5_XML_FIELD *field_arr; //child elements, in document order
+} strRB5_XML_GROUP;
+
+//one entry of the per-file moment catalog, resolved once while the header is parsed
+typedef struct{
+    const char *sparam;          //@type of <rawdata>, @refid of <rayinfo>
+    RB5_MOMENT_KIND kind;
+    RB5_CONVERSION conversion;
+    const char *quantity;        //ODIM, as per map_rb5_to_h5_param()
+    size_t blobid;
+    size_t raw_binary_depth;
+    size_t nrays;
+    size_t nbins;                //<rawdata> only
+    float data_range_min;        //<rawdata> only
+    float data_range_max;
+} strRB5_XML_PARAM;
+
+typedef struct{
+    strRB5_XML_GROUP fields;         //overrides, <slice refid="0"> holds the defaults
+    size_t n_faultstats;
+    strRB5_XML_FIELD *faultstat_arr; //the *warningstat and *faultstat fields
+    char iso8601[MAX_STRING];        //of <slicedata>
+    size_t n_rawdatas;
+    size_t n_rawdatapackeds;
+    strRB5_XML_PARAM rawdata_arr[MAX_PARAMS];
+    size_t n_rayinfos;
+    strRB5_XML_PARAM rayinfo_arr[MAX_PARAMS];
+} strRB5_XML_SLICE;
+
+typedef struct{
+    xmlDictPtr dict;             //owns the strings, a sub-dictionary of the parser's
+    size_t n_attribs;            //attribute pool, shared by all fields
+    size_t attrib_alloc;
+    const char **attrib_arr;
+    const char *root_name;
+    const char *version;         //<volume> attributes
+    const char *type;
+    const char *datetime;
+    const char *sensor_id;       //<sensorinfo> attributes
+    const char *sensor_name;
+    strRB5_XML_GROUP sensorinfo;
+    int history_exists;
+    const char *history_pdfname; //<history> attributes
+    const char *history_ppdfname;
+    const char *history_sdfname;
+    strRB5_XML_GROUP history_rawdatafiles;      //<file> fields
+    strRB5_XML_GROUP history_preprocessedfiles;
+    const char *scan_name;
+    size_t n_pargroups;
+    strRB5_XML_GROUP pargroup_arr[MAX_PARGROUPS]; //defaults, by @refid
+    size_t n_slices;
+    strRB5_XML_SLICE slice_arr[MAX_SLICES];
+} strRB5_XML_MODEL;
+
 typedef struct{
     char inp_fullfile[MAX_STRING];
     char inp_file_basename[MAX_STRING];
@@ -32,9 +159,14 @@ typedef struct{
     char inp_file_data_type[MAX_STRING];
     char *buffer;
     size_t buffer_len;
-    xmlDoc *doc;
+    int buffer_owner;             //FILE_BUFFER_*, how close_rb5_info() releases buffer
+    xmlDoc *doc;                  //NULL, the header is streamed into xml_model
     xmlXPathContextPtr xpathCtx;
+    strRB5_XML_MODEL *xml_model;  //built once by populate_rb5_info(), read in place of XPath
     size_t byte_offset_blobspace;
+    int blobspace_pending;        //1 while buffer holds only the XML header, read on by load_rb5_blobspace()
+    strRB5_BLOB_INFO *blob_index; //one per blob, sorted by blobid, built once by index_rb5_blobs()
+    size_t n_blob_index;
 
     char rainbow_version[MAX_STRING];
     char xml_block_name[MAX_STRING];
@@ -112,11 +244,67 @@ typedef struct{
     size_t n_rawdatas;
     char rayinfo_name_arr[MAX_STRING][MAX_PARAMS];
     char rawdata_name_arr[MAX_STRING][MAX_PARAMS];
+    RB5_MOMENT_KIND rayinfo_kind_arr[MAX_PARAMS];
+    int rawdata_selected[MAX_PARAMS]; //0 if filtered out by select_rb5_rawdatas()
+    int slice_selected[MAX_SLICES];   //0 if skipped by populate_rb5_info_slices(), slice info then unset
+    size_t n_slices_selected;
+    int header_mode;                  //RB5_HEADER_* if by populate_rb5_header(), no ray readbacks then
 } strRB5_INFO;
 
+//lightweight descriptor, see read_rb5_header()
+typedef struct{
+    char inp_fullfile[MAX_STRING];
+    char rainbow_version[MAX_STRING];
+    char sensor_id[MAX_STRING];
+    char sensor_name[MAX_STRING];
+    float sensor_lon_deg;
+    float sensor_lat_deg;
+    float sensor_alt_m;
+    float sensor_wavelength_cm;
+    float sensor_beamwidth_deg;
+    char scan_type[MAX_STRING];
+    char scan_name[MAX_STRING];
+    size_t n_rawdatas;
+    char quantity_arr[MAX_PARAMS][MAX_NSTRINGS]; //ODIM, as per map_rb5_to_h5_param()
+    size_t n_slices;
+    char slice_iso8601_bgn[MAX_SLICES][MAX_NSTRINGS];
+    char slice_iso8601_end[MAX_SLICES][MAX_NSTRINGS];
+    float angle_deg_arr[MAX_SLICES];
+    size_t nrays[MAX_SLICES];
+    size_t nbins[MAX_SLICES];
+    float slice_bin_range_bgn_km[MAX_SLICES];
+    float slice_bin_range_res_km[MAX_SLICES];
+    float slice_ray_angle_res_deg[MAX_SLICES];
+    float slice_antspeed_deg_sec[MAX_SLICES];
+} strRB5_HEADER;
+
+typedef struct{
+    size_t n_slices;            //> 0 selects by index: slice_arr[], 0-based in file order
+    size_t slice_arr[MAX_SLICES];
+    float angle_min_deg;        //otherwise by <posangle>, within [angle_min_deg,angle_max_deg]
+    float angle_max_deg;
+} strRB5_SLICE_SELECT;
+
+//path of an RB5 file in a bundle, e.g. rawdata/XAH/DOPVOL1_A.azi/2015-12-09/2015120916500500dBZ.azi, as
+//<rb5_ftype>/<rb5_site>/<rb5_sdf or rb5_ppdf>/<rb5_date>/<nam_yyyymmddhhmmss><nam_file_ver><nam_sparam>.<nam_scan_type>
+typedef struct{
+    char basefile[MAX_STRING];
+    char nam_yyyymmddhhmmss[MAX_STRING];
+    char nam_file_ver[MAX_STRING];
+    char nam_sparam[MAX_STRING];
+    char nam_scan_type[MAX_STRING];
+    char rb5_date[MAX_STRING];
+    char rb5_sdf[MAX_STRING];   //"" if the directory is a product definition
+    char rb5_ppdf[MAX_STRING];  //post-processing product definition, e.g. ZPHI_ITER_DEFAULT.dpatc, or ""
+    char rb5_site[MAX_STRING];
+    char rb5_ftype[MAX_STRING]; //rawdata, images, ...
+} strRB5_MEMBER_NAME;
+
 typedef struct{
     char xpath_bgn[MAX_STRING];
     char sparam[MAX_STRING];
+    RB5_MOMENT_KIND kind;
+    const char *quantity;        //ODIM, owned by strRB5_INFO.xml_model
     char iso8601[MAX_STRING];
     size_t blobid;
     size_t size_blob;
@@ -132,7 +320,7 @@ typedef struct{
     size_t nbins;
     size_t iray_0degN;
 
-    char conversion[MAX_STRING];
+    RB5_CONVERSION conversion;
     float data_range_min;
     float data_range_max;
     float data_range_width;
@@ -140,6 +328,13 @@ typedef struct{
     float NODATA_val;
 } strRB5_PARAM_INFO;
 
+typedef struct{
+    strRB5_PARAM_INFO rb5_param;
+    void *dest_arr;      //sized n_elems_data*data_bytesize
+    size_t n_elems_data; //decode_param_blobid() result, 0 on error
+    strRB5_INFO *rb5_info; //payload of the blob, NULL for the one given to decode_param_blobids()
+} strRB5_DECODE_TASK;
+
 typedef struct{
     int  type;
     char name[MAX_STRING];
@@ -150,20 +345,43 @@ typedef struct{
 //#############################################################################
 // function declarations
 //#############################################################################
-size_t uncompress_this_blob(unsigned char *buf, unsigned char** return_uncompressed_blob, size_t compressed_size_blob);
-char *get_xpath_iso8601_attrib(const xmlXPathContextPtr xpathCtx, char *xpath_bgn);
+size_t uncompress_this_blob(const unsigned char *buf, unsigned char** return_uncompressed_blob, size_t compressed_size_blob);
+int load_rb5_blobspace(strRB5_INFO *rb5_info);
+int index_rb5_blobs(strRB5_INFO *rb5_info);
+void sort_rb5_blobs(strRB5_INFO *rb5_info);
+strRB5_BLOB_INFO *find_rb5_blob(strRB5_INFO *rb5_info, size_t req_blobid);
 size_t get_blobid_buffer(strRB5_INFO *rb5_info, int req_blobid, unsigned char** return_uncompressed_blob);
 void convert_raw_to_data(strRB5_PARAM_INFO *rb5_param, void **input_raw_arr, float **return_data_arr);
+size_t decode_param_blobid(strRB5_INFO *rb5_info, strRB5_PARAM_INFO* rb5_param, void *dest_arr);
+size_t decode_param_blobids(strRB5_INFO *rb5_info, strRB5_DECODE_TASK *tasks, size_t n_tasks, int n_threads);
 size_t return_param_blobid_raw(strRB5_INFO *rb5_info, strRB5_PARAM_INFO* rb5_param, void **return_raw_arr);
-char *map_rb5_to_h5_param(char *sparam);
-strURPDATA what_is_this_param_to_urp(char *sparam);
+RB5_MOMENT_KIND get_rb5_moment_kind(const char *sparam);
+RB5_CONVERSION get_rb5_conversion(RB5_MOMENT_KIND kind);
+const char *get_rb5_conversion_name(RB5_CONVERSION conversion);
+char *map_rb5_to_h5_param(const char *sparam);
+size_t select_rb5_rawdatas(strRB5_INFO *rb5_info, const char **quantities, size_t n_quantities);
+strURPDATA what_is_this_param_to_urp(const char *sparam);
 void close_rb5_info(strRB5_INFO *rb5_info);
-char *get_xpath_slice_attrib(const xmlXPathContextPtr xpathCtx, size_t this_slice, char *xpath_end);
+strRB5_XML_MODEL *build_rb5_xml_model(const char *buffer, size_t buffer_len);
+size_t count_rb5_xml_quantities(const strRB5_XML_MODEL *model, const char **quantities, size_t n_quantities);
+void close_rb5_xml_parser(void);
+void free_rb5_xml_model(strRB5_XML_MODEL *model);
+const char *find_rb5_xml_field(const strRB5_XML_GROUP *group, const char *name, const char *attrib);
+const strRB5_XML_SLICE *get_rb5_xml_slice(strRB5_INFO *rb5_info, size_t this_slice);
+const char *get_rb5_slice_attrib(strRB5_INFO *rb5_info, size_t this_slice, const char *name, const char *attrib);
+const char *get_rb5_sensorinfo_attrib(strRB5_INFO *rb5_info, const char *name);
+const char *get_rb5_pargroup_attrib(strRB5_INFO *rb5_info, const char *refid, const char *name);
 int populate_rb5_info(strRB5_INFO *rb5_info, int L_VERBOSE);
-strRB5_PARAM_INFO get_rb5_param_info(strRB5_INFO *rb5_info, char *xpath_bgn, int L_VERBOSE);
+int populate_rb5_info_slices(strRB5_INFO *rb5_info, int L_VERBOSE, const strRB5_SLICE_SELECT *slice_select);
+int populate_rb5_header(strRB5_INFO *rb5_info, int L_VERBOSE, int header_mode);
+int read_rb5_header(char *inp_fname, int header_mode, strRB5_HEADER *header);
+int read_rb5_stream(int fd, const char *inp_fname, const char **quantities, size_t n_quantities, const strRB5_SLICE_SELECT *slice_select, strRB5_INFO *rb5_info);
+strRB5_PARAM_INFO get_rb5_param_info(strRB5_INFO *rb5_info, int this_slice, const char *block, size_t idx, int L_VERBOSE);
 size_t find_in_string_arr(char arr[][MAX_NSTRINGS], size_t n, char *match);
+int find_rb5_rayinfo(strRB5_INFO *rb5_info, RB5_MOMENT_KIND kind);
 void dump_strRB5_PARAM_INFO(strRB5_PARAM_INFO rb5_param);
 void get_slice_iray_0degN(strRB5_INFO *rb5_info, int req_slice);
 void reorder_by_iray_0degN(strRB5_PARAM_INFO *rb5_param, void **input_raw_arr);
 void get_slice_end_iso8601(strRB5_INFO *rb5_info, int req_slice);
 void get_slice_mid_angle_readbacks(strRB5_INFO *rb5_info, int req_slice);
+void parse_rb5_member_name(const char *fullfile, strRB5_MEMBER_NAME *mb);
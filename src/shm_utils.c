@@ -0,0 +1,220 @@
+/*
+ * shm_utils.c
+ *
+ * POSIX shared memory segments holding a decoded scan or volume, laid out as
+ * shm_utils.h says, so that downstream processes (QC, gridding, profiling) map
+ * the moments in place instead of re-reading the ODIM_H5 file.
+ *
+ * - the writer (saveRaveIOShm()) creates a new segment, fills it, then publishes it by
+ *   writing RB5_SHM_MAGIC last; republishing unlinks the old segment, readers that
+ *   still have it mapped keep it as it was
+ * - readers map it read-only with open_shm_segment(), needing neither RAVE nor HDF5
+ *
+ * compile: gcc -Wall -c shm_utils.c [-lrt with glibc < 2.34]
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "shm_utils.h"
+
+#define L_DEBUG_OUTPUT_shm 0
+
+//#############################################################################
+
+size_t shm_align(size_t n_bytes){
+    // rounded up to the next RB5_SHM_ALIGN boundary
+
+    return((n_bytes+RB5_SHM_ALIGN-1) & ~((size_t)RB5_SHM_ALIGN-1));
+}
+
+//#############################################################################
+
+char *create_shm_segment(const char *shm_name, size_t segment_bytes){
+    // a new zeroed segment, mapped read-write, replacing any of the same name
+    // publish_shm_segment() once written, discard_shm_segment() on error
+    // returns NULL on error
+
+    shm_unlink(shm_name); //readers that have the old one mapped keep it
+    int fd=shm_open(shm_name,O_CREAT|O_EXCL|O_RDWR,0644);
+    if(fd == -1) {
+        fprintf(stderr,"Error: cannot create shared memory = %s (%s)\n", shm_name, strerror(errno));
+        return(NULL);
+    }
+    if(ftruncate(fd,(off_t)segment_bytes) != 0) {
+        fprintf(stderr,"Error: cannot size shared memory = %s to %ld bytes (%s)\n", shm_name, segment_bytes, strerror(errno));
+        close(fd);
+        shm_unlink(shm_name);
+        return(NULL);
+    }
+    char *segment=(char *)mmap(NULL,segment_bytes,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    close(fd);
+    if(segment == MAP_FAILED) {
+        fprintf(stderr,"Error: cannot map shared memory = %s (%s)\n", shm_name, strerror(errno));
+        shm_unlink(shm_name);
+        return(NULL);
+    }
+    if(L_DEBUG_OUTPUT_shm) fprintf(stdout,"shm %s created, %ld bytes\n",shm_name,segment_bytes);
+    return(segment);
+}
+
+//#############################################################################
+
+void seal_shm_segment(char *segment, size_t segment_bytes){
+    // marks a written segment as complete, by writing RB5_SHM_MAGIC last
+
+    strRB5_SHM_HEADER *header=(strRB5_SHM_HEADER *)segment;
+    header->version=RB5_SHM_VERSION;
+    header->segment_bytes=segment_bytes;
+    __sync_synchronize(); //all of it before the magic
+    memcpy(header->magic,RB5_SHM_MAGIC,sizeof(RB5_SHM_MAGIC));
+}
+
+//#############################################################################
+
+void publish_shm_segment(char *segment, size_t segment_bytes){
+    // seals a written segment, and unmaps it; it stays until unlinked
+
+    seal_shm_segment(segment,segment_bytes);
+    munmap(segment,segment_bytes);
+}
+
+//#############################################################################
+
+void discard_shm_segment(const char *shm_name, char *segment, size_t segment_bytes){
+
+    munmap(segment,segment_bytes);
+    shm_unlink(shm_name);
+}
+
+//#############################################################################
+
+static int is_shm_table(const strRB5_SHM *shm, uint64_t byte_offset, uint64_t n_items, size_t item_bytes){
+    // whether a table lies within the segment
+
+    if(byte_offset > shm->segment_bytes) return(0);
+    return(n_items <= (shm->segment_bytes-byte_offset)/item_bytes);
+}
+
+//#############################################################################
+
+int map_shm_segment(int fd, const char *shm_name, size_t prefix_bytes, strRB5_SHM *shm){
+    // maps a published segment read-only from an open file, prefix_bytes into it,
+    // release with close_shm_segment(); fd may be closed once mapped
+
+    struct stat shm_stat;
+
+    memset(shm,0,sizeof(strRB5_SHM));
+    if((fstat(fd,&shm_stat) != 0) || ((size_t)shm_stat.st_size < prefix_bytes+sizeof(strRB5_SHM_HEADER))) {
+        fprintf(stderr,"Error: shared memory = %s is not an RB5 segment\n", shm_name);
+        return(EXIT_FAILURE);
+    }
+    char *mapping=(char *)mmap(NULL,(size_t)shm_stat.st_size,PROT_READ,MAP_SHARED,fd,0);
+    if(mapping == MAP_FAILED) {
+        fprintf(stderr,"Error: cannot map shared memory = %s (%s)\n", shm_name, strerror(errno));
+        return(EXIT_FAILURE);
+    }
+    shm->mapping=mapping;
+    shm->mapping_bytes=(size_t)shm_stat.st_size;
+    shm->segment=mapping+prefix_bytes;
+    shm->segment_bytes=shm->mapping_bytes-prefix_bytes;
+
+    const strRB5_SHM_HEADER *header=(const strRB5_SHM_HEADER *)shm->segment;
+    if(memcmp(header->magic,RB5_SHM_MAGIC,sizeof(RB5_SHM_MAGIC)) != 0) {
+        fprintf(stderr,"Error: shared memory = %s is not a published RB5 segment\n", shm_name);
+        close_shm_segment(shm);
+        return(EXIT_FAILURE);
+    }
+    __sync_synchronize(); //the rest was written before the magic
+    if((header->version != RB5_SHM_VERSION) || (header->segment_bytes > shm->segment_bytes) ||
+       (!is_shm_table(shm,header->scan_offset,header->n_scans,sizeof(strRB5_SHM_SCAN))) ||
+       (!is_shm_table(shm,header->moment_offset,header->n_moments,sizeof(strRB5_SHM_MOMENT))) ||
+       (!is_shm_table(shm,header->attrib_offset,header->n_attribs,sizeof(strRB5_SHM_ATTRIB)))) {
+        fprintf(stderr,"Error: shared memory = %s has an unknown layout (version %u)\n", shm_name, header->version);
+        close_shm_segment(shm);
+        return(EXIT_FAILURE);
+    }
+    shm->header=header;
+    shm->scan_arr=(const strRB5_SHM_SCAN *)(shm->segment+header->scan_offset);
+    shm->moment_arr=(const strRB5_SHM_MOMENT *)(shm->segment+header->moment_offset);
+    shm->attrib_arr=(const strRB5_SHM_ATTRIB *)(shm->segment+header->attrib_offset);
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+int open_shm_segment(const char *shm_name, strRB5_SHM *shm){
+    // maps a published segment read-only, release with close_shm_segment()
+
+    memset(shm,0,sizeof(strRB5_SHM));
+    int fd=shm_open(shm_name,O_RDONLY,0);
+    if(fd == -1) {
+        fprintf(stderr,"Error: cannot open shared memory = %s (%s)\n", shm_name, strerror(errno));
+        return(EXIT_FAILURE);
+    }
+    int ret=map_shm_segment(fd,shm_name,0,shm);
+    close(fd);
+    return(ret);
+}
+
+//#############################################################################
+
+void close_shm_segment(strRB5_SHM *shm){
+    // unmaps it, pointers into it are then invalid
+
+    if(shm->mapping != NULL) munmap(shm->mapping,shm->mapping_bytes);
+    memset(shm,0,sizeof(strRB5_SHM));
+}
+
+//#############################################################################
+
+int unlink_shm_segment(const char *shm_name){
+    // removes the name, the segment goes once no process has it mapped
+
+    if(shm_unlink(shm_name) != 0) {
+        fprintf(stderr,"Error: cannot unlink shared memory = %s (%s)\n", shm_name, strerror(errno));
+        return(EXIT_FAILURE);
+    }
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+const void *get_shm_data(const strRB5_SHM *shm, uint64_t byte_offset, uint64_t n_bytes){
+    // n_bytes at byte_offset, NULL unless they lie within the segment
+
+    if(!is_shm_table(shm,byte_offset,n_bytes,1)) return(NULL);
+    return(shm->segment+byte_offset);
+}
+
+//#############################################################################
+
+const strRB5_SHM_MOMENT *find_shm_moment(const strRB5_SHM *shm, size_t this_scan, const char *quantity){
+    // moment of an ODIM quantity in a scan, NULL if not there
+
+    size_t i;
+
+    if(this_scan >= shm->header->n_scans) return(NULL);
+    const strRB5_SHM_SCAN *scan=&(shm->scan_arr[this_scan]);
+    for (i = scan->first_moment; (i < (size_t)scan->first_moment+scan->n_moments) && (i < shm->header->n_moments); i++) {
+        if(strncmp(shm->moment_arr[i].quantity,quantity,RB5_SHM_MAX_NAME) == 0) return(&(shm->moment_arr[i]));
+    }
+    return(NULL);
+}
+
+//#############################################################################
+
+const strRB5_SHM_ATTRIB *find_shm_attrib(const strRB5_SHM *shm, size_t first_attrib, size_t n_attribs, const char *name){
+    // attribute of an object (first_attrib, n_attribs of its table entry), NULL if not there
+
+    size_t i;
+
+    for (i = first_attrib; (i < first_attrib+n_attribs) && (i < shm->header->n_attribs); i++) {
+        if(strncmp(shm->attrib_arr[i].name,name,RB5_SHM_MAX_NAME) == 0) return(&(shm->attrib_arr[i]));
+    }
+    return(NULL);
+}
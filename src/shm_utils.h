@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+//decoded scan or volume published in POSIX shared memory (shm_open(), /dev/shm on Linux),
+//for downstream processes to map instead of re-reading ODIM_H5, see saveRaveIOShm()
+//
+//segment layout, offsets in bytes from its start, native byte order, each part RB5_SHM_ALIGN aligned:
+//  strRB5_SHM_HEADER
+//  strRB5_SHM_SCAN[n_scans]
+//  strRB5_SHM_MOMENT[n_moments]     scan by scan
+//  strRB5_SHM_ATTRIB[n_attribs]     top level, then scan by scan, each scan's then its moments'
+//  attribute values                 strings and arrays, scalars are in strRB5_SHM_ATTRIB
+//  moment arrays                    nrays*nbins each, row (ray) major
+
+#define RB5_SHM_MAGIC    "RB5SHM"  //written last, a segment without it is still being written
+#define RB5_SHM_VERSION  1
+#define RB5_SHM_ALIGN    64
+#define RB5_SHM_MAX_NAME 64        //quantities and attribute names, NUL terminated
+#define RB5_SHM_MAX_DATE 16        //"YYYYMMDD", "HHmmss"
+#define RB5_SHM_MAX_SOURCE 256
+
+//strRB5_SHM_HEADER object_type
+#define RB5_SHM_PVOL 1
+#define RB5_SHM_SCAN 2
+
+//strRB5_SHM_ATTRIB format, as RaveAttribute_Format
+#define RB5_SHM_ATTRIB_STRING       0
+#define RB5_SHM_ATTRIB_LONG         1 //int64_t
+#define RB5_SHM_ATTRIB_DOUBLE       2
+#define RB5_SHM_ATTRIB_LONG_ARRAY   3 //int64_t[n_values]
+#define RB5_SHM_ATTRIB_DOUBLE_ARRAY 4 //double[n_values]
+
+//angles in degrees and ranges as in ODIM_H5 files, not radians as in the Toolbox objects
+typedef struct{
+    char magic[8];             //RB5_SHM_MAGIC
+    uint32_t version;          //RB5_SHM_VERSION
+    uint32_t object_type;      //RB5_SHM_PVOL or RB5_SHM_SCAN
+    uint64_t segment_bytes;
+    char date[RB5_SHM_MAX_DATE];
+    char time[RB5_SHM_MAX_DATE];
+    char source[RB5_SHM_MAX_SOURCE];
+    double longitude;          //deg
+    double latitude;           //deg
+    double height;             //m
+    double beamwidth;          //deg
+    uint32_t n_scans;
+    uint32_t n_moments;        //of all scans
+    uint32_t n_attribs;        //of all objects
+    uint32_t n_attribs_top;    //the first ones
+    uint64_t scan_offset;
+    uint64_t moment_offset;
+    uint64_t attrib_offset;
+} strRB5_SHM_HEADER;
+
+typedef struct{
+    char startdate[RB5_SHM_MAX_DATE];
+    char starttime[RB5_SHM_MAX_DATE];
+    char enddate[RB5_SHM_MAX_DATE];
+    char endtime[RB5_SHM_MAX_DATE];
+    double elangle;            //deg
+    double rstart;             //km
+    double rscale;             //m
+    int64_t a1gate;
+    uint32_t nrays;
+    uint32_t nbins;
+    uint32_t first_moment;     //index in the moment table
+    uint32_t n_moments;
+    uint32_t first_attrib;     //index in the attribute table
+    uint32_t n_attribs;
+} strRB5_SHM_SCAN;
+
+typedef struct{
+    char quantity[RB5_SHM_MAX_NAME];
+    double gain;
+    double offset;
+    double nodata;
+    double undetect;
+    char typecode[4];          //of an element, as Python's struct and numpy: "B", "H", "b", "f", ...
+    uint32_t elem_bytes;
+    uint32_t nrays;
+    uint32_t nbins;
+    uint32_t first_attrib;
+    uint32_t n_attribs;
+    uint64_t data_offset;
+    uint64_t data_bytes;
+} strRB5_SHM_MOMENT;
+
+typedef struct{
+    char name[RB5_SHM_MAX_NAME]; //e.g. "how/startazA"
+    uint32_t format;           //RB5_SHM_ATTRIB_*
+    uint32_t n_values;         //array length, string length incl. its NUL, 1 for scalars
+    int64_t lvalue;
+    double dvalue;
+    uint64_t value_offset;     //strings and arrays, 0 for scalars
+} strRB5_SHM_ATTRIB;
+
+//a published segment, as mapped by open_shm_segment() or map_shm_segment()
+typedef struct{
+    char *mapping;             //what close_shm_segment() unmaps, a cache entry's starts with its key
+    size_t mapping_bytes;
+    char *segment;
+    size_t segment_bytes;
+    const strRB5_SHM_HEADER *header;
+    const strRB5_SHM_SCAN *scan_arr;
+    const strRB5_SHM_MOMENT *moment_arr;
+    const strRB5_SHM_ATTRIB *attrib_arr;
+} strRB5_SHM;
+
+//#############################################################################
+// function declarations
+//#############################################################################
+size_t shm_align(size_t n_bytes);
+char *create_shm_segment(const char *shm_name, size_t segment_bytes);
+void seal_shm_segment(char *segment, size_t segment_bytes);
+void publish_shm_segment(char *segment, size_t segment_bytes);
+void discard_shm_segment(const char *shm_name, char *segment, size_t segment_bytes);
+int map_shm_segment(int fd, const char *shm_name, size_t prefix_bytes, strRB5_SHM *shm);
+int open_shm_segment(const char *shm_name, strRB5_SHM *shm);
+void close_shm_segment(strRB5_SHM *shm);
+int unlink_shm_segment(const char *shm_name);
+const strRB5_SHM_MOMENT *find_shm_moment(const strRB5_SHM *shm, size_t this_scan, const char *quantity);
+const strRB5_SHM_ATTRIB *find_shm_attrib(const strRB5_SHM *shm, size_t first_attrib, size_t n_attribs, const char *name);
+const void *get_shm_data(const strRB5_SHM *shm, uint64_t byte_offset, uint64_t n_bytes);
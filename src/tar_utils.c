@@ -0,0 +1,243 @@
+/*
+ * tar_utils.c
+ *
+ * Reads a tar file, optionally gzipped, as one buffer and indexes its members in place,
+ * so that bundles of RB5 files (e.g. caxah_dopvol1a_20151209T1650Z.azi.tar.gz) are
+ * decoded straight from it, without extracting or copying any member.
+ *
+ * - POSIX ustar and GNU tar: ustar prefix, GNU 'L' long names, pax 'x' path records
+ * - only regular files are indexed, directories, links and the like are skipped
+ *
+ * compile: gcc -Wall -I/usr/include/libxml2 -c tar_utils.c -lxml2 -lz
+ *
+ */
+
+#include "xml_utils.h"
+#include "inflate_utils.h"
+#include "tar_utils.h"
+
+#define L_DEBUG_OUTPUT_tar 0
+
+//ustar header fields, offset and length
+#define TAR_NAME_OFFSET     0
+#define TAR_NAME_LEN        100
+#define TAR_SIZE_OFFSET     124
+#define TAR_SIZE_LEN        12
+#define TAR_CHKSUM_OFFSET   148
+#define TAR_CHKSUM_LEN      8
+#define TAR_TYPEFLAG_OFFSET 156
+#define TAR_MAGIC_OFFSET    257
+#define TAR_PREFIX_OFFSET   345
+#define TAR_PREFIX_LEN      155
+
+//#############################################################################
+
+size_t read_tar_2_buffer(char *inp_fname, char **return_buffer, int *return_owner){
+    // the whole tar file, mapped if it can be, inflated first if it is gzipped
+    // release with close_file_buffer(..,*return_owner)
+    // returns the buffer length, 0 on error
+
+    size_t EXIT_NULL_VAL=0;
+    char *buffer=NULL;
+    int buffer_owner=FILE_BUFFER_MMAP;
+
+    size_t buffer_len=map_file_2_buffer(inp_fname,&buffer);
+    if(buffer_len == 0) {
+        buffer_owner=FILE_BUFFER_HEAP;
+        buffer_len=read_file_2_buffer(inp_fname,&buffer);
+        if(buffer_len == 0) return(EXIT_NULL_VAL);
+    }
+
+    if(is_gzip_buffer((const unsigned char *)buffer,buffer_len)) {
+        char *gunzipped=NULL;
+        size_t gunzipped_len=gunzip_buffer((const unsigned char *)buffer,buffer_len,&gunzipped);
+        close_file_buffer(buffer,buffer_len,buffer_owner);
+        if(gunzipped_len == 0) {
+            fprintf(stderr,"Error cannot gunzip file = %s\n", inp_fname);
+            return(EXIT_NULL_VAL);
+        }
+        buffer=gunzipped;
+        buffer_len=gunzipped_len;
+        buffer_owner=FILE_BUFFER_HEAP;
+    }
+    if(L_DEBUG_OUTPUT_tar) fprintf(stdout,"tar buffer_len = %ld\n",buffer_len);
+
+    *return_buffer=buffer;
+    *return_owner=buffer_owner;
+    return(buffer_len);
+}
+
+//#############################################################################
+
+static int parse_tar_number(const unsigned char *field, size_t field_len, size_t *value){
+    // octal, space or NUL terminated, or GNU base-256 (high bit of the first byte set)
+
+    size_t i=0;
+    size_t n=0;
+
+    if(field[0] & 0x80) {
+        n=field[0] & 0x7f;
+        for (i = 1; i < field_len; i++) {
+            if(n > ((size_t)-1 >> 8)) return(EXIT_FAILURE);
+            n=(n << 8) | field[i];
+        }
+        *value=n;
+        return(EXIT_SUCCESS);
+    }
+
+    while((i < field_len) && (field[i] == ' ')) i++;
+    if((i == field_len) || (field[i] < '0') || (field[i] > '7')) return(EXIT_FAILURE);
+    for (; (i < field_len) && (field[i] >= '0') && (field[i] <= '7'); i++) {
+        n=(n << 3) | (size_t)(field[i]-'0');
+    }
+    if((i < field_len) && (field[i] != ' ') && (field[i] != '\0')) return(EXIT_FAILURE);
+    *value=n;
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+static int is_tar_header(const unsigned char *header){
+    // checksum of the block, with its own field counted as spaces
+    // (unsigned, as POSIX says, or signed, as some old tars wrote it)
+
+    size_t chksum=0;
+    size_t sum=0;
+    long signed_sum=0;
+    size_t i;
+
+    if(parse_tar_number(header+TAR_CHKSUM_OFFSET,TAR_CHKSUM_LEN,&chksum) != 0) return(0);
+    for (i = 0; i < TAR_BLOCK_BYTES; i++) {
+        unsigned char c=((i >= TAR_CHKSUM_OFFSET) && (i < TAR_CHKSUM_OFFSET+TAR_CHKSUM_LEN)) ? ' ' : header[i];
+        sum+=c;
+        signed_sum+=(signed char)c;
+    }
+    return((chksum == sum) || ((long)chksum == signed_sum));
+}
+
+//#############################################################################
+
+static int is_zero_block(const unsigned char *block){
+
+    size_t i;
+    for (i = 0; i < TAR_BLOCK_BYTES; i++) if(block[i] != '\0') return(0);
+    return(1);
+}
+
+//#############################################################################
+
+static void copy_tar_string(char *dest, size_t dest_len, const char *src, size_t src_len){
+    // src need not be NUL terminated, dest always is
+
+    size_t len=0;
+    while((len < src_len) && (src[len] != '\0')) len++;
+    if(len >= dest_len) len=dest_len-1;
+    memcpy(dest,src,len);
+    dest[len]='\0';
+}
+
+//#############################################################################
+
+static void set_pax_path(char *long_name, const char *records, size_t records_len){
+    // "<len> path=<value>\n" of a pax extended header, other records are ignored
+
+    size_t pos=0;
+    while(pos < records_len) {
+        size_t record_len=0;
+        size_t i=pos;
+        while((i < records_len) && (records[i] >= '0') && (records[i] <= '9')) {
+            record_len=record_len*10+(size_t)(records[i]-'0');
+            i++;
+        }
+        if((record_len == 0) || (i >= records_len) || (records[i] != ' ') || (record_len > records_len-pos)) return;
+        const char *key=records+i+1;
+        const char *record_end=records+pos+record_len; //past its '\n'
+        if((record_end-key > 5) && (strncmp(key,"path=",5) == 0)) {
+            copy_tar_string(long_name,TAR_MAX_NAME,key+5,record_end-1-(key+5));
+        }
+        pos+=record_len;
+    }
+}
+
+//#############################################################################
+
+size_t index_tar_members(const char *buffer, size_t buffer_len, strTAR_MEMBER **return_members){
+    // the regular files of a tar buffer, in archive order, into a plain malloc()ed array
+    // (free() it), their data stays in buffer
+    // returns the number of members, 0 on error or if there are none
+
+    size_t EXIT_NULL_VAL=0;
+    size_t n_members=0;
+    size_t n_alloc=TAR_N_MEMBERS_0;
+    size_t offset=0;
+    char long_name[TAR_MAX_NAME]="\0"; //of the next member, from a 'L' or 'x' header
+
+    *return_members=NULL;
+    strTAR_MEMBER *members=(strTAR_MEMBER *)malloc(n_alloc*sizeof(strTAR_MEMBER));
+    if(members == NULL) {
+        fprintf(stderr,"Error: cannot allocate the tar index\n");
+        return(EXIT_NULL_VAL);
+    }
+
+    while(offset+TAR_BLOCK_BYTES <= buffer_len) {
+        const unsigned char *header=(const unsigned char *)buffer+offset;
+        size_t size=0;
+
+        if(is_zero_block(header)) break; //end of archive
+        if((!is_tar_header(header)) || (parse_tar_number(header+TAR_SIZE_OFFSET,TAR_SIZE_LEN,&size) != 0)) {
+            fprintf(stderr,"Error: not a tar header at byte_offset = %ld\n",offset);
+            free(members);
+            return(EXIT_NULL_VAL);
+        }
+        size_t byte_offset=offset+TAR_BLOCK_BYTES;
+        if(size > buffer_len-byte_offset) {
+            fprintf(stderr,"Error: tar member truncated at byte_offset = %ld\n",byte_offset);
+            free(members);
+            return(EXIT_NULL_VAL);
+        }
+
+        char typeflag=(char)header[TAR_TYPEFLAG_OFFSET];
+        if(typeflag == 'L') {
+            copy_tar_string(long_name,TAR_MAX_NAME,buffer+byte_offset,size);
+        } else if(typeflag == 'x') {
+            set_pax_path(long_name,buffer+byte_offset,size);
+        } else {
+            if((typeflag == '0') || (typeflag == '\0') || (typeflag == '7')) {
+                if(n_members == n_alloc) {
+                    strTAR_MEMBER *grown=(strTAR_MEMBER *)realloc(members,2*n_alloc*sizeof(strTAR_MEMBER));
+                    if(grown == NULL) {
+                        fprintf(stderr,"Error: cannot allocate the tar index\n");
+                        free(members);
+                        return(EXIT_NULL_VAL);
+                    }
+                    members=grown;
+                    n_alloc*=2;
+                }
+                strTAR_MEMBER *member=&(members[n_members++]);
+                if(long_name[0] != '\0') {
+                    strcpy(member->name,long_name);
+                } else if((strncmp((const char *)header+TAR_MAGIC_OFFSET,"ustar",5) == 0) && (header[TAR_PREFIX_OFFSET] != '\0')) {
+                    char prefix[TAR_PREFIX_LEN+1];
+                    char name[TAR_NAME_LEN+1];
+                    copy_tar_string(prefix,sizeof(prefix),(const char *)header+TAR_PREFIX_OFFSET,TAR_PREFIX_LEN);
+                    copy_tar_string(name,sizeof(name),(const char *)header+TAR_NAME_OFFSET,TAR_NAME_LEN);
+                    snprintf(member->name,TAR_MAX_NAME,"%s/%s",prefix,name);
+                } else {
+                    copy_tar_string(member->name,TAR_MAX_NAME,(const char *)header+TAR_NAME_OFFSET,TAR_NAME_LEN);
+                }
+                member->byte_offset=byte_offset;
+                member->size=size;
+                if(L_DEBUG_OUTPUT_tar) fprintf(stdout,"tar member = %s (%ld)\n",member->name,size);
+            }
+            long_name[0]='\0'; //a long name only applies to the header that follows it
+        }
+        offset=byte_offset+((size+TAR_BLOCK_BYTES-1)/TAR_BLOCK_BYTES)*TAR_BLOCK_BYTES;
+    }
+
+    if(n_members == 0) {
+        free(members);
+        return(EXIT_NULL_VAL);
+    }
+    *return_members=members;
+    return(n_members);
+}
@@ -0,0 +1,20 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TAR_BLOCK_BYTES 512
+#define TAR_MAX_NAME    1024 //member path incl. ustar prefix, GNU 'L' and pax 'path' long names
+#define TAR_N_MEMBERS_0 64   //index_tar_members() initial allocation, doubled as needed
+
+//one regular file of a tar buffer, its data is in place at byte_offset
+typedef struct{
+    char name[TAR_MAX_NAME];
+    size_t byte_offset;
+    size_t size;
+} strTAR_MEMBER;
+
+//#############################################################################
+// function declarations
+//#############################################################################
+size_t read_tar_2_buffer(char *inp_fname, char **return_buffer, int *return_owner);
+size_t index_tar_members(const char *buffer, size_t buffer_len, strTAR_MEMBER **return_members);
@@ -3,130 +3,131 @@
  *
  * Author: Peter Rodriguez 2018-Jan-25
  *
- * compile: gcc -Wall -I/usr/include/libxml2 -c xml_utils.c -lxml2
+ * compile: gcc -Wall -I/usr/include/libxml2 -c xml_utils.c -lxml2 -lz
  *
  */
 
 #include "xml_utils.h"
+#include "inflate_utils.h" //for gunzip_buffer()
 
 #define L_DEBUG_OUTPUT_xml 0
 
-//#############################################################################
+static int parse_xml_buffer(strXML_FILE_INFO *xml_info);
+static int gunzip_xml_buffer(strXML_FILE_INFO *xml_info);
 
-size_t get_xpath_size(const xmlXPathContextPtr xpathCtx, char *xpath){
-    size_t return_NULL_val=0;
+//#############################################################################
 
-    const xmlChar* xpathExpr = (const xmlChar*) xpath;
+size_t read_file_2_buffer(char *inp_fname, char **return_buffer){
+    // NUL terminated, free with close_file_buffer()
 
-    // evaluate xpath expression
-    xmlXPathObjectPtr xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
-    if(xpathObj == NULL) {
-        fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
-        return(return_NULL_val);
-    }
+    size_t EXIT_NULL_VAL=0;
+    char *buffer=NULL;
+    size_t buffer_len=0;
 
-    // use xpath object
-    xmlNodeSetPtr nodes = xpathObj->nodesetval;
-    size_t size = (nodes) ? nodes->nodeNr : 0;
-    if(size == 0) {
-        if(L_DEBUG_OUTPUT_xml) fprintf(stderr,"Error: xpath expression not found \"%s\"\n", xpathExpr);
-        xmlXPathFreeObject(xpathObj);
-        return(return_NULL_val);
+    FILE *fp = NULL;
+    fp = fopen(inp_fname, "r");
+    if (NULL == fp) {
+        fprintf(stderr,"Error while opening file = %s\n", inp_fname);
+        return(EXIT_NULL_VAL);
     }
 
-    /* Cleanup */
-    xmlXPathFreeObject(xpathObj);
-
-    return(size);
-}
-
-//#############################################################################
-
-char *return_xpath_name(const xmlXPathContextPtr xpathCtx, char *xpath){
-
-    const xmlChar* xpathExpr = (const xmlChar*) xpath;
+    if (fseek(fp,0L,SEEK_END) == 0) {
+        /* Get the size of the file. */
+        long file_len=ftell(fp);
+        if (file_len == -1) {
+            fprintf(stderr,"Error while reading file\n");
+            fclose(fp);
+            return(EXIT_NULL_VAL);
+        }
+        buffer_len=file_len;
 
-    // evaluate xpath expression
-    xmlXPathObjectPtr xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
-    if(xpathObj == NULL) {
-        fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
-        return("\0");
-    }
+        /* Allocate our buffer to that size. */
+        buffer=malloc(sizeof(char)*(buffer_len+1));
+        if(L_DEBUG_OUTPUT_xml) fprintf(stdout,"buffer_len = %ld\n",buffer_len);
 
-    // use xpath object
-    xmlNodeSetPtr nodes = xpathObj->nodesetval;
-    size_t size = (nodes) ? nodes->nodeNr : 0;
-    if(size == 0) {
-        if(L_DEBUG_OUTPUT_xml) fprintf(stderr,"Error: xpath expression not found \"%s\"\n", xpathExpr);
-        xmlXPathFreeObject(xpathObj);
-        return("\0");
-    }
+        /* Go back to the start of the file. */
+        if ((buffer == NULL) || (fseek(fp,0L,SEEK_SET) != 0)) {
+            fprintf(stderr,"Error while reading file\n");
+            if (buffer != NULL) free(buffer);
+            fclose(fp);
+            return(EXIT_NULL_VAL);
+        }
 
-    //assume uniqueness, use [position()=X] in xpath
-    //having used get_xpath_size() to build looping code
-    int iNode = 0; // get only 1st value at xpath
-    xmlNodePtr cur = (xmlNodePtr)xpathObj->nodesetval->nodeTab[iNode];
-    if(cur == NULL) {
-        fprintf(stderr,"Error: NULL node at xpath expression \"%s\"\n", xpathExpr);
-        xmlXPathFreeObject(xpathObj);
-        return("\0");
-    }
-    char *value = (char *) cur->name;
-//    fprintf(stdout,"XPATH: %s = %s\n", xpathExpr, value);
+        /* Read the entire file into memory. */
+        if (fread(buffer,sizeof(char),buffer_len,fp) <= 0) {
+            fprintf(stderr,"Error while reading file\n");
+            free(buffer);
+            fclose(fp);
+            return(EXIT_NULL_VAL);
+        }
+        buffer[buffer_len]='\0';
+    } //if (fseek(fp,0L,SEEK_END) == 0) {
+    fclose(fp);
 
-    /* Cleanup */
-    xmlXPathFreeObject(xpathObj);
+    *return_buffer=buffer;
 
-    return(value);
+    return(buffer_len);
 }
 
 //#############################################################################
 
-char *return_xpath_value(const xmlXPathContextPtr xpathCtx, char *xpath){
+size_t read_file_rest_2_buffer(char *inp_fname, char **buffer, size_t buffer_len){
+    // second phase of read_file_header_2_buffer(): grows its buffer to the whole file
+    // returns the new length, 0 on error with *buffer left as it was
 
-    const xmlChar* xpathExpr = (const xmlChar*) xpath;
-
-    // evaluate xpath expression
-    xmlXPathObjectPtr xpathObj = xmlXPathEvalExpression(xpathExpr, xpathCtx);
-    if(xpathObj == NULL) {
-        fprintf(stderr,"Error: unable to evaluate xpath expression \"%s\"\n", xpathExpr);
-        return("\0");
+    size_t EXIT_NULL_VAL=0;
+    FILE *fp = NULL;
+    fp = fopen(inp_fname, "r");
+    if (NULL == fp) {
+        fprintf(stderr,"Error while opening file = %s\n", inp_fname);
+        return(EXIT_NULL_VAL);
     }
 
-    // use xpath object
-    xmlNodeSetPtr nodes = xpathObj->nodesetval;
-    size_t size = (nodes) ? nodes->nodeNr : 0;
-    if(size == 0) {
-        if(L_DEBUG_OUTPUT_xml) fprintf(stderr,"Error: xpath expression not found \"%s\"\n", xpathExpr);
-        xmlXPathFreeObject(xpathObj);
-        return("\0");
+    long file_len=-1;
+    if (fseek(fp,0L,SEEK_END) == 0) file_len=ftell(fp);
+    if ((file_len == -1) || (fseek(fp,(long)buffer_len,SEEK_SET) != 0)) {
+        fprintf(stderr,"Error while reading file\n");
+        fclose(fp);
+        return(EXIT_NULL_VAL);
+    }
+    if ((size_t)file_len <= buffer_len) { //nothing left
+        fclose(fp);
+        return(buffer_len);
     }
 
-    //assume uniqueness, use [position()=X] in xpath
-    //having used get_xpath_size() to build looping code
-    int iNode = 0; // get only 1st value at xpath
-    xmlNodePtr cur = (xmlNodePtr)xpathObj->nodesetval->nodeTab[iNode];
-    if(cur == NULL) {
-        fprintf(stderr,"Error: NULL node at xpath expression \"%s\"\n", xpathExpr);
-        xmlXPathFreeObject(xpathObj);
-        return("\0");
+    char *grown=realloc(*buffer,sizeof(char)*(file_len+1));
+    if (grown == NULL) {
+        fprintf(stderr,"Error while reading file\n");
+        fclose(fp);
+        return(EXIT_NULL_VAL);
     }
-    char *value = (char *) cur->children->content;
-//    fprintf(stdout,"XPATH: %s = %s\n", xpathExpr, value);
+    *buffer=grown;
 
-    /* Cleanup */
-    xmlXPathFreeObject(xpathObj);
+    size_t n_read=fread(grown+buffer_len,sizeof(char),file_len-buffer_len,fp);
+    fclose(fp);
+    if (n_read != (size_t)file_len-buffer_len) {
+        fprintf(stderr,"Error while reading file\n");
+        return(EXIT_NULL_VAL);
+    }
+    grown[file_len]='\0';
 
-    return(value);
+    return((size_t)file_len);
 }
 
 //#############################################################################
 
-size_t read_file_2_buffer(char *inp_fname, char **return_buffer){
+size_t read_file_header_2_buffer(char *inp_fname, char **return_buffer){
+    // reads only up to "<!-- END XML -->" (whole file if absent), so the blob space stays on disk
+    // NUL terminated, free with close_file_buffer()
 
     size_t EXIT_NULL_VAL=0;
-    char *buffer=NULL;
+    char substring[]="<!-- END XML -->";
+    size_t substring_len=strlen(substring);
+    size_t n_alloc=XML_HEADER_CHUNK_BYTES;
     size_t buffer_len=0;
+    size_t n_read;
+    char *buffer=NULL;
+    char *match=NULL;
 
     FILE *fp = NULL;
     fp = fopen(inp_fname, "r");
@@ -135,77 +136,249 @@ size_t read_file_2_buffer(char *inp_fname, char **return_buffer){
         return(EXIT_NULL_VAL);
     }
 
-    if (fseek(fp,0L,SEEK_END) == 0) {
-        /* Get the size of the file. */
-        buffer_len=ftell(fp);
-        if (buffer_len == -1) {
-            fprintf(stderr,"Error while reading file\n");
-            return(EXIT_NULL_VAL);
+    buffer=malloc(sizeof(char)*(n_alloc+1));
+    while (buffer != NULL) {
+        if (buffer_len == n_alloc) {
+            char *grown=realloc(buffer,sizeof(char)*(2*n_alloc+1));
+            if (grown == NULL) {
+                free(buffer);
+                buffer=NULL;
+                break;
+            }
+            buffer=grown;
+            n_alloc*=2;
         }
+        n_read=fread(buffer+buffer_len,sizeof(char),n_alloc-buffer_len,fp);
+        if (n_read == 0) break;
+        //search the new bytes, plus the tail a marker could straddle
+        size_t search_bgn=(buffer_len >= substring_len) ? buffer_len-substring_len+1 : 0;
+        buffer_len+=n_read;
+        match=find_in_buffer(buffer+search_bgn,buffer_len-search_bgn,substring);
+        //stop once the trailing \n, counted by find_buffer_end_of_xml(), is in too
+        if ((match != NULL) && (match+substring_len < buffer+buffer_len)) break;
+    }
+    fclose(fp);
 
-        /* Allocate our buffer to that size. */
-        buffer=malloc(sizeof(char)*(buffer_len));
-        if(L_DEBUG_OUTPUT_xml) fprintf(stdout,"buffer_len = %ld\n",buffer_len);
+    if ((buffer == NULL) || (buffer_len == 0)) {
+        fprintf(stderr,"Error while reading file\n");
+        if (buffer != NULL) free(buffer);
+        return(EXIT_NULL_VAL);
+    }
+    buffer[buffer_len]='\0';
 
-        /* Go back to the start of the file. */
-        if (fseek(fp,0L,SEEK_SET) != 0) {
-            fprintf(stderr,"Error while reading file\n");
-            return(EXIT_NULL_VAL);
-        }
+    *return_buffer=buffer;
+    return(buffer_len);
+}
 
-        /* Read the entire file into memory. */
-        if (fread(buffer,sizeof(char),buffer_len,fp) <= 0) {
-            fprintf(stderr,"Error while reading file\n");
-            return(EXIT_NULL_VAL);
-        }
-    } //if (fseek(fp,0L,SEEK_END) == 0) {
-    fclose(fp);
+//#############################################################################
 
-    *return_buffer=buffer;
+size_t map_file_2_buffer(char *inp_fname, char **return_buffer){
+    // read-only private mapping of the whole file, pages come straight from the page cache
+    // and only those touched are ever read, e.g. the XML header and the blobs decoded
+    // NOT NUL terminated, release with close_file_buffer(..,FILE_BUFFER_MMAP)
+    // 0, silently, if the file cannot be mapped (empty, pipe, ...), for the caller to read it instead
+    //
+    // a mapped file truncated in place raises SIGBUS on the pages cut off, where read() would have
+    // come up short; files replaced by rename() are safe (the mapping keeps the old inode)
+    // files modified within MAP_FILE_MIN_AGE_SEC (likely still being written), or that change
+    // while being mapped, are left to read(), which narrows the window but does not close it:
+    // callers keep mappings only while decoding, payloads held open (lazy reads) are read instead
+    // RB52ODIM_NO_MMAP=1 reads all files
+
+    size_t EXIT_NULL_VAL=0;
+    struct stat file_stat;
+    struct stat mapped_stat;
+
+    if ((getenv("RB52ODIM_NO_MMAP") != NULL) && (strcmp(getenv("RB52ODIM_NO_MMAP"),"0") != 0)) return(EXIT_NULL_VAL);
+
+    int fd=open(inp_fname,O_RDONLY);
+    if (fd == -1) return(EXIT_NULL_VAL);
+    if ((fstat(fd,&file_stat) != 0) || (!S_ISREG(file_stat.st_mode)) || (file_stat.st_size <= 0) ||
+        (time(NULL)-file_stat.st_mtime < MAP_FILE_MIN_AGE_SEC)) {
+        close(fd);
+        return(EXIT_NULL_VAL);
+    }
+    size_t buffer_len=(size_t)file_stat.st_size;
+    void *buffer=mmap(NULL,buffer_len,PROT_READ,MAP_PRIVATE,fd,0);
+    if (buffer == MAP_FAILED) {
+        close(fd);
+        return(EXIT_NULL_VAL);
+    }
+
+    //the size mapped is still the file's
+    int unstable=((fstat(fd,&mapped_stat) != 0) || (mapped_stat.st_size != file_stat.st_size) ||
+                  (mapped_stat.st_mtim.tv_sec != file_stat.st_mtim.tv_sec) || (mapped_stat.st_mtim.tv_nsec != file_stat.st_mtim.tv_nsec));
+    close(fd); //the mapping keeps its own reference
+    if (unstable) {
+        munmap(buffer,buffer_len);
+        return(EXIT_NULL_VAL);
+    }
+
+    //header first, then the blob space front to back
+    madvise(buffer,buffer_len,MADV_SEQUENTIAL);
+    madvise(buffer,(buffer_len < XML_HEADER_CHUNK_BYTES) ? buffer_len : XML_HEADER_CHUNK_BYTES,MADV_WILLNEED);
+    if(L_DEBUG_OUTPUT_xml) fprintf(stdout,"mapped buffer_len = %ld\n",buffer_len);
 
+    *return_buffer=(char *)buffer;
     return(buffer_len);
 }
 
 //#############################################################################
 
-void close_file_buffer(char *buffer){
+void close_file_buffer(char *buffer, size_t buffer_len, int buffer_owner){
 
-    if(buffer != NULL) free(buffer);
+    if((buffer == NULL) || (buffer_owner == FILE_BUFFER_BORROWED)) return;
+    if(buffer_owner == FILE_BUFFER_MMAP) {
+        munmap(buffer,buffer_len);
+    } else {
+        free(buffer);
+    }
 }
 
 //#############################################################################
 
-size_t find_buffer_end_of_xml(char *buffer){
-    
+size_t find_buffer_end_of_xml(const char *buffer, size_t buffer_len){
+    // bounded, the blob space after the header is binary and need not be NUL terminated
+    // buffer_len if there is no marker
+
     char substring[]="<!-- END XML -->";
-    char *match=strstr(buffer,substring);
-    if(match == 0){
-        return strlen(buffer);
+    char *match=find_in_buffer(buffer,buffer_len,substring);
+    if(match == NULL){
+        return(buffer_len);
     } else {
-        return match-buffer+strlen(substring)+1; //count trailing \n
+        size_t end_of_xml=match-buffer+strlen(substring)+1; //count trailing \n
+        return((end_of_xml > buffer_len) ? buffer_len : end_of_xml);
     }
 }
 
 //#############################################################################
 
-int open_xml_buffer(strXML_FILE_INFO *xml_info){
+char *find_in_buffer(const char *buffer, size_t buffer_len, const char *substring){
+    // bounded strstr(), safe on binary (non NUL-terminated) buffers
+
+    size_t substring_len=strlen(substring);
+    const char *p=buffer;
+    const char *p_end=buffer+buffer_len;
+
+    if((buffer == NULL) || (substring_len == 0) || (buffer_len < substring_len)) return(NULL);
+    while((p=memchr(p,substring[0],(p_end-p)-substring_len+1)) != NULL){
+        if(memcmp(p,substring,substring_len) == 0) return((char *)p);
+        if(++p > p_end-substring_len) break;
+    }
+    return(NULL);
+}
+
+//#############################################################################
+
+static int gunzip_xml_buffer(strXML_FILE_INFO *xml_info){
+    // a gzipped file (.vol.gz, .azi.gz) is inflated whole in place of what was read or mapped of it
+
+    if(!is_gzip_buffer((const unsigned char *)xml_info->buffer,xml_info->buffer_len)) return(EXIT_SUCCESS);
+
+    //the header-only fallback read stops at "<!-- END XML -->", never found in a compressed file
+    char *buffer=NULL;
+    size_t buffer_len=gunzip_buffer((const unsigned char *)xml_info->buffer,xml_info->buffer_len,&buffer);
+    close_file_buffer(xml_info->buffer,xml_info->buffer_len,xml_info->buffer_owner);
+    xml_info->buffer=buffer;
+    xml_info->buffer_len=buffer_len;
+    xml_info->buffer_owner=FILE_BUFFER_HEAP;
+    xml_info->header_only=0;
+    if(buffer_len == 0) {
+        fprintf(stderr,"Cannot gunzip %s\n", xml_info->inp_fullfile);
+        return(EXIT_FAILURE);
+    }
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+int read_xml_buffer(strXML_FILE_INFO *xml_info){
+    // as open_xml_buffer(), without building the DOM, doc and xpathCtx are left NULL
 
     // init
     xml_info->buffer=NULL;
+    xml_info->header_only=0;
     xml_info->doc=NULL;
     xml_info->xpathCtx=NULL;
 
     //ingest XML file to buffer
     if(L_DEBUG_OUTPUT_xml) fprintf(stdout,"reading : %s\n",xml_info->inp_fullfile);
-    xml_info->buffer_len=read_file_2_buffer(xml_info->inp_fullfile,&(xml_info->buffer));
+    xml_info->buffer_owner=FILE_BUFFER_MMAP;
+    xml_info->buffer_len=map_file_2_buffer(xml_info->inp_fullfile,&(xml_info->buffer));
+    if (xml_info->buffer_len == 0) {
+        xml_info->buffer_owner=FILE_BUFFER_HEAP;
+        xml_info->buffer_len=read_file_2_buffer(xml_info->inp_fullfile,&(xml_info->buffer));
+    }
+    if (xml_info->buffer_len == 0) {
+        fprintf(stderr,"Cannot read XML in %s\n", xml_info->inp_fullfile);
+        close_xml_buffer(&(*xml_info));
+        return(EXIT_FAILURE);
+    }
+    if (gunzip_xml_buffer(&(*xml_info)) != 0) {
+        close_xml_buffer(&(*xml_info));
+        return(EXIT_FAILURE);
+    }
+
+    //find end of XML
+    xml_info->byte_offset_end_of_xml=find_buffer_end_of_xml(xml_info->buffer,xml_info->buffer_len);
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+int read_xml_header(strXML_FILE_INFO *xml_info){
+    // as open_xml_header(), without building the DOM, doc and xpathCtx are left NULL
+
+    // init
+    xml_info->buffer=NULL;
+    xml_info->header_only=0;
+    xml_info->doc=NULL;
+    xml_info->xpathCtx=NULL;
+
+    //mapped whole, only the header pages are read in until the blobs are decoded
+    if(L_DEBUG_OUTPUT_xml) fprintf(stdout,"reading header : %s\n",xml_info->inp_fullfile);
+    xml_info->buffer_owner=FILE_BUFFER_MMAP;
+    xml_info->buffer_len=map_file_2_buffer(xml_info->inp_fullfile,&(xml_info->buffer));
+    if (xml_info->buffer_len == 0) {
+        xml_info->buffer_owner=FILE_BUFFER_HEAP;
+        xml_info->buffer_len=read_file_header_2_buffer(xml_info->inp_fullfile,&(xml_info->buffer));
+        xml_info->header_only=1;
+    }
     if (xml_info->buffer_len == 0) {
         fprintf(stderr,"Cannot read XML in %s\n", xml_info->inp_fullfile);
         close_xml_buffer(&(*xml_info));
         return(EXIT_FAILURE);
     }
+    if (gunzip_xml_buffer(&(*xml_info)) != 0) {
+        close_xml_buffer(&(*xml_info));
+        return(EXIT_FAILURE);
+    }
 
     //find end of XML
-    xml_info->byte_offset_end_of_xml=find_buffer_end_of_xml(xml_info->buffer);
+    xml_info->byte_offset_end_of_xml=find_buffer_end_of_xml(xml_info->buffer,xml_info->buffer_len);
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+int open_xml_buffer(strXML_FILE_INFO *xml_info){
+
+    if(read_xml_buffer(&(*xml_info)) != 0) return(EXIT_FAILURE);
+    return(parse_xml_buffer(&(*xml_info)));
+}
+
+//#############################################################################
+
+int open_xml_header(strXML_FILE_INFO *xml_info){
+    // as open_xml_buffer(), but buffer holds only the XML header, up to "<!-- END XML -->"
+
+    if(read_xml_header(&(*xml_info)) != 0) return(EXIT_FAILURE);
+    return(parse_xml_buffer(&(*xml_info)));
+}
+
+//#############################################################################
+
+static int parse_xml_buffer(strXML_FILE_INFO *xml_info){
 
     // parse the XML and get the DOM
     xml_info->doc=xmlReadMemory(xml_info->buffer, xml_info->byte_offset_end_of_xml, "noname.xml", NULL, 0);
@@ -227,5 +400,5 @@ void close_xml_buffer(strXML_FILE_INFO *xml_info){
 
     if(xml_info->xpathCtx != NULL) xmlXPathFreeContext(xml_info->xpathCtx); //cleanup
     if(xml_info->doc      != NULL) xmlFreeDoc(xml_info->doc); // free the document
-    if(xml_info->buffer   != NULL) close_file_buffer(xml_info->buffer); // free entire file buffer
+    if(xml_info->buffer   != NULL) close_file_buffer(xml_info->buffer,xml_info->buffer_len,xml_info->buffer_owner); // free entire file buffer
 }
@@ -1,5 +1,11 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <libxml/tree.h> //add -I/usr/include/libxml2 -lxml2 to compile
 #include <libxml/parser.h>
@@ -7,11 +13,20 @@
 #include <libxml/xpathInternals.h>
 
 #define MAX_STRING 256
+#define XML_HEADER_CHUNK_BYTES 65536 //read_file_header_2_buffer() increment, RB5 headers are mostly smaller
+#define MAP_FILE_MIN_AGE_SEC 2       //younger files are read rather than mapped, see map_file_2_buffer()
+
+//how a file buffer is released by close_file_buffer()
+#define FILE_BUFFER_HEAP 0 //malloc()ed, by read_file_*_2_buffer() or handed over by the caller
+#define FILE_BUFFER_MMAP 1 //by map_file_2_buffer()
+#define FILE_BUFFER_BORROWED 2 //part of the caller's buffer (e.g. a tar member), left alone
 
 typedef struct{
     char inp_fullfile[MAX_STRING];
     char *buffer;
     size_t buffer_len;
+    int buffer_owner;             //FILE_BUFFER_*
+    int header_only;              //1 if buffer stops after the XML header, see read_xml_header()
     size_t byte_offset_end_of_xml;
     xmlDoc *doc;
     xmlXPathContextPtr xpathCtx;
@@ -20,14 +35,17 @@ typedef struct{
 //#############################################################################
 // function declarations
 //#############################################################################
-size_t get_xpath_size(const xmlXPathContextPtr xpathCtx, char *xpath);
-char *return_xpath_name(const xmlXPathContextPtr xpathCtx, char *xpath);
-char *return_xpath_value(const xmlXPathContextPtr xpathCtx, char *xpath);
-
 size_t read_file_2_buffer(char *inp_fname, char **return_buffer);
-void close_file_buffer(char *buffer);
+size_t read_file_header_2_buffer(char *inp_fname, char **return_buffer);
+size_t read_file_rest_2_buffer(char *inp_fname, char **buffer, size_t buffer_len);
+size_t map_file_2_buffer(char *inp_fname, char **return_buffer);
+void close_file_buffer(char *buffer, size_t buffer_len, int buffer_owner);
 
-size_t find_buffer_end_of_xml(char *buffer);
+size_t find_buffer_end_of_xml(const char *buffer, size_t buffer_len);
+char *find_in_buffer(const char *buffer, size_t buffer_len, const char *substring);
 
+int read_xml_buffer(strXML_FILE_INFO *xml_info);
+int read_xml_header(strXML_FILE_INFO *xml_info);
 int open_xml_buffer(strXML_FILE_INFO *xml_info);
+int open_xml_header(strXML_FILE_INFO *xml_info);
 void close_xml_buffer(strXML_FILE_INFO *xml_info);
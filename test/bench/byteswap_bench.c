@@ -0,0 +1,122 @@
+/*
+ * byteswap_bench.c
+ *
+ * Microbenchmark of the big-endian -> host byte-swap kernels in
+ * src/byteswap_utils.c, against memcpy() of the same bytes as the
+ * memory-bandwidth reference.
+ *
+ * Sizes: one 720-ray x 1200-bin moment (cache resident, as decoded per
+ * inflate window), and a 64 MiB buffer (DRAM bound).
+ *
+ * build & run: make bench
+ *         or : gcc -O2 -Wall -I../../src byteswap_bench.c ../../src/byteswap_utils.c -o byteswap_bench
+ *
+ */
+
+#include <time.h>
+
+#include "byteswap_utils.h"
+
+#define BENCH_NRAYS 720
+#define BENCH_NBINS 1200
+#define BENCH_BIG_BYTES (64UL<<20)
+#define BENCH_MIN_SECS 0.25
+
+//#############################################################################
+
+static double now_secs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return(ts.tv_sec+ts.tv_nsec*1.e-9);
+}
+
+//#############################################################################
+
+static void memcpy_16(void *dest, const void *src, size_t n_elems){ memcpy(dest,src,n_elems*2); }
+static void memcpy_32(void *dest, const void *src, size_t n_elems){ memcpy(dest,src,n_elems*4); }
+
+static double bench_gbps(void (*func)(void *, const void *, size_t), void *dest, const void *src, size_t n_elems, size_t data_bytesize){
+    // GB/s of bytes read+written, best of repeated runs lasting >= BENCH_MIN_SECS
+
+    size_t n_bytes=n_elems*data_bytesize;
+    double best=1.e30;
+    double t_total=0.;
+    func(dest,src,n_elems); //warm up
+    while (t_total < BENCH_MIN_SECS) {
+        double t0=now_secs();
+        func(dest,src,n_elems);
+        double dt=now_secs()-t0;
+        if (dt < best) best=dt;
+        t_total+=dt;
+    }
+    return(2.*n_bytes/best/1.e9);
+}
+
+//#############################################################################
+
+static int check_kernel(size_t data_bytesize, const uint8_t *src, size_t n_elems){
+    // compare against the scalar kernel, with an unaligned tail
+
+    size_t n_bytes=n_elems*data_bytesize;
+    uint8_t *ref=malloc(n_bytes);
+    uint8_t *out=malloc(n_bytes);
+    int kernel=byteswap_get_kernel();
+    int ok;
+
+    byteswap_use_kernel(BYTESWAP_KERNEL_SCALAR);
+    if (data_bytesize == 2) byteswap_copy_16(ref,src+1,n_elems-1);
+    else                    byteswap_copy_32(ref,src+1,n_elems-1);
+    byteswap_use_kernel(kernel);
+    if (data_bytesize == 2) byteswap_copy_16(out,src+1,n_elems-1);
+    else                    byteswap_copy_32(out,src+1,n_elems-1);
+    ok=(memcmp(ref,out,(n_elems-1)*data_bytesize) == 0);
+    free(ref);
+    free(out);
+    return(ok);
+}
+
+//#############################################################################
+
+int main(void){
+
+    int kernels[]={BYTESWAP_KERNEL_SCALAR,BYTESWAP_KERNEL_SSSE3,BYTESWAP_KERNEL_AVX2};
+    size_t n_kernels=sizeof(kernels)/sizeof(kernels[0]);
+    size_t sizes[]={(size_t)BENCH_NRAYS*BENCH_NBINS*4,BENCH_BIG_BYTES};
+    const char *size_names[]={"720x1200 moment","64 MiB buffer"};
+    size_t depths[]={2,4};
+    size_t i,j,k;
+    int status=EXIT_SUCCESS;
+
+    uint8_t *src=malloc(BENCH_BIG_BYTES+4);
+    uint8_t *dest=malloc(BENCH_BIG_BYTES+4);
+    for (i = 0; i < BENCH_BIG_BYTES+4; i++) src[i]=(uint8_t)(i*2654435761u >> 13);
+    memset(dest,0,BENCH_BIG_BYTES+4);
+
+    fprintf(stdout,"auto-selected kernel = %s\n",byteswap_kernel_name(byteswap_get_kernel()));
+    for (i = 0; i < 2; i++) {
+      for (j = 0; j < 2; j++) {
+        size_t data_bytesize=depths[j];
+        size_t n_elems=sizes[i]/data_bytesize;
+        if (i == 0) n_elems=(size_t)BENCH_NRAYS*BENCH_NBINS;
+        double ref_gbps=bench_gbps(data_bytesize == 2 ? memcpy_16 : memcpy_32,dest,src,n_elems,data_bytesize);
+        fprintf(stdout,"\n%s, %2ld-bit (%ld elems) memcpy reference = %7.2f GB/s\n",size_names[i],data_bytesize*8,n_elems,ref_gbps);
+        for (k = 0; k < n_kernels; k++) {
+          if (!byteswap_kernel_supported(kernels[k])) {
+            fprintf(stdout,"  %-7s : not supported by this CPU\n",byteswap_kernel_name(kernels[k]));
+            continue;
+          }
+          byteswap_use_kernel(kernels[k]);
+          int ok=check_kernel(data_bytesize,src,BENCH_NRAYS*BENCH_NBINS);
+          double gbps=bench_gbps(data_bytesize == 2 ? byteswap_copy_16 : byteswap_copy_32,dest,src,n_elems,data_bytesize);
+          fprintf(stdout,"  %-7s : %7.2f GB/s (%5.1f%% of memcpy) %s\n",
+              byteswap_kernel_name(kernels[k]),gbps,100.*gbps/ref_gbps,ok ? "OK" : "MISMATCH");
+          if (!ok) status=EXIT_FAILURE;
+        }
+      }
+    }
+    byteswap_use_kernel(BYTESWAP_KERNEL_AUTO);
+
+    free(src);
+    free(dest);
+    return(status);
+}
@@ -0,0 +1,251 @@
+/*
+ * inflate_bench.c
+ *
+ * Equivalence test and throughput comparison of the blob inflate backends
+ * in src/inflate_utils.c. Every <BLOB> of every input file (plain, .gz or
+ * .tar.gz rainbow5) is inflated with each backend built in; outputs must be
+ * byte-identical to stock zlib's. Gzipped inputs are also gunzipped with
+ * gunzip_buffer(), which must match zlib's gzread().
+ *
+ * build & run: make bench [WITH_LIBDEFLATE=yes]
+ *         or : ./src/inflate_bench test/<files>
+ * check only : ./src/inflate_bench -c test/<files> (no timing, run by make test)
+ *
+ */
+
+#include <time.h>
+
+#include "xml_utils.h"
+#include "inflate_utils.h"
+
+#define BENCH_MIN_SECS 0.25
+
+typedef struct{
+    const unsigned char *src; //zlib stream, after the 4-byte size prefix
+    size_t src_len;
+    size_t out_len;
+} strBENCH_BLOB;
+
+//#############################################################################
+
+static double now_secs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return(ts.tv_sec+ts.tv_nsec*1.e-9);
+}
+
+//#############################################################################
+
+static size_t read_gz_2_buffer(char *inp_fname, char **return_buffer){
+    // gzread() passes plain files through untouched
+
+    size_t buffer_len=0;
+    size_t n_alloc=1<<20;
+    int n_read;
+    char *buffer=NULL;
+
+    gzFile gz=gzopen(inp_fname,"rb");
+    if (gz == NULL) return(0);
+    buffer=malloc(n_alloc);
+    while ((n_read=gzread(gz,buffer+buffer_len,n_alloc-buffer_len)) > 0) {
+        buffer_len+=n_read;
+        if (buffer_len == n_alloc) {
+            n_alloc*=2;
+            buffer=realloc(buffer,n_alloc);
+        }
+    }
+    gzclose(gz);
+    if ((n_read < 0) || (buffer_len == 0)) {
+        free(buffer);
+        return(0);
+    }
+    *return_buffer=buffer;
+    return(buffer_len);
+}
+
+//#############################################################################
+
+static int check_gunzip(char *inp_fname, const char *ref, size_t ref_len){
+    // gunzip_buffer() of the raw file vs gzread()'s ref; -1 if not gzipped
+
+    FILE *fp=fopen(inp_fname,"rb");
+    if (fp == NULL) return(-1);
+    fseek(fp,0,SEEK_END);
+    size_t raw_len=ftell(fp);
+    fseek(fp,0,SEEK_SET);
+    unsigned char *raw=malloc(raw_len);
+    if (fread(raw,1,raw_len,fp) != raw_len) raw_len=0;
+    fclose(fp);
+
+    int status=-1;
+    if (is_gzip_buffer(raw,raw_len)) {
+        char *out=NULL;
+        size_t out_len=gunzip_buffer(raw,raw_len,&out);
+        status=((out_len == ref_len) && (memcmp(out,ref,ref_len) == 0)) ? EXIT_SUCCESS : EXIT_FAILURE;
+        free(out);
+    }
+    free(raw);
+    return(status);
+}
+
+//#############################################################################
+
+static size_t find_blobs(char *buffer, size_t buffer_len, strBENCH_BLOB **blobs, size_t *n_blobs, size_t *n_alloc){
+    // <BLOB blobid="N" size="S" compression="qt">\n + S bytes, anywhere in buffer (tar members included)
+
+    char BLOB_line[MAX_STRING];
+    char *p=buffer;
+    char *p_end=buffer+buffer_len;
+    char *BLOB_bgn;
+    size_t n_found=0;
+
+    while ((BLOB_bgn=find_in_buffer(p,p_end-p,"<BLOB ")) != NULL) {
+        char *BLOB_end=memchr(BLOB_bgn,'>',p_end-BLOB_bgn);
+        if ((BLOB_end == NULL) || (BLOB_end-BLOB_bgn+1 >= MAX_STRING)) break;
+        memcpy(BLOB_line,BLOB_bgn,BLOB_end-BLOB_bgn+1);
+        BLOB_line[BLOB_end-BLOB_bgn+1]='\0';
+        char *attrib=strstr(BLOB_line," size=\"");
+        p=BLOB_end+1;
+        if (attrib == NULL) continue;
+        size_t size_blob=strtoul(attrib+strlen(" size=\""),NULL,10);
+        if ((p < p_end) && (*p == '\n')) p++;
+        if ((size_blob < 4) || (size_blob > (size_t)(p_end-p))) continue;
+
+        if (*n_blobs == *n_alloc) {
+            *n_alloc=(*n_alloc == 0) ? 256 : 2*(*n_alloc);
+            *blobs=realloc(*blobs,(*n_alloc)*sizeof(strBENCH_BLOB));
+        }
+        const unsigned char *u=(const unsigned char *)p;
+        (*blobs)[*n_blobs].src=u+4;
+        (*blobs)[*n_blobs].src_len=size_blob-4;
+        (*blobs)[*n_blobs].out_len=((size_t)u[0] << 24) | ((size_t)u[1] << 16) | ((size_t)u[2] << 8) | u[3];
+        (*n_blobs)++;
+        n_found++;
+        p+=size_blob;
+    }
+    return(n_found);
+}
+
+//#############################################################################
+
+static int inflate_all(strBENCH_BLOB *blobs, size_t n_blobs, unsigned char **out){
+
+    size_t i;
+    for (i = 0; i < n_blobs; i++) {
+        if (inflate_blob(blobs[i].src,blobs[i].src_len,out[i],blobs[i].out_len) != blobs[i].out_len) return(EXIT_FAILURE);
+    }
+    return(EXIT_SUCCESS);
+}
+
+//#############################################################################
+
+int main(int argc, char **argv){
+
+    int backends[]={INFLATE_BACKEND_ZLIB,INFLATE_BACKEND_LIBDEFLATE};
+    size_t n_backends=sizeof(backends)/sizeof(backends[0]);
+    strBENCH_BLOB *blobs=NULL;
+    size_t n_blobs=0;
+    size_t n_alloc=0;
+    size_t n_in_bytes=0;
+    size_t n_out_bytes=0;
+    size_t n_files=0;
+    size_t i,k;
+    size_t n_gz=0;
+    size_t n_gz_diff=0;
+    int a;
+    int a_first=1;
+    int check_only=0;
+    int status=EXIT_SUCCESS;
+
+    if ((argc > 1) && (strcmp(argv[1],"-c") == 0)) {
+        check_only=1;
+        a_first++;
+    }
+    if (argc <= a_first) {
+        fprintf(stderr,"usage: %s [-c] rb5_file[.gz|.tar.gz] ...\n",argv[0]);
+        return(EXIT_FAILURE);
+    }
+
+    char **buffers=calloc(argc,sizeof(char *));
+    for (a = a_first; a < argc; a++) {
+        size_t buffer_len=read_gz_2_buffer(argv[a],&buffers[a]);
+        if (buffer_len == 0) continue;
+        int gz_status=check_gunzip(argv[a],buffers[a],buffer_len);
+        if (gz_status != -1) n_gz++;
+        if (gz_status == EXIT_FAILURE) {
+            fprintf(stderr,"gunzip_buffer() differs from gzread() on %s\n",argv[a]);
+            n_gz_diff++;
+        }
+        size_t n_found=find_blobs(buffers[a],buffer_len,&blobs,&n_blobs,&n_alloc);
+        if (n_found > 0) n_files++;
+    }
+    if (n_blobs == 0) {
+        fprintf(stderr,"no BLOBs found\n");
+        return(EXIT_FAILURE);
+    }
+
+    unsigned char **ref=malloc(n_blobs*sizeof(unsigned char *));
+    unsigned char **out=malloc(n_blobs*sizeof(unsigned char *));
+    for (i = 0; i < n_blobs; i++) {
+        ref[i]=malloc(blobs[i].out_len+1);
+        out[i]=malloc(blobs[i].out_len+1);
+        n_in_bytes+=blobs[i].src_len;
+        n_out_bytes+=blobs[i].out_len;
+    }
+    fprintf(stdout,"%ld files, %ld blobs, %.1f MB compressed -> %.1f MB\n",n_files,n_blobs,n_in_bytes/1.e6,n_out_bytes/1.e6);
+    fprintf(stdout,"  %-10s : %ld gzipped files %s\n","gunzip",n_gz,n_gz_diff == 0 ? "IDENTICAL" : "MISMATCH");
+    if (n_gz_diff != 0) status=EXIT_FAILURE;
+
+    //stock zlib is the reference
+    inflate_use_backend(INFLATE_BACKEND_ZLIB);
+    if (inflate_all(blobs,n_blobs,ref) != EXIT_SUCCESS) {
+        fprintf(stderr,"zlib failed to inflate a blob\n");
+        return(EXIT_FAILURE);
+    }
+
+    for (k = 0; k < n_backends; k++) {
+        if (!inflate_backend_supported(backends[k])) {
+            fprintf(stdout,"  %-10s : not built in\n",inflate_backend_name(backends[k]));
+            continue;
+        }
+        inflate_use_backend(backends[k]);
+
+        size_t n_diff=0;
+        for (i = 0; i < n_blobs; i++) memset(out[i],0xA5,blobs[i].out_len);
+        if (inflate_all(blobs,n_blobs,out) != EXIT_SUCCESS) n_diff=n_blobs;
+        for (i = 0; (n_diff < n_blobs) && (i < n_blobs); i++) {
+            if (memcmp(ref[i],out[i],blobs[i].out_len) != 0) n_diff++;
+        }
+
+        if (check_only) {
+            fprintf(stdout,"  %-10s : %s\n",inflate_backend_name(backends[k]),n_diff == 0 ? "IDENTICAL" : "MISMATCH");
+            if (n_diff != 0) status=EXIT_FAILURE;
+            continue;
+        }
+
+        double best=1.e30;
+        double t_total=0.;
+        while (t_total < BENCH_MIN_SECS) {
+            double t0=now_secs();
+            inflate_all(blobs,n_blobs,out);
+            double dt=now_secs()-t0;
+            if (dt < best) best=dt;
+            t_total+=dt;
+        }
+        fprintf(stdout,"  %-10s : %8.1f MB/s out %s\n",
+            inflate_backend_name(backends[k]),n_out_bytes/best/1.e6,n_diff == 0 ? "IDENTICAL" : "MISMATCH");
+        if (n_diff != 0) status=EXIT_FAILURE;
+    }
+    inflate_use_backend(INFLATE_BACKEND_AUTO);
+
+    for (i = 0; i < n_blobs; i++) {
+        free(ref[i]);
+        free(out[i]);
+    }
+    free(ref);
+    free(out);
+    free(blobs);
+    for (a = a_first; a < argc; a++) if (buffers[a] != NULL) free(buffers[a]);
+    free(buffers);
+    return(status);
+}
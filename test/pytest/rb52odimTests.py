@@ -23,7 +23,7 @@ rb52odim unit tests
 @author Daniel Michelson and Peter Rodriguez, Environment and Climate Change Cananda
 @date 2016-08-17
 '''
-import os, unittest, types, glob
+import os, unittest, types, glob, mmap, subprocess, tempfile, shutil
 import _rave
 import _raveio
 import _polarscan
@@ -128,6 +128,7 @@ class rb52odimTest(unittest.TestCase):
     GOOD_RB5_AZI = "../2016081612320300dBZ.azi"
     NEW_H5_VOL = "../2016092614304000dBZ.vol.new.h5"
     NEW_H5_AZI = "../2016081612320300dBZ.azi.new.h5"
+    NEW_SHM = "shm:/rb52odimTests"
     REF_H5_VOL = "../2016092614304000dBZ.vol.h5"  # Assumes that these reference files are ODIM compliant
     REF_H5_AZI = "../2016081612320300dBZ.azi.h5"  
     FILELIST_RB5 = [\
@@ -165,9 +166,13 @@ class rb52odimTest(unittest.TestCase):
         pass
 
     def testWrongInput(self):
-        status = _rb52odim.isRainbow5(self.CASRA_AZI_dBZ)
+        status = _rb52odim.isRainbow5(self.REF_H5_AZI)
         self.assertFalse(status)
 
+    def testIsGoodRB5GzInput(self):
+        status = _rb52odim.isRainbow5(self.CASRA_AZI_dBZ)
+        self.assertTrue(status)
+
     def testIsBadRB5Input(self):
         status = _rb52odim.isRainbow5(self.BAD_RB5_VOL)
         self.assertFalse(status)
@@ -196,6 +201,97 @@ class rb52odimTest(unittest.TestCase):
             ref_scan = ref_pvol.getScan(i)
             validateScan(self, scan, ref_scan)
 
+    def testReadRB5VolThreaded(self):
+        rb52odim.setDecodeThreads(4)
+        try:
+            self.assertEquals(_rb52odim.getDecodeThreads(), 4)
+            pvol = _rb52odim.readRB5(self.GOOD_RB5_VOL).object
+        finally:
+            rb52odim.setDecodeThreads(1)
+        ref_pvol = _raveio.open(self.REF_H5_VOL).object
+        self.assertEquals(pvol.getNumberOfScans(), ref_pvol.getNumberOfScans())
+        validateTopLevel(self, pvol, ref_pvol)
+        for i in range(pvol.getNumberOfScans()):
+            validateScan(self, pvol.getScan(i), ref_pvol.getScan(i))
+
+    def testReadRB5VolLazy(self):
+        lazy = rb52odim.readRB5lazy(self.GOOD_RB5_VOL)
+        pvol = lazy.rio.object
+        ref_pvol = _raveio.open(self.REF_H5_VOL).object
+        self.assertEquals(pvol.getNumberOfScans(), ref_pvol.getNumberOfScans())
+        self.assertFalse(pvol.getScan(0).hasParameter('DBZH'))  # not until loaded
+        param = lazy.getParameter(0, 'DBZH')
+        self.assertTrue((param.getData() == ref_pvol.getScan(0).getParameter('DBZH').getData()).all())
+        self.assertEquals(lazy.load('DBZH', 0), 0)
+        self.assertTrue(lazy.load() > 0)
+        validateTopLevel(self, pvol, ref_pvol)
+        for i in range(pvol.getNumberOfScans()):
+            validateScan(self, pvol.getScan(i), ref_pvol.getScan(i))
+
+    def testReadRB5bufBorrowed(self):
+        ref_scan = _rb52odim.readRB5(self.GOOD_RB5_AZI).object
+        fd = open(self.GOOD_RB5_AZI, 'rb')
+        try:
+            mm = mmap.mmap(fd.fileno(), 0, access=mmap.ACCESS_READ)
+            data = fd.read()
+        finally:
+            fd.close()
+        for buf in [data, bytearray(data), memoryview(data), mm]:
+            self.assertTrue(_rb52odim.isRainbow5buf(buf))
+            scan = _rb52odim.readRB5buf(self.GOOD_RB5_AZI, buf).object
+            validateTopLevel(self, scan, ref_scan)
+            validateScan(self, scan, ref_scan)
+        mm.close()
+
+    def testReadRB5VolLazyBuffer(self):
+        buf = bytearray(open(self.GOOD_RB5_VOL, 'rb').read())
+        lazy = rb52odim.readRB5lazy(self.GOOD_RB5_VOL, buf)
+        self.assertRaises(BufferError, buf.extend, 'x')  # held until lazy is gone
+        del buf
+        lazy.load()
+        pvol = lazy.rio.object
+        ref_pvol = _raveio.open(self.REF_H5_VOL).object
+        for i in range(pvol.getNumberOfScans()):
+            validateScan(self, pvol.getScan(i), ref_pvol.getScan(i))
+
+    def testReadRB5VolQuantities(self):
+        pvol = _rb52odim.readRB5(self.GOOD_RB5_VOL, ['DBZH']).object
+        ref_pvol = _raveio.open(self.REF_H5_VOL).object
+        for i in range(pvol.getNumberOfScans()):
+            validateScan(self, pvol.getScan(i), ref_pvol.getScan(i))
+        self.assertRaises(IOError, _rb52odim.readRB5, self.GOOD_RB5_VOL, ['VRADH'])
+
+    def testReadRB5VolQuantitiesTemporaries(self):
+        class Quantities(object):  # items made afresh on each access
+            def __len__(self): return 1
+            def __getitem__(self, i): return ''.join(['DB', 'ZH'])
+        pvol = _rb52odim.readRB5(self.GOOD_RB5_VOL, Quantities()).object
+        self.assertEquals(pvol.getScan(0).getParameterNames(), ['DBZH'])
+
+    def testReadRB5VolSlices(self):
+        ref_pvol = _raveio.open(self.REF_H5_VOL).object
+        pvol = _rb52odim.readRB5(self.GOOD_RB5_VOL, None, [0, 2]).object
+        self.assertEquals(pvol.getNumberOfScans(), 2)
+        validateScan(self, pvol.getScan(0), ref_pvol.getScan(0))
+        validateScan(self, pvol.getScan(1), ref_pvol.getScan(2))
+        elangle = np.degrees(ref_pvol.getScan(1).elangle)
+        pvol = _rb52odim.readRB5(self.GOOD_RB5_VOL, None, None, (elangle-0.01, elangle+0.01)).object
+        self.assertEquals(pvol.getNumberOfScans(), 1)
+        validateScan(self, pvol.getScan(0), ref_pvol.getScan(1))
+
+    def testReadRB5Header(self):
+        header = rb52odim.readRB5header(self.GOOD_RB5_VOL)
+        ref_pvol = _raveio.open(self.REF_H5_VOL).object
+        self.assertEquals(header['quantities'], ['DBZH'])
+        self.assertEquals(len(header['slices']), ref_pvol.getNumberOfScans())
+        for i in range(ref_pvol.getNumberOfScans()):
+            slice, ref_scan = header['slices'][i], ref_pvol.getScan(i)
+            self.assertAlmostEquals(slice['elangle'], np.degrees(ref_scan.elangle), 4)
+            self.assertEquals(slice['nrays'], ref_scan.nrays)
+            self.assertEquals(slice['nbins'], ref_scan.nbins)
+        timed = rb52odim.readRB5header(self.GOOD_RB5_VOL, timestamps=True)
+        self.assertEquals(timed['slices'][0]['startdatetime'], header['slices'][0]['startdatetime'])
+
     def testSingleRB5Azi(self):
         rb52odim.singleRB5(self.GOOD_RB5_AZI,out_fullfile=self.NEW_H5_AZI)
         new_rio = _raveio.open(self.NEW_H5_AZI)
@@ -256,6 +352,121 @@ class rb52odimTest(unittest.TestCase):
         validateTopLevel(self, new_scan, ref_scan)
         validateScan(self, new_scan, ref_scan)
 
+    def testCombineRB5FromTarballSequential(self):
+        new_rio = rb52odim.combineRB5FromTarball(self.RB5_TARBALL_DOPVOL1B, None, return_rio=True, nthreads=1)
+        ref_rio = _raveio.open(self.REF_H5_TARBALL_DOPVOL1B)
+        self.assertTrue(new_rio.objectType is _rave.Rave_ObjectType_SCAN)
+        new_scan, ref_scan = new_rio.object, ref_rio.object
+        validateTopLevel(self, new_scan, ref_scan)
+        validateScan(self, new_scan, ref_scan)
+
+    def testReadRB5batch(self):
+        ifiles = self.FILELIST_RB5 + [self.BAD_RB5_VOL, self.REF_H5_AZI]
+        read = list(rb52odim.readRB5batch(ifiles, window=2))
+        self.assertEquals([ifile for ifile, rio in read], ifiles)
+        for ifile, rio in read[:len(self.FILELIST_RB5)]:
+            ref_scan = _rb52odim.readRB5(ifile).object
+            validateScan(self, rio.object, ref_scan)
+        self.assertTrue(read[-2][1] is None)
+        self.assertTrue(read[-1][1] is None)
+
+    def testReadRB5stream(self):
+        for ifile in [self.GOOD_RB5_AZI, self.CASRA_AZI_dBZ]:
+            p = subprocess.Popen(["cat", ifile], stdout=subprocess.PIPE)
+            rio = rb52odim.readRB5stream(p.stdout, ifile)
+            p.stdout.close()
+            p.wait()
+            ref_scan = _rb52odim.readRB5(ifile).object
+            validateTopLevel(self, rio.object, ref_scan)
+            validateScan(self, rio.object, ref_scan)
+        p = subprocess.Popen(["cat", self.REF_H5_AZI], stdout=subprocess.PIPE)
+        self.assertRaises(IOError, rb52odim.readRB5stream, p.stdout)
+        p.stdout.close()
+        p.wait()
+
+    def testSaveRB5shm(self):
+        rio = _rb52odim.readRB5(self.GOOD_RB5_VOL)
+        rb52odim.saveRIO(rio, self.NEW_SHM)
+        try:
+            shm = rb52odim.readRB5shm(self.NEW_SHM)
+        finally:
+            _rb52odim.unlinkRB5shm(self.NEW_SHM[len(rb52odim.SHM):])
+        pvol = rio.object
+        self.assertEquals(shm['object_type'], "PVOL")
+        self.assertEquals(shm['source'], pvol.source)
+        self.assertAlmostEquals(shm['latitude'], pvol.latitude*180/np.pi, 6)
+        self.assertEquals(len(shm['scans']), pvol.getNumberOfScans())
+        for i, shm_scan in enumerate(shm['scans']):
+            scan = pvol.getScan(i)
+            self.assertAlmostEquals(shm_scan['elangle'], scan.elangle*180/np.pi, 6)
+            self.assertEquals(shm_scan['nrays'], scan.nrays)
+            self.assertTrue(np.array_equal(shm_scan['attributes']['how/startazA'], scan.getAttribute('how/startazA')))
+            for pname in scan.getParameterNames():
+                moment = shm_scan['moments'][pname]
+                self.assertEquals(moment['gain'], scan.getParameter(pname).gain)
+                self.assertTrue(np.array_equal(moment['data'], scan.getParameter(pname).getData()))
+                self.assertFalse(moment['data'].flags.writeable)
+        self.assertRaises(IOError, rb52odim.readRB5shm, self.NEW_SHM)
+
+    def testReadRB5cache(self):
+        cache_dir = tempfile.mkdtemp()
+        try:
+            rb52odim.setCache(cache_dir)
+            try:
+                _rb52odim.readRB5(self.GOOD_RB5_VOL)
+                # a hit maps the entry in place, marking it as used, a miss would write a new one
+                entry_file = glob.glob(os.path.join(cache_dir, '*.rb5c'))[0]
+                entry_ino = os.stat(entry_file).st_ino
+                os.utime(entry_file, (0, 0))
+                rio = _rb52odim.readRB5(self.GOOD_RB5_VOL)
+                self.assertEquals(os.stat(entry_file).st_ino, entry_ino)
+            finally:
+                rb52odim.setCache(None)
+            entries = rb52odim.listCache(cache_dir)
+            self.assertEquals(len(entries), 1)
+            self.assertEquals(entries[0]['path'], os.path.realpath(self.GOOD_RB5_VOL))
+            self.assertFalse(entries[0]['stale'])
+            self.assertTrue(entries[0]['used'] > 0)
+            pvol, ref_pvol = rio.object, _rb52odim.readRB5(self.GOOD_RB5_VOL).object
+            validateTopLevel(self, pvol, ref_pvol)
+            self.assertEquals(pvol.getNumberOfScans(), ref_pvol.getNumberOfScans())
+            for i in range(pvol.getNumberOfScans()):
+                validateScan(self, pvol.getScan(i), ref_pvol.getScan(i))
+            self.assertEquals(rb52odim.evictCache(cache_dir), 1)
+            self.assertEquals(rb52odim.listCache(cache_dir), [])
+        finally:
+            shutil.rmtree(cache_dir)
+
+    def testReadRB5cacheStale(self):
+        cache_dir = tempfile.mkdtemp()
+        try:
+            ifile = os.path.join(cache_dir, os.path.basename(self.GOOD_RB5_VOL))
+            shutil.copyfile(self.GOOD_RB5_VOL, ifile)
+            rb52odim.setCache(cache_dir)
+            try:
+                _rb52odim.readRB5(ifile)
+                entries = rb52odim.listCache(cache_dir)
+                self.assertEquals(len(entries), 1)
+                entry_file = glob.glob(os.path.join(cache_dir, '*.rb5c'))[0]
+                entry_ino = os.stat(entry_file).st_ino
+                # a touched input no longer matches its entry, which the next read replaces
+                os.utime(ifile, (entries[0]['mtime'] - 3600, entries[0]['mtime'] - 3600))
+                self.assertTrue(rb52odim.listCache(cache_dir)[0]['stale'])
+                rio = _rb52odim.readRB5(ifile)
+            finally:
+                rb52odim.setCache(None)
+            entries = rb52odim.listCache(cache_dir)
+            self.assertEquals(len(entries), 1)
+            self.assertFalse(entries[0]['stale'])
+            self.assertEquals(int(entries[0]['mtime']), int(os.stat(ifile).st_mtime))
+            self.assertNotEquals(os.stat(entry_file).st_ino, entry_ino)
+            self.assertEquals(rio.object.getNumberOfScans(), _rb52odim.readRB5(self.GOOD_RB5_VOL).object.getNumberOfScans())
+        finally:
+            shutil.rmtree(cache_dir)
+
+    def testReadRB5TarballWrongInput(self):
+        self.assertRaises(IOError, _rb52odim.readRB5tarball, self.GOOD_RB5_AZI)
+
     def testMergeOdimScans2Pvol(self):
         rb52odim.combineRB5FromTarball(self.RB5_TARBALL_DOPVOL1A, self.NEW_H5_TARBALL_DOPVOL1A)
         rb52odim.combineRB5FromTarball(self.RB5_TARBALL_DOPVOL1B, self.NEW_H5_TARBALL_DOPVOL1B)
@@ -306,6 +517,15 @@ class rb52odimTest(unittest.TestCase):
 
         os.remove(self.NEW_H5_MERGED_PVOL)
 
+    def testReadRB5Gz(self):
+        rio = _rb52odim.readRB5(self.CASRA_AZI_dBZ)
+        self.assertTrue(rio.objectType is _rave.Rave_ObjectType_SCAN)
+        fstr = rb52odim.gunzip(self.CASRA_AZI_dBZ)
+        ref_scan = _rb52odim.readRB5(fstr).object
+        os.remove(fstr)
+        validateTopLevel(self, rio.object, ref_scan)
+        validateScan(self, rio.object, ref_scan)
+
     def testGunzip(self):
         fstr = rb52odim.gunzip(self.CASRA_AZI_dBZ)
         self.assertTrue(_rb52odim.isRainbow5(fstr))